@@ -0,0 +1,392 @@
+/*
+ * File:   SAM_rec.c
+ * Author: Hassan
+ *
+ * SAM_demo's detection and alerts with the drive recorded, from one camera
+ * capture:
+ *
+ *   SAM_rec [segment prefix] [log]
+ *
+ * The camera video port frames go to the detection pipeline through the
+ * mailbox and, once the prepare stage has downscaled them, to the H.264
+ * encoder in the same GPU buffers (frame_source_mmal's encode_video). The
+ * face and padding boxes of the latest detection and a status line are
+ * drawn into each frame on its way to the encoder, so detection never sees
+ * them. The recording is fragmented MP4 segments with an index, the state
+ * of each detection frame in it as SEI (sam_seidump); "-" writes raw H.264
+ * to stdout instead, which is why everything else SAM_rec prints goes to
+ * stderr.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bcm_host.h"
+#include "interface/vcos/vcos.h"
+
+#include "wiringPi.h"
+
+#include "frame_source.h"
+#include "frame_source_mmal.h"
+#include "sam_detector.h"
+#include "sam_alert.h"
+#include "sam_pipeline.h"
+#include "sam_inputs.h"
+#include "sam_outputs.h"
+#include "sam_log.h"
+#include "h264_writer.h"
+#include "sam_sei.h"
+#include "glyph_atlas.h"
+#include "overlay_spans.h"
+
+#define STATS_INTERVAL 300 // frames between pipeline utilisation reports
+#define FPS_TEXT_INTERVAL 15 // frames between FPS text updates, the text is recompiled only when it changes
+#define REC_BITRATE 4000000
+#define BOX_THICKNESS 4 // video pixels, even
+#define TEXT_X 16 // status line in the video frame, even
+#define TEXT_Y 16
+#define TEXT_SIZE 24
+#define TEXT_COLOR 0xff00ff00
+#define ALARM_TEXT_COLOR 0xffff0000
+
+/* box colours as I420 */
+typedef struct {
+    uint8_t y, u, v;
+} REC_COLOR_T;
+
+static const REC_COLOR_T face_color = {145, 54, 34}; // green
+static const REC_COLOR_T alarm_color = {81, 90, 240}; // red
+static const REC_COLOR_T padding_color = {210, 16, 146}; // yellow
+
+typedef struct {
+    FRAME_SOURCE_T *source;
+    SAM_PIPELINE_T *pipeline;
+    SAM_ALERT_T *alert;
+    SAM_INPUT_PINS_T input; // no gpio_input: digitalRead once a frame
+    SAM_OUTPUT_PINS_T output; // no gpio_output: digitalWrite
+    H264_WRITER_T writer;
+    SAM_SEI_LATEST_T sei; // detection state for the stream, output stage -> encoder
+    int width, height; // video
+    int detect_width, detect_height;
+    // output stage: the status line, compiled into spans[!front]
+    GLYPH_ATLAS_T atlas;
+    GLYPH_TEXT_T shown;
+    uint32_t *text_pixels;
+    int text_width;
+    char text[256];
+    char fps_text[64];
+    // what the annotate callback draws, output stage -> camera threads
+    pthread_mutex_t lock;
+    OVERLAY_SPANS_T spans[2];
+    int front;
+    int face_found, draw_flag, alarm;
+    CvRect face, padding; // detection frame pixels
+    int opencv_frames;
+    struct timespec t1;
+} REC_T;
+
+/* input checkpoint (silance and turn signal), on the eyes stage */
+static void read_inputs(SAM_INPUTS_T *inputs, void *userdata) {
+    REC_T *rec = (REC_T *) userdata;
+
+    sam_inputs_frame(&rec->input, inputs);
+}
+
+/* encoder output to the segments, on the encoder's callback thread */
+static void record_encoded(const uint8_t *data, size_t length, int flags, int64_t pts, void *arg) {
+    REC_T *rec = (REC_T *) arg;
+    uint8_t sei[SAM_SEI_NAL_MAX];
+    size_t n;
+
+    // the latest detection state, ahead of a picture's slices
+    if ((n = sam_sei_take_before(&rec->sei, flags, sei, sizeof (sei))) > 0) {
+        h264_writer_push(&rec->writer, sei, n, flags & H264_WRITER_KEYFRAME, pts);
+    }
+    h264_writer_push(&rec->writer, data, length, flags, pts);
+}
+
+/* x0..x1, y0..y1 even and inside the frame */
+static void fill_rect(uint8_t *y, uint8_t *u, uint8_t *v, int stride, int uv_stride,
+        int x0, int y0, int x1, int y1, const REC_COLOR_T *color) {
+    int row;
+
+    for (row = y0; row < y1; row++) {
+        memset(y + row * stride + x0, color->y, x1 - x0);
+    }
+    for (row = y0 / 2; row < y1 / 2; row++) {
+        memset(u + row * uv_stride + x0 / 2, color->u, (x1 - x0) / 2);
+        memset(v + row * uv_stride + x0 / 2, color->v, (x1 - x0) / 2);
+    }
+}
+
+/* the outline of a detection frame box, scaled up to the video and clipped to it */
+static void draw_box(const REC_T *rec, uint8_t *y, uint8_t *u, uint8_t *v, int stride, int uv_stride,
+        const CvRect *box, const REC_COLOR_T *color) {
+    int x0 = box->x * rec->width / rec->detect_width & ~1;
+    int y0 = box->y * rec->height / rec->detect_height & ~1;
+    int x1 = (box->x + box->width) * rec->width / rec->detect_width & ~1;
+    int y1 = (box->y + box->height) * rec->height / rec->detect_height & ~1;
+
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    x1 = x1 > rec->width ? rec->width & ~1 : x1;
+    y1 = y1 > rec->height ? rec->height & ~1 : y1;
+    if (x1 - x0 < 2 * BOX_THICKNESS || y1 - y0 < 2 * BOX_THICKNESS) {
+        return;
+    }
+    fill_rect(y, u, v, stride, uv_stride, x0, y0, x1, y0 + BOX_THICKNESS, color);
+    fill_rect(y, u, v, stride, uv_stride, x0, y1 - BOX_THICKNESS, x1, y1, color);
+    fill_rect(y, u, v, stride, uv_stride, x0, y0 + BOX_THICKNESS, x0 + BOX_THICKNESS, y1 - BOX_THICKNESS, color);
+    fill_rect(y, u, v, stride, uv_stride, x1 - BOX_THICKNESS, y0 + BOX_THICKNESS, x1, y1 - BOX_THICKNESS, color);
+}
+
+/* a video frame on its way to the encoder, on whichever thread released it to the camera */
+static void annotate_frame(uint8_t *y, uint8_t *u, uint8_t *v, int stride, int uv_stride, int64_t pts, void *arg) {
+    REC_T *rec = (REC_T *) arg;
+
+    pthread_mutex_lock(&rec->lock);
+    if (rec->face_found) {
+        if (rec->draw_flag) {
+            draw_box(rec, y, u, v, stride, uv_stride, &rec->padding, &padding_color);
+        }
+        draw_box(rec, y, u, v, stride, uv_stride, &rec->face, rec->alarm ? &alarm_color : &face_color);
+    }
+    overlay_spans_blend(&rec->spans[rec->front], y, stride, u, v, uv_stride, TEXT_X, TEXT_Y);
+    pthread_mutex_unlock(&rec->lock);
+}
+
+/* alarm deadline, on the timer wheel thread; the next frame's outputs take over */
+static void buzz_now(void *userdata) {
+    REC_T *rec = (REC_T *) userdata;
+
+    sam_outputs_buzz(&rec->output);
+}
+
+/* GPIO, boxes and status line for one frame, on the output stage in frame order */
+static void write_outputs(const SAM_PIPELINE_SLOT_T *slot, void *userdata) {
+    REC_T *rec = (REC_T *) userdata;
+    SAM_SEI_T sei;
+    struct timespec t2;
+    float fps = 0.0;
+    int alarm = sam_alert_buzzing(rec->alert);
+    const char *state;
+
+    rec->opencv_frames++;
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+    float d = (t2.tv_sec + t2.tv_nsec / 1000000000.0) - (rec->t1.tv_sec + rec->t1.tv_nsec / 1000000000.0);
+    if (d > 0) {
+        fps = rec->opencv_frames / d;
+    } else {
+        fps = rec->opencv_frames;
+    }
+    /* face LED and buzzer, an older frame must not silence what the wheel has sounded since */
+    sam_outputs_frame(&rec->output, &slot->outputs, alarm);
+    sam_sei_from_slot(slot, rec->detect_width, rec->detect_height, alarm, &sei);
+    sam_sei_publish(&rec->sei, &sei);
+
+    /* the status line goes through the glyph cache, only the characters that changed are redrawn and compiled */
+    if (rec->opencv_frames % FPS_TEXT_INTERVAL == 1) {
+        sprintf(rec->fps_text, "Video %.1f FPS, OpenCV %.1f FPS", rec->source->fps, fps);
+    }
+    if (slot->outputs.buzz || alarm) {
+        state = "ALARM";
+    } else if (!slot->face_found) {
+        state = "no face";
+    } else if (slot->out_of_bound) {
+        state = "out of bound";
+    } else {
+        state = slot->eyes_run && !slot->eyes_detected ? "eyes closed" : "face";
+    }
+    sprintf(rec->text, "%s  %s", rec->fps_text, state);
+    if (glyph_text_draw(&rec->shown, rec->text_pixels, rec->text_width, rec->text_width, rec->atlas.cell_height,
+            0, 0, rec->text, slot->outputs.buzz || alarm ? ALARM_TEXT_COLOR : TEXT_COLOR, 0) > 0) {
+        overlay_spans_compile(&rec->spans[!rec->front], rec->text_pixels, rec->text_width);
+        pthread_mutex_lock(&rec->lock);
+        rec->front = !rec->front;
+        pthread_mutex_unlock(&rec->lock);
+    }
+    /* the boxes, in the frames the encoder gets from now on */
+    pthread_mutex_lock(&rec->lock);
+    rec->face_found = slot->face_found;
+    rec->face = slot->face;
+    rec->draw_flag = slot->draw_flag;
+    rec->padding = slot->padding;
+    rec->alarm = slot->outputs.buzz || alarm;
+    pthread_mutex_unlock(&rec->lock);
+
+    if (rec->opencv_frames % STATS_INTERVAL == 0) {
+        sam_pipeline_print_stats(rec->pipeline, stderr);
+        sam_inputs_log_stats(&rec->input);
+        if (rec->output.output) {
+            gpio_output_print_stats(rec->output.output, stderr);
+        }
+        SAM_LOG(SAM_LOG_INFO, "camera: %u frames not detected, %u not encoded",
+                frame_source_mmal_dropped(rec->source), frame_source_mmal_encode_dropped(rec->source));
+        h264_writer_print_stats(&rec->writer);
+    }
+}
+
+int main(int argc, char** argv) {
+    /* GPIO pins setup */
+    wiringPiSetup();
+    pinMode(SAM_PIN_BUZZ, OUTPUT);
+    pinMode(SAM_PIN_SLC_BUTTON, INPUT);
+    pinMode(SAM_PIN_FACE, OUTPUT);
+    pinMode(SAM_PIN_L_TURN, INPUT);
+    pinMode(SAM_PIN_R_TURN, INPUT);
+    /* *************** */
+
+    FRAME_SOURCE_CONFIG_T source_config;
+    GPIO_INPUT_CONFIG_T input_config;
+    SAM_LOG_CONFIG_T log_config;
+    H264_WRITER_CONFIG_T writer_config;
+    FRAME_SOURCE_T *source;
+    SAM_DETECTOR_T detector;
+    SAM_ALERT_T alert;
+    SAM_PIPELINE_T pipeline;
+    TIMER_WHEEL_T wheel;
+    REC_T rec;
+
+    fprintf(stderr, "Running...\n");
+
+    // SAM_rec [segment prefix] [log]: the frame loop only queues log records, a thread writes them
+    sam_log_config_default(&log_config);
+    log_config.level = SAM_LOG_DEBUG;
+    if (argc > 2) {
+        log_config.path = argv[2];
+    }
+    if (sam_log_start(&log_config) != 0) {
+        return -1;
+    }
+
+    bcm_host_init();
+    memset(&rec, 0, sizeof (rec));
+    pthread_mutex_init(&rec.lock, NULL);
+    sam_sei_latest_init(&rec.sei);
+
+    frame_source_config_default(&source_config);
+    rec.width = source_config.width;
+    rec.height = source_config.height;
+    rec.detect_width = rec.width / 4;
+    rec.detect_height = rec.height / 4;
+
+    // the status line: glyphs rasterised once, a surface one text line high
+    if (glyph_atlas_init(&rec.atlas, "sans-serif", TEXT_SIZE) != 0) {
+        return -1;
+    }
+    glyph_text_init(&rec.shown, &rec.atlas);
+    rec.text_width = (rec.width - 2 * TEXT_X) & ~1;
+    rec.text_pixels = (uint32_t *) calloc((size_t) rec.text_width * rec.atlas.cell_height, sizeof (uint32_t));
+    if (!rec.text_pixels) {
+        fprintf(stderr, "Error: no memory for the status line\n");
+        return -1;
+    }
+    if (overlay_spans_init(&rec.spans[0], rec.text_width, rec.atlas.cell_height) != 0
+            || overlay_spans_init(&rec.spans[1], rec.text_width, rec.atlas.cell_height) != 0) {
+        return -1;
+    }
+    fprintf(stderr, "Overlay blend: %s\n", overlay_spans_impl());
+
+    // segment prefix, "sam_rec" by default; "-" for raw H.264 on stdout
+    h264_writer_config_default(&writer_config);
+    writer_config.path = argc > 1 ? argv[1] : "sam_rec";
+    if (strcmp(writer_config.path, "-") != 0) {
+        writer_config.format = H264_WRITER_MP4;
+        writer_config.fps = source_config.fps;
+        writer_config.index = 1;
+    }
+    if (h264_writer_init(&rec.writer, &writer_config) != 0) {
+        return -1;
+    }
+
+    // one capture: the video port frames are detected, then annotated and encoded
+    source_config.bitrate = REC_BITRATE;
+    source_config.encoded = record_encoded;
+    source_config.encoded_arg = &rec;
+    source_config.encode_video = 1;
+    source_config.annotate = annotate_frame;
+    source_config.annotate_arg = &rec;
+    source = frame_source_mmal_create(&source_config);
+    if (!source) {
+        fprintf(stderr, "Error: unable to open frame source\n");
+        return -1;
+    }
+
+    /* setup opencv, cascades compiled in (no XML parse at power-on) */
+    if (sam_detector_init(&detector, rec.detect_width, rec.detect_height, NULL, NULL) != 0) {
+        return -1;
+    }
+    // a face scan borrows the cores the other stages leave idle, for a fresher box
+    if (sam_detector_set_threads(&detector, 0) != 0) {
+        return -1;
+    }
+
+    /* *****SAM***** */
+    sam_alert_init(&alert);
+    alert.verbose = 1;
+    // alert timers on CLOCK_MONOTONIC ms, the pipeline's frame clock
+    timer_wheel_init(&wheel, timer_wheel_now_ms());
+    if (timer_wheel_start(&wheel) != 0) {
+        return -1;
+    }
+    // face LED and buzzer straight to the GPIO registers, only on change
+    rec.output.output = sam_outputs_open("gpiomem");
+    rec.output.write_pin = digitalWrite;
+    sam_alert_set_timer(&alert, &wheel, buzz_now, &rec);
+
+    // button and turn signals as debounced edges; kernels without the GPIO chardev keep polling
+    sam_inputs_config(&input_config);
+    rec.input.read_pin = digitalRead;
+    rec.input.input = gpio_input_open("chip", &input_config);
+    if (rec.input.input && gpio_input_start(rec.input.input) != 0) {
+        gpio_input_destroy(rec.input.input);
+        rec.input.input = NULL;
+    }
+    /* ********************************* */
+
+    // prepare, face, eyes and output each get a core, see sam_pipeline.h
+    if (sam_pipeline_init(&pipeline, &detector, &alert, source) != 0) {
+        return -1;
+    }
+    pipeline.inputs_cb = read_inputs;
+    pipeline.output_cb = write_outputs;
+    pipeline.userdata = &rec;
+    rec.source = source;
+    rec.pipeline = &pipeline;
+    rec.alert = &alert;
+
+    if (frame_source_start(source) != 0) {
+        fprintf(stderr, "Error: unable to start frame source\n");
+        return -1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &rec.t1);
+    if (sam_pipeline_start(&pipeline) != 0) {
+        return -1;
+    }
+    sam_pipeline_wait(&pipeline);
+    sam_pipeline_print_stats(&pipeline, stderr);
+    timer_wheel_destroy(&wheel);
+    gpio_input_destroy(rec.input.input);
+
+    digitalWrite(SAM_PIN_BUZZ, LOW);
+    digitalWrite(SAM_PIN_FACE, LOW);
+    gpio_output_destroy(rec.output.output);
+    // no more encoder callbacks after this, the writer closes the last segment
+    frame_source_destroy(source);
+    h264_writer_print_stats(&rec.writer);
+    h264_writer_destroy(&rec.writer);
+    sam_pipeline_destroy(&pipeline);
+    sam_detector_destroy(&detector);
+    overlay_spans_destroy(&rec.spans[0]);
+    overlay_spans_destroy(&rec.spans[1]);
+    free(rec.text_pixels);
+    glyph_atlas_destroy(&rec.atlas);
+    sam_sei_latest_destroy(&rec.sei);
+    pthread_mutex_destroy(&rec.lock);
+    sam_log_stop();
+    return 0;
+}
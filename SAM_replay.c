@@ -0,0 +1,495 @@
+/*
+ * File:   SAM_replay.c
+ * Author: Hassan
+ *
+ * Runs the SAM detection and alert logic against a recorded drive or the
+ * synthetic source, without the camera, GPIO or display. Prints every change
+ * in the alert outputs and a throughput summary, so detector changes can be
+ * measured on any Linux box.
+ *
+ *   SAM_replay [-r] [-l] [-n frames] [-s WxH] [-f fps] [-q] [-c] [-t interval] [-m margin] [-o] [-p] [-j threads] [-g script] recording.y4m|recording.yuv|synthetic
+ *   SAM_replay -a
+ *
+ * -p runs the frames through sam_pipeline's four stage threads instead of the
+ * serial loop and adds each stage's utilisation to the summary. -j spreads
+ * every face and eye scan over that many threads, 0 for one per CPU. -g
+ * feeds the button and turn signals from a gpio_input_sim script, played
+ * in real time from the first frame, and reports how long events waited.
+ * The outputs of every frame go to a fake gpio_output register file, whose
+ * write counts show up in the summary.
+ *
+ * With -c every malloc, calloc and realloc call after the warm-up frames is
+ * counted, SAM's own and the libraries' alike, and the run fails if the
+ * native path made any, if the heap in use has grown by the end, or if the
+ * detector's frame arena ever ran out. The OpenCV path (-o) allocates in
+ * cvHaarDetectObjects on every frame, so there the calls are only reported.
+ * Counting needs glibc, whose allocator the wrappers below forward to.
+ *
+ * -a needs no source: it plays the alarm against silence presses, with the
+ * timer wheel driven by hand, and fails if the buzzer is not where SAM_demo
+ * would leave it after each step.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <malloc.h>
+
+#include "frame_source.h"
+#include "sam_detector.h"
+#include "sam_alert.h"
+#include "sam_pipeline.h"
+#include "sam_inputs.h"
+#include "sam_outputs.h"
+
+typedef struct {
+    int quiet;
+    int frames, faces, eye_runs, alarms;
+    SAM_OUTPUTS_T last_outputs;
+    size_t heap_warm;
+    int count_allocs; // -c
+    GPIO_INPUT_T *input; // NULL: no inputs
+    SAM_INPUT_STATS_T input_stats;
+    GPIO_OUTPUT_T *output; // fake registers
+} REPLAY_T;
+
+static double now_ms(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+#define HEAP_CHECK_WARMUP 30
+
+static int alloc_counting; // set once the loop has warmed up under -c
+static uint32_t alloc_calls;
+
+#ifdef __GLIBC__
+#define ALLOC_COUNTED 1
+
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *p, size_t size);
+
+static void count_alloc(void) {
+    if (__atomic_load_n(&alloc_counting, __ATOMIC_RELAXED)) {
+        __atomic_add_fetch(&alloc_calls, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/* Every allocation in the process comes through here, glibc's own and OpenCV's included. */
+void *malloc(size_t size) {
+    count_alloc();
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    count_alloc();
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *p, size_t size) {
+    count_alloc();
+    return __libc_realloc(p, size);
+}
+#else
+#define ALLOC_COUNTED 0
+#endif
+
+/* Bytes currently allocated through malloc, mmapped chunks included. */
+static size_t heap_in_use(void) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+#else
+    struct mallinfo mi = mallinfo();
+#endif
+
+    return (size_t) mi.uordblks + (size_t) mi.hblkhd;
+}
+
+/* Counts and prints one frame's outcome, for the serial loop and the pipeline alike. */
+static void replay_frame(REPLAY_T *replay, uint32_t seq, int64_t pts, int face_found, const CvRect *face,
+        int eyes_run, const SAM_OUTPUTS_T *outputs, int out_of_bound, int eyes_detected) {
+    replay->faces += face_found;
+    replay->eye_runs += eyes_run;
+    sam_outputs_write(replay->output, outputs, 0);
+    if (outputs->buzz && !replay->last_outputs.buzz) {
+        replay->alarms++;
+    }
+    if (!replay->quiet && (replay->frames == 0 || outputs->buzz != replay->last_outputs.buzz
+            || outputs->face_led != replay->last_outputs.face_led)) {
+        printf("frame %u t=%.3f face=%d [%d %d %d %d] out_of_bound=%d eyes=%d buzz=%d\n",
+                seq, pts / 1000000.0, outputs->face_led, face->x, face->y, face->width, face->height,
+                out_of_bound, eyes_detected, outputs->buzz);
+    }
+    replay->last_outputs = *outputs;
+    replay->frames++;
+    if (replay->frames == HEAP_CHECK_WARMUP) {
+        replay->heap_warm = heap_in_use();
+        __atomic_store_n(&alloc_counting, replay->count_allocs, __ATOMIC_RELAXED);
+    }
+}
+
+static void replay_inputs(SAM_INPUTS_T *inputs, void *userdata) {
+    REPLAY_T *replay = (REPLAY_T *) userdata;
+
+    sam_inputs_read(replay->input, inputs, &replay->input_stats);
+}
+
+static void pipeline_output(const SAM_PIPELINE_SLOT_T *slot, void *userdata) {
+    replay_frame((REPLAY_T *) userdata, slot->seq, slot->pts, slot->face_found, &slot->face,
+            slot->eyes_run, &slot->outputs, slot->out_of_bound, slot->eyes_detected);
+}
+
+static void check_buzz(void *userdata) {
+    (*(int *) userdata)++;
+}
+
+/* One frame of the alarm check, without a face or with one in place; the buzzer as SAM_demo drives it. */
+static int check_frame(SAM_ALERT_T *alert, TIMER_WHEEL_T *wheel, uint64_t now, int face_found, int press) {
+    SAM_INPUTS_T inputs;
+    SAM_OUTPUTS_T outputs;
+    CvRect face = cvRect(0, 0, 0, 0);
+
+    timer_wheel_advance(wheel, now);
+    memset(&inputs, 0, sizeof (inputs));
+    inputs.slc_pressed = press;
+    sam_alert_inputs(alert, &inputs);
+    sam_alert_face(alert, face_found, &face, now);
+    sam_alert_decide(alert, now, &outputs);
+    return outputs.buzz || sam_alert_buzzing(alert);
+}
+
+/* The alarm sequences around the silence button, on a wheel driven by hand. */
+static int check_alarm(void) {
+    static const struct {
+        uint64_t now; // ms
+        int frame; // 0: only the wheel moves on
+        int face_found, press;
+        int buzz, buzz_cb; // expected after the step
+        const char *what;
+    } steps[] = {
+        {0, 1, 0, 0, 0, 0, "face lost"},
+        {1000, 0, 0, 0, 1, 1, "the wheel sounds the buzzer on the deadline"},
+        {1033, 1, 0, 0, 1, 1, "the next frame keeps it on"},
+        {1066, 1, 0, 1, 0, 1, "silence stops it"},
+        {2100, 1, 0, 0, 0, 1, "and it stays off"},
+        {2133, 1, 0, 1, 1, 1, "silence again lets the alarm still on sound"},
+        {2166, 1, 1, 0, 0, 1, "the face back stops it"},
+        {3000, 1, 0, 0, 0, 1, "face lost again"},
+        {3500, 1, 0, 1, 0, 1, "silenced before the deadline"},
+        {4000, 0, 0, 0, 0, 1, "the deadline passes quietly"},
+        {4033, 1, 0, 0, 0, 1, "and the frames keep it quiet"},
+    };
+    SAM_ALERT_T alert;
+    TIMER_WHEEL_T wheel;
+    int buzz_cb = 0, buzz, result = 0;
+    size_t i;
+
+    timer_wheel_init(&wheel, 0);
+    sam_alert_init(&alert);
+    sam_alert_set_timer(&alert, &wheel, check_buzz, &buzz_cb);
+    for (i = 0; i < sizeof (steps) / sizeof (steps[0]); i++) {
+        if (steps[i].frame) {
+            buzz = check_frame(&alert, &wheel, steps[i].now, steps[i].face_found, steps[i].press);
+        } else {
+            timer_wheel_advance(&wheel, steps[i].now);
+            buzz = sam_alert_buzzing(&alert);
+        }
+        if (buzz != steps[i].buzz || buzz_cb != steps[i].buzz_cb) {
+            printf("Error: alarm check at %llu ms, %s: buzzer %d, %d wheel buzzes\n", (unsigned long long) steps[i].now,
+                    steps[i].what, buzz, buzz_cb);
+            result = -1;
+        }
+    }
+    timer_wheel_cancel(&wheel, &alert.alarm_timer);
+    timer_wheel_destroy(&wheel);
+    if (result == 0) {
+        printf("alarm check: %zu steps passed\n", sizeof (steps) / sizeof (steps[0]));
+    }
+    return result;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-r] [-l] [-n frames] [-s WxH] [-f fps] [-q] [-c] [-t interval] [-m margin] [-o] [-p] [-j threads] [-g script] source\n", name);
+    fprintf(stderr, "       %s -a\n", name);
+    fprintf(stderr, "  source  recording.y4m, raw I420 recording, or \"synthetic\"\n");
+    fprintf(stderr, "  -r      pace frames in real time (default: as fast as possible)\n");
+    fprintf(stderr, "  -l      loop the recording\n");
+    fprintf(stderr, "  -n      stop after this many frames\n");
+    fprintf(stderr, "  -s      frame size of a raw I420 recording (default 1280x720)\n");
+    fprintf(stderr, "  -f      frame rate of a raw I420 recording (default 30)\n");
+    fprintf(stderr, "  -q      only print the summary\n");
+    fprintf(stderr, "  -t      frames between full face detections, 0 detects every frame (default %d)\n", FACE_TRACKER_INTERVAL);
+    fprintf(stderr, "  -m      face search margin around the padding box, -1 always scans the whole frame (default %d)\n", SAM_ROI_MARGIN);
+    fprintf(stderr, "  -o      load the XML cascades and evaluate them with OpenCV instead of haar_native\n");
+    fprintf(stderr, "  -p      run the stages on their own threads (sam_pipeline)\n");
+    fprintf(stderr, "  -j      threads per face or eye scan, 0 for one per CPU (default 1)\n");
+    fprintf(stderr, "  -g      simulated GPIO input script, see gpio_input_sim.c\n");
+    fprintf(stderr, "  -c      fail on any allocation once the loop has warmed up (native path), on heap growth or an arena overflow\n");
+    fprintf(stderr, "  -a      check the alarm against the silence button on a hand-driven timer wheel, then exit\n");
+}
+
+int main(int argc, char** argv) {
+    FRAME_SOURCE_CONFIG_T config;
+    FRAME_SOURCE_T *source;
+    SAM_DETECTOR_T detector;
+    SAM_ALERT_T alert;
+    SAM_PIPELINE_T pipeline;
+    SAM_INPUTS_T inputs;
+    SAM_OUTPUTS_T outputs;
+    REPLAY_T replay;
+    FRAME_T *frame;
+    int check_heap = 0;
+    int track_interval = FACE_TRACKER_INTERVAL;
+    int roi_margin = SAM_ROI_MARGIN;
+    int use_roi;
+    int use_native = 1;
+    int pipelined = 0;
+    int threads = 1;
+    const char *input_script = NULL;
+    GPIO_INPUT_CONFIG_T input_config;
+    size_t heap_end, arena_high, arena_size;
+    uint32_t arena_overflows, integrals;
+    int opt, i;
+    double t_start, t_init, t_prepare = 0, t_face = 0, t_eyes = 0, t0, t1;
+
+    memset(&replay, 0, sizeof (replay));
+    frame_source_config_default(&config);
+    config.pace = FRAME_SOURCE_PACE_FAST;
+
+    while ((opt = getopt(argc, argv, "rln:s:f:qct:m:opj:g:a")) != -1) {
+        switch (opt) {
+            case 'r':
+                config.pace = FRAME_SOURCE_PACE_REALTIME;
+                break;
+            case 'l':
+                config.loop = 1;
+                break;
+            case 'n':
+                config.max_frames = atoi(optarg);
+                break;
+            case 's':
+                if (sscanf(optarg, "%dx%d", &config.width, &config.height) != 2) {
+                    usage(argv[0]);
+                    return -1;
+                }
+                break;
+            case 'f':
+                config.fps = atof(optarg);
+                break;
+            case 'q':
+                replay.quiet = 1;
+                break;
+            case 'c':
+                check_heap = 1;
+                replay.count_allocs = 1;
+                break;
+            case 't':
+                track_interval = atoi(optarg);
+                break;
+            case 'm':
+                roi_margin = atoi(optarg);
+                break;
+            case 'o':
+                use_native = 0;
+                break;
+            case 'p':
+                pipelined = 1;
+                break;
+            case 'j':
+                threads = atoi(optarg);
+                break;
+            case 'g':
+                input_script = optarg;
+                break;
+            case 'a':
+                return check_alarm() == 0 ? 0 : 1;
+            default:
+                usage(argv[0]);
+                return -1;
+        }
+    }
+    if (optind >= argc) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    source = frame_source_open(argv[optind], &config);
+    if (!source) {
+        return -1;
+    }
+    // compiled-in cascades unless OpenCV is to evaluate them, which needs the XML
+    t0 = now_ms();
+    if (sam_detector_init(&detector, source->width / 4, source->height / 4,
+            use_native ? NULL : SAM_FACE_CASCADE, use_native ? NULL : SAM_EYES_CASCADE) != 0) {
+        frame_source_destroy(source);
+        return -1;
+    }
+    t_init = now_ms() - t0;
+    if (sam_detector_set_threads(&detector, threads) != 0) {
+        sam_detector_destroy(&detector);
+        frame_source_destroy(source);
+        return -1;
+    }
+    detector.tracker.interval = track_interval;
+    detector.roi_margin = roi_margin;
+    detector.use_native = use_native;
+    use_roi = roi_margin >= 0;
+    sam_alert_init(&alert);
+    memset(&inputs, 0, sizeof (inputs));
+    replay.output = sam_outputs_open("fake");
+    if (!replay.output) {
+        return -1;
+    }
+    if (input_script) {
+        sam_inputs_config(&input_config);
+        replay.input = gpio_input_sim_create(input_script, &input_config);
+        if (!replay.input) {
+            return -1;
+        }
+    }
+    if (pipelined) {
+        if (sam_pipeline_init(&pipeline, &detector, &alert, source) != 0) {
+            return -1;
+        }
+        pipeline.inputs_cb = replay.input ? replay_inputs : NULL;
+        pipeline.output_cb = pipeline_output;
+        pipeline.userdata = &replay;
+        pipeline.use_roi = use_roi;
+        pipeline.pts_clock = 1;
+    }
+
+    if (frame_source_start(source) != 0) {
+        return -1;
+    }
+    if (replay.input && gpio_input_start(replay.input) != 0) {
+        return -1;
+    }
+    t_start = now_ms();
+
+    if (pipelined) {
+        if (sam_pipeline_start(&pipeline) != 0) {
+            return -1;
+        }
+        sam_pipeline_wait(&pipeline);
+    }
+    while (!pipelined && frame_source_acquire(source, &frame, -1) > 0) {
+        // alert timers run on the recording's clock, not on the wall clock
+        uint64_t now = (uint64_t) (frame->pts / 1000);
+        int64_t pts = frame->pts;
+        uint32_t seq = frame->seq;
+        CvRect face = cvRect(0, 0, 0, 0);
+        int face_found, eyes_run;
+
+        t0 = now_ms();
+        sam_detector_prepare(&detector, frame);
+        frame_source_release(source, frame);
+        t1 = now_ms();
+        t_prepare += t1 - t0;
+
+        face_found = sam_detector_track_face(&detector, &face);
+        t0 = now_ms();
+        t_face += t0 - t1;
+
+        if (replay.input) {
+            sam_inputs_read(replay.input, &inputs, &replay.input_stats);
+        }
+        sam_alert_inputs(&alert, &inputs);
+        sam_alert_face(&alert, face_found, &face, now);
+        eyes_run = sam_alert_begin_eyes(&alert, now);
+        if (eyes_run) {
+            sam_alert_eyes(&alert, sam_detector_eyes(&detector, &alert.face));
+            t_eyes += now_ms() - t0;
+        }
+        sam_alert_decide(&alert, now, &outputs);
+        if (alert.draw_flag && use_roi) {
+            // once calibrated, look for the face around the padding box only
+            CvRect box = cvRect(alert.padding_x, alert.padding_y, alert.padding_w, alert.padding_h);
+            sam_detector_set_search_box(&detector, &box);
+        }
+        sam_detector_end_frame(&detector);
+
+        replay_frame(&replay, seq, pts, face_found, &face, eyes_run, &outputs, alert.out_of_bound, alert.eyes_detected);
+    }
+    __atomic_store_n(&alloc_counting, 0, __ATOMIC_RELAXED);
+    heap_end = heap_in_use();
+
+    // one working frame when serial, one per slot when pipelined
+    arena_high = detector.frame.arena.high_water;
+    arena_size = detector.frame.arena.size;
+    arena_overflows = detector.frame.arena.overflows;
+    integrals = detector.frame.pyramid.integrals_built;
+    for (i = 0; pipelined && i < SAM_PIPELINE_SLOTS; i++) {
+        const SAM_DETECTOR_FRAME_T *work = &pipeline.slot[i].work;
+
+        arena_high = work->arena.high_water > arena_high ? work->arena.high_water : arena_high;
+        arena_overflows += work->arena.overflows;
+        integrals += work->pyramid.integrals_built;
+    }
+
+    t1 = now_ms() - t_start;
+    printf("%s: %d frames in %.2f s, %.2f detection FPS\n", source->name, replay.frames, t1 / 1000.0,
+            t1 > 0 ? replay.frames * 1000.0 / t1 : 0.0);
+    if (replay.frames > 0) {
+        if (pipelined) {
+            sam_pipeline_print_stats(&pipeline, stdout);
+        } else {
+            printf("  prepare %.2f ms, face %.2f ms, eyes %.2f ms (%d runs) per frame\n",
+                    t_prepare / replay.frames, t_face / replay.frames,
+                    replay.eye_runs ? t_eyes / replay.eye_runs : 0.0, replay.eye_runs);
+        }
+        printf("  face found in %d frames (%.1f%%), %d alarms\n", replay.faces, 100.0 * replay.faces / replay.frames, replay.alarms);
+        printf("  %u full detections (%u inside the padding box), %u tracked frames, %u scale levels skipped\n",
+                detector.detect_runs, detector.roi_scans, detector.track_runs, detector.face_stats.skipped_levels);
+        printf("  cascade evaluator: %s on %d threads, %s cascades, detector ready in %.1f ms\n",
+                use_native && detector.native ? haar_native_impl() : "opencv",
+                detector.pool ? task_pool_threads(detector.pool) : 1,
+                detector.cascade ? "XML" : "compiled-in", t_init);
+        printf("  cascade windows per frame: face %.0f, eyes %.0f; %.2f integral images built per frame\n",
+                (double) detector.face_stats.windows / replay.frames, (double) detector.eyes_stats.windows / replay.frames,
+                (double) integrals / replay.frames);
+    }
+
+    printf("  frame arena high water %zu of %zu bytes, %u overflows\n", arena_high, arena_size, arena_overflows);
+    printf("  ");
+    gpio_output_print_stats(replay.output, stdout);
+    if (replay.input) {
+        printf("  inputs: %u events (%u edges, %u bounces, %u dropped), %u presses, %.2f ms average wait, %.2f ms worst\n",
+                replay.input_stats.events, replay.input->edges, replay.input->bounces, replay.input->dropped, replay.input_stats.presses,
+                replay.input_stats.events ? replay.input_stats.latency_ns / 1000000.0 / replay.input_stats.events : 0.0,
+                replay.input_stats.max_latency_ns / 1000000.0);
+    }
+
+    if (check_heap) {
+        if (replay.frames <= HEAP_CHECK_WARMUP) {
+            printf("Error: heap check needs more than %d frames\n", HEAP_CHECK_WARMUP);
+            return -1;
+        }
+        printf("  heap in use after %d frames %zu bytes, at the end %zu bytes\n", HEAP_CHECK_WARMUP, replay.heap_warm, heap_end);
+        if (ALLOC_COUNTED) {
+            printf("  %u allocation calls in the %d frames after warm-up\n", alloc_calls, replay.frames - HEAP_CHECK_WARMUP);
+        }
+        if (heap_end > replay.heap_warm || arena_overflows) {
+            printf("Error: per-frame allocations are not steady\n");
+            return -1;
+        }
+        if (use_native && alloc_calls) {
+            printf("Error: the native path allocates once warmed up\n");
+            return -1;
+        }
+    }
+
+    frame_source_destroy(source);
+    gpio_input_destroy(replay.input);
+    gpio_output_destroy(replay.output);
+    if (pipelined) {
+        sam_pipeline_destroy(&pipeline);
+    }
+    sam_detector_destroy(&detector);
+    return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * File:   bench_downscale.c
+ * Author: Hassan
+ *
+ * Times the detector input preparation: cvResize + cvEqualizeHist, the way
+ * SAM_demo used to do it, against the fused downscale_eq kernel. The fused
+ * output is also checked against cvResize(CV_INTER_AREA) + cvEqualizeHist,
+ * which computes the same 4x4 mean, and the run fails if they differ by more
+ * than one grey level anywhere.
+ *
+ *   bench_downscale [-n iterations] [-s WxH] [source]
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <opencv2/core/core_c.h>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "frame_source.h"
+#include "downscale_eq.h"
+
+static double now_ms(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+int main(int argc, char** argv) {
+    FRAME_SOURCE_CONFIG_T config;
+    FRAME_SOURCE_T *source;
+    FRAME_T *frame;
+    IplImage header;
+    IplImage *reference, *fused;
+    const char *spec = "synthetic";
+    int iterations = 200;
+    int opt, i, x, y;
+    int max_diff = 0;
+    double t0, t_opencv, t_fused;
+
+    frame_source_config_default(&config);
+    config.pace = FRAME_SOURCE_PACE_FAST;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 's':
+                if (sscanf(optarg, "%dx%d", &config.width, &config.height) != 2) {
+                    fprintf(stderr, "usage: %s [-n iterations] [-s WxH] [source]\n", argv[0]);
+                    return -1;
+                }
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-s WxH] [source]\n", argv[0]);
+                return -1;
+        }
+    }
+    if (optind < argc) {
+        spec = argv[optind];
+    }
+    if (iterations <= 0) {
+        iterations = 1;
+    }
+
+    source = frame_source_open(spec, &config);
+    if (!source || frame_source_start(source) != 0 || frame_source_acquire(source, &frame, -1) <= 0) {
+        printf("Error: unable to read a frame from %s\n", spec);
+        return -1;
+    }
+
+    cvInitImageHeader(&header, cvSize(frame->width, frame->height), IPL_DEPTH_8U, 1, 0, 4);
+    cvSetData(&header, (void *) frame->data, frame->stride);
+    reference = cvCreateImage(cvSize(frame->width / 4, frame->height / 4), IPL_DEPTH_8U, 1);
+    fused = cvCreateImage(cvSize(frame->width / 4, frame->height / 4), IPL_DEPTH_8U, 1);
+
+    t0 = now_ms();
+    for (i = 0; i < iterations; i++) {
+        cvResize(&header, reference, CV_INTER_LINEAR);
+        cvEqualizeHist(reference, reference);
+    }
+    t_opencv = (now_ms() - t0) / iterations;
+
+    t0 = now_ms();
+    for (i = 0; i < iterations; i++) {
+        downscale_eq_4x4(frame->data, frame->stride, frame->width, frame->height,
+                (uint8_t *) fused->imageData, fused->widthStep);
+    }
+    t_fused = (now_ms() - t0) / iterations;
+
+    cvResize(&header, reference, CV_INTER_AREA);
+    cvEqualizeHist(reference, reference);
+    for (y = 0; y < fused->height; y++) {
+        const uint8_t *a = (const uint8_t *) reference->imageData + y * reference->widthStep;
+        const uint8_t *b = (const uint8_t *) fused->imageData + y * fused->widthStep;
+
+        for (x = 0; x < fused->width; x++) {
+            int d = abs(a[x] - b[x]);
+
+            if (d > max_diff) {
+                max_diff = d;
+            }
+        }
+    }
+
+    printf("%s %dx%d -> %dx%d, %d iterations, %s kernel\n", source->name, frame->width, frame->height,
+            fused->width, fused->height, iterations, downscale_eq_impl());
+    printf("  cvResize + cvEqualizeHist  %.3f ms\n", t_opencv);
+    printf("  downscale_eq_4x4           %.3f ms (%.1fx)\n", t_fused, t_fused > 0 ? t_opencv / t_fused : 0.0);
+    printf("  max difference from CV_INTER_AREA + cvEqualizeHist: %d\n", max_diff);
+
+    frame_source_release(source, frame);
+    frame_source_destroy(source);
+    cvReleaseImage(&reference);
+    cvReleaseImage(&fused);
+    if (max_diff > 1) {
+        printf("Error: fused kernel output does not match OpenCV\n");
+        return -1;
+    }
+    return 0;
+}
@@ -26,27 +26,43 @@
 #include <stdio.h>
 #include <wiringPi.h>
 
+#include "gpio_input.h"
+
 // LED Pin - wiringPi pin 0 is BCM_GPIO 17.
 
 #define	LED	0
 #define BUTTON  2  //<
-int main (void)
+
+// Mirrors the button onto the LED. Sleeps on button edges (GPIO character
+// device) instead of spinning on digitalRead; a script file as the first
+// argument replays simulated presses instead.
+
+int main (int argc, char **argv)
 {
+  GPIO_INPUT_CONFIG_T config ;
+  GPIO_INPUT_T *input ;
+  GPIO_EVENT_T event ;
+
   printf ("Raspberry Pi blink\n") ;
 
   wiringPiSetup () ;
   pinMode (LED, OUTPUT) ;
   pinMode (BUTTON, INPUT); //<
-  int input;
 
-  for (;;)
+  gpio_input_config_default (&config) ;
+  config.pins [0] = BUTTON ;
+  config.pin_count = 1 ;
+  input = gpio_input_open (argc > 1 ? argv [1] : "chip", &config) ;
+  if (!input || gpio_input_start (input) != 0)
+    return 1 ;
+
+  digitalWrite (LED, gpio_input_level (input, BUTTON)) ;
+  while (gpio_input_wait (input, &event, -1) > 0)
   {
-    input = digitalRead(BUTTON); //<
-    printf("%d ", input);
-    digitalWrite (LED, input) ;	// On
- //   delay (500) ;		// mS
-//    digitalWrite (LED, LOW) ;	// Off
- //   delay (500) ;
+    printf ("%d ", event.level) ;
+    fflush (stdout) ;
+    digitalWrite (LED, event.level) ;	// follows the button
   }
+  gpio_input_destroy (input) ;
   return 0 ;
 }
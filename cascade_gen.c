@@ -0,0 +1,163 @@
+/*
+ * File:   cascade_gen.c
+ * Author: Hassan
+ *
+ * Build-time tool: loads an OpenCV Haar cascade XML, flattens it the way
+ * haar_native_create does and writes the tables out as a C header of static
+ * const arrays, so the detector no longer parses XML at power-on.
+ *
+ *   cascade_gen name cascade.xml cascade_name.h
+ *
+ * The header defines CASCADE_<NAME>_STAGES, _NODES, _WINDOW_WIDTH and
+ * _WINDOW_HEIGHT and the arrays cascade_<name>_stages, _rect_x/y/w/h[3],
+ * _weight2[3], _tilted, _threshold, _alpha0 and _alpha1. Floats are written
+ * as hex literals so the compiled-in tables are bit-identical to the ones
+ * built from the XML at run time. See haar_cascades.c.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "haar_native.h"
+
+#define VALUES_PER_LINE 12
+
+typedef enum {
+    VALUE_INT16,
+    VALUE_INT8,
+    VALUE_UINT8
+} VALUE_TYPE_T;
+
+static const char *value_type_names[] = {"int16_t", "int8_t", "uint8_t"};
+
+static void write_row(FILE *out, const void *data, VALUE_TYPE_T type, int n) {
+    int i;
+
+    for (i = 0; i < n; i++) {
+        long v;
+
+        if (type == VALUE_INT16) {
+            v = ((const int16_t *) data)[i];
+        } else if (type == VALUE_INT8) {
+            v = ((const int8_t *) data)[i];
+        } else {
+            v = ((const uint8_t *) data)[i];
+        }
+        fprintf(out, "%s%ld,%s", i % VALUES_PER_LINE == 0 ? "        " : " ", v,
+                i % VALUES_PER_LINE == VALUES_PER_LINE - 1 || i == n - 1 ? "\n" : "");
+    }
+}
+
+/* One [3][nodes] table, one row per feature rectangle. */
+static void write_rect_table(FILE *out, const char *prefix, const char *upper, const char *field,
+        VALUE_TYPE_T type, const void *r0, const void *r1, const void *r2, int n) {
+    fprintf(out, "static const %s %s_%s[3][%s_NODES] = {\n", value_type_names[type], prefix, field, upper);
+    fprintf(out, "    {\n");
+    write_row(out, r0, type, n);
+    fprintf(out, "    }, {\n");
+    write_row(out, r1, type, n);
+    fprintf(out, "    }, {\n");
+    write_row(out, r2, type, n);
+    fprintf(out, "    }\n};\n\n");
+}
+
+static void write_floats(FILE *out, const char *prefix, const char *upper, const char *field, const float *data, int n) {
+    int i;
+
+    fprintf(out, "static const float %s_%s[%s_NODES] = {\n", prefix, field, upper);
+    for (i = 0; i < n; i++) {
+        fprintf(out, "%s%af,%s", i % 4 == 0 ? "        " : " ", data[i], i % 4 == 3 || i == n - 1 ? "\n" : "");
+    }
+    fprintf(out, "};\n\n");
+}
+
+static int write_header(FILE *out, const char *name, const char *xml, const HAAR_NATIVE_CASCADE_T *c) {
+    char prefix[64], upper[64];
+    int i;
+
+    snprintf(prefix, sizeof (prefix), "cascade_%s", name);
+    for (i = 0; prefix[i]; i++) {
+        upper[i] = (char) toupper((unsigned char) prefix[i]);
+    }
+    upper[i] = 0;
+
+    fprintf(out, "/*\n * Generated by cascade_gen from %s, do not edit.\n */\n\n", xml);
+    fprintf(out, "#ifndef %s_H\n#define %s_H\n\n", upper, upper);
+    fprintf(out, "#include \"haar_native.h\"\n\n");
+    fprintf(out, "#define %s_STAGES %d\n", upper, c->stage_count);
+    fprintf(out, "#define %s_NODES %d\n", upper, c->node_count);
+    fprintf(out, "#define %s_WINDOW_WIDTH %d\n", upper, c->orig_window.width);
+    fprintf(out, "#define %s_WINDOW_HEIGHT %d\n\n", upper, c->orig_window.height);
+
+    fprintf(out, "static const HAAR_NATIVE_STAGE_T %s_stages[%s_STAGES] = {\n", prefix, upper);
+    for (i = 0; i < c->stage_count; i++) {
+        fprintf(out, "    {%d, %d, %af},\n", c->stages[i].first, c->stages[i].count, c->stages[i].threshold);
+    }
+    fprintf(out, "};\n\n");
+
+    write_rect_table(out, prefix, upper, "rect_x", VALUE_INT16, c->rect_x[0], c->rect_x[1], c->rect_x[2], c->node_count);
+    write_rect_table(out, prefix, upper, "rect_y", VALUE_INT16, c->rect_y[0], c->rect_y[1], c->rect_y[2], c->node_count);
+    write_rect_table(out, prefix, upper, "rect_w", VALUE_INT16, c->rect_w[0], c->rect_w[1], c->rect_w[2], c->node_count);
+    write_rect_table(out, prefix, upper, "rect_h", VALUE_INT16, c->rect_h[0], c->rect_h[1], c->rect_h[2], c->node_count);
+    write_rect_table(out, prefix, upper, "weight2", VALUE_INT8, c->weight2[0], c->weight2[1], c->weight2[2], c->node_count);
+    fprintf(out, "static const uint8_t %s_tilted[%s_NODES] = {\n", prefix, upper);
+    write_row(out, c->tilted, VALUE_UINT8, c->node_count);
+    fprintf(out, "};\n\n");
+    write_floats(out, prefix, upper, "threshold", c->threshold, c->node_count);
+    write_floats(out, prefix, upper, "alpha0", c->alpha0, c->node_count);
+    write_floats(out, prefix, upper, "alpha1", c->alpha1, c->node_count);
+
+    fprintf(out, "#endif /* %s_H */\n", upper);
+    return ferror(out) ? -1 : 0;
+}
+
+int main(int argc, char** argv) {
+    CvHaarClassifierCascade *cascade;
+    HAAR_NATIVE_T *native;
+    FILE *out;
+    const char *p;
+    int status;
+
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s name cascade.xml output.h\n", argv[0]);
+        return -1;
+    }
+    for (p = argv[1]; *p; p++) {
+        if (!isalnum((unsigned char) *p) && *p != '_') {
+            printf("Error: cascade name %s is not a C identifier\n", argv[1]);
+            return -1;
+        }
+    }
+    if (strlen(argv[1]) > 40) {
+        printf("Error: cascade name %s is too long\n", argv[1]);
+        return -1;
+    }
+    cascade = (CvHaarClassifierCascade*) cvLoad(argv[2], NULL, NULL, NULL);
+    if (!cascade) {
+        printf("Error: unable to load harrcascade %s\n", argv[2]);
+        return -1;
+    }
+    native = haar_native_create(cascade);
+    if (!native) {
+        printf("Error: %s cannot be compiled in\n", argv[2]);
+        return -1;
+    }
+    out = fopen(argv[3], "w");
+    if (!out) {
+        printf("Error: unable to create %s\n", argv[3]);
+        return -1;
+    }
+    status = write_header(out, argv[1], argv[2], &native->cascade);
+    if (fclose(out) != 0 || status != 0) {
+        printf("Error: unable to write %s\n", argv[3]);
+        remove(argv[3]);
+        return -1;
+    }
+    haar_native_destroy(native);
+    cvReleaseHaarClassifierCascade(&cascade);
+    return 0;
+}
@@ -0,0 +1,197 @@
+/*
+ * File:   downscale_eq.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DOWNSCALE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DOWNSCALE_SSE2 1
+#endif
+
+#include "downscale_eq.h"
+
+/*
+ * Output pixels per vector step. Every path produces the exact rounded mean
+ * (sum + 8) >> 4 of its 4x4 block, so the SIMD and scalar results match.
+ */
+#define BLOCK_OUT 8
+
+static inline uint8_t block_mean(const uint8_t *r0, const uint8_t *r1, const uint8_t *r2, const uint8_t *r3, int x) {
+    unsigned sum = r0[x] + r0[x + 1] + r0[x + 2] + r0[x + 3]
+            + r1[x] + r1[x + 1] + r1[x + 2] + r1[x + 3]
+            + r2[x] + r2[x + 1] + r2[x + 2] + r2[x + 3]
+            + r3[x] + r3[x + 1] + r3[x + 2] + r3[x + 3];
+
+    return (uint8_t) ((sum + 8) >> 4);
+}
+
+#if DOWNSCALE_NEON
+/* 32 source columns of four rows into 8 output pixels */
+static inline uint8x8_t block8(const uint8_t *r0, const uint8_t *r1, const uint8_t *r2, const uint8_t *r3, int x) {
+    uint16x8_t lo, hi;
+    uint16x4_t q_lo, q_hi;
+
+    // pairwise sums down the four rows
+    lo = vpaddlq_u8(vld1q_u8(r0 + x));
+    lo = vpadalq_u8(lo, vld1q_u8(r1 + x));
+    lo = vpadalq_u8(lo, vld1q_u8(r2 + x));
+    lo = vpadalq_u8(lo, vld1q_u8(r3 + x));
+    hi = vpaddlq_u8(vld1q_u8(r0 + x + 16));
+    hi = vpadalq_u8(hi, vld1q_u8(r1 + x + 16));
+    hi = vpadalq_u8(hi, vld1q_u8(r2 + x + 16));
+    hi = vpadalq_u8(hi, vld1q_u8(r3 + x + 16));
+    // then pairs of pairs: one 16-pixel sum per output
+    q_lo = vpadd_u16(vget_low_u16(lo), vget_high_u16(lo));
+    q_hi = vpadd_u16(vget_low_u16(hi), vget_high_u16(hi));
+    return vrshrn_n_u16(vcombine_u16(q_lo, q_hi), 4);
+}
+#elif DOWNSCALE_SSE2
+/* 16 source columns of four rows into 4 block sums */
+static inline __m128i block4(const uint8_t *r0, const uint8_t *r1, const uint8_t *r2, const uint8_t *r3, int x) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i a = _mm_loadu_si128((const __m128i *) (r0 + x));
+    __m128i b = _mm_loadu_si128((const __m128i *) (r1 + x));
+    __m128i c = _mm_loadu_si128((const __m128i *) (r2 + x));
+    __m128i d = _mm_loadu_si128((const __m128i *) (r3 + x));
+    __m128i lo, hi, pairs;
+
+    lo = _mm_add_epi16(_mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+            _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+    hi = _mm_add_epi16(_mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+            _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+    // column sums are at most 1020, pair sums 2040: both fit the signed madd
+    pairs = _mm_packs_epi32(_mm_madd_epi16(lo, ones), _mm_madd_epi16(hi, ones));
+    return _mm_madd_epi16(pairs, ones);
+}
+
+static inline __m128i block8(const uint8_t *r0, const uint8_t *r1, const uint8_t *r2, const uint8_t *r3, int x) {
+    __m128i sums = _mm_packs_epi32(block4(r0, r1, r2, r3, x), block4(r0, r1, r2, r3, x + 16));
+
+    sums = _mm_srli_epi16(_mm_add_epi16(sums, _mm_set1_epi16(8)), 4);
+    return _mm_packus_epi16(sums, sums);
+}
+#endif
+
+void downscale_4x4_hist(const uint8_t *src, int src_stride, int src_width, int src_height,
+        uint8_t *dst, int dst_stride, uint32_t hist[256]) {
+    // four interleaved histograms so back-to-back equal pixels do not
+    // serialise on the same counter
+    uint32_t h[4][256];
+    int width = src_width / 4;
+    int height = src_height / 4;
+    int x, y, i;
+
+    memset(h, 0, sizeof (h));
+    for (y = 0; y < height; y++) {
+        const uint8_t *r0 = src + (size_t) (y * 4) * src_stride;
+        const uint8_t *r1 = r0 + src_stride;
+        const uint8_t *r2 = r1 + src_stride;
+        const uint8_t *r3 = r2 + src_stride;
+        uint8_t *out = dst + (size_t) y * dst_stride;
+
+        x = 0;
+#if DOWNSCALE_NEON || DOWNSCALE_SSE2
+        for (; x + BLOCK_OUT <= width; x += BLOCK_OUT) {
+#if DOWNSCALE_NEON
+            vst1_u8(out + x, block8(r0, r1, r2, r3, x * 4));
+#else
+            _mm_storel_epi64((__m128i *) (out + x), block8(r0, r1, r2, r3, x * 4));
+#endif
+            h[0][out[x]]++;
+            h[1][out[x + 1]]++;
+            h[2][out[x + 2]]++;
+            h[3][out[x + 3]]++;
+            h[0][out[x + 4]]++;
+            h[1][out[x + 5]]++;
+            h[2][out[x + 6]]++;
+            h[3][out[x + 7]]++;
+        }
+#endif
+        for (; x < width; x++) {
+            out[x] = block_mean(r0, r1, r2, r3, x * 4);
+            h[x & 3][out[x]]++;
+        }
+    }
+
+    for (i = 0; i < 256; i++) {
+        hist[i] = h[0][i] + h[1][i] + h[2][i] + h[3][i];
+    }
+}
+
+/* Same mapping as cvEqualizeHist: the lowest occupied bin goes to 0, the CDF above it is stretched to 255. */
+void equalize_lut(const uint32_t hist[256], uint32_t total, uint8_t lut[256]) {
+    uint32_t sum = 0;
+    float scale;
+    int i = 0;
+
+    while (i < 255 && !hist[i]) {
+        i++;
+    }
+    if (hist[i] == total) {
+        memset(lut, i, 256);
+        return;
+    }
+    scale = 255.0f / (float) (total - hist[i]);
+    memset(lut, 0, i + 1);
+    for (i++; i < 256; i++) {
+        int v;
+
+        sum += hist[i];
+        v = (int) (sum * scale + 0.5f);
+        lut[i] = (uint8_t) (v > 255 ? 255 : v);
+    }
+}
+
+void apply_lut(uint8_t *img, int stride, int width, int height, const uint8_t lut[256]) {
+    int x, y;
+
+    for (y = 0; y < height; y++) {
+        uint8_t *row = img + (size_t) y * stride;
+
+        for (x = 0; x + 4 <= width; x += 4) {
+            uint8_t a = lut[row[x]], b = lut[row[x + 1]], c = lut[row[x + 2]], d = lut[row[x + 3]];
+
+            row[x] = a;
+            row[x + 1] = b;
+            row[x + 2] = c;
+            row[x + 3] = d;
+        }
+        for (; x < width; x++) {
+            row[x] = lut[row[x]];
+        }
+    }
+}
+
+void downscale_eq_4x4(const uint8_t *src, int src_stride, int src_width, int src_height,
+        uint8_t *dst, int dst_stride) {
+    uint32_t hist[256];
+    uint8_t lut[256];
+    int width = src_width / 4;
+    int height = src_height / 4;
+
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+    downscale_4x4_hist(src, src_stride, src_width, src_height, dst, dst_stride, hist);
+    equalize_lut(hist, (uint32_t) width * height, lut);
+    // the LUT pass only touches the 1/16 size output, which is still in cache
+    apply_lut(dst, dst_stride, width, height, lut);
+}
+
+const char *downscale_eq_impl(void) {
+#if DOWNSCALE_NEON
+    return "neon";
+#elif DOWNSCALE_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
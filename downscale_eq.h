@@ -0,0 +1,34 @@
+/*
+ * File:   downscale_eq.h
+ * Author: Hassan
+ *
+ * Detector input preparation in one pass over the camera's Y plane: 4x4 area
+ * average straight from the plane at its native stride, histogram built while
+ * the output is written, then the equalisation LUT applied to the small image.
+ * Replaces cvResize(CV_INTER_LINEAR) followed by cvEqualizeHist.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef DOWNSCALE_EQ_H
+#define DOWNSCALE_EQ_H
+
+#include <stdint.h>
+
+/*
+ * dst is (src_width / 4) x (src_height / 4). Source columns and rows past the
+ * last full 4x4 block are ignored.
+ */
+void downscale_eq_4x4(const uint8_t *src, int src_stride, int src_width, int src_height,
+        uint8_t *dst, int dst_stride);
+
+/* The two halves on their own, for callers that need the histogram. */
+void downscale_4x4_hist(const uint8_t *src, int src_stride, int src_width, int src_height,
+        uint8_t *dst, int dst_stride, uint32_t hist[256]);
+void equalize_lut(const uint32_t hist[256], uint32_t total, uint8_t lut[256]);
+void apply_lut(uint8_t *img, int stride, int width, int height, const uint8_t lut[256]);
+
+/* "neon", "sse2" or "scalar", whichever this build uses. */
+const char *downscale_eq_impl(void);
+
+#endif /* DOWNSCALE_EQ_H */
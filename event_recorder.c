@@ -0,0 +1,328 @@
+/*
+ * File:   event_recorder.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "event_recorder.h"
+#include "sys_util.h"
+
+#define IDLE_WAIT_MS 1000 // between clips only a trigger wakes the writer, this is a backstop
+
+void event_recorder_config_default(EVENT_RECORDER_CONFIG_T *config) {
+    memset(config, 0, sizeof (EVENT_RECORDER_CONFIG_T));
+    config->dir = ".";
+    config->ring_size = 8 << 20; // 30 s of 2 Mbit/s
+    config->pre_seconds = 10;
+    config->post_seconds = 10;
+}
+
+static H264_WRITER_CHUNK_T *unit_at(EVENT_RECORDER_T *recorder, uint32_t index) {
+    return &recorder->unit[index & (EVENT_RECORDER_UNITS - 1)];
+}
+
+/* Writer thread only, down to writer_thread. */
+static void open_clip(EVENT_RECORDER_T *recorder) {
+    char name[512], stamp[32];
+    time_t wall = time(NULL);
+    struct tm tm;
+
+    localtime_r(&wall, &tm);
+    strftime(stamp, sizeof (stamp), "%Y%m%d-%H%M%S", &tm);
+    snprintf(name, sizeof (name), "%s/event-%04u-%s.h264", recorder->config.dir, recorder->stats.clips, stamp);
+    recorder->fd = open(name, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (recorder->fd < 0) {
+        fprintf(stderr, "Error: event_recorder: unable to open %s: %s\n", name, strerror(errno));
+    }
+}
+
+static void close_clip(EVENT_RECORDER_T *recorder) {
+    if (recorder->fd >= 0) {
+        // a clip is the evidence, it has to survive the power going off right after
+        fdatasync(recorder->fd);
+        close(recorder->fd);
+        recorder->fd = -1;
+    }
+    __atomic_add_fetch(&recorder->stats.clips, 1, __ATOMIC_RELAXED);
+}
+
+static void write_out(EVENT_RECORDER_T *recorder, const uint8_t *data, uint32_t length) {
+    uint64_t t0 = now_ns();
+    uint32_t ms;
+    size_t n = recorder->fd >= 0 ? write_all(recorder->fd, data, length) : 0;
+
+    __atomic_add_fetch(&recorder->stats.bytes_written, (uint64_t) n, __ATOMIC_RELAXED);
+    if (n < length) {
+        __atomic_add_fetch(&recorder->stats.write_errors, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&recorder->stats.bytes_dropped, length - n, __ATOMIC_RELAXED);
+    }
+    ms = (uint32_t) ((now_ns() - t0) / 1000000);
+    if (ms > __atomic_load_n(&recorder->stats.max_write_ms, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&recorder->stats.max_write_ms, ms, __ATOMIC_RELAXED);
+    }
+}
+
+/* Writes the open clip up to what has been pushed; 1 once it is complete. */
+static int write_clip(EVENT_RECORDER_T *recorder) {
+    // newest before recording: while the clip still records, every unit below newest is in it
+    uint32_t newest = __atomic_load_n(&recorder->newest, __ATOMIC_ACQUIRE);
+    int recording = __atomic_load_n(&recorder->recording, __ATOMIC_ACQUIRE);
+    uint32_t end = recording ? newest : __atomic_load_n(&recorder->clip_end, __ATOMIC_ACQUIRE);
+    uint32_t ring_size = recorder->ring_mask + 1;
+    uint32_t from, to, at, first;
+    H264_WRITER_CHUNK_T *last;
+
+    if (recorder->cursor != end) {
+        // units follow each other in the ring, the clip so far is one run of bytes
+        last = unit_at(recorder, end - 1);
+        from = unit_at(recorder, recorder->cursor)->start;
+        to = last->start + last->length;
+        at = from & recorder->ring_mask;
+        first = ring_size - at < to - from ? ring_size - at : to - from;
+        write_out(recorder, recorder->ring + at, first);
+        if (first < to - from) {
+            write_out(recorder, recorder->ring, to - from - first);
+        }
+        __atomic_store_n(&recorder->cursor, end, __ATOMIC_RELEASE);
+    }
+    return !recording;
+}
+
+static void *writer_thread(void *arg) {
+    EVENT_RECORDER_T *recorder = (EVENT_RECORDER_T *) arg;
+    uint32_t seq;
+
+    while (!__atomic_load_n(&recorder->stop, __ATOMIC_ACQUIRE) || __atomic_load_n(&recorder->busy, __ATOMIC_ACQUIRE)) {
+        seq = __atomic_load_n(&recorder->clip_seq, __ATOMIC_ACQUIRE);
+        if (!__atomic_load_n(&recorder->busy, __ATOMIC_ACQUIRE)) {
+            futex_wait(&recorder->clip_seq, seq, IDLE_WAIT_MS);
+            continue;
+        }
+        if (recorder->fd < 0) {
+            open_clip(recorder);
+        }
+        if (write_clip(recorder)) {
+            close_clip(recorder);
+            __atomic_store_n(&recorder->busy, 0, __ATOMIC_RELEASE);
+            continue;
+        }
+        futex_wait(&recorder->clip_seq, seq, EVENT_RECORDER_FLUSH_MS);
+    }
+    return NULL;
+}
+
+int event_recorder_init(EVENT_RECORDER_T *recorder, const EVENT_RECORDER_CONFIG_T *config) {
+    size_t ring_size = 4096;
+
+    memset(recorder, 0, sizeof (EVENT_RECORDER_T));
+    recorder->config = *config;
+    while (ring_size < config->ring_size) {
+        ring_size <<= 1;
+    }
+    if (ring_size > (1u << 30)) {
+        fprintf(stderr, "Error: event_recorder: ring of %zu bytes is too large\n", config->ring_size);
+        return -1;
+    }
+    recorder->config.ring_size = ring_size;
+    // all of it now, and touched, so memory use does not move once recording
+    recorder->ring = (uint8_t *) malloc(ring_size);
+    if (!recorder->ring) {
+        fprintf(stderr, "Error: event_recorder: no memory for a %zu byte ring\n", ring_size);
+        return -1;
+    }
+    memset(recorder->ring, 0, ring_size);
+    recorder->ring_mask = (uint32_t) ring_size - 1;
+    h264_split_init(&recorder->split);
+    // the ring starts at an SPS/PPS or IDR
+    recorder->skipping = 1;
+    recorder->fd = -1;
+    if (pthread_create(&recorder->thread, NULL, writer_thread, recorder) != 0) {
+        fprintf(stderr, "Error: event_recorder: unable to start the writer thread\n");
+        free(recorder->ring);
+        recorder->ring = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+static void end_clip(EVENT_RECORDER_T *recorder) {
+    __atomic_store_n(&recorder->clip_end, recorder->newest, __ATOMIC_RELEASE);
+    __atomic_store_n(&recorder->recording, 0, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&recorder->clip_seq, 1, __ATOMIC_RELEASE);
+    futex_wake(&recorder->clip_seq);
+}
+
+void event_recorder_destroy(EVENT_RECORDER_T *recorder) {
+    if (!recorder->ring) {
+        return;
+    }
+    if (recorder->recording) {
+        end_clip(recorder);
+    }
+    __atomic_store_n(&recorder->stop, 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&recorder->clip_seq, 1, __ATOMIC_RELEASE);
+    futex_wake(&recorder->clip_seq);
+    pthread_join(recorder->thread, NULL);
+    free(recorder->ring);
+    recorder->ring = NULL;
+}
+
+void event_recorder_trigger(EVENT_RECORDER_T *recorder) {
+    __atomic_store_n(&recorder->trigger_ns, now_ns(), __ATOMIC_RELAXED);
+    __atomic_add_fetch(&recorder->stats.triggers, 1, __ATOMIC_RELAXED);
+}
+
+/* Producer only, from here on. */
+static void open_or_extend(EVENT_RECORDER_T *recorder) {
+    uint64_t trigger = __atomic_exchange_n(&recorder->trigger_ns, 0, __ATOMIC_RELAXED);
+    uint64_t expected = 0;
+
+    if (!trigger) {
+        return;
+    }
+    if (recorder->recording) {
+        recorder->post_until_ns = trigger + (uint64_t) recorder->config.post_seconds * 1000000000ull;
+        return;
+    }
+    if (__atomic_load_n(&recorder->busy, __ATOMIC_ACQUIRE)) {
+        // the last clip is still being written out, this one opens once it is closed
+        __atomic_compare_exchange_n(&recorder->trigger_ns, &expected, trigger, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        return;
+    }
+    recorder->post_until_ns = trigger + (uint64_t) recorder->config.post_seconds * 1000000000ull;
+    recorder->clip_trigger_ns = trigger;
+    __atomic_store_n(&recorder->stats.pre_ms, recorder->oldest != recorder->newest
+            ? (uint32_t) ((trigger - unit_at(recorder, recorder->oldest)->time_ns) / 1000000) : 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&recorder->cursor, recorder->oldest, __ATOMIC_RELAXED);
+    __atomic_store_n(&recorder->recording, 1, __ATOMIC_RELAXED);
+    __atomic_store_n(&recorder->busy, 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&recorder->clip_seq, 1, __ATOMIC_RELEASE);
+    futex_wake(&recorder->clip_seq);
+}
+
+/* The next split after oldest, or newest when the ring is one group of pictures. */
+static uint32_t next_split(EVENT_RECORDER_T *recorder) {
+    uint32_t i;
+
+    for (i = recorder->oldest + 1; i != recorder->newest; i++) {
+        if (unit_at(recorder, i)->split) {
+            break;
+        }
+    }
+    return i;
+}
+
+/* Drops the oldest group of pictures, unless the open clip has not been written that far. */
+static int evict(EVENT_RECORDER_T *recorder, uint32_t next) {
+    if (__atomic_load_n(&recorder->busy, __ATOMIC_ACQUIRE)
+            && (int32_t) (next - __atomic_load_n(&recorder->cursor, __ATOMIC_ACQUIRE)) > 0) {
+        return 0;
+    }
+    recorder->oldest = next;
+    return 1;
+}
+
+static uint32_t ring_used(EVENT_RECORDER_T *recorder) {
+    return recorder->oldest == recorder->newest ? 0 : recorder->tail - unit_at(recorder, recorder->oldest)->start;
+}
+
+static void drop(EVENT_RECORDER_T *recorder, size_t length) {
+    recorder->skipping = 1;
+    __atomic_add_fetch(&recorder->stats.units_dropped, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&recorder->stats.bytes_dropped, (uint64_t) length, __ATOMIC_RELAXED);
+}
+
+int event_recorder_push(EVENT_RECORDER_T *recorder, const uint8_t *data, size_t length, int flags) {
+    uint32_t ring_size = recorder->ring_mask + 1;
+    uint64_t now = now_ns();
+    uint64_t pre_ns = (uint64_t) recorder->config.pre_seconds * 1000000000ull;
+    uint32_t next, at, first;
+    H264_WRITER_CHUNK_T *u;
+    int starts_picture = recorder->split.frame_start;
+    int split = h264_split_check(&recorder->split, flags);
+
+    // a clip ends between pictures
+    if (recorder->recording && starts_picture && now >= recorder->post_until_ns) {
+        end_clip(recorder);
+    }
+    open_or_extend(recorder);
+    if (length == 0) {
+        return 0;
+    }
+    if (length > ring_size / 2 || (recorder->skipping && !split)) {
+        drop(recorder, length);
+        return -1;
+    }
+
+    // groups of pictures older than the pre-trigger window go, the newest one before it stays
+    while (recorder->oldest != recorder->newest) {
+        next = next_split(recorder);
+        if (next == recorder->newest || unit_at(recorder, next)->time_ns + pre_ns > now || !evict(recorder, next)) {
+            break;
+        }
+    }
+    // and more while the new buffer does not fit
+    while (recorder->oldest != recorder->newest && (ring_used(recorder) + length > ring_size
+            || recorder->newest - recorder->oldest == EVENT_RECORDER_UNITS)) {
+        if (!evict(recorder, next_split(recorder))) {
+            break;
+        }
+    }
+    if (ring_used(recorder) + length > ring_size || recorder->newest - recorder->oldest == EVENT_RECORDER_UNITS
+            || (recorder->oldest == recorder->newest && !split)) {
+        drop(recorder, length);
+        return -1;
+    }
+    recorder->skipping = 0;
+
+    at = recorder->tail & recorder->ring_mask;
+    first = ring_size - at < length ? ring_size - at : (uint32_t) length;
+    memcpy(recorder->ring + at, data, first);
+    memcpy(recorder->ring, data + first, length - first);
+    u = unit_at(recorder, recorder->newest);
+    u->start = recorder->tail;
+    u->length = (uint32_t) length;
+    u->time_ns = now;
+    u->split = split;
+    recorder->tail += (uint32_t) length;
+    __atomic_store_n(&recorder->newest, recorder->newest + 1, __ATOMIC_RELEASE);
+
+    __atomic_store_n(&recorder->stats.ring_bytes, ring_used(recorder), __ATOMIC_RELAXED);
+    __atomic_store_n(&recorder->stats.ring_ms, (uint32_t) ((now - unit_at(recorder, recorder->oldest)->time_ns) / 1000000),
+            __ATOMIC_RELAXED);
+    return 0;
+}
+
+void event_recorder_get_stats(EVENT_RECORDER_T *recorder, EVENT_RECORDER_STATS_T *stats) {
+    EVENT_RECORDER_STATS_T *s = &recorder->stats;
+
+    stats->clips = __atomic_load_n(&s->clips, __ATOMIC_RELAXED);
+    stats->triggers = __atomic_load_n(&s->triggers, __ATOMIC_RELAXED);
+    stats->bytes_written = __atomic_load_n(&s->bytes_written, __ATOMIC_RELAXED);
+    stats->units_dropped = __atomic_load_n(&s->units_dropped, __ATOMIC_RELAXED);
+    stats->bytes_dropped = __atomic_load_n(&s->bytes_dropped, __ATOMIC_RELAXED);
+    stats->write_errors = __atomic_load_n(&s->write_errors, __ATOMIC_RELAXED);
+    stats->max_write_ms = __atomic_load_n(&s->max_write_ms, __ATOMIC_RELAXED);
+    stats->pre_ms = __atomic_load_n(&s->pre_ms, __ATOMIC_RELAXED);
+    stats->ring_ms = __atomic_load_n(&s->ring_ms, __ATOMIC_RELAXED);
+    stats->ring_bytes = __atomic_load_n(&s->ring_bytes, __ATOMIC_RELAXED);
+}
+
+void event_recorder_print_stats(EVENT_RECORDER_T *recorder) {
+    EVENT_RECORDER_STATS_T s;
+
+    event_recorder_get_stats(recorder, &s);
+    fprintf(stderr, "event_recorder: %u clips from %u triggers, %.1f MB written, %u ms before the last trigger, "
+            "ring %u ms %u bytes, %u buffers %llu bytes dropped, %u write errors, longest write %u ms\n",
+            s.clips, s.triggers, s.bytes_written / 1048576.0, s.pre_ms, s.ring_ms, s.ring_bytes,
+            s.units_dropped, (unsigned long long) s.bytes_dropped, s.write_errors, s.max_write_ms);
+}
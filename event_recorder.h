@@ -0,0 +1,95 @@
+/*
+ * File:   event_recorder.h
+ * Author: Hassan
+ *
+ * Video of the seconds around an alarm, without recording all day. The
+ * encoder output is pushed buffer by buffer into a fixed ring in memory
+ * that always starts at an SPS/PPS or IDR; whole groups of pictures fall
+ * off the front once they are older than pre_seconds, or when the ring is
+ * full. event_recorder_trigger makes a clip: a writer thread writes the
+ * ring out from its first IDR to dir/event-NNNN-YYYYmmdd-HHMMSS.h264, and
+ * keeps appending until post_seconds after the last trigger. Nothing is
+ * allocated after init and nothing touches the card between clips.
+ *
+ * While a clip is written the ring cannot drop what the writer has not
+ * reached yet; a buffer that does not fit then is dropped and counted,
+ * with the rest of its group of pictures. Buffers come from one thread,
+ * triggers and stats from any.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef EVENT_RECORDER_H
+#define EVENT_RECORDER_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "h264_writer.h" // the buffer flags, the chunk and split tracking
+
+#define EVENT_RECORDER_UNITS 4096 // buffers the ring holds at most, power of two
+#define EVENT_RECORDER_FLUSH_MS 100 // how often the writer looks while a clip is open
+
+typedef struct {
+    const char *dir;
+    size_t ring_size; // bytes, rounded up to a power of two
+    int pre_seconds; // kept ahead of a trigger, as far as the ring allows
+    int post_seconds; // recorded after the last trigger
+} EVENT_RECORDER_CONFIG_T;
+
+typedef struct {
+    uint32_t clips;
+    uint32_t triggers;
+    uint64_t bytes_written;
+    uint32_t units_dropped;
+    uint64_t bytes_dropped;
+    uint32_t write_errors; // their bytes are counted as dropped
+    uint32_t max_write_ms;
+    uint32_t pre_ms; // video ahead of the trigger in the last clip
+    uint32_t ring_ms; // video in the ring now
+    uint32_t ring_bytes;
+} EVENT_RECORDER_STATS_T;
+
+typedef struct {
+    EVENT_RECORDER_CONFIG_T config;
+    uint8_t *ring;
+    uint32_t ring_mask;
+    H264_WRITER_CHUNK_T unit[EVENT_RECORDER_UNITS];
+    uint32_t oldest; // first unit kept, always a split; producer owned
+    uint32_t newest; // one past the last unit
+    uint32_t tail; // producer: ring position after the newest unit
+    H264_SPLIT_T split; // producer
+    int skipping; // producer: dropping up to the next split
+    uint64_t trigger_ns; // last trigger not taken up yet, any thread
+    uint64_t post_until_ns; // producer
+    int recording; // producer: the open clip still takes new units
+    int busy; // a clip is open until the writer has closed it
+    uint32_t cursor; // next unit to write
+    uint32_t clip_end; // unit the open clip ends at, once it is known
+    uint32_t clip_seq; // bumped when a clip opens, futex for the writer as well
+    uint64_t clip_trigger_ns;
+    int fd;
+    pthread_t thread;
+    int stop;
+    EVENT_RECORDER_STATS_T stats;
+} EVENT_RECORDER_T;
+
+void event_recorder_config_default(EVENT_RECORDER_CONFIG_T *config);
+
+/* Allocates the ring and starts the writer thread. */
+int event_recorder_init(EVENT_RECORDER_T *recorder, const EVENT_RECORDER_CONFIG_T *config);
+
+/* Finishes an open clip with what is in the ring, and stops the thread. */
+void event_recorder_destroy(EVENT_RECORDER_T *recorder);
+
+/* One encoder buffer, flags as for h264_writer_push; 0, or -1 when it was dropped. */
+int event_recorder_push(EVENT_RECORDER_T *recorder, const uint8_t *data, size_t length, int flags);
+
+/* Opens a clip, or keeps the open one going; cheap enough for every frame of an alarm. */
+void event_recorder_trigger(EVENT_RECORDER_T *recorder);
+
+void event_recorder_get_stats(EVENT_RECORDER_T *recorder, EVENT_RECORDER_STATS_T *stats);
+void event_recorder_print_stats(EVENT_RECORDER_T *recorder);
+
+#endif /* EVENT_RECORDER_H */
@@ -0,0 +1,153 @@
+/*
+ * File:   face_tracker.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <math.h>
+
+#include "face_tracker.h"
+
+void face_tracker_init(FACE_TRACKER_T *tracker, int interval, float min_confidence) {
+    tracker->active = 0;
+    tracker->interval = interval;
+    tracker->min_confidence = min_confidence;
+    tracker->radius = FACE_TRACKER_RADIUS;
+    tracker->frames_since_detect = 0;
+    tracker->confidence = 0;
+    tracker->rect = cvRect(0, 0, 0, 0);
+}
+
+int face_tracker_need_detect(const FACE_TRACKER_T *tracker) {
+    return !tracker->active || tracker->interval <= 0 || tracker->frames_since_detect >= tracker->interval;
+}
+
+void face_tracker_start(FACE_TRACKER_T *tracker, const IplImage *image, const CvRect *face) {
+    const uint8_t *base = (const uint8_t *) image->imageData;
+    int64_t sum = 0, sq = 0;
+    int side = face->width > face->height ? face->width : face->height;
+    int n, i, j;
+
+    tracker->frames_since_detect = 0;
+    if (tracker->interval <= 0 || face->width < 2 || face->height < 2) {
+        tracker->active = 0;
+        return;
+    }
+    tracker->step = (side + FACE_TRACKER_MAX_SIDE - 1) / FACE_TRACKER_MAX_SIDE;
+    if (tracker->step < 2) {
+        tracker->step = 2;
+    }
+    tracker->tw = face->width / tracker->step;
+    tracker->th = face->height / tracker->step;
+    for (j = 0; j < tracker->th; j++) {
+        const uint8_t *row = base + (face->y + j * tracker->step) * image->widthStep + face->x;
+        uint8_t *t = tracker->templ + j * tracker->tw;
+
+        for (i = 0; i < tracker->tw; i++) {
+            t[i] = row[i * tracker->step];
+            sum += t[i];
+            sq += t[i] * t[i];
+        }
+    }
+    n = tracker->tw * tracker->th;
+    tracker->t_sum = sum;
+    tracker->t_norm = sqrt((double) (n * sq - sum * sum));
+    tracker->rect = *face;
+    tracker->confidence = 1.0f;
+    // a flat template matches anything, keep detecting instead
+    tracker->active = tracker->t_norm > 0;
+}
+
+void face_tracker_stop(FACE_TRACKER_T *tracker) {
+    tracker->active = 0;
+}
+
+/* NCC of the template placed with its top-left corner at (x, y). */
+static float match_at(const FACE_TRACKER_T *tracker, const IplImage *image, int x, int y) {
+    const uint8_t *base = (const uint8_t *) image->imageData;
+    int step = tracker->step;
+    int64_t n = tracker->tw * tracker->th;
+    int64_t si = 0, sii = 0, sit = 0;
+    double den;
+    int i, j;
+
+    for (j = 0; j < tracker->th; j++) {
+        const uint8_t *row = base + (y + j * step) * image->widthStep + x;
+        const uint8_t *t = tracker->templ + j * tracker->tw;
+        uint32_t rs = 0, rss = 0, rst = 0; // one row cannot overflow 32 bits
+
+        for (i = 0; i < tracker->tw; i++) {
+            uint32_t p = row[i * step];
+
+            rs += p;
+            rss += p * p;
+            rst += p * t[i];
+        }
+        si += rs;
+        sii += rss;
+        sit += rst;
+    }
+    den = sqrt((double) (n * sii - si * si)) * tracker->t_norm;
+    if (den <= 0) {
+        return 0;
+    }
+    return (float) ((n * sit - si * tracker->t_sum) / den);
+}
+
+int face_tracker_update(FACE_TRACKER_T *tracker, const IplImage *image, CvRect *face) {
+    int x0 = tracker->rect.x, y0 = tracker->rect.y;
+    int max_x = image->width - tracker->rect.width;
+    int max_y = image->height - tracker->rect.height;
+    int best_x = x0, best_y = y0;
+    float best = -2.0f;
+    int cx, cy, x, y;
+
+    if (!tracker->active) {
+        return 0;
+    }
+    // coarse pass on a 2 pixel grid, then the 8 neighbours of the best
+    for (y = y0 - tracker->radius; y <= y0 + tracker->radius; y += 2) {
+        for (x = x0 - tracker->radius; x <= x0 + tracker->radius; x += 2) {
+            float score;
+
+            if (x < 0 || y < 0 || x > max_x || y > max_y) {
+                continue;
+            }
+            score = match_at(tracker, image, x, y);
+            if (score > best) {
+                best = score;
+                best_x = x;
+                best_y = y;
+            }
+        }
+    }
+    cx = best_x;
+    cy = best_y;
+    for (y = cy - 1; y <= cy + 1; y++) {
+        for (x = cx - 1; x <= cx + 1; x++) {
+            float score;
+
+            if ((x == cx && y == cy) || x < 0 || y < 0 || x > max_x || y > max_y) {
+                continue;
+            }
+            score = match_at(tracker, image, x, y);
+            if (score > best) {
+                best = score;
+                best_x = x;
+                best_y = y;
+            }
+        }
+    }
+
+    tracker->frames_since_detect++;
+    tracker->confidence = best;
+    if (best < tracker->min_confidence) {
+        tracker->active = 0;
+        return 0;
+    }
+    tracker->rect.x = best_x;
+    tracker->rect.y = best_y;
+    *face = tracker->rect;
+    return 1;
+}
@@ -0,0 +1,59 @@
+/*
+ * File:   face_tracker.h
+ * Author: Hassan
+ *
+ * Follows the driver's face between full Haar detections with normalised
+ * cross-correlation on the detector image. The template is taken from the
+ * last detection, subsampled to at most FACE_TRACKER_MAX_SIDE points a side,
+ * and matched in a small window around the previous position.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef FACE_TRACKER_H
+#define FACE_TRACKER_H
+
+#include <stdint.h>
+
+#include <opencv2/core/core_c.h>
+
+#define FACE_TRACKER_MAX_SIDE 80
+#define FACE_TRACKER_RADIUS 8 // search window half size in detector pixels
+#define FACE_TRACKER_INTERVAL 5 // frames between full detections
+#define FACE_TRACKER_MIN_CONFIDENCE 0.7f
+
+typedef struct {
+    int active;
+    int interval; // 0 disables tracking, every frame is a detection
+    float min_confidence;
+    int radius;
+    int frames_since_detect;
+    float confidence; // NCC score of the last match, 1 right after a detection
+    CvRect rect;
+    int step; // template sampling step in image pixels
+    int tw; // template size in samples
+    int th;
+    int64_t t_sum;
+    double t_norm; // sqrt(n * sum(T^2) - sum(T)^2)
+    uint8_t templ[FACE_TRACKER_MAX_SIDE * FACE_TRACKER_MAX_SIDE];
+} FACE_TRACKER_T;
+
+void face_tracker_init(FACE_TRACKER_T *tracker, int interval, float min_confidence);
+
+/* 1 when the next frame needs a full detection. */
+int face_tracker_need_detect(const FACE_TRACKER_T *tracker);
+
+/* Takes a new template from a fresh detection. */
+void face_tracker_start(FACE_TRACKER_T *tracker, const IplImage *image, const CvRect *face);
+
+/* Stops tracking, the next frame runs the detector. */
+void face_tracker_stop(FACE_TRACKER_T *tracker);
+
+/*
+ * Looks for the face near its last position. Returns 1 and the new rectangle
+ * when the match is at least min_confidence, otherwise stops tracking and
+ * returns 0.
+ */
+int face_tracker_update(FACE_TRACKER_T *tracker, const IplImage *image, CvRect *face);
+
+#endif /* FACE_TRACKER_H */
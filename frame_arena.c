@@ -0,0 +1,66 @@
+/*
+ * File:   frame_arena.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "frame_arena.h"
+
+int frame_arena_init(FRAME_ARENA_T *arena, size_t size) {
+    size = (size + FRAME_ARENA_ALIGN - 1) & ~(size_t) (FRAME_ARENA_ALIGN - 1);
+    arena->used = 0;
+    arena->high_water = 0;
+    arena->overflows = 0;
+    arena->size = 0;
+    if (posix_memalign((void **) &arena->base, FRAME_ARENA_ALIGN, size) != 0) {
+        arena->base = NULL;
+        fprintf(stderr, "Error: unable to allocate %zu byte frame arena\n", size);
+        return -1;
+    }
+    arena->size = size;
+    return 0;
+}
+
+void frame_arena_destroy(FRAME_ARENA_T *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->size = 0;
+    arena->used = 0;
+}
+
+void *frame_arena_alloc(FRAME_ARENA_T *arena, size_t size) {
+    void *p;
+
+    size = (size + FRAME_ARENA_ALIGN - 1) & ~(size_t) (FRAME_ARENA_ALIGN - 1);
+    if (size > arena->size - arena->used) {
+        arena->overflows++;
+        return NULL;
+    }
+    p = arena->base + arena->used;
+    arena->used += size;
+    return p;
+}
+
+size_t frame_arena_mark(const FRAME_ARENA_T *arena) {
+    return arena->used;
+}
+
+void frame_arena_rewind(FRAME_ARENA_T *arena, size_t mark) {
+    if (arena->used > arena->high_water) {
+        arena->high_water = arena->used;
+    }
+    if (mark < arena->used) {
+        arena->used = mark;
+    }
+}
+
+void frame_arena_reset(FRAME_ARENA_T *arena) {
+    if (arena->used > arena->high_water) {
+        arena->high_water = arena->used;
+    }
+    arena->used = 0;
+}
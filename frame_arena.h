@@ -0,0 +1,41 @@
+/*
+ * File:   frame_arena.h
+ * Author: Hassan
+ *
+ * Bump allocator for per-frame scratch memory. Everything allocated during a
+ * frame is dropped at once by frame_arena_reset, so the detection loop does
+ * no heap allocation once it is running.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define FRAME_ARENA_ALIGN 16
+
+typedef struct {
+    uint8_t *base;
+    size_t size;
+    size_t used;
+    size_t high_water; // largest 'used' seen at a reset
+    uint32_t overflows; // allocations refused since init
+} FRAME_ARENA_T;
+
+int frame_arena_init(FRAME_ARENA_T *arena, size_t size);
+void frame_arena_destroy(FRAME_ARENA_T *arena);
+
+/* Returns FRAME_ARENA_ALIGN aligned memory, or NULL when the arena is full. */
+void *frame_arena_alloc(FRAME_ARENA_T *arena, size_t size);
+
+/* Scoped scratch inside a frame: rewind drops what was allocated after mark. */
+size_t frame_arena_mark(const FRAME_ARENA_T *arena);
+void frame_arena_rewind(FRAME_ARENA_T *arena, size_t mark);
+
+/* Frees everything allocated since the previous reset. */
+void frame_arena_reset(FRAME_ARENA_T *arena);
+
+#endif /* FRAME_ARENA_H */
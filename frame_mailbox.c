@@ -0,0 +1,101 @@
+/*
+ * File:   frame_mailbox.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "frame_mailbox.h"
+#include "sys_util.h"
+
+#define FRAME_MAILBOX_FRESH 0x80u
+#define FRAME_MAILBOX_INDEX 0x03u
+
+static void release_slot(FRAME_MAILBOX_T *mailbox, FRAME_T *frame) {
+    if (frame->handle) {
+        mailbox->release(frame, mailbox->release_userdata);
+        frame->handle = NULL;
+    }
+}
+
+void frame_mailbox_init(FRAME_MAILBOX_T *mailbox, FRAME_RELEASE_CB_T release, void *userdata) {
+    memset(mailbox, 0, sizeof (FRAME_MAILBOX_T));
+    mailbox->back = 0;
+    mailbox->middle = 1;
+    mailbox->front = 2;
+    mailbox->release = release;
+    mailbox->release_userdata = userdata;
+}
+
+void frame_mailbox_publish(FRAME_MAILBOX_T *mailbox, const FRAME_T *frame) {
+    uint32_t prev;
+    FRAME_T *slot;
+
+    mailbox->slot[mailbox->back] = *frame;
+    prev = __atomic_exchange_n(&mailbox->middle, mailbox->back | FRAME_MAILBOX_FRESH, __ATOMIC_ACQ_REL);
+    mailbox->back = prev & FRAME_MAILBOX_INDEX;
+
+    slot = &mailbox->slot[mailbox->back];
+    if (prev & FRAME_MAILBOX_FRESH) {
+        // consumer was still busy, the older frame is stale now
+        __atomic_add_fetch(&mailbox->dropped, 1, __ATOMIC_RELAXED);
+    }
+    release_slot(mailbox, slot);
+
+    __atomic_add_fetch(&mailbox->published, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&mailbox->waiting, __ATOMIC_SEQ_CST)) {
+        futex_wake(&mailbox->published);
+    }
+}
+
+int frame_mailbox_acquire(FRAME_MAILBOX_T *mailbox, FRAME_T **frame, int timeout_ms) {
+    uint32_t seen;
+    uint32_t prev;
+
+    release_slot(mailbox, &mailbox->slot[mailbox->front]);
+
+    for (;;) {
+        seen = __atomic_load_n(&mailbox->published, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&mailbox->middle, __ATOMIC_ACQUIRE) & FRAME_MAILBOX_FRESH) {
+            // only the producer stores fresh indices, so the swap returns one
+            prev = __atomic_exchange_n(&mailbox->middle, mailbox->front, __ATOMIC_ACQ_REL);
+            mailbox->front = prev & FRAME_MAILBOX_INDEX;
+            *frame = &mailbox->slot[mailbox->front];
+            return 1;
+        }
+        if (timeout_ms == 0) {
+            return 0;
+        }
+
+        __atomic_store_n(&mailbox->waiting, 1, __ATOMIC_SEQ_CST);
+        if (!(__atomic_load_n(&mailbox->middle, __ATOMIC_SEQ_CST) & FRAME_MAILBOX_FRESH)) {
+            futex_wait(&mailbox->published, seen, timeout_ms);
+        }
+        __atomic_store_n(&mailbox->waiting, 0, __ATOMIC_SEQ_CST);
+
+        if (timeout_ms > 0 && __atomic_load_n(&mailbox->published, __ATOMIC_SEQ_CST) == seen) {
+            return 0;
+        }
+    }
+}
+
+void frame_mailbox_release(FRAME_MAILBOX_T *mailbox, FRAME_T *frame) {
+    release_slot(mailbox, frame);
+}
+
+uint32_t frame_mailbox_dropped(FRAME_MAILBOX_T *mailbox) {
+    return __atomic_load_n(&mailbox->dropped, __ATOMIC_RELAXED);
+}
+
+void frame_mailbox_flush(FRAME_MAILBOX_T *mailbox) {
+    int i;
+
+    for (i = 0; i < 3; i++) {
+        release_slot(mailbox, &mailbox->slot[i]);
+    }
+    mailbox->middle &= FRAME_MAILBOX_INDEX;
+}
@@ -0,0 +1,65 @@
+/*
+ * File:   frame_mailbox.h
+ * Author: Hassan
+ *
+ * Latest-frame-wins handoff between the camera callback and the detection
+ * loop. Three slots are rotated with atomic exchanges: the producer never
+ * blocks and a frame that was superseded before the consumer got to it is
+ * handed back to its owner through the release callback.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef FRAME_MAILBOX_H
+#define FRAME_MAILBOX_H
+
+#include <stdint.h>
+
+#define FRAME_PTS_UNKNOWN INT64_MIN
+
+typedef struct {
+    const uint8_t *data; // Y plane, read only
+    int width;
+    int height;
+    int stride;
+    uint32_t seq; // producer frame counter, gaps mean skipped frames
+    int64_t pts; // buffer->pts in microseconds or FRAME_PTS_UNKNOWN
+    void *handle; // owner's buffer, NULL when the slot is empty
+} FRAME_T;
+
+typedef void (*FRAME_RELEASE_CB_T)(FRAME_T *frame, void *userdata);
+
+typedef struct {
+    FRAME_T slot[3];
+    int back; // producer owned
+    int front; // consumer owned
+    uint32_t middle; // shared slot index, FRAME_MAILBOX_FRESH when unread
+    uint32_t published; // futex word, bumped on every publish
+    uint32_t waiting;
+    uint32_t dropped;
+    FRAME_RELEASE_CB_T release;
+    void *release_userdata;
+} FRAME_MAILBOX_T;
+
+void frame_mailbox_init(FRAME_MAILBOX_T *mailbox, FRAME_RELEASE_CB_T release, void *userdata);
+
+/* Producer side, never blocks. Takes ownership of frame->handle. */
+void frame_mailbox_publish(FRAME_MAILBOX_T *mailbox, const FRAME_T *frame);
+
+/*
+ * Consumer side. Waits up to timeout_ms (-1 forever) for a frame newer than
+ * the last one acquired and returns 1 with *frame pointing at it, 0 on
+ * timeout. The previous frame is released first if the caller has not done so.
+ */
+int frame_mailbox_acquire(FRAME_MAILBOX_T *mailbox, FRAME_T **frame, int timeout_ms);
+
+/* Consumer side, hands the acquired frame back to its owner. */
+void frame_mailbox_release(FRAME_MAILBOX_T *mailbox, FRAME_T *frame);
+
+/* Number of frames replaced before the consumer saw them. */
+uint32_t frame_mailbox_dropped(FRAME_MAILBOX_T *mailbox);
+
+/* Release everything still held, only once both sides have stopped. */
+void frame_mailbox_flush(FRAME_MAILBOX_T *mailbox);
+
+#endif /* FRAME_MAILBOX_H */
@@ -0,0 +1,69 @@
+/*
+ * File:   frame_source.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include "frame_source.h"
+
+void frame_source_config_default(FRAME_SOURCE_CONFIG_T *config) {
+    memset(config, 0, sizeof (FRAME_SOURCE_CONFIG_T));
+    config->width = 1280;
+    config->height = 720;
+    config->fps = 30.0;
+    config->pace = FRAME_SOURCE_PACE_REALTIME;
+    config->preview = 1;
+    config->intra_period = 60;
+}
+
+FRAME_SOURCE_T *frame_source_open(const char *spec, const FRAME_SOURCE_CONFIG_T *config) {
+    if (strcmp(spec, "synthetic") == 0) {
+        return frame_source_synth_create(config);
+    }
+    if (strcmp(spec, "camera") == 0) {
+        fprintf(stderr, "Error: camera source is not available through frame_source_open\n");
+        return NULL;
+    }
+    return frame_source_file_create(spec, config);
+}
+
+int frame_source_start(FRAME_SOURCE_T *source) {
+    return source->ops->start(source);
+}
+
+int frame_source_acquire(FRAME_SOURCE_T *source, FRAME_T **frame, int timeout_ms) {
+    return source->ops->acquire(source, frame, timeout_ms);
+}
+
+void frame_source_release(FRAME_SOURCE_T *source, FRAME_T *frame) {
+    source->ops->release(source, frame);
+}
+
+void frame_source_destroy(FRAME_SOURCE_T *source) {
+    if (source) {
+        source->ops->destroy(source);
+    }
+}
+
+void frame_source_pace(struct timespec *start, uint32_t seq, float fps) {
+    struct timespec due;
+    double offset;
+
+    if (fps <= 0) {
+        return;
+    }
+    offset = seq / fps;
+    due.tv_sec = start->tv_sec + (time_t) offset;
+    due.tv_nsec = start->tv_nsec + (long) ((offset - (time_t) offset) * 1000000000.0);
+    if (due.tv_nsec >= 1000000000L) {
+        due.tv_sec++;
+        due.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR)
+        ;
+}
@@ -0,0 +1,91 @@
+/*
+ * File:   frame_source.h
+ * Author: Hassan
+ *
+ * Where the detector gets its frames from. Every backend hands out read-only
+ * Y planes as FRAME_T and gets them back through release():
+ *
+ *   camera     live MMAL camera video port (frame_source_mmal.c)
+ *   file       raw I420 or YUV4MPEG2 recording (frame_source_file.c)
+ *   synthetic  generated test pattern (frame_source_synth.c)
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <stddef.h>
+#include <time.h>
+
+#include "frame_mailbox.h"
+
+typedef enum {
+    FRAME_SOURCE_PACE_REALTIME = 0, // deliver frames at the recorded rate
+    FRAME_SOURCE_PACE_FAST // as fast as the consumer asks for them
+} FRAME_SOURCE_PACE_T;
+
+/* Camera: one buffer of H.264, flags as for h264_writer_push, pts in microseconds or FRAME_PTS_UNKNOWN. */
+typedef void (*FRAME_SOURCE_ENCODED_T)(const uint8_t *data, size_t length, int flags, int64_t pts, void *arg);
+
+/* Camera: draws into a video frame, I420 in place, just before the encoder gets it. */
+typedef void (*FRAME_SOURCE_ANNOTATE_T)(uint8_t *y, uint8_t *u, uint8_t *v, int stride, int uv_stride, int64_t pts, void *arg);
+
+typedef struct {
+    int width; // capture size, or geometry of a raw I420 file
+    int height;
+    float fps; // capture rate, or pacing rate of a raw file (Y4M header wins)
+    FRAME_SOURCE_PACE_T pace;
+    int loop; // file/synthetic: restart instead of ending
+    int max_frames; // file/synthetic: end after this many frames, 0 = no limit
+    int preview; // camera: route the preview port to the display
+    int bitrate; // camera: H.264 encode the preview port at this rate into encoded, 0 for none
+    int intra_period; // camera: frames from one IDR, with its SPS/PPS, to the next
+    FRAME_SOURCE_ENCODED_T encoded; // called on the encoder's callback thread
+    void *encoded_arg;
+    int encode_video; // camera: encode the video port frames the consumer reads instead of the preview port
+    FRAME_SOURCE_ANNOTATE_T annotate; // camera, encode_video: NULL or called once the consumer is done with a frame
+    void *annotate_arg;
+} FRAME_SOURCE_CONFIG_T;
+
+typedef struct FRAME_SOURCE_T FRAME_SOURCE_T;
+
+typedef struct {
+    int (*start)(FRAME_SOURCE_T *source);
+    int (*acquire)(FRAME_SOURCE_T *source, FRAME_T **frame, int timeout_ms);
+    void (*release)(FRAME_SOURCE_T *source, FRAME_T *frame);
+    void (*destroy)(FRAME_SOURCE_T *source);
+} FRAME_SOURCE_OPS_T;
+
+struct FRAME_SOURCE_T {
+    const FRAME_SOURCE_OPS_T *ops;
+    const char *name;
+    int width;
+    int height;
+    float fps; // nominal rate, the camera keeps it updated with the measured one
+};
+
+void frame_source_config_default(FRAME_SOURCE_CONFIG_T *config);
+
+/*
+ * Open "synthetic" or a file path; *.y4m is read as YUV4MPEG2, anything else
+ * as headerless I420 of config->width x config->height. The camera is not
+ * handled here so that this layer builds without the Pi userland, see
+ * frame_source_mmal_create().
+ */
+FRAME_SOURCE_T *frame_source_open(const char *spec, const FRAME_SOURCE_CONFIG_T *config);
+
+FRAME_SOURCE_T *frame_source_file_create(const char *path, const FRAME_SOURCE_CONFIG_T *config);
+FRAME_SOURCE_T *frame_source_synth_create(const FRAME_SOURCE_CONFIG_T *config);
+
+int frame_source_start(FRAME_SOURCE_T *source);
+
+/* 1 with a frame, 0 on timeout, -1 at end of stream or on error. */
+int frame_source_acquire(FRAME_SOURCE_T *source, FRAME_T **frame, int timeout_ms);
+void frame_source_release(FRAME_SOURCE_T *source, FRAME_T *frame);
+void frame_source_destroy(FRAME_SOURCE_T *source);
+
+/* Shared by the file and synthetic backends for real-time pacing. */
+void frame_source_pace(struct timespec *start, uint32_t seq, float fps);
+
+#endif /* FRAME_SOURCE_H */
@@ -0,0 +1,240 @@
+/*
+ * File:   frame_source_file.c
+ * Author: Hassan
+ *
+ * Replays a recorded drive. Reads YUV4MPEG2 (as written by ffmpeg -f yuv4mpegpipe)
+ * or headerless I420. Only the Y plane is read, chroma is skipped with a seek.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "frame_source.h"
+
+#define FILE_READ_BUFFER (1 << 20)
+
+typedef struct {
+    FRAME_SOURCE_T base;
+    FILE *file;
+    char *io_buffer;
+    uint8_t *luma;
+    int y4m;
+    int mono;
+    off_t data_start;
+    off_t chroma_size;
+    uint32_t seq;
+    FRAME_SOURCE_PACE_T pace;
+    int loop;
+    int max_frames;
+    struct timespec t_start;
+    FRAME_T frame;
+} FRAME_SOURCE_FILE_T;
+
+static int has_suffix(const char *s, const char *suffix) {
+    size_t ls = strlen(s);
+    size_t lx = strlen(suffix);
+
+    return ls >= lx && strcmp(s + ls - lx, suffix) == 0;
+}
+
+/* Reads one '\n' terminated header line, returns its length or -1. */
+static int read_line(FILE *file, char *line, int size) {
+    int c;
+    int n = 0;
+
+    while ((c = getc(file)) != EOF && c != '\n') {
+        if (n < size - 1) {
+            line[n++] = (char) c;
+        }
+    }
+    line[n] = 0;
+    return (c == EOF && n == 0) ? -1 : n;
+}
+
+static int parse_y4m_header(FRAME_SOURCE_FILE_T *src) {
+    char line[512];
+    char *token;
+    char *save = NULL;
+
+    if (read_line(src->file, line, sizeof (line)) < 0 || strncmp(line, "YUV4MPEG2", 9) != 0) {
+        fprintf(stderr, "Error: not a YUV4MPEG2 stream\n");
+        return -1;
+    }
+    for (token = strtok_r(line + 9, " ", &save); token; token = strtok_r(NULL, " ", &save)) {
+        switch (token[0]) {
+            case 'W':
+                src->base.width = atoi(token + 1);
+                break;
+            case 'H':
+                src->base.height = atoi(token + 1);
+                break;
+            case 'F':
+            {
+                int num = 0, den = 0;
+                if (sscanf(token + 1, "%d:%d", &num, &den) == 2 && num > 0 && den > 0) {
+                    src->base.fps = (float) num / (float) den;
+                }
+                break;
+            }
+            case 'C':
+                if (strncmp(token + 1, "mono", 4) == 0) {
+                    src->mono = 1;
+                } else if (strncmp(token + 1, "420", 3) != 0) {
+                    fprintf(stderr, "Error: unsupported Y4M colorspace %s\n", token + 1);
+                    return -1;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return 0;
+}
+
+static int file_start(FRAME_SOURCE_T *source) {
+    FRAME_SOURCE_FILE_T *src = (FRAME_SOURCE_FILE_T *) source;
+
+    clock_gettime(CLOCK_MONOTONIC, &src->t_start);
+    return 0;
+}
+
+static int file_rewind(FRAME_SOURCE_FILE_T *src) {
+    if (!src->loop) {
+        return -1;
+    }
+    clearerr(src->file);
+    return fseeko(src->file, src->data_start, SEEK_SET);
+}
+
+static int file_acquire(FRAME_SOURCE_T *source, FRAME_T **frame, int timeout_ms) {
+    FRAME_SOURCE_FILE_T *src = (FRAME_SOURCE_FILE_T *) source;
+    size_t luma_size = (size_t) source->width * source->height;
+    char line[256];
+    int retried = 0;
+
+    (void) timeout_ms; // a file always has the next frame at hand
+    if (src->max_frames > 0 && src->seq >= (uint32_t) src->max_frames) {
+        return -1;
+    }
+
+    for (;;) {
+        if (src->y4m) {
+            int n = read_line(src->file, line, sizeof (line));
+            if (n < 0) {
+                if (retried++ || file_rewind(src) != 0) {
+                    return -1;
+                }
+                continue;
+            }
+            if (strncmp(line, "FRAME", 5) != 0) {
+                fprintf(stderr, "Error: bad Y4M frame header at frame %u\n", src->seq);
+                return -1;
+            }
+        }
+        if (fread(src->luma, 1, luma_size, src->file) == luma_size) {
+            break;
+        }
+        if (retried++ || file_rewind(src) != 0) {
+            return -1;
+        }
+    }
+    if (src->chroma_size > 0) {
+        fseeko(src->file, src->chroma_size, SEEK_CUR);
+    }
+
+    if (src->pace == FRAME_SOURCE_PACE_REALTIME) {
+        frame_source_pace(&src->t_start, src->seq, source->fps);
+    }
+
+    src->frame.data = src->luma;
+    src->frame.width = source->width;
+    src->frame.height = source->height;
+    src->frame.stride = source->width;
+    src->frame.seq = src->seq;
+    src->frame.pts = source->fps > 0 ? (int64_t) (src->seq * 1000000.0 / source->fps) : FRAME_PTS_UNKNOWN;
+    src->frame.handle = src->luma;
+    src->seq++;
+
+    *frame = &src->frame;
+    return 1;
+}
+
+static void file_release(FRAME_SOURCE_T *source, FRAME_T *frame) {
+    (void) source;
+    frame->handle = NULL;
+}
+
+static void file_destroy(FRAME_SOURCE_T *source) {
+    FRAME_SOURCE_FILE_T *src = (FRAME_SOURCE_FILE_T *) source;
+
+    if (src->file) {
+        fclose(src->file);
+    }
+    free(src->io_buffer);
+    free(src->luma);
+    free(src);
+}
+
+static const FRAME_SOURCE_OPS_T file_ops = {
+    file_start,
+    file_acquire,
+    file_release,
+    file_destroy
+};
+
+FRAME_SOURCE_T *frame_source_file_create(const char *path, const FRAME_SOURCE_CONFIG_T *config) {
+    FRAME_SOURCE_FILE_T *src;
+
+    src = (FRAME_SOURCE_FILE_T *) calloc(1, sizeof (FRAME_SOURCE_FILE_T));
+    if (!src) {
+        return NULL;
+    }
+    src->base.ops = &file_ops;
+    src->base.name = path;
+    src->base.width = config->width;
+    src->base.height = config->height;
+    src->base.fps = config->fps;
+    src->pace = config->pace;
+    src->loop = config->loop;
+    src->max_frames = config->max_frames;
+    src->y4m = has_suffix(path, ".y4m");
+
+    src->file = fopen(path, "rb");
+    if (!src->file) {
+        fprintf(stderr, "Error: unable to open %s\n", path);
+        file_destroy(&src->base);
+        return NULL;
+    }
+    src->io_buffer = (char *) malloc(FILE_READ_BUFFER);
+    if (src->io_buffer) {
+        setvbuf(src->file, src->io_buffer, _IOFBF, FILE_READ_BUFFER);
+    }
+
+    if (src->y4m && parse_y4m_header(src) != 0) {
+        file_destroy(&src->base);
+        return NULL;
+    }
+    if (src->base.width <= 0 || src->base.height <= 0) {
+        fprintf(stderr, "Error: %s has no frame size\n", path);
+        file_destroy(&src->base);
+        return NULL;
+    }
+    src->data_start = ftello(src->file);
+    src->chroma_size = src->mono ? 0 : 2 * (off_t) ((src->base.width + 1) / 2) * ((src->base.height + 1) / 2);
+
+    src->luma = (uint8_t *) malloc((size_t) src->base.width * src->base.height);
+    if (!src->luma) {
+        file_destroy(&src->base);
+        return NULL;
+    }
+
+    fprintf(stderr, "INFO: %s %dx%d %.2f fps %s\n", path, src->base.width, src->base.height,
+            src->base.fps, src->pace == FRAME_SOURCE_PACE_FAST ? "(fast)" : "(real time)");
+    return &src->base;
+}
@@ -0,0 +1,700 @@
+/*
+ * File:   frame_source_mmal.c
+ * Author: Hassan : author Tasanakorn
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bcm_host.h"
+#include "interface/vcos/vcos.h"
+
+#include "interface/mmal/mmal.h"
+#include "interface/mmal/util/mmal_default_components.h"
+#include "interface/mmal/util/mmal_connection.h"
+#include "interface/mmal/util/mmal_util.h"
+
+#include "frame_source_mmal.h"
+#include "h264_writer.h" // the encoded buffer flags
+
+#define MMAL_CAMERA_PREVIEW_PORT 0
+#define MMAL_CAMERA_VIDEO_PORT 1
+#define MMAL_CAMERA_CAPTURE_PORT 2
+
+// one frame with the consumer, one in the mailbox, the rest with the camera
+#define VIDEO_BUFFERS 4
+#define ENCODER_IN_FLIGHT 2
+// encode_video: and frames the encoder holds, and stale ones waiting for the consumer's to go first
+#define ENCODE_VIDEO_BUFFERS (VIDEO_BUFFERS + ENCODER_IN_FLIGHT + 2)
+
+typedef struct {
+    MMAL_BUFFER_HEADER_T *buffer;
+    int released; // by the mailbox, the consumer is done with it
+} CAPTURED_T;
+
+typedef struct {
+    FRAME_SOURCE_T base;
+    int video_stride;
+    int preview;
+    int bitrate;
+    int intra_period;
+    FRAME_SOURCE_ENCODED_T encoded;
+    void *encoded_arg;
+    int encode_video;
+    FRAME_SOURCE_ANNOTATE_T annotate;
+    void *annotate_arg;
+    MMAL_COMPONENT_T *camera;
+    MMAL_COMPONENT_T *preview_renderer;
+    MMAL_COMPONENT_T *splitter; // preview port to both the display and the encoder
+    MMAL_COMPONENT_T *encoder;
+    MMAL_PORT_T *camera_preview_port;
+    MMAL_PORT_T *camera_video_port;
+    MMAL_POOL_T *camera_video_port_pool;
+    MMAL_CONNECTION_T *camera_preview_connection;
+    MMAL_CONNECTION_T *splitter_connection;
+    MMAL_CONNECTION_T *encoder_connection;
+    MMAL_POOL_T *encoder_output_pool;
+    FRAME_MAILBOX_T mailbox;
+    // encode_video: video port frames in capture order, each until the mailbox releases it
+    pthread_mutex_t captured_lock;
+    CAPTURED_T captured[ENCODE_VIDEO_BUFFERS];
+    int captured_head;
+    int captured_count;
+    int encoder_in_flight; // camera buffers the encoder has not released yet
+    int stopping; // no more frames to the encoder
+    uint32_t encode_dropped;
+    uint32_t frame_count;
+    struct timespec t1;
+} FRAME_SOURCE_MMAL_T;
+
+/* Drop the last reference to a camera buffer and queue a fresh one on the video port. */
+static void recycle_video_buffer(FRAME_SOURCE_MMAL_T *src, MMAL_BUFFER_HEADER_T *buffer) {
+    MMAL_PORT_T *port = src->camera_video_port;
+    MMAL_BUFFER_HEADER_T *new_buffer;
+
+    mmal_buffer_header_release(buffer);
+    // and send one back to the port (if still open)
+    if (port->is_enabled) {
+        MMAL_STATUS_T status;
+
+        new_buffer = mmal_queue_get(src->camera_video_port_pool->queue);
+
+        if (new_buffer)
+            status = mmal_port_send_buffer(port, new_buffer);
+
+        if (!new_buffer || status != MMAL_SUCCESS)
+            fprintf(stderr, "Unable to return a buffer to the video port\n");
+    }
+}
+
+/*
+ * encode_video: the released frames at the head of the capture order go to
+ * the encoder, annotated, in the buffer the camera wrote. A frame still with
+ * the consumer holds back those captured after it, so the encoder never sees
+ * time run backwards whichever thread released what first. With the encoder
+ * ENCODER_IN_FLIGHT frames behind, a frame is skipped rather than waited for.
+ */
+static void encode_captured(FRAME_SOURCE_MMAL_T *src) {
+    MMAL_PORT_T *encoder_port = src->encoder ? src->encoder->input[0] : NULL;
+    MMAL_BUFFER_HEADER_T *buffer;
+    int y_size;
+
+    pthread_mutex_lock(&src->captured_lock);
+    while (src->captured_count > 0 && src->captured[src->captured_head].released) {
+        buffer = src->captured[src->captured_head].buffer;
+        src->captured_head = (src->captured_head + 1) % ENCODE_VIDEO_BUFFERS;
+        src->captured_count--;
+
+        if (encoder_port && encoder_port->is_enabled && !__atomic_load_n(&src->stopping, __ATOMIC_ACQUIRE)
+                && __atomic_load_n(&src->encoder_in_flight, __ATOMIC_ACQUIRE) < ENCODER_IN_FLIGHT) {
+            if (src->annotate) {
+                y_size = src->video_stride * VCOS_ALIGN_UP(src->base.height, 16);
+                src->annotate(buffer->data, buffer->data + y_size, buffer->data + y_size + y_size / 4,
+                        src->video_stride, src->video_stride / 2,
+                        buffer->pts == MMAL_TIME_UNKNOWN ? FRAME_PTS_UNKNOWN : buffer->pts, src->annotate_arg);
+            }
+            mmal_buffer_header_mem_unlock(buffer);
+            __atomic_add_fetch(&src->encoder_in_flight, 1, __ATOMIC_ACQ_REL);
+            // the encoder holds the last reference now, encoder_input_callback drops it
+            if (mmal_port_send_buffer(encoder_port, buffer) == MMAL_SUCCESS) {
+                continue;
+            }
+            __atomic_sub_fetch(&src->encoder_in_flight, 1, __ATOMIC_ACQ_REL);
+        } else {
+            mmal_buffer_header_mem_unlock(buffer);
+        }
+        __atomic_add_fetch(&src->encode_dropped, 1, __ATOMIC_RELAXED);
+        recycle_video_buffer(src, buffer);
+    }
+    pthread_mutex_unlock(&src->captured_lock);
+}
+
+/*
+ * The mailbox release callback, on the MMAL callback thread for frames that
+ * went stale and on the detection thread once it is done reading. Without
+ * encode_video that was the only reference; with it, the frame goes on to
+ * the encoder in capture order.
+ */
+static void return_video_buffer(FRAME_T *frame, void *arg) {
+    FRAME_SOURCE_MMAL_T *src = (FRAME_SOURCE_MMAL_T *) arg;
+    MMAL_BUFFER_HEADER_T *buffer = (MMAL_BUFFER_HEADER_T *) frame->handle;
+    int i;
+
+    if (!src->encode_video) {
+        mmal_buffer_header_mem_unlock(buffer);
+        recycle_video_buffer(src, buffer);
+        return;
+    }
+    mmal_buffer_header_release(buffer);
+    pthread_mutex_lock(&src->captured_lock);
+    for (i = 0; i < src->captured_count; i++) {
+        if (src->captured[(src->captured_head + i) % ENCODE_VIDEO_BUFFERS].buffer == buffer) {
+            src->captured[(src->captured_head + i) % ENCODE_VIDEO_BUFFERS].released = 1;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&src->captured_lock);
+    encode_captured(src);
+}
+
+static void video_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer) {
+    FRAME_SOURCE_MMAL_T *src = (FRAME_SOURCE_MMAL_T *) port->userdata;
+    struct timespec t2;
+    FRAME_T frame;
+
+    if (src->frame_count == 0) {
+        clock_gettime(CLOCK_MONOTONIC, &src->t1);
+    }
+    src->frame_count++;
+
+    // Publish the buffer as the latest frame; the consumer reads the Y plane
+    // in place and the mailbox hands it back through return_video_buffer.
+    mmal_buffer_header_mem_lock(buffer);
+    if (src->encode_video) {
+        // a second reference for the encoder, queued before the mailbox can release the first
+        mmal_buffer_header_acquire(buffer);
+        pthread_mutex_lock(&src->captured_lock);
+        src->captured[(src->captured_head + src->captured_count) % ENCODE_VIDEO_BUFFERS].buffer = buffer;
+        src->captured[(src->captured_head + src->captured_count) % ENCODE_VIDEO_BUFFERS].released = 0;
+        src->captured_count++;
+        pthread_mutex_unlock(&src->captured_lock);
+    }
+    frame.data = buffer->data;
+    frame.width = src->base.width;
+    frame.height = src->base.height;
+    frame.stride = src->video_stride;
+    frame.seq = src->frame_count;
+    frame.pts = buffer->pts == MMAL_TIME_UNKNOWN ? FRAME_PTS_UNKNOWN : buffer->pts;
+    frame.handle = buffer;
+    frame_mailbox_publish(&src->mailbox, &frame);
+
+    if (src->frame_count % 10 == 0) {
+        // update framerate every n frame
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+        float d = (t2.tv_sec + t2.tv_nsec / 1000000000.0) - (src->t1.tv_sec + src->t1.tv_nsec / 1000000000.0);
+
+        if (d > 0) {
+            src->base.fps = src->frame_count / d;
+        } else {
+            src->base.fps = src->frame_count;
+        }
+    }
+}
+
+/* encode_video: the encoder is done with a camera buffer. */
+static void encoder_input_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer) {
+    FRAME_SOURCE_MMAL_T *src = (FRAME_SOURCE_MMAL_T *) port->userdata;
+
+    __atomic_sub_fetch(&src->encoder_in_flight, 1, __ATOMIC_ACQ_REL);
+    recycle_video_buffer(src, buffer);
+}
+
+/* H.264 out of the encoder: to the consumer's callback, then the buffer goes back to the encoder. */
+static void encoder_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer) {
+    FRAME_SOURCE_MMAL_T *src = (FRAME_SOURCE_MMAL_T *) port->userdata;
+    MMAL_BUFFER_HEADER_T *new_buffer;
+    int flags = 0;
+
+    if (buffer->length > 0) {
+        if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_CONFIG) {
+            flags |= H264_WRITER_CONFIG;
+        }
+        if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_KEYFRAME) {
+            flags |= H264_WRITER_KEYFRAME;
+        }
+        if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_FRAME_END) {
+            flags |= H264_WRITER_FRAME_END;
+        }
+        mmal_buffer_header_mem_lock(buffer);
+        src->encoded(buffer->data, buffer->length, flags,
+                buffer->pts == MMAL_TIME_UNKNOWN ? FRAME_PTS_UNKNOWN : buffer->pts, src->encoded_arg);
+        mmal_buffer_header_mem_unlock(buffer);
+    }
+
+    mmal_buffer_header_release(buffer);
+    if (port->is_enabled) {
+        MMAL_STATUS_T status;
+
+        new_buffer = mmal_queue_get(src->encoder_output_pool->queue);
+
+        if (new_buffer)
+            status = mmal_port_send_buffer(port, new_buffer);
+
+        if (!new_buffer || status != MMAL_SUCCESS)
+            fprintf(stderr, "Unable to return a buffer to the encoder output port\n");
+    }
+}
+
+static int setup_camera(FRAME_SOURCE_MMAL_T *src) {
+    MMAL_COMPONENT_T *camera = 0;
+    MMAL_ES_FORMAT_T *format;
+    MMAL_STATUS_T status;
+    MMAL_PORT_T *camera_preview_port, *camera_video_port;
+    int width = src->base.width;
+    int height = src->base.height;
+
+    status = mmal_component_create(MMAL_COMPONENT_DEFAULT_CAMERA, &camera);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: create camera %x\n", status);
+        return -1;
+    }
+    src->camera = camera;
+
+    camera_preview_port = camera->output[MMAL_CAMERA_PREVIEW_PORT];
+    camera_video_port = camera->output[MMAL_CAMERA_VIDEO_PORT];
+    src->camera_preview_port = camera_preview_port;
+    src->camera_video_port = camera_video_port;
+
+    {
+        MMAL_PARAMETER_CAMERA_CONFIG_T cam_config = {
+            { MMAL_PARAMETER_CAMERA_CONFIG, sizeof (cam_config)},
+            .max_stills_w = width,
+            .max_stills_h = height,
+            .stills_yuv422 = 0,
+            .one_shot_stills = 0,
+            .max_preview_video_w = width,
+            .max_preview_video_h = height,
+            .num_preview_video_frames = 2,
+            .stills_capture_circular_buffer_height = 0,
+            .fast_preview_resume = 1,
+            .use_stc_timestamp = MMAL_PARAM_TIMESTAMP_MODE_RESET_STC
+        };
+
+        mmal_port_parameter_set(camera->control, &cam_config.hdr);
+    }
+
+    format = camera_video_port->format;
+
+    format->encoding = MMAL_ENCODING_I420;
+    format->encoding_variant = MMAL_ENCODING_I420;
+
+    format->es->video.width = width;
+    format->es->video.height = height;
+    format->es->video.crop.x = 0;
+    format->es->video.crop.y = 0;
+    format->es->video.crop.width = width;
+    format->es->video.crop.height = height;
+    format->es->video.frame_rate.num = (int) src->base.fps;
+    format->es->video.frame_rate.den = 1;
+
+    camera_video_port->buffer_size = width * height * 12 / 8;
+    camera_video_port->buffer_num = src->encode_video ? ENCODE_VIDEO_BUFFERS : VIDEO_BUFFERS;
+    fprintf(stderr, "  Camera video buffer_size = %d\n", camera_video_port->buffer_size);
+
+    status = mmal_port_format_commit(camera_video_port);
+
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to commit camera video port format (%u)\n", status);
+        return -1;
+    }
+    src->video_stride = mmal_encoding_width_to_stride(MMAL_ENCODING_I420, camera_video_port->format->es->video.width);
+
+    format = camera_preview_port->format;
+
+    format->encoding = MMAL_ENCODING_OPAQUE;
+    format->encoding_variant = MMAL_ENCODING_I420;
+
+    format->es->video.width = width;
+    format->es->video.height = height;
+    format->es->video.crop.x = 0;
+    format->es->video.crop.y = 0;
+    format->es->video.crop.width = width;
+    format->es->video.crop.height = height;
+    format->es->video.frame_rate.num = (int) src->base.fps;
+    format->es->video.frame_rate.den = 1;
+
+    status = mmal_port_format_commit(camera_preview_port);
+
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: camera viewfinder format couldn't be set\n");
+        return -1;
+    }
+
+    // the encoder reads the same GPU memory the camera wrote and the detector read
+    if (src->encode_video && mmal_port_parameter_set_boolean(camera_video_port, MMAL_PARAMETER_ZERO_COPY, 1) != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to set zero copy on the camera video port\n");
+        return -1;
+    }
+    // crate pool form camera video port
+    src->camera_video_port_pool = (MMAL_POOL_T *) mmal_port_pool_create(camera_video_port, camera_video_port->buffer_num, camera_video_port->buffer_size);
+    frame_mailbox_init(&src->mailbox, return_video_buffer, src);
+    camera_video_port->userdata = (struct MMAL_PORT_USERDATA_T *) src;
+
+    status = mmal_port_enable(camera_video_port, video_buffer_callback);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to enable camera video port (%u)\n", status);
+        return -1;
+    }
+
+    status = mmal_component_enable(camera);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to enable camera (%u)\n", status);
+        return -1;
+    }
+    return 0;
+}
+
+/* The renderer, fed from the camera preview port or a splitter output. */
+static int setup_preview(FRAME_SOURCE_MMAL_T *src, MMAL_PORT_T *output_port) {
+    MMAL_STATUS_T status;
+    MMAL_PORT_T *preview_input_port;
+
+    status = mmal_component_create(MMAL_COMPONENT_DEFAULT_VIDEO_RENDERER, &src->preview_renderer);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to create preview (%u)\n", status);
+        return -1;
+    }
+    preview_input_port = src->preview_renderer->input[0];
+
+    {
+        MMAL_DISPLAYREGION_T param;
+        param.hdr.id = MMAL_PARAMETER_DISPLAYREGION;
+        param.hdr.size = sizeof (MMAL_DISPLAYREGION_T);
+        param.set = MMAL_DISPLAY_SET_LAYER;
+        param.layer = 0;
+        param.set |= MMAL_DISPLAY_SET_FULLSCREEN;
+        param.fullscreen = 1;
+        status = mmal_port_parameter_set(preview_input_port, &param.hdr);
+        if (status != MMAL_SUCCESS && status != MMAL_ENOSYS) {
+            fprintf(stderr, "Error: unable to set preview port parameters (%u)\n", status);
+            return -1;
+        }
+    }
+
+    status = mmal_connection_create(&src->camera_preview_connection, output_port, preview_input_port, MMAL_CONNECTION_FLAG_TUNNELLING | MMAL_CONNECTION_FLAG_ALLOCATION_ON_INPUT);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to create connection (%u)\n", status);
+        return -1;
+    }
+
+    status = mmal_connection_enable(src->camera_preview_connection);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to enable connection (%u)\n", status);
+        return -1;
+    }
+    return 0;
+}
+
+/* One preview stream to two places: output 0 for the display, 1 for the encoder. */
+static int setup_splitter(FRAME_SOURCE_MMAL_T *src) {
+    MMAL_STATUS_T status;
+    MMAL_COMPONENT_T *splitter;
+    int i;
+
+    status = mmal_component_create(MMAL_COMPONENT_DEFAULT_VIDEO_SPLITTER, &src->splitter);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to create the splitter (%u)\n", status);
+        return -1;
+    }
+    splitter = src->splitter;
+    if (splitter->output_num < 2) {
+        fprintf(stderr, "Error: the splitter has %u outputs\n", splitter->output_num);
+        return -1;
+    }
+
+    mmal_format_copy(splitter->input[0]->format, src->camera_preview_port->format);
+    status = mmal_port_format_commit(splitter->input[0]);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to commit splitter input port format (%u)\n", status);
+        return -1;
+    }
+    for (i = 0; i < 2; i++) {
+        mmal_format_copy(splitter->output[i]->format, splitter->input[0]->format);
+        status = mmal_port_format_commit(splitter->output[i]);
+        if (status != MMAL_SUCCESS) {
+            fprintf(stderr, "Error: unable to commit splitter output port %d format (%u)\n", i, status);
+            return -1;
+        }
+    }
+
+    status = mmal_connection_create(&src->splitter_connection, src->camera_preview_port, splitter->input[0], MMAL_CONNECTION_FLAG_TUNNELLING | MMAL_CONNECTION_FLAG_ALLOCATION_ON_INPUT);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to create splitter connection (%u)\n", status);
+        return -1;
+    }
+
+    status = mmal_connection_enable(src->splitter_connection);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to enable splitter connection (%u)\n", status);
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * H.264 from the preview stream, which the GPU passes along without a copy;
+ * the video port stays the detector's. With output_port NULL (encode_video)
+ * it is fed the video port's own buffers by encode_captured instead. An IDR
+ * with SPS/PPS every intra_period frames, so a recording can start at any
+ * of them.
+ */
+static int setup_encoder(FRAME_SOURCE_MMAL_T *src, MMAL_PORT_T *output_port) {
+    MMAL_STATUS_T status;
+    MMAL_PORT_T *encoder_input_port, *encoder_output_port;
+    MMAL_BUFFER_HEADER_T *buffer;
+
+    status = mmal_component_create(MMAL_COMPONENT_DEFAULT_VIDEO_ENCODER, &src->encoder);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to create the encoder (%u)\n", status);
+        return -1;
+    }
+    encoder_input_port = src->encoder->input[0];
+    encoder_output_port = src->encoder->output[0];
+
+    if (output_port) {
+        mmal_format_copy(encoder_input_port->format, output_port->format);
+    } else {
+        mmal_format_copy(encoder_input_port->format, src->camera_video_port->format);
+        // the camera's buffers, no pool of its own
+        encoder_input_port->buffer_size = src->camera_video_port->buffer_size;
+        encoder_input_port->buffer_num = src->camera_video_port->buffer_num;
+    }
+    status = mmal_port_format_commit(encoder_input_port);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to commit encoder input port format (%u)\n", status);
+        return -1;
+    }
+
+    mmal_format_copy(encoder_output_port->format, encoder_input_port->format);
+    encoder_output_port->format->encoding = MMAL_ENCODING_H264;
+    encoder_output_port->format->bitrate = src->bitrate;
+
+    encoder_output_port->buffer_size = encoder_output_port->buffer_size_recommended;
+    if (encoder_output_port->buffer_size < encoder_output_port->buffer_size_min) {
+        encoder_output_port->buffer_size = encoder_output_port->buffer_size_min;
+    }
+    encoder_output_port->buffer_num = encoder_output_port->buffer_num_recommended;
+    if (encoder_output_port->buffer_num < encoder_output_port->buffer_num_min) {
+        encoder_output_port->buffer_num = encoder_output_port->buffer_num_min;
+    }
+
+    status = mmal_port_format_commit(encoder_output_port);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to commit encoder output port format (%u)\n", status);
+        return -1;
+    }
+
+    if (mmal_port_parameter_set_uint32(encoder_output_port, MMAL_PARAMETER_INTRAPERIOD, src->intra_period) != MMAL_SUCCESS
+            || mmal_port_parameter_set_boolean(encoder_output_port, MMAL_PARAMETER_VIDEO_ENCODE_INLINE_HEADER, 1) != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to set the encoder intra period and inline headers\n");
+        return -1;
+    }
+
+    src->encoder_output_pool = (MMAL_POOL_T *) mmal_port_pool_create(encoder_output_port, encoder_output_port->buffer_num, encoder_output_port->buffer_size);
+    encoder_output_port->userdata = (struct MMAL_PORT_USERDATA_T *) src;
+
+    status = mmal_port_enable(encoder_output_port, encoder_buffer_callback);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to enable encoder output port (%u)\n", status);
+        return -1;
+    }
+    while ((buffer = mmal_queue_get(src->encoder_output_pool->queue)) != NULL) {
+        if (mmal_port_send_buffer(encoder_output_port, buffer) != MMAL_SUCCESS) {
+            fprintf(stderr, "Unable to send a buffer to the encoder output port\n");
+        }
+    }
+
+    if (!output_port) {
+        if (mmal_port_parameter_set_boolean(encoder_input_port, MMAL_PARAMETER_ZERO_COPY, 1) != MMAL_SUCCESS) {
+            fprintf(stderr, "Error: unable to set zero copy on the encoder input port\n");
+            return -1;
+        }
+        encoder_input_port->userdata = (struct MMAL_PORT_USERDATA_T *) src;
+        status = mmal_port_enable(encoder_input_port, encoder_input_callback);
+        if (status != MMAL_SUCCESS) {
+            fprintf(stderr, "Error: unable to enable encoder input port (%u)\n", status);
+            return -1;
+        }
+        return 0;
+    }
+
+    status = mmal_connection_create(&src->encoder_connection, output_port, encoder_input_port, MMAL_CONNECTION_FLAG_TUNNELLING | MMAL_CONNECTION_FLAG_ALLOCATION_ON_INPUT);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to create encoder connection (%u)\n", status);
+        return -1;
+    }
+
+    status = mmal_connection_enable(src->encoder_connection);
+    if (status != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to enable encoder connection (%u)\n", status);
+        return -1;
+    }
+    return 0;
+}
+
+static int mmal_start(FRAME_SOURCE_T *source) {
+    FRAME_SOURCE_MMAL_T *src = (FRAME_SOURCE_MMAL_T *) source;
+    int num = mmal_queue_length(src->camera_video_port_pool->queue);
+    int q;
+
+    // Send all the buffers to the camera video port
+    for (q = 0; q < num; q++) {
+        MMAL_BUFFER_HEADER_T *buffer = mmal_queue_get(src->camera_video_port_pool->queue);
+
+        if (!buffer) {
+            fprintf(stderr, "Unable to get a required buffer %d from pool queue\n", q);
+            return -1;
+        }
+
+        if (mmal_port_send_buffer(src->camera_video_port, buffer) != MMAL_SUCCESS) {
+            fprintf(stderr, "Unable to send a buffer to camera video port (%d)\n", q);
+        }
+    }
+
+    if (mmal_port_parameter_set_boolean(src->camera_video_port, MMAL_PARAMETER_CAPTURE, 1) != MMAL_SUCCESS) {
+        fprintf(stderr, "%s: Failed to start capture\n", __func__);
+        return -1;
+    }
+    return 0;
+}
+
+static int mmal_acquire(FRAME_SOURCE_T *source, FRAME_T **frame, int timeout_ms) {
+    FRAME_SOURCE_MMAL_T *src = (FRAME_SOURCE_MMAL_T *) source;
+
+    return frame_mailbox_acquire(&src->mailbox, frame, timeout_ms);
+}
+
+static void mmal_release(FRAME_SOURCE_T *source, FRAME_T *frame) {
+    FRAME_SOURCE_MMAL_T *src = (FRAME_SOURCE_MMAL_T *) source;
+
+    frame_mailbox_release(&src->mailbox, frame);
+}
+
+static void mmal_destroy(FRAME_SOURCE_T *source) {
+    FRAME_SOURCE_MMAL_T *src = (FRAME_SOURCE_MMAL_T *) source;
+
+    if (src->camera_video_port && src->camera_video_port->is_enabled) {
+        mmal_port_parameter_set_boolean(src->camera_video_port, MMAL_PARAMETER_CAPTURE, 0);
+        mmal_port_disable(src->camera_video_port);
+    }
+    if (src->camera_video_port_pool) {
+        // what the mailbox still holds goes back to the pool, not to the encoder
+        __atomic_store_n(&src->stopping, 1, __ATOMIC_RELEASE);
+        frame_mailbox_flush(&src->mailbox);
+    }
+    if (src->encoder_connection) {
+        mmal_connection_destroy(src->encoder_connection);
+    }
+    if (src->encoder) {
+        // the frames it holds come back through encoder_input_callback
+        if (src->encoder->input[0]->is_enabled) {
+            mmal_port_disable(src->encoder->input[0]);
+        }
+        if (src->encoder->output[0]->is_enabled) {
+            mmal_port_disable(src->encoder->output[0]);
+        }
+        mmal_component_disable(src->encoder);
+        if (src->encoder_output_pool) {
+            mmal_port_pool_destroy(src->encoder->output[0], src->encoder_output_pool);
+        }
+        mmal_component_destroy(src->encoder);
+    }
+    if (src->camera_preview_connection) {
+        mmal_connection_destroy(src->camera_preview_connection);
+    }
+    if (src->preview_renderer) {
+        mmal_component_destroy(src->preview_renderer);
+    }
+    if (src->splitter_connection) {
+        mmal_connection_destroy(src->splitter_connection);
+    }
+    if (src->splitter) {
+        mmal_component_destroy(src->splitter);
+    }
+    if (src->camera) {
+        mmal_component_disable(src->camera);
+        if (src->camera_video_port_pool) {
+            mmal_port_pool_destroy(src->camera_video_port, src->camera_video_port_pool);
+        }
+        mmal_component_destroy(src->camera);
+    }
+    pthread_mutex_destroy(&src->captured_lock);
+    free(src);
+}
+
+static const FRAME_SOURCE_OPS_T mmal_ops = {
+    mmal_start,
+    mmal_acquire,
+    mmal_release,
+    mmal_destroy
+};
+
+FRAME_SOURCE_T *frame_source_mmal_create(const FRAME_SOURCE_CONFIG_T *config) {
+    FRAME_SOURCE_MMAL_T *src;
+
+    src = (FRAME_SOURCE_MMAL_T *) calloc(1, sizeof (FRAME_SOURCE_MMAL_T));
+    if (!src) {
+        return NULL;
+    }
+    src->base.ops = &mmal_ops;
+    src->base.name = "camera";
+    src->base.width = config->width;
+    src->base.height = config->height;
+    src->base.fps = config->fps > 0 ? config->fps : 30.0;
+    src->preview = config->preview;
+    src->bitrate = config->encoded ? config->bitrate : 0;
+    src->intra_period = config->intra_period > 0 ? config->intra_period : 60;
+    src->encoded = config->encoded;
+    src->encoded_arg = config->encoded_arg;
+    src->encode_video = src->bitrate && config->encode_video;
+    src->annotate = config->annotate;
+    src->annotate_arg = config->annotate_arg;
+    pthread_mutex_init(&src->captured_lock, NULL);
+
+    if (setup_camera(src) != 0) {
+        mmal_destroy(&src->base);
+        return NULL;
+    }
+    if (src->encode_video) {
+        if ((src->preview && setup_preview(src, src->camera_preview_port) != 0) || setup_encoder(src, NULL) != 0) {
+            mmal_destroy(&src->base);
+            return NULL;
+        }
+    } else if (src->preview && src->bitrate) {
+        if (setup_splitter(src) != 0 || setup_preview(src, src->splitter->output[0]) != 0
+                || setup_encoder(src, src->splitter->output[1]) != 0) {
+            mmal_destroy(&src->base);
+            return NULL;
+        }
+    } else if ((src->preview && setup_preview(src, src->camera_preview_port) != 0)
+            || (src->bitrate && setup_encoder(src, src->camera_preview_port) != 0)) {
+        mmal_destroy(&src->base);
+        return NULL;
+    }
+    return &src->base;
+}
+
+uint32_t frame_source_mmal_dropped(FRAME_SOURCE_T *source) {
+    FRAME_SOURCE_MMAL_T *src = (FRAME_SOURCE_MMAL_T *) source;
+
+    return frame_mailbox_dropped(&src->mailbox);
+}
+
+uint32_t frame_source_mmal_encode_dropped(FRAME_SOURCE_T *source) {
+    FRAME_SOURCE_MMAL_T *src = (FRAME_SOURCE_MMAL_T *) source;
+
+    return __atomic_load_n(&src->encode_dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,33 @@
+/*
+ * File:   frame_source_mmal.h
+ * Author: Hassan
+ *
+ * Live camera backend. The video port delivers I420 buffers that are handed
+ * to the consumer by reference through a FRAME_MAILBOX_T; the preview port is
+ * tunnelled to the HDMI renderer when config->preview is set, and to the
+ * H.264 encoder when config->bitrate is, through a splitter for both.
+ *
+ * With config->encode_video the encoder takes the video port frames
+ * instead, one capture for detection and recording: each buffer carries a
+ * reference for the mailbox and one for the encoder, and goes to the
+ * encoder, after config->annotate has drawn into it, once the consumer has
+ * released it and every frame captured before it.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef FRAME_SOURCE_MMAL_H
+#define FRAME_SOURCE_MMAL_H
+
+#include "frame_source.h"
+
+/* bcm_host_init() must have been called. */
+FRAME_SOURCE_T *frame_source_mmal_create(const FRAME_SOURCE_CONFIG_T *config);
+
+/* Frames the consumer never saw because a newer one replaced them. */
+uint32_t frame_source_mmal_dropped(FRAME_SOURCE_T *source);
+
+/* encode_video: frames the encoder skipped because it was ENCODER_IN_FLIGHT behind. */
+uint32_t frame_source_mmal_encode_dropped(FRAME_SOURCE_T *source);
+
+#endif /* FRAME_SOURCE_MMAL_H */
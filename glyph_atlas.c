@@ -0,0 +1,257 @@
+/*
+ * File:   glyph_atlas.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cairo/cairo.h>
+
+#include "glyph_atlas.h"
+
+static int ceil_int(double v) {
+    int i = (int) v;
+
+    return v > i ? i + 1 : i;
+}
+
+static int glyph_index(char c) {
+    int i = (unsigned char) c - GLYPH_ATLAS_FIRST;
+
+    return i >= 0 && i < GLYPH_ATLAS_CHARS ? i : '?' - GLYPH_ATLAS_FIRST;
+}
+
+static void set_font(cairo_t *cr, const char *face, int size) {
+    cairo_select_font_face(cr, face, CAIRO_FONT_SLANT_NORMAL, CAIRO_FONT_WEIGHT_NORMAL);
+    cairo_set_font_size(cr, size);
+}
+
+/* Advances, and cells wide enough for the widest ink. */
+static void measure(GLYPH_ATLAS_T *atlas, const char *face, int size) {
+    cairo_surface_t *surface = cairo_image_surface_create(CAIRO_FORMAT_A8, 1, 1);
+    cairo_t *cr = cairo_create(surface);
+    cairo_font_extents_t font;
+    cairo_text_extents_t glyph;
+    char s[2] = {0, 0};
+    int i, advance, ink;
+
+    set_font(cr, face, size);
+    cairo_font_extents(cr, &font);
+    for (i = 0; i < GLYPH_ATLAS_CHARS; i++) {
+        s[0] = GLYPH_ATLAS_FIRST + i;
+        cairo_text_extents(cr, s, &glyph);
+        advance = (int) (glyph.x_advance + 0.5);
+        atlas->advance[i] = advance > 255 ? 255 : advance;
+        ink = ceil_int(glyph.x_bearing + glyph.width);
+        if (advance > atlas->cell_width) {
+            atlas->cell_width = advance;
+        }
+        if (ink > atlas->cell_width) {
+            atlas->cell_width = ink;
+        }
+    }
+    atlas->baseline = ceil_int(font.ascent);
+    atlas->cell_height = atlas->baseline + ceil_int(font.descent);
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+}
+
+int glyph_atlas_init(GLYPH_ATLAS_T *atlas, const char *face, int size) {
+    cairo_surface_t *surface;
+    cairo_t *cr;
+    const unsigned char *data;
+    char s[2] = {0, 0};
+    int i, y, stride;
+
+    memset(atlas, 0, sizeof (GLYPH_ATLAS_T));
+    measure(atlas, face, size);
+    if (atlas->cell_width <= 0 || atlas->cell_height <= 0) {
+        fprintf(stderr, "Error: glyph_atlas: no glyphs for %s at %d\n", face, size);
+        return -1;
+    }
+    atlas->stride = atlas->cell_width * GLYPH_ATLAS_CHARS;
+    atlas->coverage = (uint8_t *) calloc((size_t) atlas->stride * atlas->cell_height, 1);
+    if (!atlas->coverage) {
+        return -1;
+    }
+    surface = cairo_image_surface_create(CAIRO_FORMAT_A8, atlas->stride, atlas->cell_height);
+    cr = cairo_create(surface);
+    set_font(cr, face, size);
+    cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 1.0);
+    for (i = 0; i < GLYPH_ATLAS_CHARS; i++) {
+        s[0] = GLYPH_ATLAS_FIRST + i;
+        // ink left of the pen would land in the previous cell
+        cairo_save(cr);
+        cairo_rectangle(cr, i * atlas->cell_width, 0, atlas->cell_width, atlas->cell_height);
+        cairo_clip(cr);
+        cairo_move_to(cr, i * atlas->cell_width, atlas->baseline);
+        cairo_show_text(cr, s);
+        cairo_restore(cr);
+    }
+    cairo_surface_flush(surface);
+    data = cairo_image_surface_get_data(surface);
+    stride = cairo_image_surface_get_stride(surface);
+    for (y = 0; y < atlas->cell_height; y++) {
+        memcpy(atlas->coverage + y * atlas->stride, data + y * stride, atlas->stride);
+    }
+    cairo_destroy(cr);
+    cairo_surface_destroy(surface);
+    return 0;
+}
+
+void glyph_atlas_destroy(GLYPH_ATLAS_T *atlas) {
+    free(atlas->coverage);
+    atlas->coverage = NULL;
+}
+
+void glyph_text_init(GLYPH_TEXT_T *text, const GLYPH_ATLAS_T *atlas) {
+    memset(text, 0, sizeof (GLYPH_TEXT_T));
+    text->atlas = atlas;
+}
+
+static uint32_t mix(uint32_t fg, uint32_t bg, int coverage) {
+    uint32_t out = 0;
+    int shift, f, b;
+
+    if (coverage == 0) {
+        return bg;
+    }
+    if (coverage == 255) {
+        return fg;
+    }
+    if ((bg >> 24) == 0) {
+        // nothing under the text, keep the colour and fade it in
+        return (fg & 0x00ffffffu) | (((fg >> 24) * coverage + 127) / 255) << 24;
+    }
+    for (shift = 0; shift < 32; shift += 8) {
+        f = (fg >> shift) & 0xff;
+        b = (bg >> shift) & 0xff;
+        out |= (uint32_t) (b + ((f - b) * coverage + (f > b ? 127 : -127)) / 255) << shift;
+    }
+    return out;
+}
+
+typedef struct {
+    int start;
+    int end;
+} SPAN_T;
+
+/* Columns [span->start, span->end) of the text, cleared to bg with every glyph that reaches in. */
+static int compose(GLYPH_TEXT_T *text, const SPAN_T *span, const char *string, const int *x, int length,
+        uint32_t *pixels, int stride, int width, int height, int x0, int y0) {
+    const GLYPH_ATLAS_T *atlas = text->atlas;
+    int cw = atlas->cell_width;
+    int start = x0 + span->start, end = x0 + span->end;
+    int first = 0, last, row, col, rel, j, off, cov, v;
+    const uint8_t *cell[GLYPH_TEXT_MAX];
+    uint32_t *dst;
+    int written = 0;
+
+    if (start < 0) {
+        start = 0;
+    }
+    if (end > width) {
+        end = width;
+    }
+    if (start >= end) {
+        return 0;
+    }
+    while (first < length && x[first] + cw <= span->start) {
+        first++;
+    }
+    last = first;
+    while (last < length && x[last] < span->end) {
+        cell[last] = atlas->coverage + glyph_index(string[last]) * cw;
+        last++;
+    }
+    for (row = 0; row < atlas->cell_height; row++) {
+        if (y0 + row < 0 || y0 + row >= height) {
+            continue;
+        }
+        dst = pixels + (y0 + row) * stride;
+        for (col = start; col < end; col++) {
+            rel = col - x0;
+            cov = 0;
+            for (j = first; j < last; j++) {
+                off = rel - x[j];
+                if (off >= 0 && off < cw) {
+                    v = cell[j][row * atlas->stride + off];
+                    cov = v > cov ? v : cov;
+                }
+            }
+            dst[col] = mix(text->fg, text->bg, cov);
+        }
+        written += end - start;
+    }
+    return written;
+}
+
+static void add_span(SPAN_T *spans, int *count, int start, int end) {
+    int i = *count;
+
+    // insertion by start, the list is short
+    while (i > 0 && spans[i - 1].start > start) {
+        spans[i] = spans[i - 1];
+        i--;
+    }
+    spans[i].start = start;
+    spans[i].end = end;
+    (*count)++;
+}
+
+int glyph_text_draw(GLYPH_TEXT_T *text, uint32_t *pixels, int stride, int width, int height,
+        int x0, int y0, const char *string, uint32_t fg, uint32_t bg) {
+    const GLYPH_ATLAS_T *atlas = text->atlas;
+    SPAN_T spans[GLYPH_TEXT_MAX * 2];
+    int x[GLYPH_TEXT_MAX];
+    int cw = atlas->cell_width;
+    int length = strlen(string);
+    int recolour = fg != text->fg || bg != text->bg;
+    int count = 0, merged = 0, written = 0, pen = 0;
+    int i, n;
+
+    if (length > GLYPH_TEXT_MAX - 1) {
+        length = GLYPH_TEXT_MAX - 1;
+    }
+    for (i = 0; i < length; i++) {
+        x[i] = pen;
+        pen += atlas->advance[glyph_index(string[i])];
+    }
+    // the cells each changed character leaves and the cells it goes to
+    n = length > text->length ? length : text->length;
+    for (i = 0; i < n; i++) {
+        if (!recolour && i < length && i < text->length && string[i] == text->text[i] && x[i] == text->x[i]) {
+            continue;
+        }
+        if (i < text->length) {
+            add_span(spans, &count, text->x[i], text->x[i] + cw);
+        }
+        if (i < length) {
+            add_span(spans, &count, x[i], x[i] + cw);
+        }
+    }
+    for (i = 0; i < count; i++) {
+        if (merged && spans[i].start <= spans[merged - 1].end) {
+            if (spans[i].end > spans[merged - 1].end) {
+                spans[merged - 1].end = spans[i].end;
+            }
+        } else {
+            spans[merged++] = spans[i];
+        }
+    }
+    text->fg = fg;
+    text->bg = bg;
+    for (i = 0; i < merged; i++) {
+        written += compose(text, &spans[i], string, x, length, pixels, stride, width, height, x0, y0);
+    }
+    text->dirty_x = merged ? x0 + spans[0].start : 0;
+    text->dirty_width = merged ? spans[merged - 1].end - spans[0].start : 0;
+    memcpy(text->text, string, length);
+    text->text[length] = 0;
+    memcpy(text->x, x, sizeof (int) * length);
+    text->length = length;
+    return written;
+}
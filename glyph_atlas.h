@@ -0,0 +1,68 @@
+/*
+ * File:   glyph_atlas.h
+ * Author: Hassan
+ *
+ * Text for the status overlays without a text renderer in the frame loop.
+ * glyph_atlas_init has cairo rasterise printable ASCII once, for one face
+ * and size, into an 8-bit coverage atlas of equal cells; after that a
+ * string is composed by blending cells into a 32-bit surface.
+ *
+ * GLYPH_TEXT_T remembers what a surface holds. Drawing a new string only
+ * recomposes the spans under characters that changed or moved, so a
+ * status line whose digits tick over costs a few cells, not the line.
+ * Cells may overhang the advance, a span is composed from every glyph that
+ * reaches into it.
+ *
+ * Surfaces are 32-bit pixels with alpha in the top byte, which is both
+ * vgfont's RGBA32 and cairo's ARGB32 on a little-endian Pi. Over a
+ * transparent background the colour keeps fg and the alpha follows the
+ * coverage; over anything else each byte is mixed from bg to fg.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <stdint.h>
+
+#define GLYPH_ATLAS_FIRST 32 // ' '
+#define GLYPH_ATLAS_CHARS 95 // to '~'
+#define GLYPH_TEXT_MAX 128
+
+typedef struct {
+    uint8_t *coverage; // cell_width x cell_height per character, side by side
+    int stride; // cell_width * GLYPH_ATLAS_CHARS
+    int cell_width;
+    int cell_height;
+    int baseline; // from the top of a cell
+    uint8_t advance[GLYPH_ATLAS_CHARS];
+} GLYPH_ATLAS_T;
+
+typedef struct {
+    const GLYPH_ATLAS_T *atlas;
+    char text[GLYPH_TEXT_MAX];
+    int x[GLYPH_TEXT_MAX]; // pen position of each character
+    int length;
+    uint32_t fg;
+    uint32_t bg;
+    int dirty_x; // span recomposed by the last draw, dirty_width 0 for none
+    int dirty_width;
+} GLYPH_TEXT_T;
+
+/* face as cairo_select_font_face takes it, size in pixels. */
+int glyph_atlas_init(GLYPH_ATLAS_T *atlas, const char *face, int size);
+void glyph_atlas_destroy(GLYPH_ATLAS_T *atlas);
+
+/* For a surface that holds bg only. */
+void glyph_text_init(GLYPH_TEXT_T *text, const GLYPH_ATLAS_T *atlas);
+
+/*
+ * Brings the cell_height rows at (x0, y0) of a width x height surface
+ * (stride in pixels) to string; the pixels written, see dirty_x. A text
+ * is always drawn at the same place on the same surface.
+ */
+int glyph_text_draw(GLYPH_TEXT_T *text, uint32_t *pixels, int stride, int width, int height,
+        int x0, int y0, const char *string, uint32_t fg, uint32_t bg);
+
+#endif /* GLYPH_ATLAS_H */
@@ -0,0 +1,182 @@
+/*
+ * File:   gpio_input.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "gpio_input.h"
+#include "sys_util.h"
+
+#define QUEUE_MASK (GPIO_INPUT_QUEUE_SIZE - 1)
+
+/* wiringPi pins 0-7 on a revision 2 board */
+static const int wiringpi_bcm[] = {17, 18, 27, 22, 23, 24, 25, 4};
+
+int gpio_wiringpi_to_bcm(int pin) {
+    if (pin < 0 || pin >= (int) (sizeof (wiringpi_bcm) / sizeof (wiringpi_bcm[0]))) {
+        return -1;
+    }
+    return wiringpi_bcm[pin];
+}
+
+void gpio_input_config_default(GPIO_INPUT_CONFIG_T *config) {
+    memset(config, 0, sizeof (GPIO_INPUT_CONFIG_T));
+    config->debounce_ms = GPIO_INPUT_DEBOUNCE_MS;
+}
+
+GPIO_INPUT_T *gpio_input_open(const char *spec, const GPIO_INPUT_CONFIG_T *config) {
+    if (strcmp(spec, "chip") == 0) {
+        return gpio_input_chardev_create(GPIO_INPUT_CHIP, config);
+    }
+    return gpio_input_sim_create(spec, config);
+}
+
+int gpio_input_start(GPIO_INPUT_T *input) {
+    return input->ops->start(input);
+}
+
+void gpio_input_destroy(GPIO_INPUT_T *input) {
+    if (input) {
+        input->ops->destroy(input);
+    }
+}
+
+void gpio_input_setup(GPIO_INPUT_T *input, const GPIO_INPUT_OPS_T *ops, const char *name, const GPIO_INPUT_CONFIG_T *config) {
+    int i;
+
+    input->ops = ops;
+    input->name = name;
+    input->pin_count = config->pin_count < GPIO_INPUT_MAX_PINS ? config->pin_count : GPIO_INPUT_MAX_PINS;
+    for (i = 0; i < input->pin_count; i++) {
+        memset(&input->pin[i], 0, sizeof (GPIO_PIN_STATE_T));
+        input->pin[i].pin = config->pins[i];
+    }
+    input->debounce_ns = (uint64_t) config->debounce_ms * 1000000ull;
+}
+
+void gpio_input_initial(GPIO_INPUT_T *input, int index, int level) {
+    input->pin[index].raw = level;
+    __atomic_store_n(&input->pin[index].stable, level, __ATOMIC_RELAXED);
+}
+
+/* Backend thread only. */
+static void push_event(GPIO_INPUT_T *input, int index, int level, uint64_t now) {
+    uint32_t tail = input->tail;
+    GPIO_EVENT_T *event;
+
+    __atomic_store_n(&input->pin[index].stable, level, __ATOMIC_RELAXED);
+    input->pin[index].lockout_until = now + input->debounce_ns;
+    if (tail - __atomic_load_n(&input->head, __ATOMIC_ACQUIRE) >= GPIO_INPUT_QUEUE_SIZE) {
+        // nobody is reading; the level above still tells the truth
+        __atomic_add_fetch(&input->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    event = &input->ring[tail & QUEUE_MASK];
+    event->pin = input->pin[index].pin;
+    event->level = level;
+    event->time_ns = now;
+    __atomic_store_n(&input->tail, tail + 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&input->signal, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&input->waiting, __ATOMIC_SEQ_CST)) {
+        futex_wake(&input->signal);
+    }
+}
+
+void gpio_input_edge(GPIO_INPUT_T *input, int index, int level, uint64_t time_ns) {
+    GPIO_PIN_STATE_T *pin = &input->pin[index];
+
+    input->edges++;
+    pin->raw = level;
+    if (time_ns < pin->lockout_until || level == pin->stable) {
+        // bouncing, gpio_input_settle reports where it ends up
+        input->bounces++;
+        return;
+    }
+    // the lockout runs from the edge itself
+    push_event(input, index, level, time_ns);
+}
+
+void gpio_input_settle(GPIO_INPUT_T *input, uint64_t now) {
+    int i;
+
+    for (i = 0; i < input->pin_count; i++) {
+        GPIO_PIN_STATE_T *pin = &input->pin[i];
+
+        if (pin->raw != pin->stable && now >= pin->lockout_until) {
+            push_event(input, i, pin->raw, now);
+        }
+    }
+}
+
+uint64_t gpio_input_next_settle(const GPIO_INPUT_T *input) {
+    uint64_t next = 0;
+    int i;
+
+    for (i = 0; i < input->pin_count; i++) {
+        const GPIO_PIN_STATE_T *pin = &input->pin[i];
+
+        if (pin->raw != pin->stable && (next == 0 || pin->lockout_until < next)) {
+            next = pin->lockout_until;
+        }
+    }
+    return next;
+}
+
+void gpio_input_finish(GPIO_INPUT_T *input) {
+    __atomic_store_n(&input->finished, 1, __ATOMIC_SEQ_CST);
+    __atomic_add_fetch(&input->signal, 1, __ATOMIC_SEQ_CST);
+    futex_wake(&input->signal);
+}
+
+int gpio_input_poll(GPIO_INPUT_T *input, GPIO_EVENT_T *event) {
+    uint32_t head = input->head;
+
+    if (__atomic_load_n(&input->tail, __ATOMIC_ACQUIRE) == head) {
+        return 0;
+    }
+    *event = input->ring[head & QUEUE_MASK];
+    __atomic_store_n(&input->head, head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+int gpio_input_wait(GPIO_INPUT_T *input, GPIO_EVENT_T *event, int timeout_ms) {
+    uint32_t seen;
+
+    for (;;) {
+        seen = __atomic_load_n(&input->signal, __ATOMIC_SEQ_CST);
+        if (gpio_input_poll(input, event)) {
+            return 1;
+        }
+        if (__atomic_load_n(&input->finished, __ATOMIC_SEQ_CST)) {
+            return -1;
+        }
+        if (timeout_ms == 0) {
+            return 0;
+        }
+        __atomic_store_n(&input->waiting, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&input->signal, __ATOMIC_SEQ_CST) == seen) {
+            futex_wait(&input->signal, seen, timeout_ms);
+        }
+        __atomic_store_n(&input->waiting, 0, __ATOMIC_SEQ_CST);
+        if (timeout_ms > 0 && __atomic_load_n(&input->signal, __ATOMIC_SEQ_CST) == seen) {
+            return 0;
+        }
+    }
+}
+
+int gpio_input_level(GPIO_INPUT_T *input, int pin) {
+    int i;
+
+    for (i = 0; i < input->pin_count; i++) {
+        if (input->pin[i].pin == pin) {
+            return __atomic_load_n(&input->pin[i].stable, __ATOMIC_RELAXED);
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,107 @@
+/*
+ * File:   gpio_input.h
+ * Author: Hassan
+ *
+ * Edge-triggered GPIO inputs. A backend thread sleeps until a line changes
+ * and turns every edge into a debounced, timestamped GPIO_EVENT_T on a
+ * lock-free single-consumer queue, so a press is neither missed nor held up
+ * by a slow detection frame:
+ *
+ *   chip       the GPIO character device with epoll (gpio_input_chardev.c)
+ *   simulated  edges replayed from a script file (gpio_input_sim.c)
+ *
+ * Debouncing takes the first edge at once and then locks the pin out for
+ * debounce_ms; whatever level the pin has settled on when the lockout ends
+ * is reported then if it differs. Pins are wiringPi numbers, as in SAM_demo.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef GPIO_INPUT_H
+#define GPIO_INPUT_H
+
+#include <stdint.h>
+
+#define GPIO_INPUT_MAX_PINS 8
+#define GPIO_INPUT_QUEUE_SIZE 64 // power of two
+#define GPIO_INPUT_DEBOUNCE_MS 20
+#define GPIO_INPUT_CHIP "/dev/gpiochip0"
+
+typedef struct {
+    int pin; // wiringPi number
+    int level;
+    uint64_t time_ns; // CLOCK_MONOTONIC, of the edge where the backend has its time stamp
+} GPIO_EVENT_T;
+
+typedef struct {
+    int pins[GPIO_INPUT_MAX_PINS];
+    int pin_count;
+    int debounce_ms;
+} GPIO_INPUT_CONFIG_T;
+
+typedef struct GPIO_INPUT_T GPIO_INPUT_T;
+
+typedef struct {
+    int (*start)(GPIO_INPUT_T *input);
+    void (*destroy)(GPIO_INPUT_T *input);
+} GPIO_INPUT_OPS_T;
+
+typedef struct {
+    int pin;
+    int raw; // last edge seen
+    int stable; // last level reported
+    uint64_t lockout_until; // ns
+} GPIO_PIN_STATE_T;
+
+struct GPIO_INPUT_T {
+    const GPIO_INPUT_OPS_T *ops;
+    const char *name;
+    int pin_count;
+    GPIO_PIN_STATE_T pin[GPIO_INPUT_MAX_PINS];
+    uint64_t debounce_ns;
+    GPIO_EVENT_T ring[GPIO_INPUT_QUEUE_SIZE];
+    uint32_t head; // next to pop, consumer owned
+    uint32_t tail; // next to push, backend owned
+    uint32_t signal; // futex, bumped with every event and at the end
+    uint32_t waiting;
+    uint32_t edges; // raw edges from the backend
+    uint32_t bounces; // ... swallowed by the debouncer
+    uint32_t dropped; // events lost to a full queue
+    int finished; // the backend has no more edges to give (end of script)
+};
+
+void gpio_input_config_default(GPIO_INPUT_CONFIG_T *config);
+
+/* "chip" opens GPIO_INPUT_CHIP, anything else is a script for the simulated backend. */
+GPIO_INPUT_T *gpio_input_open(const char *spec, const GPIO_INPUT_CONFIG_T *config);
+
+GPIO_INPUT_T *gpio_input_chardev_create(const char *chip, const GPIO_INPUT_CONFIG_T *config);
+GPIO_INPUT_T *gpio_input_sim_create(const char *script, const GPIO_INPUT_CONFIG_T *config);
+
+int gpio_input_start(GPIO_INPUT_T *input);
+void gpio_input_destroy(GPIO_INPUT_T *input);
+
+/* One thread only. 1 with an event, 0 when the queue is empty. */
+int gpio_input_poll(GPIO_INPUT_T *input, GPIO_EVENT_T *event);
+
+/*
+ * As gpio_input_poll, waiting up to timeout_ms for an event, -1 forever.
+ * Returns -1 once the backend has finished and the queue is empty.
+ */
+int gpio_input_wait(GPIO_INPUT_T *input, GPIO_EVENT_T *event, int timeout_ms);
+
+/* Debounced level of pin, from any thread; -1 for a pin not configured. */
+int gpio_input_level(GPIO_INPUT_T *input, int pin);
+
+/* BCM line of a wiringPi pin (board revision 2), -1 if unknown. */
+int gpio_wiringpi_to_bcm(int pin);
+
+/* For the backends. */
+void gpio_input_setup(GPIO_INPUT_T *input, const GPIO_INPUT_OPS_T *ops, const char *name, const GPIO_INPUT_CONFIG_T *config);
+void gpio_input_initial(GPIO_INPUT_T *input, int index, int level);
+void gpio_input_edge(GPIO_INPUT_T *input, int index, int level, uint64_t time_ns); // when the edge happened
+void gpio_input_settle(GPIO_INPUT_T *input, uint64_t now);
+uint64_t gpio_input_next_settle(const GPIO_INPUT_T *input); // 0 when nothing is pending
+void gpio_input_finish(GPIO_INPUT_T *input);
+
+#endif /* GPIO_INPUT_H */
@@ -0,0 +1,204 @@
+/*
+ * File:   gpio_input_chardev.c
+ * Author: Hassan
+ *
+ * GPIO inputs through the Linux GPIO character device: one line event
+ * request per pin for both edges, all of them on one epoll set watched by a
+ * thread, plus an eventfd to stop it. The epoll timeout is the next debounce
+ * lockout to end, so the thread sleeps unless a pin is changing.
+ *
+ * Edges carry the kernel's time stamp, taken in the interrupt, so the
+ * lockout and the event time start at the edge rather than at the thread's
+ * wakeup. It is CLOCK_MONOTONIC from Linux 5.7; an older kernel stamps
+ * CLOCK_REALTIME, which is taken for what it is and replaced by the time
+ * the edge was read.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+
+#include "gpio_input.h"
+#include "sys_util.h"
+
+#define CHARDEV_CONSUMER "SAM"
+#define STAMP_MAX_AGE_NS 10000000000ull // a monotonic stamp older than this is not one
+
+typedef struct {
+    GPIO_INPUT_T input;
+    int chip_fd;
+    int line_fd[GPIO_INPUT_MAX_PINS];
+    int epoll_fd;
+    int stop_fd;
+    pthread_t thread;
+    int started;
+} GPIO_INPUT_CHARDEV_T;
+
+/* The kernel's stamp when it is a CLOCK_MONOTONIC time no later than now, else now. */
+static uint64_t edge_time(uint64_t stamp, uint64_t now) {
+    return stamp <= now && now - stamp < STAMP_MAX_AGE_NS ? stamp : now;
+}
+
+static void read_edges(GPIO_INPUT_CHARDEV_T *dev, int index) {
+    struct gpioevent_data data;
+
+    // the line fd is non-blocking, drain what the kernel has queued
+    while (read(dev->line_fd[index], &data, sizeof (data)) == sizeof (data)) {
+        gpio_input_edge(&dev->input, index, data.id == GPIOEVENT_EVENT_RISING_EDGE,
+                edge_time(data.timestamp, now_ns()));
+    }
+}
+
+static void *chardev_thread(void *arg) {
+    GPIO_INPUT_CHARDEV_T *dev = (GPIO_INPUT_CHARDEV_T *) arg;
+    struct epoll_event events[GPIO_INPUT_MAX_PINS + 1];
+    uint64_t next, now;
+    int timeout, n, i;
+
+    for (;;) {
+        timeout = -1;
+        next = gpio_input_next_settle(&dev->input);
+        if (next) {
+            now = now_ns();
+            // round up, waking before the lockout ends would only loop
+            timeout = next > now ? (int) ((next - now + 999999) / 1000000) : 0;
+        }
+        n = epoll_wait(dev->epoll_fd, events, GPIO_INPUT_MAX_PINS + 1, timeout);
+        if (n < 0 && errno != EINTR) {
+            fprintf(stderr, "Error: gpio_input: epoll_wait failed\n");
+            break;
+        }
+        for (i = 0; i < n; i++) {
+            if (events[i].data.u32 == GPIO_INPUT_MAX_PINS) {
+                gpio_input_finish(&dev->input);
+                return NULL;
+            }
+            read_edges(dev, events[i].data.u32);
+        }
+        gpio_input_settle(&dev->input, now_ns());
+    }
+    gpio_input_finish(&dev->input);
+    return NULL;
+}
+
+static int chardev_start(GPIO_INPUT_T *input) {
+    GPIO_INPUT_CHARDEV_T *dev = (GPIO_INPUT_CHARDEV_T *) input;
+
+    if (pthread_create(&dev->thread, NULL, chardev_thread, dev) != 0) {
+        fprintf(stderr, "Error: gpio_input: unable to start the input thread\n");
+        return -1;
+    }
+    dev->started = 1;
+    return 0;
+}
+
+static void chardev_destroy(GPIO_INPUT_T *input) {
+    GPIO_INPUT_CHARDEV_T *dev = (GPIO_INPUT_CHARDEV_T *) input;
+    uint64_t one = 1;
+    int i;
+
+    if (dev->started) {
+        if (write(dev->stop_fd, &one, sizeof (one)) != sizeof (one)) {
+            fprintf(stderr, "Error: gpio_input: unable to stop the input thread\n");
+        }
+        pthread_join(dev->thread, NULL);
+    }
+    for (i = 0; i < input->pin_count; i++) {
+        if (dev->line_fd[i] >= 0) {
+            close(dev->line_fd[i]);
+        }
+    }
+    if (dev->stop_fd >= 0) {
+        close(dev->stop_fd);
+    }
+    if (dev->epoll_fd >= 0) {
+        close(dev->epoll_fd);
+    }
+    if (dev->chip_fd >= 0) {
+        close(dev->chip_fd);
+    }
+    free(dev);
+}
+
+static const GPIO_INPUT_OPS_T chardev_ops = {
+    chardev_start,
+    chardev_destroy
+};
+
+/* Requests both edges of one pin and puts it on the epoll set. */
+static int request_line(GPIO_INPUT_CHARDEV_T *dev, int index) {
+    struct gpioevent_request req;
+    struct gpiohandle_data value;
+    struct epoll_event ev;
+    int pin = dev->input.pin[index].pin;
+    int bcm = gpio_wiringpi_to_bcm(pin);
+
+    if (bcm < 0) {
+        fprintf(stderr, "Error: gpio_input: no BCM line for wiringPi pin %d\n", pin);
+        return -1;
+    }
+    memset(&req, 0, sizeof (req));
+    req.lineoffset = bcm;
+    req.handleflags = GPIOHANDLE_REQUEST_INPUT;
+    req.eventflags = GPIOEVENT_REQUEST_BOTH_EDGES;
+    strncpy(req.consumer_label, CHARDEV_CONSUMER, sizeof (req.consumer_label) - 1);
+    if (ioctl(dev->chip_fd, GPIO_GET_LINEEVENT_IOCTL, &req) < 0) {
+        fprintf(stderr, "Error: gpio_input: unable to request line %d (wiringPi %d)\n", bcm, pin);
+        return -1;
+    }
+    dev->line_fd[index] = req.fd;
+    fcntl(req.fd, F_SETFL, fcntl(req.fd, F_GETFL) | O_NONBLOCK);
+    if (ioctl(req.fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &value) == 0) {
+        gpio_input_initial(&dev->input, index, value.values[0] != 0);
+    }
+    memset(&ev, 0, sizeof (ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = index;
+    return epoll_ctl(dev->epoll_fd, EPOLL_CTL_ADD, req.fd, &ev);
+}
+
+GPIO_INPUT_T *gpio_input_chardev_create(const char *chip, const GPIO_INPUT_CONFIG_T *config) {
+    GPIO_INPUT_CHARDEV_T *dev = (GPIO_INPUT_CHARDEV_T *) calloc(1, sizeof (GPIO_INPUT_CHARDEV_T));
+    struct epoll_event ev;
+    int i;
+
+    if (!dev) {
+        return NULL;
+    }
+    gpio_input_setup(&dev->input, &chardev_ops, "chip", config);
+    for (i = 0; i < GPIO_INPUT_MAX_PINS; i++) {
+        dev->line_fd[i] = -1;
+    }
+    dev->chip_fd = open(chip, O_RDONLY | O_CLOEXEC);
+    dev->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    dev->stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (dev->chip_fd < 0 || dev->epoll_fd < 0 || dev->stop_fd < 0) {
+        fprintf(stderr, "Error: gpio_input: unable to open %s\n", chip);
+        chardev_destroy(&dev->input);
+        return NULL;
+    }
+    memset(&ev, 0, sizeof (ev));
+    ev.events = EPOLLIN;
+    ev.data.u32 = GPIO_INPUT_MAX_PINS;
+    if (epoll_ctl(dev->epoll_fd, EPOLL_CTL_ADD, dev->stop_fd, &ev) != 0) {
+        chardev_destroy(&dev->input);
+        return NULL;
+    }
+    for (i = 0; i < dev->input.pin_count; i++) {
+        if (request_line(dev, i) != 0) {
+            chardev_destroy(&dev->input);
+            return NULL;
+        }
+    }
+    return &dev->input;
+}
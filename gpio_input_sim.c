@@ -0,0 +1,198 @@
+/*
+ * File:   gpio_input_sim.c
+ * Author: Hassan
+ *
+ * Simulated GPIO inputs replayed in real time from a script, so debouncing
+ * and input latency can be checked on any Linux box. One edge per line:
+ *
+ *   # ms since start, wiringPi pin, level
+ *   1000 3 1
+ *   1002 3 0
+ *   1004 3 1
+ *
+ * Times must not go backwards. Pins start low. Edges are stamped with
+ * their scripted time, not the time the thread got round to them, so a run
+ * debounces the same way every time.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "gpio_input.h"
+#include "sys_util.h"
+
+#define SIM_STOP_CHECK_NS 50000000ull // longest sleep between looks at the stop flag
+
+typedef struct {
+    uint64_t time_ns; // since start
+    int index;
+    int level;
+} SIM_EDGE_T;
+
+typedef struct {
+    GPIO_INPUT_T input;
+    SIM_EDGE_T *edge;
+    int edge_count;
+    pthread_t thread;
+    int started;
+    int stop;
+} GPIO_INPUT_SIM_T;
+
+/* Sleeps until the CLOCK_MONOTONIC time due; 0 when stopped first. */
+static int sleep_until(GPIO_INPUT_SIM_T *sim, uint64_t due) {
+    struct timespec ts;
+    uint64_t now, wake;
+
+    for (;;) {
+        if (__atomic_load_n(&sim->stop, __ATOMIC_ACQUIRE)) {
+            return 0;
+        }
+        now = now_ns();
+        if (now >= due) {
+            return 1;
+        }
+        wake = due - now > SIM_STOP_CHECK_NS ? now + SIM_STOP_CHECK_NS : due;
+        ts.tv_sec = wake / 1000000000ull;
+        ts.tv_nsec = wake % 1000000000ull;
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR)
+            ;
+    }
+}
+
+static void *sim_thread(void *arg) {
+    GPIO_INPUT_SIM_T *sim = (GPIO_INPUT_SIM_T *) arg;
+    uint64_t start = now_ns();
+    uint64_t due, settle;
+    int i = 0;
+
+    for (;;) {
+        settle = gpio_input_next_settle(&sim->input);
+        if (i == sim->edge_count && settle == 0) {
+            break;
+        }
+        due = i < sim->edge_count ? start + sim->edge[i].time_ns : settle;
+        if (settle && settle < due) {
+            if (!sleep_until(sim, settle)) {
+                break;
+            }
+            gpio_input_settle(&sim->input, settle);
+            continue;
+        }
+        if (!sleep_until(sim, due)) {
+            break;
+        }
+        gpio_input_edge(&sim->input, sim->edge[i].index, sim->edge[i].level, due);
+        i++;
+    }
+    gpio_input_finish(&sim->input);
+    return NULL;
+}
+
+static int sim_start(GPIO_INPUT_T *input) {
+    GPIO_INPUT_SIM_T *sim = (GPIO_INPUT_SIM_T *) input;
+
+    if (pthread_create(&sim->thread, NULL, sim_thread, sim) != 0) {
+        fprintf(stderr, "Error: gpio_input: unable to start the simulation thread\n");
+        return -1;
+    }
+    sim->started = 1;
+    return 0;
+}
+
+static void sim_destroy(GPIO_INPUT_T *input) {
+    GPIO_INPUT_SIM_T *sim = (GPIO_INPUT_SIM_T *) input;
+
+    if (sim->started) {
+        __atomic_store_n(&sim->stop, 1, __ATOMIC_RELEASE);
+        pthread_join(sim->thread, NULL);
+    }
+    free(sim->edge);
+    free(sim);
+}
+
+static const GPIO_INPUT_OPS_T sim_ops = {
+    sim_start,
+    sim_destroy
+};
+
+static int pin_index(const GPIO_INPUT_T *input, int pin) {
+    int i;
+
+    for (i = 0; i < input->pin_count; i++) {
+        if (input->pin[i].pin == pin) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int load_script(GPIO_INPUT_SIM_T *sim, const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[256];
+    int capacity = 0, line_no = 0;
+    double ms, last_ms = 0;
+    int pin, level, index;
+    SIM_EDGE_T *grown;
+
+    if (!f) {
+        fprintf(stderr, "Error: gpio_input: unable to open script %s\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof (line), f)) {
+        char *p = line;
+
+        line_no++;
+        while (*p == ' ' || *p == '\t') {
+            p++;
+        }
+        if (*p == '#' || *p == '\n' || *p == '\r' || *p == 0) {
+            continue;
+        }
+        if (sscanf(p, "%lf %d %d", &ms, &pin, &level) != 3 || ms < last_ms) {
+            fprintf(stderr, "Error: gpio_input: %s:%d: expected \"ms pin level\" in time order\n", path, line_no);
+            fclose(f);
+            return -1;
+        }
+        index = pin_index(&sim->input, pin);
+        if (index < 0) {
+            // not an input of this run
+            continue;
+        }
+        if (sim->edge_count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            grown = (SIM_EDGE_T *) realloc(sim->edge, sizeof (SIM_EDGE_T) * capacity);
+            if (!grown) {
+                fclose(f);
+                return -1;
+            }
+            sim->edge = grown;
+        }
+        sim->edge[sim->edge_count].time_ns = (uint64_t) (ms * 1000000.0);
+        sim->edge[sim->edge_count].index = index;
+        sim->edge[sim->edge_count].level = level != 0;
+        sim->edge_count++;
+        last_ms = ms;
+    }
+    fclose(f);
+    return 0;
+}
+
+GPIO_INPUT_T *gpio_input_sim_create(const char *script, const GPIO_INPUT_CONFIG_T *config) {
+    GPIO_INPUT_SIM_T *sim = (GPIO_INPUT_SIM_T *) calloc(1, sizeof (GPIO_INPUT_SIM_T));
+
+    if (!sim) {
+        return NULL;
+    }
+    gpio_input_setup(&sim->input, &sim_ops, "simulated", config);
+    if (load_script(sim, script) != 0) {
+        sim_destroy(&sim->input);
+        return NULL;
+    }
+    return &sim->input;
+}
@@ -0,0 +1,151 @@
+/*
+ * File:   gpio_output.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "gpio_output.h"
+#include "sys_util.h"
+#include "gpio_input.h"
+
+#define REG(output, offset) ((output)->regs[(offset) / 4])
+
+uint32_t gpio_output_bit(int pin) {
+    int bcm = gpio_wiringpi_to_bcm(pin);
+
+    return bcm < 0 ? 0 : 1u << bcm;
+}
+
+/* Function select 001 (output) for one line, lines 0-31 only. */
+static void make_output(GPIO_OUTPUT_T *output, int bcm) {
+    volatile uint32_t *fsel = &output->regs[GPIO_REG_GPFSEL0 / 4 + bcm / 10];
+    int shift = (bcm % 10) * 3;
+
+    *fsel = (*fsel & ~(7u << shift)) | (1u << shift);
+}
+
+/* Caller holds the lock. */
+static void write_regs(GPIO_OUTPUT_T *output, uint32_t set, uint32_t clear) {
+    uint64_t t0 = now_ns(), t;
+
+    if (set) {
+        REG(output, GPIO_REG_GPSET0) = set;
+        output->writes++;
+    }
+    if (clear) {
+        REG(output, GPIO_REG_GPCLR0) = clear;
+        output->writes++;
+    }
+    if (output->fd < 0) {
+        // the real GPSET0 and GPCLR0 are write only and latch into GPLEV0
+        output->fake[GPIO_REG_GPLEV0 / 4] = (output->fake[GPIO_REG_GPLEV0 / 4] | set) & ~clear;
+    }
+    t = now_ns() - t0;
+    output->write_ns += t;
+    if (t > output->max_write_ns) {
+        output->max_write_ns = t;
+    }
+}
+
+static int map_gpiomem(GPIO_OUTPUT_T *output) {
+    void *block;
+
+    output->fd = open(GPIO_OUTPUT_MEM, O_RDWR | O_SYNC | O_CLOEXEC);
+    if (output->fd < 0) {
+        fprintf(stderr, "Error: gpio_output: unable to open %s\n", GPIO_OUTPUT_MEM);
+        return -1;
+    }
+    block = mmap(NULL, GPIO_OUTPUT_BLOCK_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, output->fd, 0);
+    if (block == MAP_FAILED) {
+        fprintf(stderr, "Error: gpio_output: unable to map %s\n", GPIO_OUTPUT_MEM);
+        return -1;
+    }
+    output->regs = (volatile uint32_t *) block;
+    return 0;
+}
+
+GPIO_OUTPUT_T *gpio_output_open(const char *spec, const int *pins, int pin_count) {
+    GPIO_OUTPUT_T *output = (GPIO_OUTPUT_T *) calloc(1, sizeof (GPIO_OUTPUT_T));
+    int i, bcm;
+
+    if (!output) {
+        return NULL;
+    }
+    output->fd = -1;
+    pthread_mutex_init(&output->lock, NULL);
+    if (strcmp(spec, "fake") == 0) {
+        output->regs = output->fake;
+    } else if (strcmp(spec, "gpiomem") != 0 || map_gpiomem(output) != 0) {
+        gpio_output_destroy(output);
+        return NULL;
+    }
+    for (i = 0; i < pin_count; i++) {
+        bcm = gpio_wiringpi_to_bcm(pins[i]);
+        if (bcm < 0) {
+            fprintf(stderr, "Error: gpio_output: no BCM line for wiringPi pin %d\n", pins[i]);
+            gpio_output_destroy(output);
+            return NULL;
+        }
+        make_output(output, bcm);
+        output->mask |= 1u << bcm;
+    }
+    write_regs(output, 0, output->mask);
+    output->state = 0;
+    return output;
+}
+
+void gpio_output_destroy(GPIO_OUTPUT_T *output) {
+    if (!output) {
+        return;
+    }
+    if (output->regs && output->fd >= 0) {
+        munmap((void *) output->regs, GPIO_OUTPUT_BLOCK_SIZE);
+    }
+    if (output->fd >= 0) {
+        close(output->fd);
+    }
+    pthread_mutex_destroy(&output->lock);
+    free(output);
+}
+
+void gpio_output_update(GPIO_OUTPUT_T *output, uint32_t values, uint32_t mask) {
+    uint32_t change;
+
+    pthread_mutex_lock(&output->lock);
+    output->updates++;
+    change = (values ^ output->state) & mask & output->mask;
+    if (change) {
+        write_regs(output, change & values, change & ~values);
+        output->state ^= change;
+    } else {
+        output->skipped++;
+    }
+    pthread_mutex_unlock(&output->lock);
+}
+
+void gpio_output_set(GPIO_OUTPUT_T *output, int pin, int level) {
+    uint32_t bit = gpio_output_bit(pin);
+
+    gpio_output_update(output, level ? bit : 0, bit);
+}
+
+uint32_t gpio_output_levels(GPIO_OUTPUT_T *output) {
+    return REG(output, GPIO_REG_GPLEV0);
+}
+
+void gpio_output_print_stats(GPIO_OUTPUT_T *output, FILE *out) {
+    pthread_mutex_lock(&output->lock);
+    fprintf(out, "outputs: %u updates, %u unchanged, %u register writes, %.2f us per write, %.2f us worst\n",
+            output->updates, output->skipped, output->writes,
+            output->writes ? output->write_ns / 1000.0 / output->writes : 0.0, output->max_write_ns / 1000.0);
+    pthread_mutex_unlock(&output->lock);
+}
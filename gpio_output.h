@@ -0,0 +1,69 @@
+/*
+ * File:   gpio_output.h
+ * Author: Hassan
+ *
+ * GPIO outputs written straight to the BCM283x registers. The last level
+ * of every pin is cached, so an update only touches the hardware for the
+ * pins that change, and all of those go out in at most one GPSET0 and one
+ * GPCLR0 store, with no syscall and no library call on the way:
+ *
+ *   gpiomem  the GPIO block mapped from /dev/gpiomem
+ *   fake     a register file in memory that also latches GPLEV0, for tests
+ *
+ * Updates are serialised by a mutex, so the frame loop and a timer thread
+ * may both drive pins. Pins are wiringPi numbers, mapped with
+ * gpio_wiringpi_to_bcm.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef GPIO_OUTPUT_H
+#define GPIO_OUTPUT_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define GPIO_OUTPUT_MEM "/dev/gpiomem"
+#define GPIO_OUTPUT_BLOCK_SIZE 4096
+
+/* register byte offsets in the GPIO block */
+#define GPIO_REG_GPFSEL0 0x00
+#define GPIO_REG_GPSET0 0x1c
+#define GPIO_REG_GPCLR0 0x28
+#define GPIO_REG_GPLEV0 0x34
+
+typedef struct {
+    volatile uint32_t *regs; // GPIO block
+    int fd; // /dev/gpiomem, -1 for the fake
+    uint32_t mask; // BCM lines configured as outputs
+    uint32_t state; // cached levels of those lines
+    pthread_mutex_t lock;
+    uint32_t fake[GPIO_OUTPUT_BLOCK_SIZE / 4];
+    uint32_t updates;
+    uint32_t writes; // register stores
+    uint32_t skipped; // updates that changed nothing
+    uint64_t write_ns; // time spent in the stores
+    uint64_t max_write_ns;
+} GPIO_OUTPUT_T;
+
+/* 1 << BCM line of a wiringPi pin, 0 if unknown. */
+uint32_t gpio_output_bit(int pin);
+
+/* "gpiomem" or "fake"; the pins are made outputs and start low. */
+GPIO_OUTPUT_T *gpio_output_open(const char *spec, const int *pins, int pin_count);
+void gpio_output_destroy(GPIO_OUTPUT_T *output);
+
+/* Sets the pins in mask (gpio_output_bit) to the levels in values, writing only the changes. */
+void gpio_output_update(GPIO_OUTPUT_T *output, uint32_t values, uint32_t mask);
+
+/* One pin. */
+void gpio_output_set(GPIO_OUTPUT_T *output, int pin, int level);
+
+/* Levels the hardware (or the fake) reports. */
+uint32_t gpio_output_levels(GPIO_OUTPUT_T *output);
+
+/* Updates, register stores and how long the stores took, to out. */
+void gpio_output_print_stats(GPIO_OUTPUT_T *output, FILE *out);
+
+#endif /* GPIO_OUTPUT_H */
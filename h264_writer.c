@@ -0,0 +1,594 @@
+/*
+ * File:   h264_writer.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "h264_writer.h"
+#include "sys_util.h"
+
+static int to_stdout(const H264_WRITER_T *writer) {
+    return !writer->config.path || strcmp(writer->config.path, "-") == 0;
+}
+
+void h264_writer_config_default(H264_WRITER_CONFIG_T *config) {
+    memset(config, 0, sizeof (H264_WRITER_CONFIG_T));
+    config->ring_size = 8 << 20; // 30 s of 2 Mbit/s
+    config->batch_size = 256 << 10;
+    config->flush_ms = 500;
+    config->segment_bytes = 512ull << 20;
+    config->segment_seconds = 300;
+    config->preallocate = 80ull << 20; // a full-length segment at 2 Mbit/s
+    config->fsync = H264_WRITER_FSYNC_SEGMENT;
+    config->fsync_ms = 2000;
+    config->fps = 30.0;
+}
+
+void h264_split_init(H264_SPLIT_T *split) {
+    split->frame_start = 1;
+    split->after_config = 0;
+}
+
+int h264_split_check(H264_SPLIT_T *split, int flags) {
+    int result = split->frame_start && !split->after_config && (flags & (H264_WRITER_CONFIG | H264_WRITER_KEYFRAME));
+
+    split->frame_start = (flags & (H264_WRITER_FRAME_END | H264_WRITER_CONFIG)) != 0;
+    split->after_config = (flags & H264_WRITER_CONFIG) != 0;
+    return result;
+}
+
+static void update_max(uint32_t *max, uint32_t value) {
+    if (value > __atomic_load_n(max, __ATOMIC_RELAXED)) {
+        __atomic_store_n(max, value, __ATOMIC_RELAXED);
+    }
+}
+
+/* Writer thread only, as is everything down to writer_thread. */
+static void timed_sync(H264_WRITER_T *writer) {
+    uint64_t t0 = now_ns();
+
+    fdatasync(writer->fd);
+    if (writer->index_fd >= 0) {
+        fdatasync(writer->index_fd);
+    }
+    writer->synced_ns = now_ns();
+    update_max(&writer->stats.max_write_ms, (uint32_t) ((writer->synced_ns - t0) / 1000000));
+    __atomic_add_fetch(&writer->stats.fsyncs, 1, __ATOMIC_RELAXED);
+}
+
+/* One past the highest segment number of path on disk, in either format. */
+static uint32_t first_free_segment(const char *path) {
+    const char *base = strrchr(path, '/');
+    char dir[512], ext[8];
+    size_t base_length;
+    unsigned int number;
+    uint32_t next = 0;
+    int used;
+    DIR *d;
+    struct dirent *e;
+
+    if (base) {
+        snprintf(dir, sizeof (dir), "%.*s", base == path ? 1 : (int) (base - path), path);
+        base++;
+    } else {
+        snprintf(dir, sizeof (dir), ".");
+        base = path;
+    }
+    base_length = strlen(base);
+    d = opendir(dir);
+    if (!d) {
+        return 0;
+    }
+    while ((e = readdir(d)) != NULL) {
+        const char *tail = e->d_name + base_length;
+
+        if (strncmp(e->d_name, base, base_length) != 0 || tail[0] != '-' || !isdigit((unsigned char) tail[1])
+                || sscanf(tail + 1, "%u.%7s%n", &number, ext, &used) != 2 || tail[1 + used] != '\0'
+                || (strcmp(ext, "h264") != 0 && strcmp(ext, "mp4") != 0)) {
+            continue;
+        }
+        if (number >= next) {
+            next = number + 1;
+        }
+    }
+    closedir(d);
+    return next;
+}
+
+static int open_segment(H264_WRITER_T *writer) {
+    char name[512];
+
+    writer->segment_size = 0;
+    writer->segment_start_ns = now_ns();
+    if (to_stdout(writer)) {
+        writer->fd = STDOUT_FILENO;
+        return 0;
+    }
+    // never over an earlier recording, whoever wrote it since the numbers were taken
+    do {
+        snprintf(name, sizeof (name), "%s-%04u.%s", writer->config.path, writer->segment,
+                writer->config.format == H264_WRITER_MP4 ? "mp4" : "h264");
+        writer->fd = open(name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    } while (writer->fd < 0 && errno == EEXIST && ++writer->segment != 0);
+    if (writer->fd < 0) {
+        fprintf(stderr, "Error: h264_writer: unable to open %s: %s\n", name, strerror(errno));
+        return -1;
+    }
+    // the blocks are reserved up front, the file size still follows what is written;
+    // not every file system can, and nothing depends on it
+    if (writer->config.preallocate) {
+        fallocate(writer->fd, FALLOC_FL_KEEP_SIZE, 0, (off_t) writer->config.preallocate);
+    }
+    __atomic_add_fetch(&writer->stats.segments, 1, __ATOMIC_RELAXED);
+    return 0;
+}
+
+static void close_segment(H264_WRITER_T *writer) {
+    if (writer->fd < 0 || writer->fd == STDOUT_FILENO) {
+        return;
+    }
+    // hands back the preallocated blocks the segment did not use
+    if (writer->config.preallocate) {
+        ftruncate(writer->fd, (off_t) writer->segment_size);
+    }
+    if (writer->config.fsync != H264_WRITER_FSYNC_NONE) {
+        timed_sync(writer);
+    }
+    close(writer->fd);
+    writer->fd = -1;
+}
+
+static void next_segment(H264_WRITER_T *writer) {
+    close_segment(writer);
+    writer->segment++;
+    open_segment(writer);
+}
+
+static void write_out(H264_WRITER_T *writer, const uint8_t *data, uint32_t length) {
+    uint64_t t0 = now_ns();
+    size_t n = writer->fd >= 0 ? write_all(writer->fd, data, length) : 0;
+
+    writer->segment_size += (uint64_t) n;
+    __atomic_add_fetch(&writer->stats.bytes_written, (uint64_t) n, __ATOMIC_RELAXED);
+    if (n < length) {
+        if (__atomic_add_fetch(&writer->stats.write_errors, 1, __ATOMIC_RELAXED) == 1) {
+            fprintf(stderr, "Error: h264_writer: write failed, dropping data from here on: %s\n",
+                    writer->fd >= 0 ? strerror(errno) : "no segment open");
+        }
+        __atomic_add_fetch(&writer->stats.bytes_dropped, length - n, __ATOMIC_RELAXED);
+    }
+    __atomic_add_fetch(&writer->stats.writes, 1, __ATOMIC_RELAXED);
+    update_max(&writer->stats.max_write_ms, (uint32_t) ((now_ns() - t0) / 1000000));
+}
+
+/* A segment starts with the init segment, when there is one. */
+static void write_header(H264_WRITER_T *writer) {
+    uint32_t length = __atomic_load_n(&writer->header_length, __ATOMIC_ACQUIRE);
+
+    if (length > 0 && writer->fd >= 0) {
+        write_out(writer, writer->header, length);
+    }
+}
+
+static void index_chunk(H264_WRITER_T *writer, const H264_WRITER_CHUNK_T *c) {
+    H264_WRITER_INDEX_T *entry;
+
+    if (writer->index_fd < 0 || writer->index_count == H264_WRITER_INDEX_BATCH) {
+        return;
+    }
+    entry = &writer->index[writer->index_count++];
+    entry->time_ns = c->time_ns;
+    entry->pts = c->pts;
+    entry->offset = writer->segment_size - (writer->head - c->start);
+    entry->segment = writer->segment;
+    entry->wall_s = (uint32_t) time(NULL);
+}
+
+static void write_index(H264_WRITER_T *writer) {
+    size_t length = writer->index_count * sizeof (H264_WRITER_INDEX_T);
+
+    // whole entries or none, a reader can rely on the file size
+    if (writer->index_count > 0 && write(writer->index_fd, writer->index, length) != (ssize_t) length) {
+        __atomic_add_fetch(&writer->stats.write_errors, 1, __ATOMIC_RELAXED);
+    }
+    writer->index_count = 0;
+}
+
+static int segment_due(const H264_WRITER_T *writer, uint64_t now) {
+    const H264_WRITER_CONFIG_T *c = &writer->config;
+
+    if (to_stdout(writer)) {
+        return 0;
+    }
+    if (writer->fd < 0) {
+        // opening the last one failed, try again at the next split
+        return 1;
+    }
+    return writer->segment_size > 0 && ((c->segment_bytes && writer->segment_size >= c->segment_bytes)
+            || (c->segment_seconds && now - writer->segment_start_ns >= (uint64_t) c->segment_seconds * 1000000000ull));
+}
+
+/* The first chunk a segment may start at from head on; 0 when none is queued. */
+static int find_split(H264_WRITER_T *writer, uint32_t chunk_tail, uint32_t *position) {
+    H264_WRITER_CHUNK_T *c;
+    uint32_t i;
+
+    for (i = writer->chunk_head; i != chunk_tail; i++) {
+        c = &writer->chunk[i & (H264_WRITER_CHUNKS - 1)];
+        if (c->split && (int32_t) (c->start - writer->head) >= 0) {
+            *position = c->start;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Writes what is due: full batches, everything once the oldest byte is flush_ms old, or all of it. */
+static void write_ready(H264_WRITER_T *writer, int all) {
+    uint32_t ring_size = writer->ring_mask + 1;
+    uint32_t batch = (uint32_t) writer->config.batch_size;
+    uint32_t tail, chunk_tail, limit, split, n, at;
+    uint64_t now;
+    int flush, rotated = 0;
+    H264_WRITER_CHUNK_T *c;
+
+    for (;;) {
+        tail = __atomic_load_n(&writer->tail, __ATOMIC_ACQUIRE);
+        chunk_tail = __atomic_load_n(&writer->chunk_tail, __ATOMIC_ACQUIRE);
+        if (writer->head == tail) {
+            break;
+        }
+        now = now_ns();
+        limit = tail;
+        flush = all;
+        // once per write, a segment that failed to open is not retried in a loop
+        if (!rotated && segment_due(writer, now) && find_split(writer, chunk_tail, &split)) {
+            if (split == writer->head) {
+                next_segment(writer);
+                rotated = 1;
+                continue;
+            }
+            // the rest of this segment goes out now, whatever its size
+            limit = split;
+            flush = 1;
+        }
+        c = &writer->chunk[writer->chunk_head & (H264_WRITER_CHUNKS - 1)];
+        if (now - c->time_ns >= (uint64_t) writer->config.flush_ms * 1000000ull) {
+            flush = 1;
+        }
+        n = limit - writer->head;
+        if (!flush && n < batch) {
+            break;
+        }
+        at = writer->head & writer->ring_mask;
+        if (n > ring_size - at) {
+            n = ring_size - at;
+        }
+        if (!flush) {
+            // batches end on an alignment boundary of the file
+            if (n > batch) {
+                n = batch;
+            }
+            n -= (uint32_t) ((writer->segment_size + n) % H264_WRITER_ALIGN);
+            if (n == 0) {
+                break;
+            }
+        }
+        if (writer->segment_size == 0) {
+            write_header(writer);
+        }
+        write_out(writer, writer->ring + at, n);
+        rotated = 0;
+        __atomic_store_n(&writer->head, writer->head + n, __ATOMIC_RELEASE);
+        while (writer->chunk_head != chunk_tail) {
+            c = &writer->chunk[writer->chunk_head & (H264_WRITER_CHUNKS - 1)];
+            if ((int32_t) (c->start + c->length - writer->head) > 0) {
+                break;
+            }
+            // a chunk never spans two segments, it is all in this one
+            if (c->split) {
+                index_chunk(writer, c);
+            }
+            __atomic_store_n(&writer->chunk_head, writer->chunk_head + 1, __ATOMIC_RELEASE);
+        }
+        write_index(writer);
+        if (writer->config.fsync == H264_WRITER_FSYNC_INTERVAL && writer->fd >= 0 && writer->fd != STDOUT_FILENO
+                && now_ns() - writer->synced_ns >= (uint64_t) writer->config.fsync_ms * 1000000ull) {
+            timed_sync(writer);
+        }
+    }
+}
+
+static void *writer_thread(void *arg) {
+    H264_WRITER_T *writer = (H264_WRITER_T *) arg;
+    uint32_t signal;
+
+    while (!__atomic_load_n(&writer->stop, __ATOMIC_ACQUIRE)) {
+        signal = __atomic_load_n(&writer->signal, __ATOMIC_ACQUIRE);
+        write_ready(writer, 0);
+        __atomic_store_n(&writer->sleeping, 1, __ATOMIC_SEQ_CST);
+        // a push that filled a batch since the load above has changed signal
+        futex_wait(&writer->signal, signal, writer->config.flush_ms);
+        __atomic_store_n(&writer->sleeping, 0, __ATOMIC_SEQ_CST);
+    }
+    write_ready(writer, 1);
+    return NULL;
+}
+
+static void push_fragment(const uint8_t *data, size_t length, int key, int64_t pts, void *arg);
+
+static void free_all(H264_WRITER_T *writer) {
+    if (writer->config.format == H264_WRITER_MP4) {
+        mp4_mux_destroy(&writer->mux);
+    }
+    if (writer->index_fd >= 0) {
+        close(writer->index_fd);
+        writer->index_fd = -1;
+    }
+    free(writer->ring);
+    writer->ring = NULL;
+}
+
+int h264_writer_init(H264_WRITER_T *writer, const H264_WRITER_CONFIG_T *config) {
+    H264_WRITER_CONFIG_T *c = &writer->config;
+    size_t ring_size = H264_WRITER_ALIGN;
+
+    memset(writer, 0, sizeof (H264_WRITER_T));
+    writer->config = *config;
+    c->batch_size = (c->batch_size + H264_WRITER_ALIGN - 1) / H264_WRITER_ALIGN * H264_WRITER_ALIGN;
+    if (c->batch_size == 0) {
+        c->batch_size = H264_WRITER_ALIGN;
+    }
+    // at least two batches, so one can fill while the other is written
+    while (ring_size < c->ring_size || ring_size < 2 * c->batch_size) {
+        ring_size <<= 1;
+    }
+    if (ring_size > (1u << 30)) {
+        fprintf(stderr, "Error: h264_writer: ring of %zu bytes is too large\n", c->ring_size);
+        return -1;
+    }
+    c->ring_size = ring_size;
+    if (c->flush_ms <= 0) {
+        c->flush_ms = 1;
+    }
+    if (c->fsync_ms <= 0) {
+        c->fsync_ms = 1;
+    }
+    if (posix_memalign((void **) &writer->ring, H264_WRITER_ALIGN, ring_size) != 0) {
+        fprintf(stderr, "Error: h264_writer: no memory for a %zu byte ring\n", ring_size);
+        writer->ring = NULL;
+        return -1;
+    }
+    writer->ring_mask = (uint32_t) ring_size - 1;
+    h264_split_init(&writer->split);
+    writer->fd = -1;
+    writer->index_fd = -1;
+    if (c->format == H264_WRITER_MP4 && mp4_mux_init(&writer->mux, c->fps, push_fragment, writer) != 0) {
+        free(writer->ring);
+        writer->ring = NULL;
+        return -1;
+    }
+    if (c->index && !to_stdout(writer)) {
+        char name[512];
+        off_t size;
+
+        // the earlier runs' entries stay, a torn one at the end of the last run goes
+        snprintf(name, sizeof (name), "%s.idx", c->path);
+        writer->index_fd = open(name, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (writer->index_fd < 0) {
+            fprintf(stderr, "Error: h264_writer: unable to open %s: %s\n", name, strerror(errno));
+        } else if ((size = lseek(writer->index_fd, 0, SEEK_END)) % (off_t) sizeof (H264_WRITER_INDEX_T) != 0) {
+            ftruncate(writer->index_fd, size - size % (off_t) sizeof (H264_WRITER_INDEX_T));
+        }
+    }
+    if (!to_stdout(writer)) {
+        writer->segment = first_free_segment(c->path);
+    }
+    if (open_segment(writer) != 0) {
+        free_all(writer);
+        return -1;
+    }
+    writer->synced_ns = now_ns();
+    if (pthread_create(&writer->thread, NULL, writer_thread, writer) != 0) {
+        fprintf(stderr, "Error: h264_writer: unable to start the writer thread\n");
+        close_segment(writer);
+        free_all(writer);
+        return -1;
+    }
+    return 0;
+}
+
+void h264_writer_destroy(H264_WRITER_T *writer) {
+    if (!writer->ring) {
+        return;
+    }
+    if (writer->config.format == H264_WRITER_MP4) {
+        mp4_mux_flush(&writer->mux);
+    }
+    __atomic_store_n(&writer->stop, 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&writer->signal, 1, __ATOMIC_RELEASE);
+    futex_wake(&writer->signal);
+    pthread_join(writer->thread, NULL);
+    close_segment(writer);
+    free_all(writer);
+}
+
+static void drop(H264_WRITER_T *writer, size_t length) {
+    writer->skipping = 1;
+    __atomic_add_fetch(&writer->stats.buffers_dropped, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&writer->stats.bytes_dropped, (uint64_t) length, __ATOMIC_RELAXED);
+}
+
+static int push_chunk(H264_WRITER_T *writer, const uint8_t *data, size_t length, int flags, int64_t pts) {
+    uint32_t ring_size = writer->ring_mask + 1;
+    uint32_t tail = writer->tail;
+    uint32_t chunk_tail = writer->chunk_tail;
+    uint32_t used, at, first;
+    H264_WRITER_CHUNK_T *c;
+    int split;
+
+    split = h264_split_check(&writer->split, flags);
+    if (length == 0) {
+        return 0;
+    }
+    if (writer->skipping && !split) {
+        drop(writer, length);
+        return -1;
+    }
+    used = tail - __atomic_load_n(&writer->head, __ATOMIC_ACQUIRE);
+    if (length > ring_size - used
+            || chunk_tail - __atomic_load_n(&writer->chunk_head, __ATOMIC_ACQUIRE) == H264_WRITER_CHUNKS) {
+        drop(writer, length);
+        return -1;
+    }
+    writer->skipping = 0;
+
+    at = tail & writer->ring_mask;
+    first = ring_size - at < length ? ring_size - at : (uint32_t) length;
+    memcpy(writer->ring + at, data, first);
+    memcpy(writer->ring, data + first, length - first);
+    c = &writer->chunk[chunk_tail & (H264_WRITER_CHUNKS - 1)];
+    c->start = tail;
+    c->length = (uint32_t) length;
+    c->time_ns = now_ns();
+    c->pts = pts;
+    c->split = split;
+    __atomic_store_n(&writer->chunk_tail, chunk_tail + 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&writer->tail, tail + (uint32_t) length, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&writer->stats.bytes_in, (uint64_t) length, __ATOMIC_RELAXED);
+    update_max(&writer->stats.max_lag_bytes, used + (uint32_t) length);
+
+    // the writer only needs waking for a full batch, it looks on its own every flush_ms
+    if (used < writer->config.batch_size && used + length >= writer->config.batch_size) {
+        __atomic_add_fetch(&writer->signal, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&writer->sleeping, __ATOMIC_SEQ_CST)) {
+            futex_wake(&writer->signal);
+        }
+    }
+    return 0;
+}
+
+/* mp4_mux output: one fragment a picture, an IDR one is where a segment may start. */
+static void push_fragment(const uint8_t *data, size_t length, int key, int64_t pts, void *arg) {
+    H264_WRITER_T *writer = (H264_WRITER_T *) arg;
+
+    if (!writer->header_length) {
+        // the mux builds it before the first fragment, and never changes it after
+        memcpy(writer->header, writer->mux.init, writer->mux.init_length);
+        __atomic_store_n(&writer->header_length, writer->mux.init_length, __ATOMIC_RELEASE);
+    }
+    if (push_chunk(writer, data, length, key ? H264_WRITER_KEYFRAME | H264_WRITER_FRAME_END : H264_WRITER_FRAME_END, pts) != 0) {
+        writer->mux_result = -1;
+    }
+}
+
+int h264_writer_push(H264_WRITER_T *writer, const uint8_t *data, size_t length, int flags, int64_t pts) {
+    if (writer->config.format != H264_WRITER_MP4) {
+        return push_chunk(writer, data, length, flags, pts);
+    }
+    // SPS/PPS go with the IDR after them into one picture
+    writer->mux_result = 0;
+    mp4_mux_push(&writer->mux, data, length, (flags & H264_WRITER_FRAME_END) && !(flags & H264_WRITER_CONFIG), pts);
+    return writer->mux_result;
+}
+
+void h264_writer_get_stats(H264_WRITER_T *writer, H264_WRITER_STATS_T *stats) {
+    H264_WRITER_STATS_T *s = &writer->stats;
+    uint32_t head = __atomic_load_n(&writer->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = __atomic_load_n(&writer->tail, __ATOMIC_ACQUIRE);
+    uint32_t chunk_head = __atomic_load_n(&writer->chunk_head, __ATOMIC_ACQUIRE);
+    uint64_t pushed;
+
+    stats->bytes_in = __atomic_load_n(&s->bytes_in, __ATOMIC_RELAXED);
+    stats->bytes_written = __atomic_load_n(&s->bytes_written, __ATOMIC_RELAXED);
+    stats->bytes_dropped = __atomic_load_n(&s->bytes_dropped, __ATOMIC_RELAXED);
+    stats->buffers_dropped = __atomic_load_n(&s->buffers_dropped, __ATOMIC_RELAXED);
+    stats->writes = __atomic_load_n(&s->writes, __ATOMIC_RELAXED);
+    stats->write_errors = __atomic_load_n(&s->write_errors, __ATOMIC_RELAXED);
+    stats->fsyncs = __atomic_load_n(&s->fsyncs, __ATOMIC_RELAXED);
+    stats->segments = __atomic_load_n(&s->segments, __ATOMIC_RELAXED);
+    stats->max_lag_bytes = __atomic_load_n(&s->max_lag_bytes, __ATOMIC_RELAXED);
+    stats->max_write_ms = __atomic_load_n(&s->max_write_ms, __ATOMIC_RELAXED);
+    stats->lag_bytes = tail - head;
+    stats->lag_ms = 0;
+    if (head != tail) {
+        // the slot may be reused under us if the writer catches up meanwhile, close enough for a metric
+        pushed = __atomic_load_n(&writer->chunk[chunk_head & (H264_WRITER_CHUNKS - 1)].time_ns, __ATOMIC_RELAXED);
+        stats->lag_ms = (uint32_t) ((now_ns() - pushed) / 1000000);
+    }
+}
+
+void h264_writer_print_stats(H264_WRITER_T *writer) {
+    H264_WRITER_STATS_T s;
+
+    h264_writer_get_stats(writer, &s);
+    fprintf(stderr, "h264_writer: %u segments, %.1f MB in %u writes, lag %u bytes %u ms (max %u bytes), longest write %u ms, "
+            "%u buffers %llu bytes dropped, %u write errors, %u fsyncs\n",
+            s.segments, s.bytes_written / 1048576.0, s.writes, s.lag_bytes, s.lag_ms, s.max_lag_bytes, s.max_write_ms,
+            s.buffers_dropped, (unsigned long long) s.bytes_dropped, s.write_errors, s.fsyncs);
+}
+
+/* Where the entries of the last boot start: time_ns is CLOCK_MONOTONIC and starts over with a reboot. */
+static off_t last_boot(int fd, off_t count) {
+    H264_WRITER_INDEX_T e[H264_WRITER_INDEX_BATCH];
+    uint64_t later = UINT64_MAX;
+    off_t at = count, n, i;
+
+    while (at > 0) {
+        n = at < H264_WRITER_INDEX_BATCH ? at : H264_WRITER_INDEX_BATCH;
+        if (pread(fd, e, (size_t) n * sizeof (e[0]), (at - n) * (off_t) sizeof (e[0])) != (ssize_t) (n * sizeof (e[0]))) {
+            return at;
+        }
+        for (i = n - 1; i >= 0; i--) {
+            if (e[i].time_ns > later) {
+                return at - n + i + 1;
+            }
+            later = e[i].time_ns;
+        }
+        at -= n;
+    }
+    return 0;
+}
+
+int h264_writer_index_find(const char *index_path, uint64_t time_ns, H264_WRITER_INDEX_T *entry) {
+    H264_WRITER_INDEX_T e;
+    off_t size, low, high, mid;
+    int fd = open(index_path, O_RDONLY | O_CLOEXEC);
+    int found = -1;
+
+    if (fd < 0) {
+        fprintf(stderr, "Error: h264_writer: unable to open %s: %s\n", index_path, strerror(errno));
+        return -1;
+    }
+    size = lseek(fd, 0, SEEK_END);
+    // entries are in push order, a torn last one is left out
+    high = size / (off_t) sizeof (H264_WRITER_INDEX_T);
+    low = last_boot(fd, high);
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (pread(fd, &e, sizeof (e), mid * (off_t) sizeof (e)) != (ssize_t) sizeof (e)) {
+            break;
+        }
+        if (e.time_ns <= time_ns) {
+            *entry = e;
+            found = 0;
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    close(fd);
+    return found;
+}
@@ -0,0 +1,172 @@
+/*
+ * File:   h264_writer.h
+ * Author: Hassan
+ *
+ * Gets the encoder's output to storage without the encoder callback ever
+ * touching a file. h264_writer_push copies a buffer into a byte ring and
+ * returns; a writer thread takes the ring out in batch_size writes on
+ * 4 KiB boundaries, or whatever is there once the oldest byte has waited
+ * flush_ms, so an SD card stall backs up the ring instead of the encoder.
+ *
+ * Output is a series of segments, path-0000.h264, path-0001.h264 ..., each
+ * preallocated with fallocate and cut at the first SPS/PPS or IDR after
+ * segment_bytes or segment_seconds, so every segment decodes on its own
+ * when the encoder repeats its headers. Numbering carries on from the
+ * highest segment already on disk and a segment is never opened over an
+ * existing file, so a restart keeps the recording of the run before it.
+ * Without a path the stream goes to stdout as one piece. fsync is never, at the end of each segment, or every
+ * fsync_ms as well.
+ *
+ * With H264_WRITER_MP4 the buffers go through mp4_mux first, on the pushing
+ * thread, and the segments are fragmented MP4, path-0000.mp4 ..., each with
+ * its own init segment and cut at an IDR fragment. With index set, every
+ * place a segment could be cut at, each IDR, gets an H264_WRITER_INDEX_T in
+ * path.idx once it is written, appended to the entries of earlier runs: a
+ * binary search there by time or pts gives the segment and offset to seek
+ * to, see h264_writer_index_find.
+ *
+ * A buffer that does not fit the ring is dropped and counted, and so is
+ * everything after it up to the next SPS/PPS or IDR, the decoder could not
+ * use it anyway. push is for one thread at a time; h264_writer_get_stats
+ * may be called from any. Messages go to stderr, stdout may be the stream.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef H264_WRITER_H
+#define H264_WRITER_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "mp4_mux.h"
+
+#define H264_WRITER_ALIGN 4096 // batches are written in multiples of this
+#define H264_WRITER_CHUNKS 1024 // buffers queued at most, power of two
+
+/* What a pushed buffer holds, from the encoder's buffer flags. */
+#define H264_WRITER_CONFIG 1 // SPS/PPS
+#define H264_WRITER_KEYFRAME 2 // (part of) an IDR picture
+#define H264_WRITER_FRAME_END 4 // the last part of a picture
+
+#define H264_WRITER_PTS_UNKNOWN MP4_MUX_PTS_UNKNOWN
+#define H264_WRITER_INDEX_BATCH 64 // index entries written at once at most
+
+typedef enum {
+    H264_WRITER_ANNEXB = 0, // the encoder's output as it is
+    H264_WRITER_MP4 // fragmented MP4, one fragment per picture
+} H264_WRITER_FORMAT_T;
+
+typedef enum {
+    H264_WRITER_FSYNC_NONE = 0,
+    H264_WRITER_FSYNC_SEGMENT, // when a segment is closed
+    H264_WRITER_FSYNC_INTERVAL // every fsync_ms, and when a segment is closed
+} H264_WRITER_FSYNC_T;
+
+typedef struct {
+    const char *path; // segment prefix, NULL or "-" for stdout
+    H264_WRITER_FORMAT_T format;
+    float fps; // MP4: frame duration while there are no pts
+    int index; // path.idx, not for stdout
+    size_t ring_size; // bytes, rounded up to a power of two
+    size_t batch_size; // bytes a write waits for, rounded to H264_WRITER_ALIGN
+    int flush_ms; // longest a byte waits for a batch to fill
+    uint64_t segment_bytes; // 0: no size limit
+    int segment_seconds; // 0: no time limit
+    uint64_t preallocate; // bytes fallocate'd per segment, 0 for none
+    H264_WRITER_FSYNC_T fsync;
+    int fsync_ms;
+} H264_WRITER_CONFIG_T;
+
+typedef struct {
+    uint64_t bytes_in; // accepted into the ring
+    uint64_t bytes_written;
+    uint64_t bytes_dropped; // ring full, or waiting for a keyframe after that
+    uint32_t buffers_dropped;
+    uint32_t writes;
+    uint32_t write_errors; // their bytes are counted as dropped
+    uint32_t fsyncs;
+    uint32_t segments;
+    uint32_t lag_bytes; // in the ring, not written yet
+    uint32_t max_lag_bytes;
+    uint32_t lag_ms; // age of the oldest byte not written yet
+    uint32_t max_write_ms; // longest write or fsync
+} H264_WRITER_STATS_T;
+
+/* One entry of path.idx, in the byte order of the machine that wrote it. */
+typedef struct {
+    uint64_t time_ns; // pushed, CLOCK_MONOTONIC as sam_log records
+    int64_t pts; // microseconds, or H264_WRITER_PTS_UNKNOWN
+    uint64_t offset; // of the SPS/PPS, IDR or fragment in the segment
+    uint32_t segment;
+    uint32_t wall_s; // CLOCK_REALTIME seconds when it was written
+} H264_WRITER_INDEX_T;
+
+/* Where a decodable stream may start, followed buffer by buffer. */
+typedef struct {
+    int frame_start; // the next buffer starts a picture
+    int after_config; // the last buffer was SPS/PPS
+} H264_SPLIT_T;
+
+typedef struct {
+    uint32_t start; // ring position of the first byte
+    uint32_t length;
+    uint64_t time_ns; // when it was pushed, CLOCK_MONOTONIC
+    int64_t pts;
+    int split; // a segment may start here
+} H264_WRITER_CHUNK_T;
+
+typedef struct {
+    H264_WRITER_CONFIG_T config;
+    uint8_t *ring;
+    uint32_t ring_mask;
+    uint32_t head; // written up to, writer thread owned
+    uint32_t tail; // filled up to, producer owned
+    H264_WRITER_CHUNK_T chunk[H264_WRITER_CHUNKS];
+    uint32_t chunk_head; // first not fully written, writer thread owned
+    uint32_t chunk_tail;
+    H264_SPLIT_T split; // producer
+    int skipping; // producer: dropping up to the next split
+    MP4_MUX_T mux; // producer
+    int mux_result;
+    uint8_t header[MP4_MUX_INIT_MAX]; // written at the start of each segment
+    uint32_t header_length; // set once by the producer
+    int fd;
+    uint32_t segment; // number of the open one
+    uint64_t segment_size;
+    uint64_t segment_start_ns;
+    uint64_t synced_ns;
+    int index_fd;
+    H264_WRITER_INDEX_T index[H264_WRITER_INDEX_BATCH];
+    int index_count;
+    pthread_t thread;
+    uint32_t signal; // futex, bumped by push when a batch is ready and by destroy
+    uint32_t sleeping;
+    int stop;
+    H264_WRITER_STATS_T stats;
+} H264_WRITER_T;
+
+void h264_writer_config_default(H264_WRITER_CONFIG_T *config);
+
+void h264_split_init(H264_SPLIT_T *split);
+
+/* 1 when the next buffer, with these flags, is SPS/PPS or an IDR not right after them, starting a picture. */
+int h264_split_check(H264_SPLIT_T *split, int flags);
+
+/* Opens the first segment and starts the writer thread. */
+int h264_writer_init(H264_WRITER_T *writer, const H264_WRITER_CONFIG_T *config);
+
+/* Writes out what is queued, closes the segment and stops the thread. */
+void h264_writer_destroy(H264_WRITER_T *writer);
+
+/* Copies a buffer in; 0, or -1 when it was dropped. flags are H264_WRITER_CONFIG etc, pts in microseconds. */
+int h264_writer_push(H264_WRITER_T *writer, const uint8_t *data, size_t length, int flags, int64_t pts);
+
+void h264_writer_get_stats(H264_WRITER_T *writer, H264_WRITER_STATS_T *stats);
+void h264_writer_print_stats(H264_WRITER_T *writer);
+
+/* The last entry of an index at or before time_ns (CLOCK_MONOTONIC, this boot's entries only); 0, or -1 when there is none. */
+int h264_writer_index_find(const char *index_path, uint64_t time_ns, H264_WRITER_INDEX_T *entry);
+
+#endif /* H264_WRITER_H */
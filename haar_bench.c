@@ -0,0 +1,265 @@
+/*
+ * File:   haar_bench.c
+ * Author: Hassan
+ *
+ * Checks haar_native against OpenCV's cascade evaluator on a set of clips and
+ * times both. The compiled-in cascades must hold exactly the tables
+ * haar_native_create builds from the XML files. For every frame the face and
+ * eye cascades are run on every window of every planned level by OpenCV and
+ * by the compiled-in evaluators and the accept/reject decisions compared;
+ * then the face and eye passes of sam_detector are timed with each evaluator
+ * and their detections compared. Fails when more than 0.1% of windows or 2%
+ * of frames disagree.
+ *
+ *   haar_bench [-n frames] [-s WxH] [source ...]
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "frame_source.h"
+#include "sam_detector.h"
+#include "scale_plan.h"
+#include "haar_cascades.h"
+
+#define WINDOW_TOLERANCE 0.001
+#define FRAME_TOLERANCE 0.02
+
+typedef struct {
+    uint32_t windows;
+    uint32_t mismatches;
+} WINDOW_COMPARE_T;
+
+static double now_ms(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000.0 + t.tv_nsec / 1000000.0;
+}
+
+/* Both evaluators on every window of every level cascade could be asked for over the whole image. */
+static void compare_windows(CvHaarClassifierCascade *cascade, HAAR_NATIVE_T *native, IMAGE_PYRAMID_T *pyramid,
+        double scale_factor, CvSize min_size, CvSize max_size, WINDOW_COMPARE_T *result) {
+    SCALE_PLAN_T plan;
+    int xs[1024];
+    uint8_t pass[1024];
+    int k, x, y, i;
+
+    scale_plan_build(&plan, cascade->orig_window_size, scale_factor, min_size, max_size,
+            cvSize(pyramid->level[0].image->width, pyramid->level[0].image->height));
+    for (k = 0; k < plan.count; k++) {
+        int li = image_pyramid_level_for(pyramid, plan.factor[k]);
+        const IMAGE_PYRAMID_LEVEL_T *level = image_pyramid_level(pyramid, li);
+        double scale = plan.factor[k] / (1 << level->shift);
+
+        if (haar_native_set_scale(native, level->sum, level->sqsum, level->tilted, scale) != 0) {
+            continue;
+        }
+        cvSetImagesForHaarClassifierCascade(cascade, level->sum, level->sqsum, level->tilted, scale);
+        for (y = 0; y + native->window.height <= level->image->height; y++) {
+            int n = 0;
+
+            for (x = 0; x + native->window.width <= level->image->width && n < 1024; x++) {
+                xs[n++] = x;
+            }
+            haar_native_run_row(native, xs, n, y, pass);
+            for (i = 0; i < n; i++) {
+                int expected = cvRunHaarClassifierCascade(cascade, cvPoint(xs[i], y), 0) > 0;
+
+                result->windows++;
+                result->mismatches += expected != pass[i];
+            }
+        }
+    }
+}
+
+static int same_tables(const HAAR_NATIVE_CASCADE_T *a, const HAAR_NATIVE_CASCADE_T *b) {
+    size_t n = a->node_count;
+    int k;
+
+    if (a->node_count != b->node_count || a->stage_count != b->stage_count
+            || a->orig_window.width != b->orig_window.width || a->orig_window.height != b->orig_window.height
+            || memcmp(a->stages, b->stages, sizeof (HAAR_NATIVE_STAGE_T) * a->stage_count) != 0) {
+        return 0;
+    }
+    for (k = 0; k < 3; k++) {
+        if (memcmp(a->rect_x[k], b->rect_x[k], sizeof (int16_t) * n) != 0
+                || memcmp(a->rect_y[k], b->rect_y[k], sizeof (int16_t) * n) != 0
+                || memcmp(a->rect_w[k], b->rect_w[k], sizeof (int16_t) * n) != 0
+                || memcmp(a->rect_h[k], b->rect_h[k], sizeof (int16_t) * n) != 0
+                || memcmp(a->weight2[k], b->weight2[k], n) != 0) {
+            return 0;
+        }
+    }
+    return memcmp(a->tilted, b->tilted, n) == 0
+            && memcmp(a->threshold, b->threshold, sizeof (float) * n) == 0
+            && memcmp(a->alpha0, b->alpha0, sizeof (float) * n) == 0
+            && memcmp(a->alpha1, b->alpha1, sizeof (float) * n) == 0;
+}
+
+/*
+ * Loads path both ways, timing each, and checks the compiled-in tables match
+ * the XML. Returns the compiled-in evaluator, NULL on a mismatch.
+ */
+static HAAR_NATIVE_T *check_builtin(const char *path, const HAAR_NATIVE_CASCADE_T *builtin) {
+    CvHaarClassifierCascade *cascade;
+    HAAR_NATIVE_T *from_xml, *native;
+    double t0, t_xml, t_builtin;
+    int same;
+
+    t0 = now_ms();
+    cascade = (CvHaarClassifierCascade*) cvLoad(path, NULL, NULL, NULL);
+    from_xml = cascade ? haar_native_create(cascade) : NULL;
+    t_xml = now_ms() - t0;
+    t0 = now_ms();
+    native = haar_native_create_static(builtin);
+    t_builtin = now_ms() - t0;
+    if (!from_xml || !native) {
+        printf("Error: unable to load %s\n", path);
+        return NULL;
+    }
+    same = same_tables(&from_xml->cascade, &native->cascade);
+    printf("%s: %d stages, %d nodes; XML load %.2f ms, compiled-in %.3f ms, tables %s\n",
+            builtin->name, builtin->stage_count, builtin->node_count, t_xml, t_builtin, same ? "identical" : "DIFFER");
+    haar_native_destroy(from_xml);
+    cvReleaseHaarClassifierCascade(&cascade);
+    if (!same) {
+        printf("Error: compiled-in %s is stale, rebuild\n", builtin->name);
+        haar_native_destroy(native);
+        return NULL;
+    }
+    return native;
+}
+
+static int same_rect(const CvRect *a, const CvRect *b) {
+    int tol = a->width / 10 + 1;
+
+    return abs(a->x - b->x) <= tol && abs(a->y - b->y) <= tol && abs(a->width - b->width) <= tol;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-n frames] [-s WxH] [source ...]\n", name);
+    fprintf(stderr, "  source  recording.y4m, raw I420 recording, or \"synthetic\" (default)\n");
+}
+
+int main(int argc, char** argv) {
+    FRAME_SOURCE_CONFIG_T config;
+    SAM_DETECTOR_T detector;
+    HAAR_NATIVE_T *face_builtin, *eyes_builtin;
+    WINDOW_COMPARE_T face_cmp = {0, 0}, eyes_cmp = {0, 0};
+    const char *default_source = "synthetic";
+    const char **sources;
+    int source_count;
+    int frames = 0, frame_mismatches = 0;
+    double t_cv = 0, t_native = 0;
+    int opt, s;
+
+    frame_source_config_default(&config);
+    config.pace = FRAME_SOURCE_PACE_FAST;
+    config.max_frames = 100;
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                config.max_frames = atoi(optarg);
+                break;
+            case 's':
+                if (sscanf(optarg, "%dx%d", &config.width, &config.height) != 2) {
+                    usage(argv[0]);
+                    return -1;
+                }
+                break;
+            default:
+                usage(argv[0]);
+                return -1;
+        }
+    }
+    if (optind < argc) {
+        sources = (const char **) &argv[optind];
+        source_count = argc - optind;
+    } else {
+        sources = &default_source;
+        source_count = 1;
+    }
+
+    face_builtin = check_builtin(SAM_FACE_CASCADE, &haar_cascade_frontalface_alt);
+    eyes_builtin = check_builtin(SAM_EYES_CASCADE, &haar_cascade_eye);
+    if (!face_builtin || !eyes_builtin) {
+        return -1;
+    }
+
+    for (s = 0; s < source_count; s++) {
+        FRAME_SOURCE_T *source = frame_source_open(sources[s], &config);
+        FRAME_T *frame;
+
+        if (!source || frame_source_start(source) != 0) {
+            printf("Error: unable to open %s\n", sources[s]);
+            return -1;
+        }
+        if (sam_detector_init(&detector, source->width / 4, source->height / 4, SAM_FACE_CASCADE, SAM_EYES_CASCADE) != 0) {
+            return -1;
+        }
+        if (!detector.native || !detector.eyes_native) {
+            printf("Error: a cascade cannot be evaluated natively\n");
+            return -1;
+        }
+
+        while (frame_source_acquire(source, &frame, -1) > 0) {
+            CvRect face_cv, face_native, eye;
+            int found_cv, found_native, eyes_cv, eyes_native;
+            double t0;
+
+            sam_detector_prepare(&detector, frame);
+            frame_source_release(source, frame);
+
+            compare_windows(detector.cascade, face_builtin, &detector.frame.pyramid, SAM_FACE_SCALE,
+                    cvSize(SAM_FACE_MIN, SAM_FACE_MIN), cvSize(SAM_FACE_MAX, SAM_FACE_MAX), &face_cmp);
+            compare_windows(detector.eyes_cascade, eyes_builtin, &detector.frame.pyramid, SAM_EYES_SCALE,
+                    cvSize(SAM_EYES_MIN, SAM_EYES_MIN), cvSize(SAM_EYES_MAX, SAM_EYES_MAX), &eyes_cmp);
+
+            // integrals are cached by now, so only the cascade evaluation is timed
+            detector.use_native = 0;
+            t0 = now_ms();
+            found_cv = sam_detector_face(&detector, &face_cv);
+            eye = found_cv ? face_cv : cvRect(detector.width / 4, detector.height / 4, detector.width / 2, detector.height / 2);
+            eyes_cv = sam_detector_eyes(&detector, &eye);
+            t_cv += now_ms() - t0;
+
+            detector.use_native = 1;
+            t0 = now_ms();
+            found_native = sam_detector_face(&detector, &face_native);
+            eyes_native = sam_detector_eyes(&detector, &eye);
+            t_native += now_ms() - t0;
+
+            if (found_cv != found_native || eyes_cv != eyes_native
+                    || (found_cv && !same_rect(&face_cv, &face_native))) {
+                frame_mismatches++;
+            }
+            frames++;
+            sam_detector_end_frame(&detector);
+        }
+        frame_source_destroy(source);
+        sam_detector_destroy(&detector);
+    }
+    haar_native_destroy(face_builtin);
+    haar_native_destroy(eyes_builtin);
+
+    printf("%d frames from %d source(s), %s evaluator\n", frames, source_count, haar_native_impl());
+    printf("  face windows %u, %u disagree\n", face_cmp.windows, face_cmp.mismatches);
+    printf("  eye windows %u, %u disagree\n", eyes_cmp.windows, eyes_cmp.mismatches);
+    printf("  detections differ in %d frames\n", frame_mismatches);
+    if (frames > 0) {
+        printf("  face + eyes: opencv %.2f ms, native %.2f ms per frame (%.1fx)\n",
+                t_cv / frames, t_native / frames, t_native > 0 ? t_cv / t_native : 0.0);
+    }
+    if (face_cmp.mismatches > WINDOW_TOLERANCE * face_cmp.windows
+            || eyes_cmp.mismatches > WINDOW_TOLERANCE * eyes_cmp.windows
+            || frame_mismatches > FRAME_TOLERANCE * frames) {
+        printf("Error: haar_native does not match OpenCV\n");
+        return -1;
+    }
+    return 0;
+}
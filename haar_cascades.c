@@ -0,0 +1,43 @@
+/*
+ * File:   haar_cascades.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include "haar_cascades.h"
+#include "cascade_frontalface_alt.h"
+#include "cascade_eye.h"
+
+#define HAAR_EVAL_FN eval_frontalface_alt
+#define HAAR_EVAL_STAGE_COUNT CASCADE_FRONTALFACE_ALT_STAGES
+#define HAAR_EVAL_STAGES cascade_frontalface_alt_stages
+#define HAAR_EVAL_TILTED cascade_frontalface_alt_tilted
+#define HAAR_EVAL_RECT_W2 cascade_frontalface_alt_rect_w[2]
+#define HAAR_EVAL_ALPHA0 cascade_frontalface_alt_alpha0
+#define HAAR_EVAL_ALPHA1 cascade_frontalface_alt_alpha1
+#include "haar_native_eval.h"
+
+#define HAAR_EVAL_FN eval_eye
+#define HAAR_EVAL_STAGE_COUNT CASCADE_EYE_STAGES
+#define HAAR_EVAL_STAGES cascade_eye_stages
+#define HAAR_EVAL_TILTED cascade_eye_tilted
+#define HAAR_EVAL_RECT_W2 cascade_eye_rect_w[2]
+#define HAAR_EVAL_ALPHA0 cascade_eye_alpha0
+#define HAAR_EVAL_ALPHA1 cascade_eye_alpha1
+#include "haar_native_eval.h"
+
+#define CASCADE_TABLE(name, NAME) { \
+        #name, NAME##_NODES, NAME##_STAGES, {NAME##_WINDOW_WIDTH, NAME##_WINDOW_HEIGHT}, \
+        cascade_##name##_stages, \
+        {cascade_##name##_rect_x[0], cascade_##name##_rect_x[1], cascade_##name##_rect_x[2]}, \
+        {cascade_##name##_rect_y[0], cascade_##name##_rect_y[1], cascade_##name##_rect_y[2]}, \
+        {cascade_##name##_rect_w[0], cascade_##name##_rect_w[1], cascade_##name##_rect_w[2]}, \
+        {cascade_##name##_rect_h[0], cascade_##name##_rect_h[1], cascade_##name##_rect_h[2]}, \
+        {cascade_##name##_weight2[0], cascade_##name##_weight2[1], cascade_##name##_weight2[2]}, \
+        cascade_##name##_tilted, cascade_##name##_threshold, cascade_##name##_alpha0, cascade_##name##_alpha1, \
+        eval_##name \
+    }
+
+const HAAR_NATIVE_CASCADE_T haar_cascade_frontalface_alt = CASCADE_TABLE(frontalface_alt, CASCADE_FRONTALFACE_ALT);
+const HAAR_NATIVE_CASCADE_T haar_cascade_eye = CASCADE_TABLE(eye, CASCADE_EYE);
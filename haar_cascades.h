@@ -0,0 +1,22 @@
+/*
+ * File:   haar_cascades.h
+ * Author: Hassan
+ *
+ * The Haar cascades SAM ships with, compiled into the binary. cascade_gen
+ * turns the OpenCV XML files into static const tables at build time and
+ * haar_cascades.c instantiates haar_native_eval.h once per cascade, so power-on
+ * needs neither the XML files nor the parse: haar_native_create_static on one
+ * of these is a couple of small allocations.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef HAAR_CASCADES_H
+#define HAAR_CASCADES_H
+
+#include "haar_native.h"
+
+extern const HAAR_NATIVE_CASCADE_T haar_cascade_frontalface_alt;
+extern const HAAR_NATIVE_CASCADE_T haar_cascade_eye;
+
+#endif /* HAAR_CASCADES_H */
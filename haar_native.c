@@ -0,0 +1,326 @@
+/*
+ * File:   haar_native.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "haar_native.h"
+
+#define HAAR_EVAL_FN eval_generic
+#define HAAR_EVAL_STAGE_COUNT native->cascade.stage_count
+#define HAAR_EVAL_STAGES native->cascade.stages
+#define HAAR_EVAL_TILTED native->cascade.tilted
+#define HAAR_EVAL_RECT_W2 native->cascade.rect_w[2]
+#define HAAR_EVAL_ALPHA0 native->cascade.alpha0
+#define HAAR_EVAL_ALPHA1 native->cascade.alpha1
+#include "haar_native_eval.h"
+
+#define ALIGN16(n) (((n) + 15) & ~(size_t) 15)
+
+static void *carve(uint8_t **cursor, size_t size) {
+    void *p = *cursor;
+
+    *cursor += ALIGN16(size);
+    return p;
+}
+
+/* The per-scale arrays in one 16 byte aligned block; NULL base only measures. */
+static size_t layout_scale(HAAR_NATIVE_T *native, uint8_t *base) {
+    uint8_t *cursor = base;
+    size_t n = native->cascade.node_count;
+    int k, c;
+
+    for (k = 0; k < 3; k++) {
+        native->coef[k] = (int16_t *) carve(&cursor, sizeof (int16_t) * n);
+        for (c = 0; c < 4; c++) {
+            native->ofs[k][c] = (int32_t *) carve(&cursor, sizeof (int32_t) * n);
+        }
+    }
+    native->node_threshold = (float *) carve(&cursor, sizeof (float) * n);
+    return (size_t) (cursor - base);
+}
+
+static HAAR_NATIVE_T *alloc_native(const HAAR_NATIVE_CASCADE_T *cascade) {
+    HAAR_NATIVE_T *native;
+    size_t size;
+
+    native = (HAAR_NATIVE_T *) calloc(1, sizeof (HAAR_NATIVE_T));
+    if (!native) {
+        return NULL;
+    }
+    native->cascade = *cascade;
+    native->eval = cascade->eval ? cascade->eval : eval_generic;
+    size = layout_scale(native, NULL);
+    if (posix_memalign(&native->block, 16, size) != 0) {
+        fprintf(stderr, "Error: haar_native: unable to allocate %zu bytes\n", size);
+        free(native);
+        return NULL;
+    }
+    memset(native->block, 0, size);
+    layout_scale(native, (uint8_t *) native->block);
+    return native;
+}
+
+HAAR_NATIVE_T *haar_native_create(const CvHaarClassifierCascade *cascade) {
+    HAAR_NATIVE_CASCADE_T tables;
+    HAAR_NATIVE_T *native;
+    HAAR_NATIVE_STAGE_T *stages;
+    int16_t *rect_x[3], *rect_y[3], *rect_w[3], *rect_h[3];
+    int8_t *weight2[3];
+    uint8_t *tilted, *cursor;
+    float *threshold, *alpha0, *alpha1;
+    void *block;
+    size_t n, size;
+    int node = 0;
+    int i, j, k;
+
+    memset(&tables, 0, sizeof (tables));
+    tables.stage_count = cascade->count;
+    tables.orig_window = cascade->orig_window_size;
+    for (i = 0; i < cascade->count; i++) {
+        const CvHaarStageClassifier *stage = &cascade->stage_classifier[i];
+
+        if (stage->next != -1 || stage->child != -1) {
+            fprintf(stderr, "Error: haar_native: tree cascade, using OpenCV\n");
+            return NULL;
+        }
+        for (j = 0; j < stage->count; j++) {
+            if (stage->classifier[j].count != 1) {
+                fprintf(stderr, "Error: haar_native: classifier with %d nodes, using OpenCV\n", stage->classifier[j].count);
+                return NULL;
+            }
+        }
+        tables.node_count += stage->count;
+    }
+
+    n = tables.node_count;
+    size = ALIGN16(sizeof (HAAR_NATIVE_STAGE_T) * tables.stage_count)
+            + 3 * (4 * ALIGN16(sizeof (int16_t) * n) + ALIGN16(n)) + ALIGN16(n) + 3 * ALIGN16(sizeof (float) * n);
+    if (posix_memalign(&block, 16, size) != 0) {
+        fprintf(stderr, "Error: haar_native: unable to allocate %zu bytes\n", size);
+        return NULL;
+    }
+    memset(block, 0, size);
+    cursor = (uint8_t *) block;
+    stages = (HAAR_NATIVE_STAGE_T *) carve(&cursor, sizeof (HAAR_NATIVE_STAGE_T) * tables.stage_count);
+    for (k = 0; k < 3; k++) {
+        rect_x[k] = (int16_t *) carve(&cursor, sizeof (int16_t) * n);
+        rect_y[k] = (int16_t *) carve(&cursor, sizeof (int16_t) * n);
+        rect_w[k] = (int16_t *) carve(&cursor, sizeof (int16_t) * n);
+        rect_h[k] = (int16_t *) carve(&cursor, sizeof (int16_t) * n);
+        weight2[k] = (int8_t *) carve(&cursor, n);
+    }
+    tilted = (uint8_t *) carve(&cursor, n);
+    threshold = (float *) carve(&cursor, sizeof (float) * n);
+    alpha0 = (float *) carve(&cursor, sizeof (float) * n);
+    alpha1 = (float *) carve(&cursor, sizeof (float) * n);
+
+    for (i = 0; i < cascade->count; i++) {
+        const CvHaarStageClassifier *stage = &cascade->stage_classifier[i];
+
+        stages[i].first = node;
+        stages[i].count = stage->count;
+        stages[i].threshold = stage->threshold - HAAR_NATIVE_STAGE_BIAS;
+        for (j = 0; j < stage->count; j++, node++) {
+            const CvHaarClassifier *classifier = &stage->classifier[j];
+            const CvHaarFeature *feature = &classifier->haar_feature[0];
+
+            tilted[node] = feature->tilted != 0;
+            threshold[node] = classifier->threshold[0];
+            alpha0[node] = classifier->alpha[0];
+            alpha1[node] = classifier->alpha[1];
+            for (k = 0; k < 3; k++) {
+                float w = feature->rect[k].weight * (feature->tilted ? 1.0f : 2.0f);
+
+                if (k > 0 && feature->rect[k].r.width == 0) {
+                    break;
+                }
+                if (w != floorf(w) || fabsf(w) > 127) {
+                    fprintf(stderr, "Error: haar_native: weight %g is not a small integer, using OpenCV\n", feature->rect[k].weight);
+                    free(block);
+                    return NULL;
+                }
+                rect_x[k][node] = (int16_t) feature->rect[k].r.x;
+                rect_y[k][node] = (int16_t) feature->rect[k].r.y;
+                rect_w[k][node] = (int16_t) feature->rect[k].r.width;
+                rect_h[k][node] = (int16_t) feature->rect[k].r.height;
+                weight2[k][node] = (int8_t) w;
+            }
+        }
+    }
+
+    tables.stages = stages;
+    for (k = 0; k < 3; k++) {
+        tables.rect_x[k] = rect_x[k];
+        tables.rect_y[k] = rect_y[k];
+        tables.rect_w[k] = rect_w[k];
+        tables.rect_h[k] = rect_h[k];
+        tables.weight2[k] = weight2[k];
+    }
+    tables.tilted = tilted;
+    tables.threshold = threshold;
+    tables.alpha0 = alpha0;
+    tables.alpha1 = alpha1;
+    native = alloc_native(&tables);
+    if (!native) {
+        free(block);
+        return NULL;
+    }
+    native->cascade_block = block;
+    return native;
+}
+
+HAAR_NATIVE_T *haar_native_create_static(const HAAR_NATIVE_CASCADE_T *cascade) {
+    return alloc_native(cascade);
+}
+
+HAAR_NATIVE_T *haar_native_clone(const HAAR_NATIVE_T *native) {
+    HAAR_NATIVE_T *clone = alloc_native(&native->cascade);
+
+    if (clone) {
+        clone->eval = native->eval;
+    }
+    return clone;
+}
+
+void haar_native_destroy(HAAR_NATIVE_T *native) {
+    if (native) {
+        free(native->cascade_block);
+        free(native->block);
+        free(native);
+    }
+}
+
+int haar_native_set_scale(HAAR_NATIVE_T *native, const CvMat *sum, const CvMat *sqsum, const CvMat *tilted, double scale) {
+    int step = sum->step / (int) sizeof (int32_t);
+    int ex, ey, ew, eh;
+    int i, k;
+
+    native->scale = scale;
+    native->sum = (const int32_t *) sum->data.i;
+    native->tilted_sum = (const int32_t *) tilted->data.i;
+    native->sqsum = (const double *) sqsum->data.db;
+    native->sum_step = step;
+    native->sqsum_step = sqsum->step / (int) sizeof (double);
+    native->sum_width = sum->cols;
+    native->sum_height = sum->rows;
+    native->window = cvSize(cvRound(native->cascade.orig_window.width * scale), cvRound(native->cascade.orig_window.height * scale));
+
+    // variance is taken over the window less a one pixel border, as cvSetImagesForHaarClassifierCascade
+    ex = ey = cvRound(scale);
+    ew = cvRound((native->cascade.orig_window.width - 2) * scale);
+    eh = cvRound((native->cascade.orig_window.height - 2) * scale);
+    native->inv_area = 1.0 / (ew * eh);
+    native->var_ofs[0] = ey * step + ex;
+    native->var_ofs[1] = ey * step + ex + ew;
+    native->var_ofs[2] = (ey + eh) * step + ex;
+    native->var_ofs[3] = (ey + eh) * step + ex + ew;
+    for (k = 0; k < 4; k++) {
+        int dy = native->var_ofs[k] / step, dx = native->var_ofs[k] % step;
+
+        native->sq_ofs[k] = dy * native->sqsum_step + dx;
+    }
+
+    for (i = 0; i < native->cascade.node_count; i++) {
+        int area[3] = {0, 0, 0};
+        int64_t c0 = 0;
+
+        for (k = 0; k < 3; k++) {
+            int x = cvRound(native->cascade.rect_x[k][i] * scale);
+            int y = cvRound(native->cascade.rect_y[k][i] * scale);
+            int w = cvRound(native->cascade.rect_w[k][i] * scale);
+            int h = cvRound(native->cascade.rect_h[k][i] * scale);
+
+            if (native->cascade.rect_w[k][i] == 0) {
+                native->ofs[k][0][i] = native->ofs[k][1][i] = native->ofs[k][2][i] = native->ofs[k][3][i] = 0;
+                continue;
+            }
+            area[k] = w * h;
+            if (!native->cascade.tilted[i]) {
+                native->ofs[k][0][i] = y * step + x;
+                native->ofs[k][1][i] = y * step + x + w;
+                native->ofs[k][2][i] = (y + h) * step + x;
+                native->ofs[k][3][i] = (y + h) * step + x + w;
+            } else {
+                native->ofs[k][0][i] = y * step + x;
+                native->ofs[k][1][i] = (y + h) * step + x - h;
+                native->ofs[k][2][i] = (y + w) * step + x + w;
+                native->ofs[k][3][i] = (y + w + h) * step + x + w - h;
+            }
+        }
+        if (area[0] == 0) {
+            return -1;
+        }
+        // rect 0's weight is re-derived so the feature is zero on a flat patch
+        for (k = 1; k < 3; k++) {
+            int64_t c = (int64_t) native->cascade.weight2[k][i] * area[0];
+
+            if (c > INT16_MAX || c < INT16_MIN) {
+                return -1;
+            }
+            native->coef[k][i] = (int16_t) c;
+            c0 -= (int64_t) native->cascade.weight2[k][i] * area[k];
+        }
+        if (c0 > INT16_MAX || c0 < INT16_MIN) {
+            return -1;
+        }
+        native->coef[0][i] = (int16_t) c0;
+        native->node_threshold[i] = (float) (native->cascade.threshold[i] * 2.0 * area[0] / native->inv_area);
+    }
+    return 0;
+}
+
+static float variance_norm(const HAAR_NATIVE_T *native, int x, int y) {
+    int p = y * native->sum_step + x;
+    int pq = y * native->sqsum_step + x;
+    const int32_t *s = native->sum;
+    const double *q = native->sqsum;
+    double mean = (s[p + native->var_ofs[0]] - s[p + native->var_ofs[1]]
+            - s[p + native->var_ofs[2]] + s[p + native->var_ofs[3]]) * native->inv_area;
+    double var = (q[pq + native->sq_ofs[0]] - q[pq + native->sq_ofs[1]]
+            - q[pq + native->sq_ofs[2]] + q[pq + native->sq_ofs[3]]) * native->inv_area - mean * mean;
+
+    return var >= 0 ? (float) sqrt(var) : 1.0f;
+}
+
+int haar_native_run_row(const HAAR_NATIVE_T *native, const int *xs, int n, int y, uint8_t *pass) {
+    int accepted = 0;
+    int i, l;
+
+    for (i = 0; i < n; i += HAAR_NATIVE_LANES) {
+        int p[HAAR_NATIVE_LANES];
+        float vnf[HAAR_NATIVE_LANES];
+        int lanes = n - i < HAAR_NATIVE_LANES ? n - i : HAAR_NATIVE_LANES;
+        unsigned mask;
+
+        // a short last group repeats its final window in the spare lanes
+        for (l = 0; l < HAAR_NATIVE_LANES; l++) {
+            int x = xs[l < lanes ? i + l : n - 1];
+
+            p[l] = y * native->sum_step + x;
+            vnf[l] = variance_norm(native, x, y);
+        }
+        mask = native->eval(native, p, vnf, lanes);
+        for (l = 0; l < lanes; l++) {
+            pass[i + l] = (mask >> l) & 1;
+            accepted += pass[i + l];
+        }
+    }
+    return accepted;
+}
+
+const char *haar_native_impl(void) {
+#if HAAR_NATIVE_NEON
+    return "neon";
+#elif HAAR_NATIVE_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
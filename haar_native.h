@@ -0,0 +1,130 @@
+/*
+ * File:   haar_native.h
+ * Author: Hassan
+ *
+ * Built-in evaluator for stump-based Haar cascades such as
+ * haarcascade_frontalface_alt.xml and haarcascade_eye.xml, used by haar_scan
+ * in place of cvRunHaarClassifierCascade.
+ *
+ * The cascade is copied out of OpenCV's CvHaarClassifierCascade tree into flat
+ * structure-of-arrays tables, 16 byte aligned. haar_native_set_scale turns
+ * them into per-level tables: corner offsets into the integral images and
+ * int16 rectangle weights. The weights are exact integers: OpenCV's
+ * area-normalised float weights multiplied through by 2 * area(rect 0) /
+ * window weight. Rectangle sums stay int32 and only the weighted sum is taken
+ * to float, for the compare against the variance-scaled node threshold. Four
+ * neighbouring windows of a row are evaluated together, one per vector lane
+ * (NEON, SSE2, or scalar).
+ *
+ * The cascade tables are either copied out of a loaded cascade at run time
+ * (haar_native_create) or compiled into the binary by cascade_gen at build
+ * time (haar_native_create_static with a table from haar_cascades.h), which
+ * also brings an evaluator specialised for that cascade.
+ *
+ * Cascades with tree stages or multi-node classifiers are refused and stay on
+ * OpenCV.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef HAAR_NATIVE_H
+#define HAAR_NATIVE_H
+
+#include <stdint.h>
+
+#include <opencv2/core/core_c.h>
+#include <opencv2/objdetect/objdetect.hpp>
+
+#define HAAR_NATIVE_LANES 4
+#define HAAR_NATIVE_STAGE_BIAS 0.0001f // OpenCV's icv_stage_threshold_bias
+
+typedef struct {
+    int first; // node index
+    int count;
+    float threshold; // bias already subtracted
+} HAAR_NATIVE_STAGE_T;
+
+typedef struct HAAR_NATIVE_T HAAR_NATIVE_T;
+
+/*
+ * Runs four windows (corner offsets p, variance norms vnf) through the
+ * cascade, returns a bit per accepted window. Only the first lanes windows
+ * are meaningful; the vector versions evaluate all four regardless.
+ */
+typedef unsigned (*HAAR_NATIVE_EVAL_FN)(const HAAR_NATIVE_T *native, const int *p, const float *vnf, int lanes);
+
+/* Scale independent cascade tables. */
+typedef struct {
+    const char *name;
+    int node_count;
+    int stage_count;
+    CvSize orig_window;
+    const HAAR_NATIVE_STAGE_T *stages;
+    const int16_t *rect_x[3]; // feature rectangles in cascade window units
+    const int16_t *rect_y[3];
+    const int16_t *rect_w[3]; // 0 for an unused third rectangle
+    const int16_t *rect_h[3];
+    const int8_t *weight2[3]; // XML weight, doubled for upright rectangles (OpenCV halves tilted ones)
+    const uint8_t *tilted;
+    const float *threshold;
+    const float *alpha0; // added when the feature is below threshold
+    const float *alpha1;
+    HAAR_NATIVE_EVAL_FN eval; // specialised evaluator, NULL for the generic one
+} HAAR_NATIVE_CASCADE_T;
+
+struct HAAR_NATIVE_T {
+    HAAR_NATIVE_CASCADE_T cascade;
+    HAAR_NATIVE_EVAL_FN eval;
+
+    /* current scale, filled by haar_native_set_scale */
+    double scale;
+    CvSize window; // scaled window in level pixels
+    int32_t *ofs[3][4]; // p0 - p1 - p2 + p3 corner offsets, in integral elements
+    int16_t *coef[3];
+    float *node_threshold; // threshold * 2 * area(rect 0) / window weight
+    const int32_t *sum;
+    const int32_t *tilted_sum;
+    const double *sqsum;
+    int sum_step; // elements
+    int sqsum_step;
+    int sum_width; // columns and rows of the integral
+    int sum_height;
+    int var_ofs[4]; // variance window corners
+    int sq_ofs[4];
+    double inv_area;
+
+    void *cascade_block; // cascade tables copied by haar_native_create, NULL for compiled-in ones
+    void *block; // single allocation behind the per-scale arrays
+};
+
+/* Returns NULL (and says why) when the cascade cannot be run natively. */
+HAAR_NATIVE_T *haar_native_create(const CvHaarClassifierCascade *cascade);
+
+/* Evaluator over tables that outlive it, such as the compiled-in cascades. */
+HAAR_NATIVE_T *haar_native_create_static(const HAAR_NATIVE_CASCADE_T *cascade);
+
+/*
+ * Second evaluator over native's cascade tables with scale state of its own,
+ * so several scales can be evaluated at once. native must outlive it.
+ */
+HAAR_NATIVE_T *haar_native_clone(const HAAR_NATIVE_T *native);
+void haar_native_destroy(HAAR_NATIVE_T *native);
+
+/*
+ * Binds the integral images of one pyramid level and a feature scale. Returns
+ * -1 if a weight does not fit int16 at this scale; the caller then uses
+ * OpenCV for the level.
+ */
+int haar_native_set_scale(HAAR_NATIVE_T *native, const CvMat *sum, const CvMat *sqsum, const CvMat *tilted, double scale);
+
+/*
+ * Evaluates the windows with top-left corners (xs[i], y), i < n, and sets
+ * pass[i] to 1 for the ones accepted by every stage. Windows must lie inside
+ * the bound integral images. Returns the number accepted.
+ */
+int haar_native_run_row(const HAAR_NATIVE_T *native, const int *xs, int n, int y, uint8_t *pass);
+
+/* "neon", "sse2" or "scalar" */
+const char *haar_native_impl(void);
+
+#endif /* HAAR_NATIVE_H */
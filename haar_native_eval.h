@@ -0,0 +1,168 @@
+/*
+ * File:   haar_native_eval.h
+ * Author: Hassan
+ *
+ * The cascade walk of haar_native, written once and instantiated per cascade.
+ * Define these, then include this file; there is deliberately no include
+ * guard around the function:
+ *
+ *   HAAR_EVAL_FN           name of the HAAR_NATIVE_EVAL_FN to define
+ *   HAAR_EVAL_STAGE_COUNT  number of stages
+ *   HAAR_EVAL_STAGES       HAAR_NATIVE_STAGE_T table
+ *   HAAR_EVAL_TILTED       per-node tilted flags
+ *   HAAR_EVAL_RECT_W2      per-node width of the third rectangle, 0 if unused
+ *   HAAR_EVAL_ALPHA0       per-node leaf values
+ *   HAAR_EVAL_ALPHA1
+ *
+ * haar_native.c points them at the run-time tables; haar_cascades.c points
+ * them at the static const tables generated by cascade_gen, so the stage
+ * loop bounds, the tilted and third-rectangle branches and the leaf values
+ * are compile-time constants in those instances. Every macro is undefined
+ * again at the end.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef HAAR_NATIVE_EVAL_COMMON
+#define HAAR_NATIVE_EVAL_COMMON
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAAR_NATIVE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define HAAR_NATIVE_SSE2 1
+#endif
+
+#include "haar_native.h"
+
+static inline int32_t haar_rect_sum(const int32_t *base, int p, const HAAR_NATIVE_T *native, int k, int i) {
+    return base[p + native->ofs[k][0][i]] - base[p + native->ofs[k][1][i]]
+            - base[p + native->ofs[k][2][i]] + base[p + native->ofs[k][3][i]];
+}
+
+#endif /* HAAR_NATIVE_EVAL_COMMON */
+
+#if HAAR_NATIVE_NEON || HAAR_NATIVE_SSE2
+static unsigned HAAR_EVAL_FN(const HAAR_NATIVE_T *native, const int *p, const float *vnf_in, int lanes) {
+    int32_t s[3][HAAR_NATIVE_LANES];
+    int st, i, k, l;
+#if HAAR_NATIVE_NEON
+    float32x4_t vnf = vld1q_f32(vnf_in);
+    uint32x4_t alive = vdupq_n_u32(0xffffffff);
+    uint32_t mask[4];
+#else
+    __m128 vnf = _mm_loadu_ps(vnf_in);
+    __m128 alive = _mm_castsi128_ps(_mm_set1_epi32(-1));
+#endif
+
+    (void) lanes;
+    for (st = 0; st < HAAR_EVAL_STAGE_COUNT; st++) {
+        const int first = HAAR_EVAL_STAGES[st].first;
+        const int end = first + HAAR_EVAL_STAGES[st].count;
+#if HAAR_NATIVE_NEON
+        float32x4_t stage_sum = vdupq_n_f32(0);
+#else
+        __m128 stage_sum = _mm_setzero_ps();
+#endif
+
+        for (i = first; i < end; i++) {
+            const int32_t *base = HAAR_EVAL_TILTED[i] ? native->tilted_sum : native->sum;
+            int rects = HAAR_EVAL_RECT_W2[i] ? 3 : 2;
+
+            // the corner loads are a gather either way, the arithmetic is vector
+            for (k = 0; k < rects; k++) {
+                for (l = 0; l < HAAR_NATIVE_LANES; l++) {
+                    s[k][l] = haar_rect_sum(base, p[l], native, k, i);
+                }
+            }
+#if HAAR_NATIVE_NEON
+            {
+                float32x4_t f = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(s[0])), (float) native->coef[0][i]);
+                uint32x4_t ge;
+
+                f = vmlaq_n_f32(f, vcvtq_f32_s32(vld1q_s32(s[1])), (float) native->coef[1][i]);
+                if (rects == 3) {
+                    f = vmlaq_n_f32(f, vcvtq_f32_s32(vld1q_s32(s[2])), (float) native->coef[2][i]);
+                }
+                ge = vcgeq_f32(f, vmulq_n_f32(vnf, native->node_threshold[i]));
+                stage_sum = vaddq_f32(stage_sum, vbslq_f32(ge, vdupq_n_f32(HAAR_EVAL_ALPHA1[i]), vdupq_n_f32(HAAR_EVAL_ALPHA0[i])));
+            }
+#else
+            {
+                __m128 f = _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) s[0])), _mm_set1_ps((float) native->coef[0][i]));
+                __m128 ge;
+
+                f = _mm_add_ps(f, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) s[1])), _mm_set1_ps((float) native->coef[1][i])));
+                if (rects == 3) {
+                    f = _mm_add_ps(f, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *) s[2])), _mm_set1_ps((float) native->coef[2][i])));
+                }
+                ge = _mm_cmpge_ps(f, _mm_mul_ps(vnf, _mm_set1_ps(native->node_threshold[i])));
+                stage_sum = _mm_add_ps(stage_sum, _mm_or_ps(_mm_and_ps(ge, _mm_set1_ps(HAAR_EVAL_ALPHA1[i])),
+                        _mm_andnot_ps(ge, _mm_set1_ps(HAAR_EVAL_ALPHA0[i]))));
+            }
+#endif
+        }
+#if HAAR_NATIVE_NEON
+        alive = vandq_u32(alive, vcgeq_f32(stage_sum, vdupq_n_f32(HAAR_EVAL_STAGES[st].threshold)));
+        {
+            uint32x2_t any = vpmax_u32(vget_low_u32(alive), vget_high_u32(alive));
+
+            if (vget_lane_u32(vpmax_u32(any, any), 0) == 0) {
+                return 0;
+            }
+        }
+#else
+        alive = _mm_and_ps(alive, _mm_cmpge_ps(stage_sum, _mm_set1_ps(HAAR_EVAL_STAGES[st].threshold)));
+        if (_mm_movemask_ps(alive) == 0) {
+            return 0;
+        }
+#endif
+    }
+#if HAAR_NATIVE_NEON
+    vst1q_u32(mask, alive);
+    return (mask[0] & 1) | (mask[1] & 2) | (mask[2] & 4) | (mask[3] & 8);
+#else
+    return (unsigned) _mm_movemask_ps(alive);
+#endif
+}
+#else
+static unsigned HAAR_EVAL_FN(const HAAR_NATIVE_T *native, const int *p, const float *vnf, int lanes) {
+    unsigned mask = 0;
+    int st, i, l;
+
+    for (l = 0; l < lanes; l++) {
+        for (st = 0; st < HAAR_EVAL_STAGE_COUNT; st++) {
+            const int first = HAAR_EVAL_STAGES[st].first;
+            const int end = first + HAAR_EVAL_STAGES[st].count;
+            float stage_sum = 0;
+
+            for (i = first; i < end; i++) {
+                const int32_t *base = HAAR_EVAL_TILTED[i] ? native->tilted_sum : native->sum;
+                float f = (float) haar_rect_sum(base, p[l], native, 0, i) * native->coef[0][i]
+                        + (float) haar_rect_sum(base, p[l], native, 1, i) * native->coef[1][i];
+
+                if (HAAR_EVAL_RECT_W2[i]) {
+                    f += (float) haar_rect_sum(base, p[l], native, 2, i) * native->coef[2][i];
+                }
+                stage_sum += f >= native->node_threshold[i] * vnf[l] ? HAAR_EVAL_ALPHA1[i] : HAAR_EVAL_ALPHA0[i];
+            }
+            if (stage_sum < HAAR_EVAL_STAGES[st].threshold) {
+                break;
+            }
+        }
+        if (st == HAAR_EVAL_STAGE_COUNT) {
+            mask |= 1u << l;
+        }
+    }
+    return mask;
+}
+#endif
+
+#undef HAAR_EVAL_FN
+#undef HAAR_EVAL_STAGE_COUNT
+#undef HAAR_EVAL_STAGES
+#undef HAAR_EVAL_TILTED
+#undef HAAR_EVAL_RECT_W2
+#undef HAAR_EVAL_ALPHA0
+#undef HAAR_EVAL_ALPHA1
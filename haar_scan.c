@@ -0,0 +1,415 @@
+/*
+ * File:   haar_scan.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "haar_scan.h"
+
+typedef struct {
+    CvRect rect;
+    int neighbors;
+} HAAR_GROUP_T;
+
+static int similar_rects(const CvRect *a, const CvRect *b) {
+    double delta = HAAR_SCAN_GROUP_EPS * (MIN(a->width, b->width) + MIN(a->height, b->height)) * 0.5;
+
+    return fabs((double) (a->x - b->x)) <= delta
+            && fabs((double) (a->y - b->y)) <= delta
+            && fabs((double) (a->x + a->width - b->x - b->width)) <= delta
+            && fabs((double) (a->y + a->height - b->y - b->height)) <= delta;
+}
+
+static int find_root(int *parent, int i) {
+    while (parent[i] != i) {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+/*
+ * cv::groupRectangles: clusters of similar rectangles are averaged, clusters
+ * with min_neighbors or fewer members are dropped, and so are small clusters
+ * sitting inside a stronger bigger one. Returns the number of groups, or -1
+ * when the arena is out of room.
+ */
+static int group_rects(const CvRect *rects, int n, int min_neighbors, FRAME_ARENA_T *arena, HAAR_GROUP_T *out, int max_out) {
+    int *parent = (int *) frame_arena_alloc(arena, sizeof (int) * n);
+    int *label = (int *) frame_arena_alloc(arena, sizeof (int) * n);
+    HAAR_GROUP_T *cls = (HAAR_GROUP_T *) frame_arena_alloc(arena, sizeof (HAAR_GROUP_T) * n);
+    int classes = 0, count = 0;
+    int i, j;
+
+    if (!parent || !label || !cls) {
+        return -1;
+    }
+    for (i = 0; i < n; i++) {
+        parent[i] = i;
+        label[i] = -1;
+    }
+    for (i = 0; i < n; i++) {
+        for (j = 0; j < i; j++) {
+            if (similar_rects(&rects[i], &rects[j])) {
+                int a = find_root(parent, i), b = find_root(parent, j);
+
+                if (a != b) {
+                    parent[a] = b;
+                }
+            }
+        }
+    }
+    // sums per cluster first, averaged below
+    for (i = 0; i < n; i++) {
+        int root = find_root(parent, i);
+        HAAR_GROUP_T *c;
+
+        if (label[root] < 0) {
+            label[root] = classes++;
+            memset(&cls[label[root]], 0, sizeof (HAAR_GROUP_T));
+        }
+        c = &cls[label[root]];
+        c->rect.x += rects[i].x;
+        c->rect.y += rects[i].y;
+        c->rect.width += rects[i].width;
+        c->rect.height += rects[i].height;
+        c->neighbors++;
+    }
+    for (i = 0; i < classes; i++) {
+        double s = 1.0 / cls[i].neighbors;
+
+        cls[i].rect = cvRect(cvRound(cls[i].rect.x * s), cvRound(cls[i].rect.y * s),
+                cvRound(cls[i].rect.width * s), cvRound(cls[i].rect.height * s));
+    }
+
+    for (i = 0; i < classes && count < max_out; i++) {
+        const CvRect *r1 = &cls[i].rect;
+        int n1 = cls[i].neighbors;
+
+        if (n1 <= min_neighbors) {
+            continue;
+        }
+        for (j = 0; j < classes; j++) {
+            const CvRect *r2 = &cls[j].rect;
+            int n2 = cls[j].neighbors;
+            int dx, dy;
+
+            if (j == i || n2 <= min_neighbors) {
+                continue;
+            }
+            dx = cvRound(r2->width * HAAR_SCAN_GROUP_EPS);
+            dy = cvRound(r2->height * HAAR_SCAN_GROUP_EPS);
+            if (r1->x >= r2->x - dx && r1->y >= r2->y - dy
+                    && r1->x + r1->width <= r2->x + r2->width + dx
+                    && r1->y + r1->height <= r2->y + r2->height + dy
+                    && (n2 > MAX(3, n1) || n1 < 3)) {
+                break;
+            }
+        }
+        if (j == classes) {
+            out[count++] = cls[i];
+        }
+    }
+    return count;
+}
+
+typedef struct {
+    const HAAR_NATIVE_T *native;
+    int x0, y0, x1, y1; // scan bounds in level pixels
+    int shift;
+    double step;
+    CvSize win_base;
+    int iy_begin; // window rows [iy_begin, iy_end)
+    int iy_end;
+    CvRect *candidates;
+    int *count; // shared by every band of a scan
+    uint32_t windows;
+    uint32_t passed;
+    uint32_t overflows;
+} HAAR_SCAN_BAND_T;
+
+static void add_candidate(CvRect *candidates, int *count, CvRect r, uint32_t *overflows) {
+    int i = __atomic_fetch_add(count, 1, __ATOMIC_RELAXED);
+
+    if (i < HAAR_SCAN_MAX_CANDIDATES) {
+        candidates[i] = r;
+    } else {
+        (*overflows)++;
+    }
+}
+
+/* Runs native, already at the level's scale, over a band of window rows. */
+static void scan_band(void *arg) {
+    HAAR_SCAN_BAND_T *band = (HAAR_SCAN_BAND_T *) arg;
+    const HAAR_NATIVE_T *native = band->native;
+    int ww = native->window.width;
+    int xs[HAAR_SCAN_ROW_CHUNK];
+    uint8_t pass[HAAR_SCAN_ROW_CHUNK];
+    int iy, ix, i, count;
+
+    for (iy = band->iy_begin; iy < band->iy_end; iy++) {
+        int y = band->y0 + cvRound(iy * band->step);
+
+        ix = 0;
+        do {
+            for (count = 0; count < HAAR_SCAN_ROW_CHUNK; ix++) {
+                int x = band->x0 + cvRound(ix * band->step);
+
+                if (x + ww > band->x1) {
+                    break;
+                }
+                xs[count++] = x;
+            }
+            if (count == 0) {
+                break;
+            }
+            band->windows += count;
+            if (haar_native_run_row(native, xs, count, y, pass) == 0) {
+                continue;
+            }
+            for (i = 0; i < count; i++) {
+                if (pass[i]) {
+                    band->passed++;
+                    add_candidate(band->candidates, band->count,
+                            cvRect(xs[i] << band->shift, y << band->shift, band->win_base.width, band->win_base.height),
+                            &band->overflows);
+                }
+            }
+        } while (count == HAAR_SCAN_ROW_CHUNK);
+    }
+}
+
+static void add_band_stats(HAAR_SCAN_STATS_T *stats, const HAAR_SCAN_BAND_T *band) {
+    stats->windows += band->windows;
+    stats->candidates += band->passed;
+    stats->overflows += band->overflows;
+}
+
+/* Serial order: smaller windows first, then row by row. */
+static int compare_candidates(const void *pa, const void *pb) {
+    const CvRect *a = (const CvRect *) pa, *b = (const CvRect *) pb;
+
+    if (a->width != b->width) {
+        return a->width - b->width;
+    }
+    if (a->y != b->y) {
+        return a->y - b->y;
+    }
+    return a->x - b->x;
+}
+
+void haar_scan_workers_init(HAAR_SCAN_WORKERS_T *workers, TASK_POOL_T *pool) {
+    memset(workers, 0, sizeof (HAAR_SCAN_WORKERS_T));
+    workers->pool = pool;
+}
+
+void haar_scan_workers_destroy(HAAR_SCAN_WORKERS_T *workers) {
+    int k;
+
+    for (k = 0; k < SCALE_PLAN_MAX_LEVELS; k++) {
+        haar_native_destroy(workers->native[k]);
+        workers->native[k] = NULL;
+    }
+}
+
+int haar_scan(CvHaarClassifierCascade *cascade, HAAR_NATIVE_T *native, HAAR_SCAN_WORKERS_T *workers,
+        IMAGE_PYRAMID_T *pyramid, CvRect region, const HAAR_SCAN_PARAMS_T *params, FRAME_ARENA_T *arena,
+        CvRect *objects, int max_objects, HAAR_SCAN_STATS_T *stats) {
+    HAAR_SCAN_STATS_T unused;
+    SCALE_PLAN_T plan;
+    CvRect *candidates;
+    HAAR_GROUP_T *groups;
+    HAAR_SCAN_BAND_T *bands = NULL;
+    TASK_T *tasks = NULL;
+    int n = 0, found = 0;
+    int k, i, j;
+
+    if (!stats) {
+        stats = &unused;
+    }
+    stats->scans++;
+    scale_plan_build(&plan, native ? native->cascade.orig_window : cascade->orig_window_size, params->scale_factor,
+            params->min_size, params->max_size, cvSize(region.width, region.height));
+    stats->skipped_levels += plan.skipped;
+    if (plan.count == 0 || max_objects <= 0) {
+        return 0;
+    }
+    candidates = (CvRect *) frame_arena_alloc(arena, sizeof (CvRect) * HAAR_SCAN_MAX_CANDIDATES);
+    groups = (HAAR_GROUP_T *) frame_arena_alloc(arena, sizeof (HAAR_GROUP_T) * max_objects);
+    if (!candidates || !groups) {
+        return 0;
+    }
+    if (workers && native) {
+        bands = (HAAR_SCAN_BAND_T *) frame_arena_alloc(arena, sizeof (HAAR_SCAN_BAND_T) * HAAR_SCAN_MAX_TASKS);
+        tasks = (TASK_T *) frame_arena_alloc(arena, sizeof (TASK_T) * HAAR_SCAN_MAX_TASKS);
+        if (!bands || !tasks) {
+            workers = NULL;
+        }
+    } else {
+        workers = NULL;
+    }
+
+    // one round per level when only the biggest object is wanted, else one round for all
+    for (k = 0; k < plan.count;) {
+        int round_end = params->find_biggest ? k + 1 : plan.count;
+        int round_start = MIN(n, HAAR_SCAN_MAX_CANDIDATES);
+        int band_count = 0;
+
+        for (; k < round_end; k++) {
+            // biggest first when only the biggest object is wanted
+            int level_index = params->find_biggest ? plan.count - 1 - k : k;
+            double factor = plan.factor[level_index];
+            CvSize win_base = plan.window[level_index];
+            int li = image_pyramid_level_for(pyramid, factor);
+            const IMAGE_PYRAMID_LEVEL_T *level = image_pyramid_level(pyramid, li);
+            int shift = level->shift;
+            int unit = 1 << shift;
+            // cvHaarDetectObjects steps max(2, factor) base pixels between windows
+            double step = MAX(2.0, factor) / unit;
+            int x0 = (region.x + unit - 1) >> shift;
+            int y0 = (region.y + unit - 1) >> shift;
+            int x1 = (region.x + region.width) >> shift;
+            int y1 = (region.y + region.height) >> shift;
+            HAAR_NATIVE_T *level_native = native;
+            int use_native;
+            int ww, wh, ix, iy, rows;
+
+            if (step < 1.0) {
+                step = 1.0;
+            }
+            if (workers) {
+                // levels of one round run at once, each needs its own scale state
+                if (!workers->native[level_index]) {
+                    workers->native[level_index] = haar_native_clone(native);
+                }
+                if (workers->native[level_index]) {
+                    level_native = workers->native[level_index];
+                }
+            }
+            use_native = level_native && haar_native_set_scale(level_native, level->sum, level->sqsum, level->tilted, factor / unit) == 0;
+            if (!use_native && !cascade) {
+                // compiled-in cascade only, and its weights overflow at this scale
+                stats->skipped_levels++;
+                continue;
+            }
+            stats->levels++;
+
+            if (use_native) {
+                HAAR_SCAN_BAND_T band;
+
+                stats->native_levels++;
+                wh = level_native->window.height;
+                for (rows = 0; y0 + cvRound(rows * step) + wh <= y1; rows++) {
+                }
+                memset(&band, 0, sizeof (band));
+                band.native = level_native;
+                band.x0 = x0;
+                band.y0 = y0;
+                band.x1 = x1;
+                band.y1 = y1;
+                band.shift = shift;
+                band.step = step;
+                band.win_base = win_base;
+                band.candidates = candidates;
+                band.count = &n;
+                for (iy = 0; iy < rows; iy += HAAR_SCAN_BAND_ROWS) {
+                    band.iy_begin = iy;
+                    if (!workers || level_native == native || band_count == HAAR_SCAN_MAX_TASKS) {
+                        // no pool, no clone for this level or out of task slots: the rest right here
+                        band.iy_end = rows;
+                        scan_band(&band);
+                        add_band_stats(stats, &band);
+                        break;
+                    }
+                    band.iy_end = MIN(iy + HAAR_SCAN_BAND_ROWS, rows);
+                    bands[band_count++] = band;
+                }
+            } else {
+                cvSetImagesForHaarClassifierCascade(cascade, level->sum, level->sqsum, level->tilted, factor / unit);
+                ww = cascade->real_window_size.width;
+                wh = cascade->real_window_size.height;
+                for (iy = 0;; iy++) {
+                    int y = y0 + cvRound(iy * step);
+
+                    if (y + wh > y1) {
+                        break;
+                    }
+                    for (ix = 0;; ix++) {
+                        int x = x0 + cvRound(ix * step);
+
+                        if (x + ww > x1) {
+                            break;
+                        }
+                        stats->windows++;
+                        if (cvRunHaarClassifierCascade(cascade, cvPoint(x, y), 0) > 0) {
+                            stats->candidates++;
+                            add_candidate(candidates, &n, cvRect(x << shift, y << shift, win_base.width, win_base.height),
+                                    &stats->overflows);
+                        }
+                    }
+                }
+            }
+        }
+
+        if (band_count > 0) {
+            for (i = 0; i < band_count; i++) {
+                tasks[i].fn = scan_band;
+                tasks[i].arg = &bands[i];
+            }
+            task_pool_run(workers->pool, tasks, band_count);
+            for (i = 0; i < band_count; i++) {
+                add_band_stats(stats, &bands[i]);
+            }
+        }
+        n = MIN(n, HAAR_SCAN_MAX_CANDIDATES);
+        if (workers) {
+            // bands finish in any order; put this round back the way a serial scan finds it
+            qsort(candidates + round_start, n - round_start, sizeof (CvRect), compare_candidates);
+        }
+
+        if (params->find_biggest && n > params->min_neighbors) {
+            size_t mark = frame_arena_mark(arena);
+
+            found = group_rects(candidates, n, params->min_neighbors, arena, groups, max_objects);
+            frame_arena_rewind(arena, mark);
+            if (found > 0) {
+                break;
+            }
+        }
+    }
+    if (!params->find_biggest || found <= 0) {
+        found = n > 0 ? group_rects(candidates, n, params->min_neighbors, arena, groups, max_objects) : 0;
+    }
+    if (found <= 0) {
+        return 0;
+    }
+
+    if (params->find_biggest) {
+        // only the largest group, as CV_HAAR_FIND_BIGGEST_OBJECT
+        for (i = 1; i < found; i++) {
+            if (groups[i].rect.width * groups[i].rect.height > groups[0].rect.width * groups[0].rect.height) {
+                groups[0] = groups[i];
+            }
+        }
+        found = 1;
+    } else {
+        // strongest first
+        for (i = 1; i < found; i++) {
+            HAAR_GROUP_T g = groups[i];
+
+            for (j = i; j > 0 && groups[j - 1].neighbors < g.neighbors; j--) {
+                groups[j] = groups[j - 1];
+            }
+            groups[j] = g;
+        }
+    }
+    for (i = 0; i < found; i++) {
+        objects[i] = groups[i].rect;
+    }
+    return found;
+}
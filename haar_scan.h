@@ -0,0 +1,81 @@
+/*
+ * File:   haar_scan.h
+ * Author: Hassan
+ *
+ * Sliding-window Haar detection over a sub-rectangle of an IMAGE_PYRAMID_T.
+ * Takes the place of cvHaarDetectObjects: each planned window size is run on
+ * the pyramid level that keeps the cascade's feature scale in [1, 2), with the
+ * cached integrals, by haar_native when it is given one and by
+ * cvRunHaarClassifierCascade otherwise. The hits are grouped the way
+ * cvHaarDetectObjects groups them (cv::groupRectangles, eps 0.2). Scratch
+ * comes from the frame arena.
+ *
+ * Given HAAR_SCAN_WORKERS_T, the haar_native levels are cut into bands of
+ * window rows and the bands of every level are run at once on a TASK_POOL_T,
+ * each level on its own clone of native. The hits are put back in the order
+ * a serial scan finds them before grouping, so as long as they fit in
+ * HAAR_SCAN_MAX_CANDIDATES the result does not depend on the number of
+ * threads. Levels left to OpenCV still run on the caller.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef HAAR_SCAN_H
+#define HAAR_SCAN_H
+
+#include <stdint.h>
+
+#include <opencv2/core/core_c.h>
+#include <opencv2/objdetect/objdetect.hpp>
+
+#include "frame_arena.h"
+#include "image_pyramid.h"
+#include "haar_native.h"
+#include "scale_plan.h"
+#include "task_pool.h"
+
+#define HAAR_SCAN_MAX_CANDIDATES 1024
+#define HAAR_SCAN_GROUP_EPS 0.2
+#define HAAR_SCAN_ROW_CHUNK 256 // windows per haar_native_run_row call
+#define HAAR_SCAN_BAND_ROWS 4 // window rows per task
+#define HAAR_SCAN_MAX_TASKS 256 // per round; the rest of a level runs on the caller
+
+typedef struct {
+    double scale_factor;
+    int min_neighbors;
+    CvSize min_size;
+    CvSize max_size;
+    int find_biggest; // scan from the largest window down, stop at the first level that yields an object
+} HAAR_SCAN_PARAMS_T;
+
+typedef struct {
+    uint32_t scans;
+    uint32_t levels; // window sizes scanned
+    uint32_t native_levels; // ... of which by haar_native
+    uint32_t skipped_levels; // window sizes the scale plan ruled out or no evaluator could take
+    uint32_t windows; // cascade evaluations
+    uint32_t candidates; // windows that passed every stage
+    uint32_t overflows; // candidates dropped for lack of room
+} HAAR_SCAN_STATS_T;
+
+/* One per cascade and per thread that calls haar_scan. */
+typedef struct {
+    TASK_POOL_T *pool;
+    HAAR_NATIVE_T *native[SCALE_PLAN_MAX_LEVELS]; // per plan level, cloned on first use
+} HAAR_SCAN_WORKERS_T;
+
+void haar_scan_workers_init(HAAR_SCAN_WORKERS_T *workers, TASK_POOL_T *pool);
+void haar_scan_workers_destroy(HAAR_SCAN_WORKERS_T *workers);
+
+/*
+ * Scans region (base image coordinates) and writes up to max_objects grouped
+ * detections into objects, most neighbours first. Returns how many. Either
+ * cascade or native may be NULL, not both; with no cascade, the levels
+ * haar_native cannot take are skipped. workers NULL scans on the caller alone.
+ */
+int haar_scan(CvHaarClassifierCascade *cascade, HAAR_NATIVE_T *native, HAAR_SCAN_WORKERS_T *workers,
+        IMAGE_PYRAMID_T *pyramid, CvRect region,
+        const HAAR_SCAN_PARAMS_T *params, FRAME_ARENA_T *arena,
+        CvRect *objects, int max_objects, HAAR_SCAN_STATS_T *stats);
+
+#endif /* HAAR_SCAN_H */
@@ -0,0 +1,104 @@
+/*
+ * File:   image_pyramid.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "image_pyramid.h"
+
+int image_pyramid_init(IMAGE_PYRAMID_T *pyramid, IplImage *base) {
+    int i;
+
+    memset(pyramid, 0, sizeof (IMAGE_PYRAMID_T));
+    for (i = 0; i < IMAGE_PYRAMID_MAX_LEVELS; i++) {
+        IMAGE_PYRAMID_LEVEL_T *level = &pyramid->level[i];
+        int w = base->width >> i;
+        int h = base->height >> i;
+
+        if (w < IMAGE_PYRAMID_MIN_SIDE || h < IMAGE_PYRAMID_MIN_SIDE) {
+            break;
+        }
+        level->shift = i;
+        level->image = i == 0 ? base : cvCreateImage(cvSize(w, h), IPL_DEPTH_8U, 1);
+        level->sum = cvCreateMat(h + 1, w + 1, CV_32SC1);
+        level->sqsum = cvCreateMat(h + 1, w + 1, CV_64FC1);
+        level->tilted = cvCreateMat(h + 1, w + 1, CV_32SC1);
+        pyramid->count = i + 1;
+        if (!level->image || !level->sum || !level->sqsum || !level->tilted) {
+            fprintf(stderr, "Error: unable to allocate pyramid level %d\n", i);
+            image_pyramid_destroy(pyramid);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+void image_pyramid_destroy(IMAGE_PYRAMID_T *pyramid) {
+    int i;
+
+    for (i = 0; i < pyramid->count; i++) {
+        IMAGE_PYRAMID_LEVEL_T *level = &pyramid->level[i];
+
+        if (i > 0 && level->image) {
+            cvReleaseImage(&level->image);
+        }
+        if (level->sum) {
+            cvReleaseMat(&level->sum);
+        }
+        if (level->sqsum) {
+            cvReleaseMat(&level->sqsum);
+        }
+        if (level->tilted) {
+            cvReleaseMat(&level->tilted);
+        }
+    }
+    pyramid->count = 0;
+}
+
+void image_pyramid_invalidate(IMAGE_PYRAMID_T *pyramid) {
+    int i;
+
+    for (i = 0; i < pyramid->count; i++) {
+        // level 0 is the base image itself
+        pyramid->level[i].image_built = i == 0;
+        pyramid->level[i].integral_built = 0;
+    }
+}
+
+int image_pyramid_level_for(const IMAGE_PYRAMID_T *pyramid, double factor) {
+    int i = 0;
+
+    while (i + 1 < pyramid->count && (double) (1 << (i + 1)) <= factor) {
+        i++;
+    }
+    return i;
+}
+
+static void build_image(IMAGE_PYRAMID_T *pyramid, int index) {
+    IMAGE_PYRAMID_LEVEL_T *level = &pyramid->level[index];
+
+    if (level->image_built) {
+        return;
+    }
+    build_image(pyramid, index - 1);
+    cvResize(pyramid->level[index - 1].image, level->image, CV_INTER_AREA);
+    level->image_built = 1;
+}
+
+const IMAGE_PYRAMID_LEVEL_T *image_pyramid_level(IMAGE_PYRAMID_T *pyramid, int index) {
+    IMAGE_PYRAMID_LEVEL_T *level = &pyramid->level[index];
+
+    if (!level->integral_built) {
+        build_image(pyramid, index);
+        cvIntegral(level->image, level->sum, level->sqsum, level->tilted);
+        level->integral_built = 1;
+        pyramid->integrals_built++;
+    }
+    return level;
+}
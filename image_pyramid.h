@@ -0,0 +1,52 @@
+/*
+ * File:   image_pyramid.h
+ * Author: Hassan
+ *
+ * Per-frame octave pyramid of the detector image with the sum, squared sum
+ * and tilted sum images each Haar cascade needs. Levels and their integrals
+ * are built on first use after image_pyramid_invalidate and then shared by
+ * every scan of the frame, so the face and eye passes never recompute them.
+ * All buffers are allocated once at init.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef IMAGE_PYRAMID_H
+#define IMAGE_PYRAMID_H
+
+#include <stdint.h>
+
+#include <opencv2/core/core_c.h>
+
+#define IMAGE_PYRAMID_MAX_LEVELS 4
+#define IMAGE_PYRAMID_MIN_SIDE 24 // no level smaller than one cascade window
+
+typedef struct {
+    IplImage *image; // level 0 is the caller's image, the others are owned
+    CvMat *sum;
+    CvMat *sqsum;
+    CvMat *tilted;
+    int shift; // level pixels are 1 << shift base pixels
+    int image_built;
+    int integral_built;
+} IMAGE_PYRAMID_LEVEL_T;
+
+typedef struct {
+    int count;
+    IMAGE_PYRAMID_LEVEL_T level[IMAGE_PYRAMID_MAX_LEVELS];
+    uint32_t integrals_built; // since init, to check the sharing
+} IMAGE_PYRAMID_T;
+
+int image_pyramid_init(IMAGE_PYRAMID_T *pyramid, IplImage *base);
+void image_pyramid_destroy(IMAGE_PYRAMID_T *pyramid);
+
+/* The base image has new content: drop every cached level. */
+void image_pyramid_invalidate(IMAGE_PYRAMID_T *pyramid);
+
+/* Deepest level whose pixel size does not exceed factor base pixels. */
+int image_pyramid_level_for(const IMAGE_PYRAMID_T *pyramid, double factor);
+
+/* Returns the level with its image and integrals built for this frame. */
+const IMAGE_PYRAMID_LEVEL_T *image_pyramid_level(IMAGE_PYRAMID_T *pyramid, int index);
+
+#endif /* IMAGE_PYRAMID_H */
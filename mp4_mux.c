@@ -0,0 +1,561 @@
+/*
+ * File:   mp4_mux.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "mp4_mux.h"
+
+#define NAL_SLICE_IDR 5
+#define NAL_SPS 7
+#define NAL_PPS 8
+#define NAL_AUD 9
+
+static uint8_t *put16(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t) (v >> 8);
+    p[1] = (uint8_t) v;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t) (v >> 24);
+    p[1] = (uint8_t) (v >> 16);
+    p[2] = (uint8_t) (v >> 8);
+    p[3] = (uint8_t) v;
+    return p + 4;
+}
+
+static uint8_t *put64(uint8_t *p, uint64_t v) {
+    return put32(put32(p, (uint32_t) (v >> 32)), (uint32_t) v);
+}
+
+static uint8_t *put_zero(uint8_t *p, int n) {
+    memset(p, 0, n);
+    return p + n;
+}
+
+/* Box header with the size patched by box_end; full boxes add version and flags. */
+static uint8_t *box_begin(uint8_t *p, const char *type) {
+    memcpy(p + 4, type, 4);
+    return p + 8;
+}
+
+static uint8_t *full_box_begin(uint8_t *p, const char *type, uint32_t version_flags) {
+    return put32(box_begin(p, type), version_flags);
+}
+
+static void box_end(uint8_t *start, uint8_t *end) {
+    put32(start, (uint32_t) (end - start));
+}
+
+static uint8_t *put_matrix(uint8_t *p) {
+    static const uint32_t unity[9] = {0x10000, 0, 0, 0, 0x10000, 0, 0, 0, 0x40000000};
+    int i;
+
+    for (i = 0; i < 9; i++) {
+        p = put32(p, unity[i]);
+    }
+    return p;
+}
+
+/* Exp-Golomb reading of the SPS, emulation prevention already taken out. */
+typedef struct {
+    const uint8_t *data;
+    uint32_t length;
+    uint32_t bit;
+} BITS_T;
+
+static uint32_t read_bit(BITS_T *b) {
+    uint32_t v;
+
+    if (b->bit >= b->length * 8) {
+        return 0;
+    }
+    v = (b->data[b->bit >> 3] >> (7 - (b->bit & 7))) & 1;
+    b->bit++;
+    return v;
+}
+
+static uint32_t read_bits(BITS_T *b, int n) {
+    uint32_t v = 0;
+
+    while (n-- > 0) {
+        v = (v << 1) | read_bit(b);
+    }
+    return v;
+}
+
+static uint32_t read_ue(BITS_T *b) {
+    int zeros = 0;
+
+    while (!read_bit(b) && zeros < 32) {
+        zeros++;
+    }
+    return ((1u << zeros) - 1) + read_bits(b, zeros);
+}
+
+static int32_t read_se(BITS_T *b) {
+    uint32_t v = read_ue(b);
+
+    return v & 1 ? (int32_t) ((v + 1) / 2) : -(int32_t) (v / 2);
+}
+
+static void skip_scaling_list(BITS_T *b, int size) {
+    int last = 8, next = 8, i;
+
+    for (i = 0; i < size; i++) {
+        if (next != 0) {
+            next = (last + read_se(b) + 256) % 256;
+        }
+        last = next == 0 ? last : next;
+    }
+}
+
+/* The picture size the SPS describes, after cropping; -1 for one it cannot read. */
+static int parse_sps(const uint8_t *sps, uint32_t length, int *width, int *height) {
+    uint8_t rbsp[MP4_MUX_PARAM_MAX];
+    uint32_t n = 0, i, profile, chroma = 1, poc_type, frame_mbs_only, w, h;
+    uint32_t crop_left = 0, crop_right = 0, crop_top = 0, crop_bottom = 0;
+    BITS_T b;
+
+    for (i = 1; i < length; i++) {
+        if (i >= 3 && sps[i] == 3 && sps[i - 1] == 0 && sps[i - 2] == 0) {
+            continue;
+        }
+        rbsp[n++] = sps[i];
+    }
+    b.data = rbsp;
+    b.length = n;
+    b.bit = 0;
+    profile = read_bits(&b, 8);
+    read_bits(&b, 16); // constraints and level
+    read_ue(&b); // seq_parameter_set_id
+    if (profile == 100 || profile == 110 || profile == 122 || profile == 244 || profile == 44
+            || profile == 83 || profile == 86 || profile == 118 || profile == 128) {
+        chroma = read_ue(&b);
+        if (chroma == 3) {
+            read_bit(&b);
+        }
+        read_ue(&b); // bit depths
+        read_ue(&b);
+        read_bit(&b);
+        if (read_bit(&b)) {
+            for (i = 0; i < (chroma != 3 ? 8u : 12u); i++) {
+                if (read_bit(&b)) {
+                    skip_scaling_list(&b, i < 6 ? 16 : 64);
+                }
+            }
+        }
+    }
+    read_ue(&b); // log2_max_frame_num_minus4
+    poc_type = read_ue(&b);
+    if (poc_type == 0) {
+        read_ue(&b);
+    } else if (poc_type == 1) {
+        read_bit(&b);
+        read_se(&b);
+        read_se(&b);
+        for (i = read_ue(&b); i > 0; i--) {
+            read_se(&b);
+        }
+    }
+    read_ue(&b); // max_num_ref_frames
+    read_bit(&b);
+    w = read_ue(&b) + 1;
+    h = read_ue(&b) + 1;
+    frame_mbs_only = read_bit(&b);
+    if (!frame_mbs_only) {
+        read_bit(&b);
+    }
+    read_bit(&b); // direct_8x8_inference
+    if (read_bit(&b)) {
+        crop_left = read_ue(&b);
+        crop_right = read_ue(&b);
+        crop_top = read_ue(&b);
+        crop_bottom = read_ue(&b);
+    }
+    if (b.bit > b.length * 8) {
+        return -1;
+    }
+    // crop units for 4:2:0, the only format the encoder makes
+    *width = (int) (w * 16 - (crop_left + crop_right) * 2);
+    *height = (int) ((2 - frame_mbs_only) * h * 16 - (crop_top + crop_bottom) * 2 * (2 - frame_mbs_only));
+    return *width > 0 && *height > 0 ? 0 : -1;
+}
+
+static void build_init(MP4_MUX_T *mux) {
+    uint8_t *p = mux->init, *moov, *trak, *mdia, *minf, *dinf, *dref, *stbl, *stsd, *avc1, *avcc, *mvex, *box;
+
+    box = p;
+    p = box_begin(p, "ftyp");
+    memcpy(p, "isom", 4);
+    p = put32(p + 4, 0x200);
+    memcpy(p, "isomiso6avc1mp41", 16);
+    p += 16;
+    box_end(box, p);
+
+    moov = p;
+    p = box_begin(p, "moov");
+    box = p;
+    p = full_box_begin(p, "mvhd", 0);
+    p = put32(p, 0); // creation and modification time
+    p = put32(p, 0);
+    p = put32(p, 1000);
+    p = put32(p, 0); // duration, the fragments carry it
+    p = put32(p, 0x00010000);
+    p = put16(p, 0x0100);
+    p = put_zero(p, 10);
+    p = put_matrix(p);
+    p = put_zero(p, 24);
+    p = put32(p, 2); // next track ID
+    box_end(box, p);
+
+    trak = p;
+    p = box_begin(p, "trak");
+    box = p;
+    p = full_box_begin(p, "tkhd", 3); // enabled, in movie
+    p = put32(p, 0);
+    p = put32(p, 0);
+    p = put32(p, 1); // track ID
+    p = put32(p, 0);
+    p = put32(p, 0); // duration
+    p = put_zero(p, 8);
+    p = put32(p, 0); // layer and alternate group
+    p = put32(p, 0); // volume
+    p = put_matrix(p);
+    p = put32(p, (uint32_t) mux->width << 16);
+    p = put32(p, (uint32_t) mux->height << 16);
+    box_end(box, p);
+
+    mdia = p;
+    p = box_begin(p, "mdia");
+    box = p;
+    p = full_box_begin(p, "mdhd", 0);
+    p = put32(p, 0);
+    p = put32(p, 0);
+    p = put32(p, MP4_MUX_TIMESCALE);
+    p = put32(p, 0);
+    p = put16(p, 0x55c4); // "und"
+    p = put16(p, 0);
+    box_end(box, p);
+    box = p;
+    p = full_box_begin(p, "hdlr", 0);
+    p = put32(p, 0);
+    memcpy(p, "vide", 4);
+    p = put_zero(p + 4, 12);
+    memcpy(p, "VideoHandler", 13);
+    p += 13;
+    box_end(box, p);
+
+    minf = p;
+    p = box_begin(p, "minf");
+    box = p;
+    p = full_box_begin(p, "vmhd", 1);
+    p = put_zero(p, 8);
+    box_end(box, p);
+    dinf = p;
+    p = box_begin(p, "dinf");
+    dref = p;
+    p = full_box_begin(p, "dref", 0);
+    p = put32(p, 1);
+    box = p;
+    p = full_box_begin(p, "url ", 1); // media in the same file
+    box_end(box, p);
+    box_end(dref, p);
+    box_end(dinf, p);
+
+    stbl = p;
+    p = box_begin(p, "stbl");
+    stsd = p;
+    p = full_box_begin(p, "stsd", 0);
+    p = put32(p, 1);
+    avc1 = p;
+    p = box_begin(p, "avc1");
+    p = put_zero(p, 6);
+    p = put16(p, 1); // data reference index
+    p = put_zero(p, 16);
+    p = put16(p, (uint32_t) mux->width);
+    p = put16(p, (uint32_t) mux->height);
+    p = put32(p, 0x00480000); // 72 dpi
+    p = put32(p, 0x00480000);
+    p = put32(p, 0);
+    p = put16(p, 1); // frame count
+    p = put_zero(p, 32); // compressor name
+    p = put16(p, 0x18);
+    p = put16(p, 0xffff);
+    avcc = p;
+    p = box_begin(p, "avcC");
+    *p++ = 1;
+    *p++ = mux->sps[1]; // profile, compatibility and level, as in the SPS
+    *p++ = mux->sps[2];
+    *p++ = mux->sps[3];
+    *p++ = 0xff; // 4 byte NAL lengths
+    *p++ = 0xe1; // one SPS
+    p = put16(p, mux->sps_length);
+    memcpy(p, mux->sps, mux->sps_length);
+    p += mux->sps_length;
+    *p++ = 1;
+    p = put16(p, mux->pps_length);
+    memcpy(p, mux->pps, mux->pps_length);
+    p += mux->pps_length;
+    if (mux->sps[1] == 100 || mux->sps[1] == 110 || mux->sps[1] == 122 || mux->sps[1] == 244) {
+        *p++ = 0xfd; // 4:2:0
+        *p++ = 0xf8; // 8 bit
+        *p++ = 0xf8;
+        *p++ = 0;
+    }
+    box_end(avcc, p);
+    box_end(avc1, p);
+    box_end(stsd, p);
+    // the sample tables are empty, the samples are in the fragments
+    box = p;
+    p = full_box_begin(p, "stts", 0);
+    p = put32(p, 0);
+    box_end(box, p);
+    box = p;
+    p = full_box_begin(p, "stsc", 0);
+    p = put32(p, 0);
+    box_end(box, p);
+    box = p;
+    p = full_box_begin(p, "stsz", 0);
+    p = put_zero(p, 8);
+    box_end(box, p);
+    box = p;
+    p = full_box_begin(p, "stco", 0);
+    p = put32(p, 0);
+    box_end(box, p);
+    box_end(stbl, p);
+    box_end(minf, p);
+    box_end(mdia, p);
+    box_end(trak, p);
+
+    mvex = p;
+    p = box_begin(p, "mvex");
+    box = p;
+    p = full_box_begin(p, "trex", 0);
+    p = put32(p, 1);
+    p = put32(p, 1); // sample description
+    p = put_zero(p, 12);
+    box_end(box, p);
+    box_end(mvex, p);
+    box_end(moov, p);
+    mux->init_length = (uint32_t) (p - mux->init);
+}
+
+int mp4_mux_init(MP4_MUX_T *mux, float fps, MP4_MUX_EMIT_T emit, void *arg) {
+    memset(mux, 0, sizeof (MP4_MUX_T));
+    mux->picture = (uint8_t *) malloc(MP4_MUX_PICTURE_MAX);
+    // length prefixes may be a byte longer than the start codes they replace
+    mux->fragment = (uint8_t *) malloc(MP4_MUX_HEADER_SIZE + MP4_MUX_PICTURE_MAX + MP4_MUX_PICTURE_MAX / 3);
+    if (!mux->picture || !mux->fragment) {
+        fprintf(stderr, "Error: mp4_mux: no memory for the picture buffers\n");
+        mp4_mux_destroy(mux);
+        return -1;
+    }
+    mux->emit = emit;
+    mux->arg = arg;
+    mux->picture_pts = MP4_MUX_PTS_UNKNOWN;
+    mux->first_pts = MP4_MUX_PTS_UNKNOWN;
+    mux->last_duration = (uint32_t) (MP4_MUX_TIMESCALE / (fps > 0 ? fps : 30.0));
+    return 0;
+}
+
+void mp4_mux_destroy(MP4_MUX_T *mux) {
+    free(mux->picture);
+    free(mux->fragment);
+    mux->picture = NULL;
+    mux->fragment = NULL;
+}
+
+/* Fills in moof and the mdat header for the waiting sample, and hands the fragment out. */
+static void emit_fragment(MP4_MUX_T *mux, uint32_t duration) {
+    uint8_t *p = mux->fragment, *moof, *traf, *box;
+    uint32_t sample = mux->fragment_length - MP4_MUX_HEADER_SIZE;
+
+    moof = p;
+    p = box_begin(p, "moof");
+    box = p;
+    p = full_box_begin(p, "mfhd", 0);
+    p = put32(p, ++mux->sequence);
+    box_end(box, p);
+    traf = p;
+    p = box_begin(p, "traf");
+    box = p;
+    p = full_box_begin(p, "tfhd", 0x020000); // offsets from the moof
+    p = put32(p, 1);
+    box_end(box, p);
+    box = p;
+    p = full_box_begin(p, "tfdt", 0x01000000);
+    p = put64(p, mux->fragment_time);
+    box_end(box, p);
+    box = p;
+    p = full_box_begin(p, "trun", 0x000701); // data offset, duration, size and flags of each sample
+    p = put32(p, 1);
+    p = put32(p, MP4_MUX_HEADER_SIZE);
+    p = put32(p, duration);
+    p = put32(p, sample);
+    // sync sample, or one that depends on others and is not a sync sample
+    p = put32(p, mux->fragment_key ? 0x02000000 : 0x01010000);
+    box_end(box, p);
+    box_end(traf, p);
+    box_end(moof, p);
+    box = p;
+    p = box_begin(p, "mdat");
+    put32(box, 8 + sample);
+
+    mux->pending = 0;
+    mux->last_duration = duration;
+    mux->emit(mux->fragment, mux->fragment_length, mux->fragment_key, mux->fragment_pts, mux->arg);
+}
+
+/* Decode time of a picture: its pts from the first one, or a frame after the last. */
+static uint64_t picture_time(MP4_MUX_T *mux, int64_t pts) {
+    uint64_t t;
+
+    if (pts == MP4_MUX_PTS_UNKNOWN || mux->first_pts == MP4_MUX_PTS_UNKNOWN) {
+        return mux->last_time + mux->last_duration;
+    }
+    t = (uint64_t) ((pts - mux->first_pts) * MP4_MUX_TIMESCALE / 1000000);
+    return t > mux->last_time ? t : mux->last_time + 1;
+}
+
+static const uint8_t *next_start_code(const uint8_t *p, const uint8_t *end) {
+    for (; p + 3 <= end; p++) {
+        if (p[0] == 0 && p[1] == 0 && p[2] == 1) {
+            return p;
+        }
+    }
+    return end;
+}
+
+static void keep_param(uint8_t *to, uint32_t *to_length, const uint8_t *nal, uint32_t length) {
+    if (length <= MP4_MUX_PARAM_MAX) {
+        memcpy(to, nal, length);
+        *to_length = length;
+    }
+}
+
+/* The picture's NAL units, length-prefixed, into the fragment; 0 when it has no slices. */
+static int convert_picture(MP4_MUX_T *mux) {
+    const uint8_t *end = mux->picture + mux->picture_length;
+    const uint8_t *p = next_start_code(mux->picture, end), *nal, *nal_end;
+    uint8_t *out = mux->fragment + MP4_MUX_HEADER_SIZE;
+    int type, slices = 0;
+
+    mux->fragment_key = 0;
+    while (p < end) {
+        nal = p + 3;
+        p = next_start_code(nal, end);
+        // trailing zeros belong to the next start code
+        for (nal_end = p; nal_end > nal && nal_end[-1] == 0; nal_end--) {
+        }
+        if (nal_end == nal) {
+            continue;
+        }
+        type = nal[0] & 0x1f;
+        if (type == NAL_SPS) {
+            // the first set goes in the init segment, repeats before each IDR stay out of the samples
+            if (!mux->init_length) {
+                keep_param(mux->sps, &mux->sps_length, nal, (uint32_t) (nal_end - nal));
+            }
+            continue;
+        }
+        if (type == NAL_PPS) {
+            if (!mux->init_length) {
+                keep_param(mux->pps, &mux->pps_length, nal, (uint32_t) (nal_end - nal));
+            }
+            continue;
+        }
+        if (type == NAL_AUD) {
+            continue;
+        }
+        if (type == NAL_SLICE_IDR) {
+            mux->fragment_key = 1;
+        }
+        if (type >= 1 && type <= 5) {
+            slices++;
+        }
+        out = put32(out, (uint32_t) (nal_end - nal));
+        memcpy(out, nal, nal_end - nal);
+        out += nal_end - nal;
+    }
+    mux->fragment_length = (uint32_t) (out - mux->fragment);
+    return slices > 0;
+}
+
+/* A picture is in: the one before goes out, this one waits for its duration. */
+static void end_picture(MP4_MUX_T *mux) {
+    uint64_t t;
+
+    if (mux->overflow) {
+        fprintf(stderr, "Error: mp4_mux: a picture of more than %u bytes is dropped\n", MP4_MUX_PICTURE_MAX);
+        mux->dropped++;
+        mux->started = 0; // from the next IDR on
+        mux->overflow = 0;
+        mux->picture_length = 0;
+        mux->picture_pts = MP4_MUX_PTS_UNKNOWN;
+        return;
+    }
+    t = picture_time(mux, mux->picture_pts);
+    if (mux->pending) {
+        emit_fragment(mux, (uint32_t) (t - mux->fragment_time));
+    }
+    if (convert_picture(mux)) {
+        if (!mux->init_length && mux->sps_length && mux->pps_length) {
+            if (parse_sps(mux->sps, mux->sps_length, &mux->width, &mux->height) == 0) {
+                build_init(mux);
+            } else {
+                fprintf(stderr, "Error: mp4_mux: unable to read the SPS\n");
+                mux->sps_length = 0;
+            }
+        }
+        if (mux->init_length && (mux->started || mux->fragment_key)) {
+            if (mux->sequence == 0 && !mux->pending) {
+                t = 0;
+            }
+            // pts from here on, continuing the time so far
+            if (mux->first_pts == MP4_MUX_PTS_UNKNOWN && mux->picture_pts != MP4_MUX_PTS_UNKNOWN) {
+                mux->first_pts = mux->picture_pts - (int64_t) (t * 1000000 / MP4_MUX_TIMESCALE);
+            }
+            mux->started = 1;
+            mux->pending = 1;
+            mux->fragment_pts = mux->picture_pts;
+            mux->fragment_time = t;
+            mux->last_time = t;
+        } else {
+            mux->dropped++;
+        }
+    }
+    mux->picture_length = 0;
+    mux->picture_pts = MP4_MUX_PTS_UNKNOWN;
+}
+
+void mp4_mux_push(MP4_MUX_T *mux, const uint8_t *data, size_t length, int frame_end, int64_t pts) {
+    if (mux->picture_pts == MP4_MUX_PTS_UNKNOWN && pts != MP4_MUX_PTS_UNKNOWN) {
+        mux->picture_pts = pts;
+        // the waiting sample's duration is known now, no need to hold it for the whole picture
+        if (mux->pending && mux->first_pts != MP4_MUX_PTS_UNKNOWN) {
+            emit_fragment(mux, (uint32_t) (picture_time(mux, pts) - mux->fragment_time));
+        }
+    }
+    if (length > MP4_MUX_PICTURE_MAX - mux->picture_length) {
+        mux->overflow = 1;
+    } else {
+        memcpy(mux->picture + mux->picture_length, data, length);
+        mux->picture_length += (uint32_t) length;
+    }
+    if (frame_end) {
+        end_picture(mux);
+    }
+}
+
+void mp4_mux_flush(MP4_MUX_T *mux) {
+    if (mux->pending) {
+        emit_fragment(mux, mux->last_duration);
+    }
+}
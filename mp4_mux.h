@@ -0,0 +1,77 @@
+/*
+ * File:   mp4_mux.h
+ * Author: Hassan
+ *
+ * Fragmented MP4 from the encoder's Annex-B output, without re-encoding.
+ * Buffers go in as the encoder hands them out; when a picture is complete
+ * its NAL units are rewritten with length prefixes into one sample, and
+ * once the next picture's pts gives its duration the sample goes out as a
+ * fragment of its own, moof and mdat, through the emit callback.
+ *
+ * The init segment (ftyp and moov, the SPS/PPS in avcC, the picture size
+ * from the SPS) is built from the first SPS/PPS; nothing is emitted before
+ * the IDR after it. A file is that init segment followed by fragments from
+ * an IDR on, and stays playable up to the last complete fragment whatever
+ * happens to the rest. Times are in 1/90000 s from buffer->pts, 0 at the
+ * first picture; a picture without a pts is one frame after the last.
+ *
+ * All of it runs on the thread pushing, with the two picture buffers
+ * allocated at init.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef MP4_MUX_H
+#define MP4_MUX_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define MP4_MUX_PTS_UNKNOWN INT64_MIN
+#define MP4_MUX_TIMESCALE 90000
+#define MP4_MUX_PICTURE_MAX (1 << 20) // Annex-B bytes of one picture, a larger one is dropped
+#define MP4_MUX_HEADER_SIZE 108 // moof for one sample and the mdat header
+#define MP4_MUX_PARAM_MAX 256 // SPS or PPS bytes
+#define MP4_MUX_INIT_MAX 2048
+
+/* One fragment: moof and mdat for a picture; key for an IDR, pts as pushed. */
+typedef void (*MP4_MUX_EMIT_T)(const uint8_t *data, size_t length, int key, int64_t pts, void *arg);
+
+typedef struct {
+    MP4_MUX_EMIT_T emit;
+    void *arg;
+    uint8_t *picture; // Annex-B of the picture coming in
+    uint32_t picture_length;
+    int64_t picture_pts;
+    int overflow; // the picture did not fit, it is dropped at its end
+    uint8_t *fragment; // header space, then the sample waiting for its duration
+    uint32_t fragment_length;
+    int fragment_key;
+    int64_t fragment_pts;
+    uint64_t fragment_time;
+    int pending;
+    uint8_t sps[MP4_MUX_PARAM_MAX];
+    uint32_t sps_length;
+    uint8_t pps[MP4_MUX_PARAM_MAX];
+    uint32_t pps_length;
+    uint8_t init[MP4_MUX_INIT_MAX]; // the init segment, once there was an SPS/PPS
+    uint32_t init_length;
+    int width, height;
+    int started; // an IDR has gone out, pictures before it are dropped
+    uint32_t sequence;
+    int64_t first_pts;
+    uint64_t last_time;
+    uint32_t last_duration;
+    uint32_t dropped; // pictures
+} MP4_MUX_T;
+
+int mp4_mux_init(MP4_MUX_T *mux, float fps, MP4_MUX_EMIT_T emit, void *arg);
+void mp4_mux_destroy(MP4_MUX_T *mux);
+
+/* One encoder buffer; frame_end on the last one of a picture, pts in microseconds. */
+void mp4_mux_push(MP4_MUX_T *mux, const uint8_t *data, size_t length, int frame_end, int64_t pts);
+
+/* Emits the last picture, with the duration of the one before. */
+void mp4_mux_flush(MP4_MUX_T *mux);
+
+#endif /* MP4_MUX_H */
@@ -20,6 +20,7 @@
 #include "interface/mmal/mmal.h"
 #include "interface/mmal/util/mmal_default_components.h"
 #include "interface/mmal/util/mmal_connection.h"
+#include "interface/mmal/util/mmal_util.h"
 
 #include "vgfont.h"
 
@@ -34,8 +35,12 @@ typedef struct {
     int preview_height;
     int opencv_width;
     int opencv_height;
+    int video_stride;
     float video_fps;
+    MMAL_PORT_T *camera_video_port;
     MMAL_POOL_T *camera_video_port_pool;
+    MMAL_BUFFER_HEADER_T *pending_buffer;
+    VCOS_MUTEX_T pending_lock;
     CvHaarClassifierCascade *cascade;
     CvMemStorage* storage;
     IplImage* image;
@@ -43,14 +48,37 @@ typedef struct {
     VCOS_SEMAPHORE_T complete_semaphore;
 } PORT_USERDATA;
 
+/*
+ * Hand a camera buffer back to its pool and queue a fresh one on the video
+ * port. Called from the MMAL callback for frames that were never looked at and
+ * from the detection loop once it is done reading a frame.
+ */
+static void return_video_buffer(PORT_USERDATA *userdata, MMAL_BUFFER_HEADER_T *buffer) {
+    MMAL_PORT_T *port = userdata->camera_video_port;
+    MMAL_BUFFER_HEADER_T *new_buffer;
+
+    mmal_buffer_header_release(buffer);
+    // and send one back to the port (if still open)
+    if (port->is_enabled) {
+        MMAL_STATUS_T status;
+
+        new_buffer = mmal_queue_get(userdata->camera_video_port_pool->queue);
+
+        if (new_buffer)
+            status = mmal_port_send_buffer(port, new_buffer);
+
+        if (!new_buffer || status != MMAL_SUCCESS)
+            printf("Unable to return a buffer to the video port\n");
+    }
+}
+
 static void video_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer) {
     static int frame_count = 0;
     static int frame_post_count = 0;
     static struct timespec t1;
     struct timespec t2;
-    MMAL_BUFFER_HEADER_T *new_buffer;
+    MMAL_BUFFER_HEADER_T *stale_buffer;
     PORT_USERDATA * userdata = (PORT_USERDATA *) port->userdata;
-    MMAL_POOL_T *pool = userdata->camera_video_port_pool;
 
     if (frame_count == 0) {
         clock_gettime(CLOCK_MONOTONIC, &t1);
@@ -61,13 +89,17 @@ static void video_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffe
 
 
 
-    //img = cvLoadImage("test.jpg",CV_LOAD_IMAGE_COLOR);
-    mmal_buffer_header_mem_lock(buffer);
-    memcpy(userdata->image->imageData, buffer->data, userdata->video_width * userdata->video_height);
-    mmal_buffer_header_mem_unlock(buffer);
-    //printf("img = %d w=%d, h=%d\n", img, img->width, img->height);
+    // Keep the buffer instead of copying it out; the detection loop reads the
+    // Y plane in place and returns the buffer when it is done with it.
+    vcos_mutex_lock(&userdata->pending_lock);
+    stale_buffer = userdata->pending_buffer;
+    userdata->pending_buffer = buffer;
+    vcos_mutex_unlock(&userdata->pending_lock);
 
-    if (vcos_semaphore_trywait(&(userdata->complete_semaphore)) != VCOS_SUCCESS) {
+    if (stale_buffer) {
+        // detection loop never picked the previous frame up, drop it
+        return_video_buffer(userdata, stale_buffer);
+    } else {
         vcos_semaphore_post(&(userdata->complete_semaphore));
         frame_post_count++;
     }
@@ -86,20 +118,6 @@ static void video_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffe
         userdata->video_fps = fps;
         printf("  Frame = %d, Frame Post %d, Framerate = %.0f fps \n", frame_count, frame_post_count, fps);
     }
-
-    mmal_buffer_header_release(buffer);
-    // and send one back to the port (if still open)
-    if (port->is_enabled) {
-        MMAL_STATUS_T status;
-
-        new_buffer = mmal_queue_get(pool->queue);
-
-        if (new_buffer)
-            status = mmal_port_send_buffer(port, new_buffer);
-
-        if (!new_buffer || status != MMAL_SUCCESS)
-            printf("Unable to return a buffer to the video port\n");
-    }
 }
 
 int main(int argc, char** argv) {
@@ -137,7 +155,8 @@ int main(int argc, char** argv) {
     /* setup opencv */
     userdata.cascade = (CvHaarClassifierCascade*) cvLoad("/usr/share/opencv/haarcascades/haarcascade_frontalface_alt.xml", NULL, NULL, NULL);
     userdata.storage = cvCreateMemStorage(0);
-    userdata.image = cvCreateImage(cvSize(userdata.video_width, userdata.video_height), IPL_DEPTH_8U, 1);
+    // header only, imageData points into the camera buffer being processed
+    userdata.image = cvCreateImageHeader(cvSize(userdata.video_width, userdata.video_height), IPL_DEPTH_8U, 1);
     userdata.image2 = cvCreateImage(cvSize(userdata.opencv_width, userdata.opencv_height), IPL_DEPTH_8U, 1);
     if (!userdata.cascade) {
         printf("Error: unable to load harrcascade\n");
@@ -178,7 +197,7 @@ int main(int argc, char** argv) {
     format->encoding_variant = MMAL_ENCODING_I420;
 
     format->es->video.width = userdata.video_width;
-    format->es->video.height = userdata.video_width;
+    format->es->video.height = userdata.video_height;
     format->es->video.crop.x = 0;
     format->es->video.crop.y = 0;
     format->es->video.crop.width = userdata.video_width;
@@ -187,7 +206,8 @@ int main(int argc, char** argv) {
     format->es->video.frame_rate.den = 1;
 
     camera_video_port->buffer_size = userdata.preview_width * userdata.preview_height * 12 / 8;
-    camera_video_port->buffer_num = 1;
+    // one frame in the detection loop, one pending, one being filled
+    camera_video_port->buffer_num = 3;
     printf("  Camera video buffer_size = %d\n", camera_video_port->buffer_size);
 
     status = mmal_port_format_commit(camera_video_port);
@@ -196,6 +216,7 @@ int main(int argc, char** argv) {
         printf("Error: unable to commit camera video port format (%u)\n", status);
         return -1;
     }
+    userdata.video_stride = mmal_encoding_width_to_stride(MMAL_ENCODING_I420, camera_video_port->format->es->video.width);
 
     format = camera_preview_port->format;
 
@@ -219,6 +240,10 @@ int main(int argc, char** argv) {
     // crate pool form camera video port
     camera_video_port_pool = (MMAL_POOL_T *) mmal_port_pool_create(camera_video_port, camera_video_port->buffer_num, camera_video_port->buffer_size);
     userdata.camera_video_port_pool = camera_video_port_pool;
+    userdata.camera_video_port = camera_video_port;
+    userdata.pending_buffer = NULL;
+    vcos_mutex_create(&userdata.pending_lock, "mmal_opencv_demo-lock");
+    vcos_semaphore_create(&userdata.complete_semaphore, "mmal_opencv_demo-sem", 0);
     camera_video_port->userdata = (struct MMAL_PORT_USERDATA_T *) &userdata;
 
     status = mmal_port_enable(camera_video_port, video_buffer_callback);
@@ -289,7 +314,6 @@ int main(int argc, char** argv) {
         printf("%s: Failed to start capture\n", __func__);
     }
 
-    vcos_semaphore_create(&userdata.complete_semaphore, "mmal_opencv_demo-sem", 0);
     int opencv_frames = 0;
     struct timespec t1;
     struct timespec t2;
@@ -329,7 +353,17 @@ int main(int argc, char** argv) {
 
 
             if (1) {
+                MMAL_BUFFER_HEADER_T *frame_buffer;
+                vcos_mutex_lock(&userdata.pending_lock);
+                frame_buffer = userdata.pending_buffer;
+                userdata.pending_buffer = NULL;
+                vcos_mutex_unlock(&userdata.pending_lock);
+                // read-only view over the Y plane, the buffer goes back to the camera right after
+                mmal_buffer_header_mem_lock(frame_buffer);
+                cvSetData(userdata.image, frame_buffer->data, userdata.video_stride);
                 cvResize(userdata.image, userdata.image2, CV_INTER_LINEAR);
+                mmal_buffer_header_mem_unlock(frame_buffer);
+                return_video_buffer(&userdata, frame_buffer);
                 CvSeq* objects = cvHaarDetectObjects(userdata.image2, userdata.cascade, userdata.storage, 1.4, 3, 0, cvSize(100, 100), cvSize(150, 150));
                 CvRect* r;
                 // Loop through objects and draw boxes
@@ -0,0 +1,281 @@
+/*
+ * File:   overlay.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "overlay.h"
+
+void overlay_config_default(OVERLAY_CONFIG_T *config) {
+    memset(config, 0, sizeof (OVERLAY_CONFIG_T));
+    config->width = 320;
+    config->height = 180;
+    config->text_width = 500;
+    config->text_height = 200;
+    config->font = "monospace";
+    config->text_size = 25;
+    config->display_width = 1280;
+    config->display_height = 720;
+}
+
+OVERLAY_T *overlay_open(const char *spec, const OVERLAY_CONFIG_T *config) {
+    if (strcmp(spec, "soft") == 0) {
+        return overlay_soft_create(config);
+    }
+    printf("Error: overlay: unknown backend %s\n", spec);
+    return NULL;
+}
+
+void overlay_destroy(OVERLAY_T *overlay) {
+    if (overlay) {
+        glyph_atlas_destroy(&overlay->atlas);
+        overlay->ops->destroy(overlay);
+    }
+}
+
+int overlay_setup(OVERLAY_T *overlay, const OVERLAY_OPS_T *ops, const char *name, const OVERLAY_CONFIG_T *config) {
+    overlay->ops = ops;
+    overlay->name = name;
+    overlay->config = *config;
+    overlay_scene_clear(&overlay->shown);
+    overlay->drawn = 0;
+    memset(&overlay->stats, 0, sizeof (OVERLAY_STATS_T));
+    // the only text rasterisation, everything after is blits from the atlas
+    if (glyph_atlas_init(&overlay->atlas, config->font, config->text_size) != 0) {
+        return -1;
+    }
+    glyph_text_init(&overlay->text, &overlay->atlas);
+    return 0;
+}
+
+void overlay_scene_clear(OVERLAY_SCENE_T *scene) {
+    memset(scene, 0, sizeof (OVERLAY_SCENE_T));
+}
+
+void overlay_scene_box(OVERLAY_SCENE_T *scene, int x, int y, int width, int height, uint32_t rgba) {
+    OVERLAY_RECT_T *box;
+
+    if (scene->box_count == OVERLAY_MAX_BOXES) {
+        return;
+    }
+    box = &scene->box[scene->box_count];
+    box->x = x;
+    box->y = y;
+    box->width = width;
+    box->height = height;
+    scene->color[scene->box_count++] = rgba;
+}
+
+void overlay_scene_text(OVERLAY_SCENE_T *scene, const char *text, uint32_t rgba) {
+    strncpy(scene->text, text, OVERLAY_TEXT_SIZE - 1);
+    scene->text[OVERLAY_TEXT_SIZE - 1] = 0;
+    scene->text_color = rgba;
+}
+
+static void layer_rect(const OVERLAY_T *overlay, int layer, OVERLAY_RECT_T *rect) {
+    rect->x = 0;
+    rect->y = 0;
+    rect->width = layer == OVERLAY_LAYER_BOXES ? overlay->config.width : overlay->config.text_width;
+    rect->height = layer == OVERLAY_LAYER_BOXES ? overlay->config.height : overlay->config.text_height;
+}
+
+/* a and b in out, 0 when they do not meet. */
+static int intersect(const OVERLAY_RECT_T *a, const OVERLAY_RECT_T *b, OVERLAY_RECT_T *out) {
+    int x0 = a->x > b->x ? a->x : b->x;
+    int y0 = a->y > b->y ? a->y : b->y;
+    int x1 = a->x + a->width < b->x + b->width ? a->x + a->width : b->x + b->width;
+    int y1 = a->y + a->height < b->y + b->height ? a->y + a->height : b->y + b->height;
+
+    if (x1 <= x0 || y1 <= y0) {
+        return 0;
+    }
+    out->x = x0;
+    out->y = y0;
+    out->width = x1 - x0;
+    out->height = y1 - y0;
+    return 1;
+}
+
+static void grow(OVERLAY_RECT_T *bounds, const OVERLAY_RECT_T *rect) {
+    int x1, y1;
+
+    if (bounds->width == 0) {
+        *bounds = *rect;
+        return;
+    }
+    x1 = bounds->x + bounds->width > rect->x + rect->width ? bounds->x + bounds->width : rect->x + rect->width;
+    y1 = bounds->y + bounds->height > rect->y + rect->height ? bounds->y + bounds->height : rect->y + rect->height;
+    bounds->x = bounds->x < rect->x ? bounds->x : rect->x;
+    bounds->y = bounds->y < rect->y ? bounds->y : rect->y;
+    bounds->width = x1 - bounds->x;
+    bounds->height = y1 - bounds->y;
+}
+
+/* The one pixel outline of a box as up to four rectangles, unclipped. */
+static int box_edges(const OVERLAY_RECT_T *box, OVERLAY_RECT_T *edge) {
+    int n = 0;
+
+    if (box->width <= 0 || box->height <= 0) {
+        return 0;
+    }
+    edge[n].x = box->x;
+    edge[n].y = box->y;
+    edge[n].width = box->width;
+    edge[n++].height = 1;
+    if (box->height > 1) {
+        edge[n].x = box->x;
+        edge[n].y = box->y + box->height - 1;
+        edge[n].width = box->width;
+        edge[n++].height = 1;
+    }
+    if (box->height > 2) {
+        edge[n].x = box->x;
+        edge[n].y = box->y + 1;
+        edge[n].width = 1;
+        edge[n++].height = box->height - 2;
+        if (box->width > 1) {
+            edge[n].x = box->x + box->width - 1;
+            edge[n].y = box->y + 1;
+            edge[n].width = 1;
+            edge[n++].height = box->height - 2;
+        }
+    }
+    return n;
+}
+
+static void fill(OVERLAY_T *overlay, int layer, const OVERLAY_RECT_T *rect, uint32_t rgba) {
+    OVERLAY_RECT_T whole, clipped;
+
+    layer_rect(overlay, layer, &whole);
+    if (!intersect(rect, &whole, &clipped)) {
+        return;
+    }
+    overlay->ops->fill(overlay, layer, &clipped, rgba);
+    overlay->stats.fills++;
+    overlay->stats.pixels += (uint64_t) clipped.width * clipped.height;
+}
+
+/* The parts of every box outline of scene inside area, which has been cleared. */
+static void draw_boxes(OVERLAY_T *overlay, const OVERLAY_SCENE_T *scene, const OVERLAY_RECT_T *area) {
+    OVERLAY_RECT_T edge[4], part;
+    int i, j, n;
+
+    for (i = 0; i < scene->box_count; i++) {
+        n = box_edges(&scene->box[i], edge);
+        for (j = 0; j < n; j++) {
+            if (intersect(&edge[j], area, &part)) {
+                fill(overlay, OVERLAY_LAYER_BOXES, &part, scene->color[i]);
+            }
+        }
+    }
+}
+
+/* The characters that changed; their span in dirty, 0 when nothing did. */
+static int draw_text(OVERLAY_T *overlay, const OVERLAY_SCENE_T *scene, OVERLAY_RECT_T *dirty) {
+    uint32_t *pixels;
+    int stride;
+
+    pixels = overlay->ops->pixels(overlay, OVERLAY_LAYER_TEXT, &stride);
+    overlay->stats.text_pixels += glyph_text_draw(&overlay->text, pixels, stride,
+            overlay->config.text_width, overlay->config.text_height, 0, 0, scene->text, scene->text_color, 0);
+    overlay->stats.texts++;
+    if (overlay->text.dirty_width == 0) {
+        return 0;
+    }
+    dirty->x = overlay->text.dirty_x;
+    dirty->y = 0;
+    dirty->width = overlay->text.dirty_width;
+    dirty->height = overlay->atlas.cell_height;
+    return 1;
+}
+
+static void present(OVERLAY_T *overlay, int layer, const OVERLAY_RECT_T *dirty) {
+    overlay->ops->present(overlay, layer, dirty);
+    overlay->stats.presents++;
+}
+
+static int same_box(const OVERLAY_SCENE_T *a, const OVERLAY_SCENE_T *b, int i) {
+    return i < a->box_count && i < b->box_count
+            && a->color[i] == b->color[i]
+            && memcmp(&a->box[i], &b->box[i], sizeof (OVERLAY_RECT_T)) == 0;
+}
+
+void overlay_redraw(OVERLAY_T *overlay, const OVERLAY_SCENE_T *scene) {
+    OVERLAY_RECT_T whole, text, dirty;
+
+    layer_rect(overlay, OVERLAY_LAYER_BOXES, &whole);
+    fill(overlay, OVERLAY_LAYER_BOXES, &whole, 0);
+    draw_boxes(overlay, scene, &whole);
+    layer_rect(overlay, OVERLAY_LAYER_TEXT, &text);
+    fill(overlay, OVERLAY_LAYER_TEXT, &text, 0);
+    glyph_text_init(&overlay->text, &overlay->atlas);
+    draw_text(overlay, scene, &dirty);
+    present(overlay, OVERLAY_LAYER_BOXES, &whole);
+    present(overlay, OVERLAY_LAYER_TEXT, &text);
+    overlay->shown = *scene;
+    overlay->drawn = 1;
+}
+
+int overlay_update(OVERLAY_T *overlay, const OVERLAY_SCENE_T *scene) {
+    OVERLAY_RECT_T dirty[OVERLAY_MAX_BOXES * 8];
+    OVERLAY_RECT_T whole, bounds, text;
+    const OVERLAY_SCENE_T *shown = &overlay->shown;
+    int count = shown->box_count > scene->box_count ? shown->box_count : scene->box_count;
+    int n = 0, kept = 0, presented = 0;
+    int i;
+
+    overlay->stats.frames++;
+    if (!overlay->drawn) {
+        overlay_redraw(overlay, scene);
+        return OVERLAY_LAYERS;
+    }
+    // where the outlines were and where they go, for every box that is not where it was
+    for (i = 0; i < count; i++) {
+        if (same_box(shown, scene, i)) {
+            continue;
+        }
+        if (i < shown->box_count) {
+            n += box_edges(&shown->box[i], &dirty[n]);
+        }
+        if (i < scene->box_count) {
+            n += box_edges(&scene->box[i], &dirty[n]);
+        }
+    }
+    layer_rect(overlay, OVERLAY_LAYER_BOXES, &whole);
+    memset(&bounds, 0, sizeof (bounds));
+    for (i = 0; i < n; i++) {
+        if (intersect(&dirty[i], &whole, &dirty[kept])) {
+            fill(overlay, OVERLAY_LAYER_BOXES, &dirty[kept], 0);
+            draw_boxes(overlay, scene, &dirty[kept]);
+            grow(&bounds, &dirty[kept]);
+            kept++;
+        }
+    }
+    if (kept) {
+        present(overlay, OVERLAY_LAYER_BOXES, &bounds);
+        presented++;
+    }
+    if ((strcmp(shown->text, scene->text) != 0 || shown->text_color != scene->text_color)
+            && draw_text(overlay, scene, &text)) {
+        present(overlay, OVERLAY_LAYER_TEXT, &text);
+        presented++;
+    }
+    if (!presented) {
+        overlay->stats.unchanged++;
+    }
+    overlay->shown = *scene;
+    return presented;
+}
+
+void overlay_print_stats(OVERLAY_T *overlay) {
+    OVERLAY_STATS_T *s = &overlay->stats;
+
+    printf("overlay: %u frames, %u unchanged, %u presents, %.1f fills and %.0f pixels per frame, %u text draws of %.0f pixels\n",
+            s->frames, s->unchanged, s->presents,
+            s->frames ? (double) s->fills / s->frames : 0.0, s->frames ? (double) s->pixels / s->frames : 0.0,
+            s->texts, s->texts ? (double) s->text_pixels / s->texts : 0.0);
+}
@@ -0,0 +1,125 @@
+/*
+ * File:   overlay.h
+ * Author: Hassan
+ *
+ * Retained-mode overlay for the face and padding boxes and the status text.
+ * The caller describes the whole scene every frame; overlay_update diffs it
+ * against the scene on screen and only repaints the edges of boxes that
+ * moved, appeared or went away (clearing each dirty rectangle and redrawing
+ * whatever current box edges cross it), recomposes only the characters of
+ * the text that changed, from a glyph_atlas built at open, and presents
+ * only the layers that changed. Boxes are one pixel outlines, the inside
+ * stays transparent.
+ *
+ *   dispmanx  on the display (overlay_dispmanx.c)
+ *   soft      RGBA32 buffers in memory, for tests and overlay_bench
+ *
+ * Two layers: OVERLAY_LAYER_BOXES is width x height, the detector's frame,
+ * scaled to the display; OVERLAY_LAYER_TEXT is text_width x text_height.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef OVERLAY_H
+#define OVERLAY_H
+
+#include <stdint.h>
+
+#include "glyph_atlas.h"
+
+#define OVERLAY_MAX_BOXES 4
+#define OVERLAY_TEXT_SIZE 128
+#define OVERLAY_LAYERS 2
+#define OVERLAY_LAYER_BOXES 0
+#define OVERLAY_LAYER_TEXT 1
+
+/* The packing of vgfont's GRAPHICS_RGBA32: RGBA bytes in memory order on the Pi. */
+#define OVERLAY_RGBA(r, g, b, a) (((uint32_t) (a) << 24) | ((uint32_t) (b) << 16) | ((uint32_t) (g) << 8) | (uint32_t) (r))
+
+typedef struct {
+    int x;
+    int y;
+    int width;
+    int height;
+} OVERLAY_RECT_T;
+
+typedef struct {
+    OVERLAY_RECT_T box[OVERLAY_MAX_BOXES];
+    uint32_t color[OVERLAY_MAX_BOXES];
+    int box_count;
+    char text[OVERLAY_TEXT_SIZE];
+    uint32_t text_color;
+} OVERLAY_SCENE_T;
+
+typedef struct {
+    int width; // boxes layer
+    int height;
+    int text_width;
+    int text_height;
+    const char *font; // cairo face of the text
+    int text_size; // pixels
+    int display_width; // dispmanx: where the layers go
+    int display_height;
+} OVERLAY_CONFIG_T;
+
+typedef struct {
+    uint32_t frames;
+    uint32_t unchanged; // frames that touched nothing
+    uint32_t presents;
+    uint32_t fills;
+    uint64_t pixels; // filled
+    uint32_t texts; // text draws
+    uint64_t text_pixels; // recomposed by them
+} OVERLAY_STATS_T;
+
+typedef struct OVERLAY_T OVERLAY_T;
+
+typedef struct {
+    void (*fill)(OVERLAY_T *overlay, int layer, const OVERLAY_RECT_T *rect, uint32_t rgba);
+    /* CPU copy of the text layer, RGBA32 rows of stride pixels */
+    uint32_t *(*pixels)(OVERLAY_T *overlay, int layer, int *stride);
+    /* dirty bounds what changed since the last present of the layer */
+    void (*present)(OVERLAY_T *overlay, int layer, const OVERLAY_RECT_T *dirty);
+    void (*destroy)(OVERLAY_T *overlay);
+} OVERLAY_OPS_T;
+
+struct OVERLAY_T {
+    const OVERLAY_OPS_T *ops;
+    const char *name;
+    OVERLAY_CONFIG_T config;
+    OVERLAY_SCENE_T shown; // what the layers hold
+    int drawn; // 0 until the first update
+    GLYPH_ATLAS_T atlas;
+    GLYPH_TEXT_T text; // what the text layer holds
+    OVERLAY_STATS_T stats;
+};
+
+void overlay_config_default(OVERLAY_CONFIG_T *config);
+
+/*
+ * "soft"; the display is not handled here so that this layer builds without
+ * the Pi userland, see overlay_dispmanx_create().
+ */
+OVERLAY_T *overlay_open(const char *spec, const OVERLAY_CONFIG_T *config);
+OVERLAY_T *overlay_soft_create(const OVERLAY_CONFIG_T *config);
+void overlay_destroy(OVERLAY_T *overlay);
+
+/* Backends call this first, and overlay_destroy once it has succeeded. */
+int overlay_setup(OVERLAY_T *overlay, const OVERLAY_OPS_T *ops, const char *name, const OVERLAY_CONFIG_T *config);
+
+void overlay_scene_clear(OVERLAY_SCENE_T *scene);
+void overlay_scene_box(OVERLAY_SCENE_T *scene, int x, int y, int width, int height, uint32_t rgba);
+void overlay_scene_text(OVERLAY_SCENE_T *scene, const char *text, uint32_t rgba);
+
+/* Brings the layers to scene touching only what changed; the layers presented. */
+int overlay_update(OVERLAY_T *overlay, const OVERLAY_SCENE_T *scene);
+
+/* Clears and draws everything and presents both layers, the old per-frame cost. */
+void overlay_redraw(OVERLAY_T *overlay, const OVERLAY_SCENE_T *scene);
+
+/* soft: a layer's pixels, rows of layer width. */
+const uint32_t *overlay_soft_pixels(OVERLAY_T *overlay, int layer);
+
+void overlay_print_stats(OVERLAY_T *overlay);
+
+#endif /* OVERLAY_H */
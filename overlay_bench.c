@@ -0,0 +1,161 @@
+/*
+ * File:   overlay_bench.c
+ * Author: Hassan
+ *
+ * Times the retained overlay against redrawing every frame, on the soft
+ * backend. A made-up drive (the face box creeping and jittering, going
+ * away now and then, the padding box recalibrated every few seconds, the
+ * FPS text changing twice a second) is rendered both ways, the redraw
+ * composing every glyph of the text again; after every frame the two sets
+ * of layers must be identical, pixel for pixel.
+ *
+ *   overlay_bench [-n frames] [-s WxH]
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "overlay.h"
+
+#define BOX_COLOR OVERLAY_RGBA(0xff, 0, 0, 0x88)
+#define TEXT_COLOR OVERLAY_RGBA(0x00, 0xff, 0x00, 0xff)
+
+typedef struct {
+    uint32_t seed;
+    int face_x, face_y, face_w, face_h;
+    int face_found;
+    int padding_x, padding_y, padding_w, padding_h;
+    int calibrated;
+} DRIVE_T;
+
+static double now_us(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1000000.0 + t.tv_nsec / 1000.0;
+}
+
+static int next_random(DRIVE_T *drive, int range) {
+    drive->seed = drive->seed * 1103515245u + 12345u;
+    return (int) ((drive->seed >> 16) % (uint32_t) range);
+}
+
+/* One frame of the drive, as SAM_demo would describe it. */
+static void drive_scene(DRIVE_T *drive, int frame, int width, int height, OVERLAY_SCENE_T *scene) {
+    char text[OVERLAY_TEXT_SIZE];
+
+    (void) height; // the box is sized from the width alone
+    if (next_random(drive, 100) < 2) {
+        drive->face_found = !drive->face_found;
+    }
+    // the detector box holds still for a few frames, then moves a little
+    if (frame % 3 == 0) {
+        drive->face_x += next_random(drive, 5) - 2;
+        drive->face_y += next_random(drive, 5) - 2;
+        drive->face_w = width / 4 + next_random(drive, 3);
+        drive->face_h = drive->face_w;
+    }
+    if (frame % 150 == 20) {
+        drive->padding_x = drive->face_x - drive->face_w * 3 / 20;
+        drive->padding_y = drive->face_y - drive->face_h / 20;
+        drive->padding_w = drive->face_w * 13 / 10;
+        drive->padding_h = drive->face_h * 5 / 4;
+        drive->calibrated = 1;
+    }
+    scene->box_count = 0;
+    if (drive->face_found) {
+        if (drive->calibrated) {
+            overlay_scene_box(scene, drive->padding_x, drive->padding_y, drive->padding_w, drive->padding_h, BOX_COLOR);
+        }
+        overlay_scene_box(scene, drive->face_x, drive->face_y, drive->face_w, drive->face_h, BOX_COLOR);
+    }
+    if (frame % 15 == 0) {
+        snprintf(text, sizeof (text), "Video = %.2f FPS, OpenCV = %.2f FPS", 30.0, 8.0 + next_random(drive, 300) / 100.0);
+        overlay_scene_text(scene, text, TEXT_COLOR);
+    }
+}
+
+static int same_layers(OVERLAY_T *a, OVERLAY_T *b, const OVERLAY_CONFIG_T *config) {
+    return memcmp(overlay_soft_pixels(a, OVERLAY_LAYER_BOXES), overlay_soft_pixels(b, OVERLAY_LAYER_BOXES),
+            sizeof (uint32_t) * config->width * config->height) == 0
+            && memcmp(overlay_soft_pixels(a, OVERLAY_LAYER_TEXT), overlay_soft_pixels(b, OVERLAY_LAYER_TEXT),
+            sizeof (uint32_t) * config->text_width * config->text_height) == 0;
+}
+
+static void print_result(const char *name, OVERLAY_T *overlay, double us, int frames) {
+    OVERLAY_STATS_T *s = &overlay->stats;
+
+    printf("%-8s %8.2f us/frame %10.0f pixels/frame %6.2f presents/frame %6.2f fills/frame %8.0f pixels/text draw\n",
+            name, us / frames, (double) s->pixels / frames, (double) s->presents / frames, (double) s->fills / frames,
+            s->texts ? (double) s->text_pixels / s->texts : 0.0);
+}
+
+int main(int argc, char** argv) {
+    OVERLAY_CONFIG_T config;
+    OVERLAY_SCENE_T scene;
+    OVERLAY_T *retained, *redraw;
+    DRIVE_T drive;
+    double t0, retained_us = 0, redraw_us = 0;
+    int frames = 3000, mismatches = 0;
+    int opt, i;
+
+    overlay_config_default(&config);
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                frames = atoi(optarg);
+                break;
+            case 's':
+                if (sscanf(optarg, "%dx%d", &config.width, &config.height) != 2) {
+                    printf("Error: -s takes WxH\n");
+                    return 1;
+                }
+                break;
+            default:
+                printf("usage: overlay_bench [-n frames] [-s WxH]\n");
+                return 1;
+        }
+    }
+    retained = overlay_open("soft", &config);
+    redraw = overlay_open("soft", &config);
+    if (!retained || !redraw || frames <= 0) {
+        return 1;
+    }
+    memset(&drive, 0, sizeof (drive));
+    drive.seed = 1;
+    drive.face_found = 1;
+    drive.face_x = config.width * 3 / 8;
+    drive.face_y = config.height / 4;
+    overlay_scene_clear(&scene);
+    for (i = 0; i < frames; i++) {
+        drive_scene(&drive, i, config.width, config.height, &scene);
+        t0 = now_us();
+        overlay_update(retained, &scene);
+        retained_us += now_us() - t0;
+        t0 = now_us();
+        overlay_redraw(redraw, &scene);
+        redraw_us += now_us() - t0;
+        if (!same_layers(retained, redraw, &config)) {
+            if (mismatches == 0) {
+                printf("Error: layers differ from a full redraw at frame %d\n", i);
+            }
+            mismatches++;
+        }
+    }
+    printf("%d frames of %dx%d, %u unchanged\n", frames, config.width, config.height, retained->stats.unchanged);
+    print_result("retained", retained, retained_us, frames);
+    print_result("redraw", redraw, redraw_us, frames);
+    overlay_destroy(retained);
+    overlay_destroy(redraw);
+    if (mismatches) {
+        printf("FAIL: %d frames differ\n", mismatches);
+        return 1;
+    }
+    printf("PASS\n");
+    return 0;
+}
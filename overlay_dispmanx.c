@@ -0,0 +1,140 @@
+/*
+ * File:   overlay_dispmanx.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bcm_host.h"
+#include "vgfont.h"
+
+#include "overlay_dispmanx.h"
+
+#define TEXT_LAYER_Z 2
+
+typedef struct {
+    OVERLAY_T overlay;
+    GRAPHICS_RESOURCE_HANDLE boxes;
+    DISPMANX_DISPLAY_HANDLE_T display;
+    DISPMANX_RESOURCE_HANDLE_T text_resource;
+    DISPMANX_ELEMENT_HANDLE_T text_element;
+    uint32_t *text; // what the element shows, composed on the CPU
+    int text_stride; // pixels, rows 32 byte aligned for the resource copy
+} OVERLAY_DISPMANX_T;
+
+static void dispmanx_fill(OVERLAY_T *overlay, int layer, const OVERLAY_RECT_T *rect, uint32_t rgba) {
+    OVERLAY_DISPMANX_T *dev = (OVERLAY_DISPMANX_T *) overlay;
+    uint32_t *row;
+    int x, y;
+
+    if (layer == OVERLAY_LAYER_BOXES) {
+        graphics_resource_fill(dev->boxes, rect->x, rect->y, rect->width, rect->height, rgba);
+        return;
+    }
+    row = dev->text + rect->y * dev->text_stride + rect->x;
+    for (y = 0; y < rect->height; y++) {
+        for (x = 0; x < rect->width; x++) {
+            row[x] = rgba;
+        }
+        row += dev->text_stride;
+    }
+}
+
+static uint32_t *dispmanx_pixels(OVERLAY_T *overlay, int layer, int *stride) {
+    OVERLAY_DISPMANX_T *dev = (OVERLAY_DISPMANX_T *) overlay;
+
+    *stride = dev->text_stride;
+    return layer == OVERLAY_LAYER_TEXT ? dev->text : NULL;
+}
+
+static void dispmanx_present(OVERLAY_T *overlay, int layer, const OVERLAY_RECT_T *dirty) {
+    OVERLAY_DISPMANX_T *dev = (OVERLAY_DISPMANX_T *) overlay;
+    const OVERLAY_CONFIG_T *c = &overlay->config;
+    DISPMANX_UPDATE_HANDLE_T update;
+    VC_RECT_T rows;
+
+    if (layer == OVERLAY_LAYER_BOXES) {
+        graphics_display_resource(dev->boxes, 0, 1, 0, 0, c->display_width, c->display_height, VC_DISPMAN_ROT0, 1);
+        return;
+    }
+    // only the rows under the changed characters cross to the GPU; x is not used by write_data
+    vc_dispmanx_rect_set(&rows, 0, dirty->y, c->text_width, dirty->height);
+    vc_dispmanx_resource_write_data(dev->text_resource, VC_IMAGE_RGBA32, dev->text_stride * 4, dev->text, &rows);
+    update = vc_dispmanx_update_start(0);
+    vc_dispmanx_element_modified(update, dev->text_element, &rows);
+    // not the _sync variant, the output stage must not wait for vsync
+    vc_dispmanx_update_submit(update, NULL, NULL);
+}
+
+static void dispmanx_destroy(OVERLAY_T *overlay) {
+    OVERLAY_DISPMANX_T *dev = (OVERLAY_DISPMANX_T *) overlay;
+    DISPMANX_UPDATE_HANDLE_T update;
+
+    if (dev->text_element) {
+        update = vc_dispmanx_update_start(0);
+        vc_dispmanx_element_remove(update, dev->text_element);
+        vc_dispmanx_update_submit_sync(update);
+    }
+    if (dev->text_resource) {
+        vc_dispmanx_resource_delete(dev->text_resource);
+    }
+    if (dev->display) {
+        vc_dispmanx_display_close(dev->display);
+    }
+    // vgfont keeps its windows until the process exits
+    free(dev->text);
+    free(dev);
+}
+
+static const OVERLAY_OPS_T dispmanx_ops = {
+    dispmanx_fill,
+    dispmanx_pixels,
+    dispmanx_present,
+    dispmanx_destroy
+};
+
+/* The text layer: an RGBA32 resource on its own element, fed from dev->text. */
+static int create_text_element(OVERLAY_DISPMANX_T *dev, const OVERLAY_CONFIG_T *config) {
+    VC_DISPMANX_ALPHA_T alpha = {DISPMANX_FLAGS_ALPHA_FROM_SOURCE, 255, 0};
+    DISPMANX_UPDATE_HANDLE_T update;
+    VC_RECT_T src, dst;
+    uint32_t image;
+
+    dev->text_stride = (config->text_width + 7) & ~7;
+    dev->text = (uint32_t *) calloc((size_t) dev->text_stride * config->text_height, sizeof (uint32_t));
+    dev->display = vc_dispmanx_display_open(0);
+    dev->text_resource = vc_dispmanx_resource_create(VC_IMAGE_RGBA32, config->text_width, config->text_height, &image);
+    if (!dev->text || !dev->display || !dev->text_resource) {
+        return -1;
+    }
+    vc_dispmanx_rect_set(&src, 0, 0, config->text_width << 16, config->text_height << 16);
+    vc_dispmanx_rect_set(&dst, 0, config->display_width / 16, config->text_width, config->text_height);
+    update = vc_dispmanx_update_start(0);
+    dev->text_element = vc_dispmanx_element_add(update, dev->display, TEXT_LAYER_Z, &dst, dev->text_resource, &src,
+            DISPMANX_PROTECTION_NONE, &alpha, NULL, DISPMANX_NO_ROTATE);
+    vc_dispmanx_update_submit_sync(update);
+    return dev->text_element ? 0 : -1;
+}
+
+OVERLAY_T *overlay_dispmanx_create(const OVERLAY_CONFIG_T *config) {
+    OVERLAY_DISPMANX_T *dev = (OVERLAY_DISPMANX_T *) calloc(1, sizeof (OVERLAY_DISPMANX_T));
+
+    if (!dev) {
+        return NULL;
+    }
+    if (overlay_setup(&dev->overlay, &dispmanx_ops, "dispmanx", config) != 0) {
+        free(dev);
+        return NULL;
+    }
+    if (gx_create_window(0, config->width, config->height, GRAPHICS_RESOURCE_RGBA32, &dev->boxes) != 0
+            || create_text_element(dev, config) != 0) {
+        printf("Error: overlay: unable to create the overlay layers\n");
+        overlay_destroy(&dev->overlay);
+        return NULL;
+    }
+    return &dev->overlay;
+}
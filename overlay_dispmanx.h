@@ -0,0 +1,24 @@
+/*
+ * File:   overlay_dispmanx.h
+ * Author: Hassan
+ *
+ * Overlay layers on the display. The boxes layer is a vgfont window at z 1
+ * scaled to the whole display; vgfont pushes a whole resource at a time,
+ * so there a present is one graphics_display_resource and what is saved is
+ * the fills and the presents of frames where no box moved. The text layer
+ * is a plain dispmanx element at z 2, a sixteenth of the display width
+ * down, composed on the CPU from the glyph atlas; a present copies only
+ * the rows under the characters that changed to its resource.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef OVERLAY_DISPMANX_H
+#define OVERLAY_DISPMANX_H
+
+#include "overlay.h"
+
+/* bcm_host_init() and gx_graphics_init() must have been called. */
+OVERLAY_T *overlay_dispmanx_create(const OVERLAY_CONFIG_T *config);
+
+#endif /* OVERLAY_DISPMANX_H */
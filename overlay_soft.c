@@ -0,0 +1,99 @@
+/*
+ * File:   overlay_soft.c
+ * Author: Hassan
+ *
+ * Overlay layers as RGBA32 buffers in memory, so the renderer can be
+ * checked and timed off the Pi.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "overlay.h"
+
+typedef struct {
+    OVERLAY_T overlay;
+    uint32_t *pixels[OVERLAY_LAYERS];
+    int width[OVERLAY_LAYERS];
+    int height[OVERLAY_LAYERS];
+} OVERLAY_SOFT_T;
+
+static void soft_fill(OVERLAY_T *overlay, int layer, const OVERLAY_RECT_T *rect, uint32_t rgba) {
+    OVERLAY_SOFT_T *soft = (OVERLAY_SOFT_T *) overlay;
+    uint32_t *row = soft->pixels[layer] + rect->y * soft->width[layer] + rect->x;
+    int x, y;
+
+    for (y = 0; y < rect->height; y++) {
+        for (x = 0; x < rect->width; x++) {
+            row[x] = rgba;
+        }
+        row += soft->width[layer];
+    }
+}
+
+static uint32_t *soft_pixels(OVERLAY_T *overlay, int layer, int *stride) {
+    OVERLAY_SOFT_T *soft = (OVERLAY_SOFT_T *) overlay;
+
+    *stride = soft->width[layer];
+    return soft->pixels[layer];
+}
+
+static void soft_present(OVERLAY_T *overlay, int layer, const OVERLAY_RECT_T *dirty) {
+    // nothing to push, the buffers are what is shown
+    (void) overlay;
+    (void) layer;
+    (void) dirty;
+}
+
+static void soft_destroy(OVERLAY_T *overlay) {
+    OVERLAY_SOFT_T *soft = (OVERLAY_SOFT_T *) overlay;
+    int i;
+
+    for (i = 0; i < OVERLAY_LAYERS; i++) {
+        free(soft->pixels[i]);
+    }
+    free(soft);
+}
+
+static const OVERLAY_OPS_T soft_ops = {
+    soft_fill,
+    soft_pixels,
+    soft_present,
+    soft_destroy
+};
+
+OVERLAY_T *overlay_soft_create(const OVERLAY_CONFIG_T *config) {
+    OVERLAY_SOFT_T *soft = (OVERLAY_SOFT_T *) calloc(1, sizeof (OVERLAY_SOFT_T));
+    int i;
+
+    if (!soft) {
+        return NULL;
+    }
+    if (overlay_setup(&soft->overlay, &soft_ops, "soft", config) != 0) {
+        free(soft);
+        return NULL;
+    }
+    soft->width[OVERLAY_LAYER_BOXES] = config->width;
+    soft->height[OVERLAY_LAYER_BOXES] = config->height;
+    soft->width[OVERLAY_LAYER_TEXT] = config->text_width;
+    soft->height[OVERLAY_LAYER_TEXT] = config->text_height;
+    for (i = 0; i < OVERLAY_LAYERS; i++) {
+        soft->pixels[i] = (uint32_t *) calloc((size_t) soft->width[i] * soft->height[i], sizeof (uint32_t));
+        if (!soft->pixels[i]) {
+            printf("Error: overlay: no memory for a %dx%d layer\n", soft->width[i], soft->height[i]);
+            overlay_destroy(&soft->overlay);
+            return NULL;
+        }
+    }
+    return &soft->overlay;
+}
+
+const uint32_t *overlay_soft_pixels(OVERLAY_T *overlay, int layer) {
+    if (strcmp(overlay->name, "soft") != 0 || layer < 0 || layer >= OVERLAY_LAYERS) {
+        return NULL;
+    }
+    return ((OVERLAY_SOFT_T *) overlay)->pixels[layer];
+}
@@ -0,0 +1,271 @@
+/*
+ * File:   overlay_spans.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define SPANS_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define SPANS_SSE2 1
+#endif
+
+#include "overlay_spans.h"
+
+/*
+ * Runs less than this many transparent pixels apart are joined. Alpha 0
+ * leaves a pixel exactly as it was, so a joined run blends the same, and
+ * the glyphs of a line become one run per row the kernel can stride over.
+ */
+#define SPAN_GAP 16
+
+/* Pixels per vector step. */
+#define BLEND_STEP 16
+
+#define ALPHA(p) ((p) >> 24)
+
+/* BT.601 studio range, what the camera's I420 is in. */
+static inline void rgb_to_yuv(uint32_t p, int *y, int *u, int *v) {
+    int r = (p >> 16) & 0xff;
+    int g = (p >> 8) & 0xff;
+    int b = p & 0xff;
+
+    *y = ((66 * r + 129 * g + 25 * b + 128) >> 8) + 16;
+    *u = ((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128;
+    *v = ((112 * r - 94 * g - 18 * b + 128) >> 8) + 128;
+}
+
+/* dst + (src - dst) * alpha / 255, rounded; every path computes exactly this. */
+static inline uint8_t mix(uint8_t dst, uint8_t src, uint8_t alpha) {
+    unsigned t = dst * (255u - alpha) + src * alpha + 128;
+
+    return (uint8_t) ((t + (t >> 8)) >> 8);
+}
+
+static void blend_row(uint8_t *dst, const uint8_t *src, const uint8_t *alpha, int length) {
+    int i = 0;
+
+#if SPANS_NEON
+    for (; i + BLEND_STEP <= length; i += BLEND_STEP) {
+        uint8x16_t d = vld1q_u8(dst + i);
+        uint8x16_t s = vld1q_u8(src + i);
+        uint8x16_t a = vld1q_u8(alpha + i);
+        uint8x16_t na = vmvnq_u8(a);
+        uint16x8_t lo = vmlal_u8(vmull_u8(vget_low_u8(d), vget_low_u8(na)), vget_low_u8(s), vget_low_u8(a));
+        uint16x8_t hi = vmlal_u8(vmull_u8(vget_high_u8(d), vget_high_u8(na)), vget_high_u8(s), vget_high_u8(a));
+
+        // (x + ((x + 128) >> 8) + 128) >> 8, the same division by 255 as mix
+        vst1q_u8(dst + i, vcombine_u8(vraddhn_u16(lo, vrshrq_n_u16(lo, 8)), vraddhn_u16(hi, vrshrq_n_u16(hi, 8))));
+    }
+#elif SPANS_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi8((char) 0xff);
+    const __m128i round = _mm_set1_epi16(128);
+
+    for (; i + BLEND_STEP <= length; i += BLEND_STEP) {
+        __m128i d = _mm_loadu_si128((const __m128i *) (dst + i));
+        __m128i s = _mm_loadu_si128((const __m128i *) (src + i));
+        __m128i a = _mm_loadu_si128((const __m128i *) (alpha + i));
+        __m128i na = _mm_xor_si128(a, ones);
+        __m128i lo, hi;
+
+        // the products sum to at most 255 * 255, the 16-bit lanes do not wrap
+        lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(na, zero)),
+                _mm_mullo_epi16(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(a, zero)));
+        hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(na, zero)),
+                _mm_mullo_epi16(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(a, zero)));
+        lo = _mm_add_epi16(lo, round);
+        hi = _mm_add_epi16(hi, round);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+        _mm_storeu_si128((__m128i *) (dst + i), _mm_packus_epi16(lo, hi));
+    }
+#endif
+    for (; i < length; i++) {
+        dst[i] = mix(dst[i], src[i], alpha[i]);
+    }
+}
+
+/* The 2x2 block at (bx, by) in chroma units; its alpha, 0 when none of it is lit. */
+static int chroma_block(const OVERLAY_SPANS_T *spans, const uint32_t *pixels, int stride, int bx, int by,
+        uint8_t *u, uint8_t *v) {
+    int sum_a = 0, sum_u = 0, sum_v = 0, count = 0;
+    int x, y, a, py, pu, pv;
+
+    for (y = by * 2; y < by * 2 + 2 && y < spans->height; y++) {
+        for (x = bx * 2; x < bx * 2 + 2 && x < spans->width; x++) {
+            a = ALPHA(pixels[(size_t) y * stride + x]);
+            count++;
+            if (!a) {
+                continue;
+            }
+            rgb_to_yuv(pixels[(size_t) y * stride + x], &py, &pu, &pv);
+            sum_a += a;
+            sum_u += pu * a;
+            sum_v += pv * a;
+        }
+    }
+    if (!sum_a) {
+        *u = *v = 0;
+        return 0;
+    }
+    // colour weighted by coverage, alpha averaged over the block
+    *u = (uint8_t) ((sum_u + sum_a / 2) / sum_a);
+    *v = (uint8_t) ((sum_v + sum_a / 2) / sum_a);
+    return (sum_a + count / 2) / count;
+}
+
+int overlay_spans_init(OVERLAY_SPANS_T *spans, int width, int height) {
+    int chroma_width = (width + 1) / 2;
+    int chroma_height = (height + 1) / 2;
+    size_t luma_pixels = (size_t) width * height;
+    size_t chroma_pixels = (size_t) chroma_width * chroma_height;
+
+    memset(spans, 0, sizeof (OVERLAY_SPANS_T));
+    if (width <= 0 || height <= 0 || width > 0xffff || height > 0xffff) {
+        fprintf(stderr, "Error: overlay spans: bad surface size %dx%d\n", width, height);
+        return -1;
+    }
+    spans->width = width;
+    spans->height = height;
+    // a run is at least one lit pixel and one gap, so at most half a row
+    spans->luma_span = (OVERLAY_SPAN_T *) malloc(sizeof (OVERLAY_SPAN_T) * height * ((width + 1) / 2));
+    spans->luma = (uint8_t *) malloc(luma_pixels);
+    spans->luma_alpha = (uint8_t *) malloc(luma_pixels);
+    spans->chroma_span = (OVERLAY_SPAN_T *) malloc(sizeof (OVERLAY_SPAN_T) * chroma_height * ((chroma_width + 1) / 2));
+    spans->u = (uint8_t *) malloc(chroma_pixels);
+    spans->v = (uint8_t *) malloc(chroma_pixels);
+    spans->chroma_alpha = (uint8_t *) malloc(chroma_pixels);
+    if (!spans->luma_span || !spans->luma || !spans->luma_alpha
+            || !spans->chroma_span || !spans->u || !spans->v || !spans->chroma_alpha) {
+        fprintf(stderr, "Error: overlay spans: no memory for a %dx%d surface\n", width, height);
+        overlay_spans_destroy(spans);
+        return -1;
+    }
+    return 0;
+}
+
+void overlay_spans_destroy(OVERLAY_SPANS_T *spans) {
+    free(spans->luma_span);
+    free(spans->luma);
+    free(spans->luma_alpha);
+    free(spans->chroma_span);
+    free(spans->u);
+    free(spans->v);
+    free(spans->chroma_alpha);
+    memset(spans, 0, sizeof (OVERLAY_SPANS_T));
+}
+
+int overlay_spans_compile(OVERLAY_SPANS_T *spans, const uint32_t *pixels, int stride) {
+    const uint32_t *row;
+    OVERLAY_SPAN_T *span;
+    uint8_t u, v;
+    uint32_t n = 0;
+    int chroma_width = (spans->width + 1) / 2;
+    int chroma_height = (spans->height + 1) / 2;
+    int x, y, i, start, end, py, pu, pv, a;
+
+    spans->luma_count = 0;
+    for (y = 0; y < spans->height; y++) {
+        row = pixels + (size_t) y * stride;
+        x = 0;
+        while (x < spans->width) {
+            if (!ALPHA(row[x])) {
+                x++;
+                continue;
+            }
+            // end is one past the last lit pixel, the run stops at a gap of SPAN_GAP
+            start = x;
+            end = x + 1;
+            for (x = start + 1; x < spans->width && x - end < SPAN_GAP; x++) {
+                if (ALPHA(row[x])) {
+                    end = x + 1;
+                }
+            }
+            span = &spans->luma_span[spans->luma_count++];
+            span->x = (uint16_t) start;
+            span->y = (uint16_t) y;
+            span->length = (uint16_t) (end - start);
+            span->offset = n;
+            for (i = start; i < end; i++) {
+                rgb_to_yuv(row[i], &py, &pu, &pv);
+                spans->luma[n] = (uint8_t) py;
+                spans->luma_alpha[n] = (uint8_t) ALPHA(row[i]);
+                n++;
+            }
+        }
+    }
+    spans->pixels = (int) n;
+
+    n = 0;
+    spans->chroma_count = 0;
+    for (y = 0; y < chroma_height; y++) {
+        span = NULL;
+        end = 0;
+        for (x = 0; x < chroma_width; x++) {
+            a = chroma_block(spans, pixels, stride, x, y, &u, &v);
+            if (!a && (!span || x - end >= SPAN_GAP)) {
+                if (span) {
+                    // the gap blocks written after its last lit block are not part of it
+                    n = span->offset + span->length;
+                    span = NULL;
+                }
+                continue;
+            }
+            if (!span) {
+                span = &spans->chroma_span[spans->chroma_count++];
+                span->x = (uint16_t) x;
+                span->y = (uint16_t) y;
+                span->offset = n;
+            }
+            spans->u[n] = u;
+            spans->v[n] = v;
+            spans->chroma_alpha[n] = (uint8_t) a;
+            n++;
+            if (a) {
+                end = x + 1;
+                span->length = (uint16_t) (end - span->x);
+            }
+        }
+        if (span) {
+            n = span->offset + span->length;
+        }
+    }
+    return spans->luma_count;
+}
+
+void overlay_spans_blend(const OVERLAY_SPANS_T *spans, uint8_t *y_plane, int y_stride,
+        uint8_t *u_plane, uint8_t *v_plane, int uv_stride, int x0, int y0) {
+    const OVERLAY_SPAN_T *s;
+    size_t at;
+    int i;
+
+    for (i = 0; i < spans->luma_count; i++) {
+        s = &spans->luma_span[i];
+        blend_row(y_plane + (size_t) (y0 + s->y) * y_stride + x0 + s->x,
+                spans->luma + s->offset, spans->luma_alpha + s->offset, s->length);
+    }
+    for (i = 0; i < spans->chroma_count; i++) {
+        s = &spans->chroma_span[i];
+        at = (size_t) (y0 / 2 + s->y) * uv_stride + x0 / 2 + s->x;
+        blend_row(u_plane + at, spans->u + s->offset, spans->chroma_alpha + s->offset, s->length);
+        blend_row(v_plane + at, spans->v + s->offset, spans->chroma_alpha + s->offset, s->length);
+    }
+}
+
+const char *overlay_spans_impl(void) {
+#if SPANS_NEON
+    return "neon";
+#elif SPANS_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,64 @@
+/*
+ * File:   overlay_spans.h
+ * Author: Hassan
+ *
+ * A 32-bit overlay surface burnt into I420 frames at the cost of what is
+ * lit, not of the surface. overlay_spans_compile runs when the surface
+ * changes: it finds the runs of pixels with any alpha, row by row, and
+ * keeps each pixel's colour as Y, U and V next to its alpha. Chroma gets
+ * its own runs over 2x2 blocks, with the alpha averaged over the block and
+ * the colour weighted by it. overlay_spans_blend then only walks those
+ * runs, mixing each plane with a SIMD kernel.
+ *
+ * The surface has alpha in the top byte and red in the next, as
+ * glyph_atlas writes it, with straight (not premultiplied) colour, which is
+ * what glyph_text_draw leaves over a transparent background.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef OVERLAY_SPANS_H
+#define OVERLAY_SPANS_H
+
+#include <stdint.h>
+
+typedef struct {
+    uint16_t x; // in the plane the run belongs to
+    uint16_t y;
+    uint16_t length;
+    uint32_t offset; // of its first pixel in the value arrays
+} OVERLAY_SPAN_T;
+
+typedef struct {
+    int width; // of the surfaces compiled
+    int height;
+    OVERLAY_SPAN_T *luma_span;
+    int luma_count;
+    uint8_t *luma; // Y of each lit pixel
+    uint8_t *luma_alpha;
+    OVERLAY_SPAN_T *chroma_span;
+    int chroma_count;
+    uint8_t *u; // of each lit 2x2 block
+    uint8_t *v;
+    uint8_t *chroma_alpha;
+    int pixels; // lit luma pixels
+} OVERLAY_SPANS_T;
+
+/* Room for any width x height surface; starts with nothing lit. */
+int overlay_spans_init(OVERLAY_SPANS_T *spans, int width, int height);
+void overlay_spans_destroy(OVERLAY_SPANS_T *spans);
+
+/* The runs of a surface of the size given to init, stride in pixels; returns the luma runs. */
+int overlay_spans_compile(OVERLAY_SPANS_T *spans, const uint32_t *pixels, int stride);
+
+/*
+ * Mixes the lit pixels into a frame with the surface's top left at (x0, y0),
+ * both even. The surface must lie inside the frame.
+ */
+void overlay_spans_blend(const OVERLAY_SPANS_T *spans, uint8_t *y_plane, int y_stride,
+        uint8_t *u_plane, uint8_t *v_plane, int uv_stride, int x0, int y0);
+
+/* "neon", "sse2" or "scalar", whichever this build uses. */
+const char *overlay_spans_impl(void);
+
+#endif /* OVERLAY_SPANS_H */
@@ -0,0 +1,150 @@
+/*
+ * File:   sam_alert.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sam_alert.h"
+#include "sam_log.h"
+
+static void alarm_due(void *userdata) {
+    SAM_ALERT_T *alert = (SAM_ALERT_T *) userdata;
+
+    if (!__atomic_load_n(&alert->slc_flag, __ATOMIC_RELAXED)) {
+        __atomic_store_n(&alert->alarm_fired, 1, __ATOMIC_RELAXED);
+        alert->buzz_cb(alert->userdata);
+    }
+}
+
+void sam_alert_init(SAM_ALERT_T *alert) {
+    memset(alert, 0, sizeof (SAM_ALERT_T));
+    alert->avg_max = 20;
+    alert->alarm_delay_ms = SAM_ALARM_DELAY_MS;
+    alert->recal_ms = SAM_RECAL_MS;
+    timer_init(&alert->alarm_timer, alarm_due, alert);
+}
+
+void sam_alert_set_timer(SAM_ALERT_T *alert, TIMER_WHEEL_T *wheel, SAM_ALERT_BUZZ_CB_T buzz_cb, void *userdata) {
+    alert->wheel = wheel;
+    alert->buzz_cb = buzz_cb;
+    alert->userdata = userdata;
+}
+
+int sam_alert_buzzing(SAM_ALERT_T *alert) {
+    // silence wins over a deadline the wheel was already firing when it was pressed
+    return __atomic_load_n(&alert->alarm_fired, __ATOMIC_RELAXED) && !__atomic_load_n(&alert->slc_flag, __ATOMIC_RELAXED);
+}
+
+void sam_alert_inputs(SAM_ALERT_T *alert, const SAM_INPUTS_T *inputs) {
+    if (inputs->slc_pressed) {
+        __atomic_store_n(&alert->slc_flag, !alert->slc_flag, __ATOMIC_RELAXED);
+        alert->padding_flag = !alert->padding_flag;
+        if (alert->slc_flag) {
+            // stops a buzzer the wheel has sounded, as it stops one a frame has
+            __atomic_store_n(&alert->alarm_fired, 0, __ATOMIC_RELAXED);
+        }
+    }
+    alert->l_turn = inputs->l_turn;
+    alert->r_turn = inputs->r_turn;
+}
+
+void sam_alert_face(SAM_ALERT_T *alert, int face_found, const CvRect *face, uint64_t now) {
+    const CvRect *r = face;
+
+    alert->face_flag = face_found;
+    if (!face_found) {
+        return;
+    }
+    alert->face = *face;
+
+    /* recalibration stage */
+    /* avg */
+    if (!alert->draw_flag) {
+        if (alert->avg_iteration < alert->avg_max) {
+            alert->avg_x += r->x;
+            alert->avg_y += r->y;
+            alert->avg_w += r->width;
+            alert->avg_h += r->height;
+            alert->avg_iteration++;
+        } else {
+            alert->padding_x = (int) (((alert->avg_x) - (0.075 * alert->avg_w)) / alert->avg_max);
+            alert->padding_y = (int) (((alert->avg_y) - (0.015 * alert->avg_h)) / alert->avg_max);
+            alert->padding_w = (int) (1.3 * alert->avg_w / alert->avg_max);
+            alert->padding_h = (int) (1.25 * alert->avg_h / alert->avg_max);
+            alert->draw_flag = 1;
+            alert->cal_begin = now;
+            alert->eye_begin = now;
+        }
+    }
+    /* *** */
+    if (alert->draw_flag) {
+        if (alert->padding_flag) {
+            if (alert->verbose)
+                SAM_LOG(SAM_LOG_DEBUG, "five seconds");
+            alert->padding_w = (int) ((r->width)*1.30);
+            alert->padding_h = (int) ((r->height)*1.25);
+            alert->padding_y = (int) ((r->y) - (alert->padding_h)*0.05);
+            alert->padding_x = (int) ((r->x) - (alert->padding_w)*0.075);
+            alert->padding_flag = 0;
+            alert->cal_begin = now;
+        }
+        /* Collision Detection Stage*/
+        alert->out_of_bound = (r->x < alert->padding_x)
+                || ((r->x + r->width) > (alert->padding_x + alert->padding_w))
+                || (r->y < alert->padding_y)
+                || ((r->y + r->height) > (alert->padding_y + alert->padding_h));
+    }
+}
+
+int sam_alert_begin_eyes(SAM_ALERT_T *alert, uint64_t now) {
+    alert->eye_end = now - alert->eye_begin;
+    if (alert->verbose)
+        SAM_LOG(SAM_LOG_DEBUG, "eyes timer: %d ms", (int) alert->eye_end);
+    if (alert->face_flag || alert->out_of_bound) {
+        alert->eye_begin = now;
+        return 1;
+    }
+    return 0;
+}
+
+void sam_alert_eyes(SAM_ALERT_T *alert, int eyes_total) {
+    alert->eyes_detected = (eyes_total > 0);
+    if (alert->verbose)
+        SAM_LOG(SAM_LOG_DEBUG, "eyes:%d", eyes_total);
+}
+
+void sam_alert_decide(SAM_ALERT_T *alert, uint64_t now, SAM_OUTPUTS_T *outputs) {
+    /* auto recalibrate */
+    alert->cal_end = now - alert->cal_begin;
+    if (alert->cal_end >= alert->recal_ms)
+        alert->padding_flag = 1; // recal time to be decided
+    /* Alert stage */
+    if (!(alert->l_turn || alert->r_turn) && (!alert->face_flag || (alert->out_of_bound && !alert->eyes_detected))) {
+        if (!alert->reset_timer) {
+            alert->alarm_begin = now;
+            alert->reset_timer = 1;
+            if (alert->wheel) {
+                // the buzzer goes off on time even if the next frames are slow
+                timer_wheel_arm(alert->wheel, &alert->alarm_timer, now + alert->alarm_delay_ms);
+            }
+        }
+        alert->alarm_end = now - alert->alarm_begin;
+        if (alert->verbose)
+            SAM_LOG(SAM_LOG_DEBUG, "time lapsed: %d ms", (int) alert->alarm_end);
+        if (alert->alarm_end >= alert->alarm_delay_ms)
+            alert->buzz = !alert->slc_flag;
+    } else {
+        if (alert->reset_timer && alert->wheel) {
+            timer_wheel_cancel(alert->wheel, &alert->alarm_timer);
+        }
+        __atomic_store_n(&alert->alarm_fired, 0, __ATOMIC_RELAXED);
+        alert->reset_timer = 0;
+        alert->buzz = 0;
+    }
+    outputs->face_led = alert->face_flag;
+    outputs->buzz = alert->buzz;
+}
@@ -0,0 +1,100 @@
+/*
+ * File:   sam_alert.h
+ * Author: Hassan
+ *
+ * Calibration, padding box and alarm decisions. Fed once per detection frame
+ * with the inputs, the face and (when asked for) the eye result. Time is
+ * passed in by the caller, in milliseconds, so recordings can be replayed on
+ * their own clock. Given a TIMER_WHEEL_T on the same clock, the buzzer also
+ * goes off right at the alarm deadline instead of at the next frame.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef SAM_ALERT_H
+#define SAM_ALERT_H
+
+#include <stdint.h>
+
+#include <opencv2/core/core_c.h>
+
+#include "timer_wheel.h"
+
+#define SAM_ALARM_DELAY_MS 1000 // no face, or lost eyes out of the box, for this long sounds the buzzer
+#define SAM_RECAL_MS 6000 // padding box recalibration period
+
+typedef struct {
+    int slc_pressed; // silence/recalibrate button level
+    int l_turn;
+    int r_turn;
+} SAM_INPUTS_T;
+
+typedef struct {
+    int face_led;
+    int buzz;
+} SAM_OUTPUTS_T;
+
+/* wheel thread, the alarm deadline has passed with the alarm still on */
+typedef void (*SAM_ALERT_BUZZ_CB_T)(void *userdata);
+
+typedef struct {
+    /* system flags and control variables */
+    int slc_flag; // 1 == True, 0 == false
+    int l_turn, r_turn;
+    int padding_flag; // 1 == True, 0 == false
+    int padding_x;
+    int padding_y;
+    int padding_w;
+    int padding_h;
+    int avg_x;
+    int avg_y;
+    int avg_w;
+    int avg_h;
+    int avg_iteration;
+    int avg_max;
+    int draw_flag;
+    int out_of_bound;
+    int face_flag;
+    int reset_timer;
+    int eyes_detected;
+    int buzz;
+    CvRect face; // last face seen, the eye stage keeps using it while out of bound
+    /* timers, ms */
+    uint64_t alarm_begin, alarm_end;
+    uint64_t cal_begin, cal_end;
+    uint64_t eye_begin, eye_end;
+    uint64_t alarm_delay_ms;
+    uint64_t recal_ms;
+    TIMER_WHEEL_T *wheel; // NULL: the buzzer only changes with a frame
+    TIMER_T alarm_timer;
+    SAM_ALERT_BUZZ_CB_T buzz_cb;
+    void *userdata;
+    int alarm_fired; // set by the wheel, cleared with the alarm or by silence
+    int verbose;
+} SAM_ALERT_T;
+
+void sam_alert_init(SAM_ALERT_T *alert);
+
+/*
+ * Arms the alarm deadline on wheel, which must run on the clock passed to
+ * the calls below; buzz_cb sounds the buzzer from the wheel thread.
+ */
+void sam_alert_set_timer(SAM_ALERT_T *alert, TIMER_WHEEL_T *wheel, SAM_ALERT_BUZZ_CB_T buzz_cb, void *userdata);
+
+/* 1 once the wheel has sounded the buzzer for the current alarm and it is not silenced, from any thread. */
+int sam_alert_buzzing(SAM_ALERT_T *alert);
+
+/* input checkpoint (silence and turn signal) */
+void sam_alert_inputs(SAM_ALERT_T *alert, const SAM_INPUTS_T *inputs);
+
+/* calibration and collision detection stage */
+void sam_alert_face(SAM_ALERT_T *alert, int face_found, const CvRect *face, uint64_t now);
+
+/* Returns 1 when the eye stage should run on alert->face this frame. */
+int sam_alert_begin_eyes(SAM_ALERT_T *alert, uint64_t now);
+void sam_alert_eyes(SAM_ALERT_T *alert, int eyes_total);
+
+/* auto recalibration and alert stage */
+void sam_alert_decide(SAM_ALERT_T *alert, uint64_t now, SAM_OUTPUTS_T *outputs);
+
+#endif /* SAM_ALERT_H */
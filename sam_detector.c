@@ -0,0 +1,265 @@
+/*
+ * File:   sam_detector.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include "sam_detector.h"
+#include "downscale_eq.h"
+#include "haar_scan.h"
+#include "haar_cascades.h"
+
+/* Loads an XML cascade, or takes the compiled-in one when path is NULL. */
+static int load_cascade(const char *path, const HAAR_NATIVE_CASCADE_T *builtin,
+        CvHaarClassifierCascade **cascade, HAAR_NATIVE_T **native) {
+    if (!path) {
+        *native = haar_native_create_static(builtin);
+        return *native ? 0 : -1;
+    }
+    *cascade = (CvHaarClassifierCascade*) cvLoad(path, NULL, NULL, NULL);
+    if (!*cascade) {
+        fprintf(stderr, "Error: unable to load harrcascade %s\n", path);
+        return -1;
+    }
+    *native = haar_native_create(*cascade);
+    return 0;
+}
+
+/* haar_scan's evaluator: OpenCV only when asked for and a cascade was loaded. */
+static HAAR_NATIVE_T *scan_native(const SAM_DETECTOR_T *detector, HAAR_NATIVE_T *native) {
+    return detector->use_native || !detector->cascade ? native : NULL;
+}
+
+static HAAR_SCAN_WORKERS_T *scan_workers(const SAM_DETECTOR_T *detector, HAAR_SCAN_WORKERS_T *workers) {
+    return detector->pool ? workers : NULL;
+}
+
+static void stop_threads(SAM_DETECTOR_T *detector) {
+    if (!detector->pool) {
+        return;
+    }
+    haar_scan_workers_destroy(&detector->face_workers);
+    haar_scan_workers_destroy(&detector->eyes_workers);
+    task_pool_destroy(detector->pool);
+    free(detector->pool);
+    detector->pool = NULL;
+}
+
+int sam_detector_frame_init(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *frame) {
+    memset(frame, 0, sizeof (SAM_DETECTOR_FRAME_T));
+    frame->image2 = cvCreateImage(cvSize(detector->width, detector->height), IPL_DEPTH_8U, 1);
+    if (image_pyramid_init(&frame->pyramid, frame->image2) != 0) {
+        return -1;
+    }
+    if (frame_arena_init(&frame->arena, SAM_DETECTOR_ARENA_SIZE) != 0) {
+        return -1;
+    }
+    return 0;
+}
+
+void sam_detector_frame_destroy(SAM_DETECTOR_FRAME_T *frame) {
+    frame_arena_destroy(&frame->arena);
+    image_pyramid_destroy(&frame->pyramid);
+    if (frame->image2) {
+        cvReleaseImage(&frame->image2);
+    }
+}
+
+int sam_detector_init(SAM_DETECTOR_T *detector, int width, int height, const char *face_cascade, const char *eyes_cascade) {
+    memset(detector, 0, sizeof (SAM_DETECTOR_T));
+    detector->width = width;
+    detector->height = height;
+    if (load_cascade(face_cascade, &haar_cascade_frontalface_alt, &detector->cascade, &detector->native) != 0
+            || load_cascade(eyes_cascade, &haar_cascade_eye, &detector->eyes_cascade, &detector->eyes_native) != 0) {
+        return -1;
+    }
+    detector->use_native = 1;
+    if (sam_detector_frame_init(detector, &detector->frame) != 0) {
+        return -1;
+    }
+    detector->roi_margin = SAM_ROI_MARGIN;
+    detector->roi_max_misses = SAM_ROI_MAX_MISSES;
+    face_tracker_init(&detector->tracker, FACE_TRACKER_INTERVAL, FACE_TRACKER_MIN_CONFIDENCE);
+    return 0;
+}
+
+int sam_detector_set_threads(SAM_DETECTOR_T *detector, int threads) {
+    TASK_POOL_T *pool;
+
+    stop_threads(detector);
+    if (threads == 1) {
+        return 0;
+    }
+    pool = (TASK_POOL_T *) malloc(sizeof (TASK_POOL_T));
+    if (!pool) {
+        fprintf(stderr, "Error: out of memory for the scan threads\n");
+        return -1;
+    }
+    if (task_pool_init(pool, threads) != 0) {
+        free(pool);
+        return -1;
+    }
+    if (task_pool_threads(pool) == 1) {
+        // a single CPU, nothing to share the scans with
+        task_pool_destroy(pool);
+        free(pool);
+        return 0;
+    }
+    detector->pool = pool;
+    haar_scan_workers_init(&detector->face_workers, pool);
+    haar_scan_workers_init(&detector->eyes_workers, pool);
+    return 0;
+}
+
+void sam_detector_destroy(SAM_DETECTOR_T *detector) {
+    stop_threads(detector);
+    sam_detector_frame_destroy(&detector->frame);
+    haar_native_destroy(detector->native);
+    haar_native_destroy(detector->eyes_native);
+    if (detector->cascade) {
+        cvReleaseHaarClassifierCascade(&detector->cascade);
+    }
+    if (detector->eyes_cascade) {
+        cvReleaseHaarClassifierCascade(&detector->eyes_cascade);
+    }
+}
+
+void sam_detector_prepare_in(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *work, const FRAME_T *frame) {
+    image_pyramid_invalidate(&work->pyramid);
+    if (frame->width / 4 == detector->width && frame->height / 4 == detector->height) {
+        downscale_eq_4x4(frame->data, frame->stride, frame->width, frame->height,
+                (uint8_t *) work->image2->imageData, work->image2->widthStep);
+        return;
+    }
+    // any other ratio: read-only view over the frame's Y plane, no copy
+    cvInitImageHeader(&work->image, cvSize(frame->width, frame->height), IPL_DEPTH_8U, 1, 0, 4);
+    cvSetData(&work->image, (void *) frame->data, frame->stride);
+    cvResize(&work->image, work->image2, CV_INTER_LINEAR);
+    cvEqualizeHist(work->image2, work->image2);
+}
+
+void sam_detector_prepare(SAM_DETECTOR_T *detector, const FRAME_T *frame) {
+    sam_detector_prepare_in(detector, &detector->frame, frame);
+}
+
+void sam_detector_set_search_box(SAM_DETECTOR_T *detector, const CvRect *box) {
+    int x0, y0, x1, y1;
+
+    if (!box || box->width <= 0 || box->height <= 0) {
+        detector->search_box = cvRect(0, 0, 0, 0);
+        return;
+    }
+    x0 = box->x - detector->roi_margin;
+    y0 = box->y - detector->roi_margin;
+    x1 = box->x + box->width + detector->roi_margin;
+    y1 = box->y + box->height + detector->roi_margin;
+    x0 = x0 < 0 ? 0 : x0;
+    y0 = y0 < 0 ? 0 : y0;
+    x1 = x1 > detector->width ? detector->width : x1;
+    y1 = y1 > detector->height ? detector->height : y1;
+    detector->search_box = x1 > x0 && y1 > y0 ? cvRect(x0, y0, x1 - x0, y1 - y0) : cvRect(0, 0, 0, 0);
+}
+
+/* Runs the face cascade over region of the shared pyramid. */
+static int detect_in(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *work, CvRect region, CvRect *face) {
+    HAAR_SCAN_PARAMS_T params;
+
+    params.scale_factor = SAM_FACE_SCALE;
+    params.min_neighbors = 3;
+    params.min_size = cvSize(SAM_FACE_MIN, SAM_FACE_MIN);
+    params.max_size = cvSize(SAM_FACE_MAX, SAM_FACE_MAX);
+    params.find_biggest = 0;
+    return haar_scan(detector->cascade, scan_native(detector, detector->native),
+            scan_workers(detector, &detector->face_workers),
+            &work->pyramid, region, &params, &work->arena,
+            face, 1, &detector->face_stats) > 0;
+}
+
+int sam_detector_face_in(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *work, CvRect *face) {
+    if (detector->search_box.width > 0 && detector->roi_misses < detector->roi_max_misses) {
+        detector->roi_scans++;
+        if (detect_in(detector, work, detector->search_box, face)) {
+            detector->roi_misses = 0;
+            return 1;
+        }
+        detector->roi_misses++;
+        return 0;
+    }
+    if (detect_in(detector, work, cvRect(0, 0, detector->width, detector->height), face)) {
+        // found again, go back to the ROI next time
+        detector->roi_misses = 0;
+        return 1;
+    }
+    return 0;
+}
+
+int sam_detector_face(SAM_DETECTOR_T *detector, CvRect *face) {
+    return sam_detector_face_in(detector, &detector->frame, face);
+}
+
+int sam_detector_track_face_in(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *work, CvRect *face) {
+    int found;
+
+    if (!face_tracker_need_detect(&detector->tracker)) {
+        if (face_tracker_update(&detector->tracker, work->image2, face)) {
+            detector->track_runs++;
+            return 1;
+        }
+        // lost it, fall through and detect on this same frame
+    }
+    detector->detect_runs++;
+    found = sam_detector_face_in(detector, work, face);
+    if (found) {
+        face_tracker_start(&detector->tracker, work->image2, face);
+    } else {
+        face_tracker_stop(&detector->tracker);
+    }
+    return found;
+}
+
+int sam_detector_track_face(SAM_DETECTOR_T *detector, CvRect *face) {
+    return sam_detector_track_face_in(detector, &detector->frame, face);
+}
+
+int sam_detector_eyes_in(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *work, const CvRect *face) {
+    HAAR_SCAN_PARAMS_T params;
+    CvRect region, eye;
+    int x1 = face->x + face->width, y1 = face->y + face->height;
+
+    // the face rectangle as a window onto the frame's pyramid, no crop
+    region.x = face->x < 0 ? 0 : face->x;
+    region.y = face->y < 0 ? 0 : face->y;
+    region.width = (x1 > detector->width ? detector->width : x1) - region.x;
+    region.height = (y1 > detector->height ? detector->height : y1) - region.y;
+    if (region.width <= 0 || region.height <= 0) {
+        return 0;
+    }
+    params.scale_factor = SAM_EYES_SCALE;
+    params.min_neighbors = 2;
+    params.min_size = cvSize(SAM_EYES_MIN, SAM_EYES_MIN);
+    params.max_size = cvSize(SAM_EYES_MAX, SAM_EYES_MAX);
+    params.find_biggest = 1;
+    return haar_scan(detector->eyes_cascade, scan_native(detector, detector->eyes_native),
+            scan_workers(detector, &detector->eyes_workers),
+            &work->pyramid, region, &params, &work->arena,
+            &eye, 1, &detector->eyes_stats);
+}
+
+int sam_detector_eyes(SAM_DETECTOR_T *detector, const CvRect *face) {
+    return sam_detector_eyes_in(detector, &detector->frame, face);
+}
+
+void sam_detector_end_frame_in(SAM_DETECTOR_FRAME_T *work) {
+    frame_arena_reset(&work->arena);
+}
+
+void sam_detector_end_frame(SAM_DETECTOR_T *detector) {
+    sam_detector_end_frame_in(&detector->frame);
+}
@@ -0,0 +1,133 @@
+/*
+ * File:   sam_detector.h
+ * Author: Hassan
+ *
+ * Face and eye detection for SAM, independent of where frames come from and
+ * of the Pi peripherals so it also runs against recordings on a desktop.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef SAM_DETECTOR_H
+#define SAM_DETECTOR_H
+
+#include <opencv2/core/core_c.h>
+#include <opencv2/objdetect/objdetect.hpp>
+
+#include "frame_mailbox.h"
+#include "frame_arena.h"
+#include "face_tracker.h"
+#include "image_pyramid.h"
+#include "haar_scan.h"
+
+#define SAM_FACE_CASCADE "/usr/share/opencv/haarcascades/haarcascade_frontalface_alt.xml"
+#define SAM_EYES_CASCADE "/usr/share/opencv/haarcascades/haarcascade_eye.xml"
+
+#define SAM_DETECTOR_ARENA_SIZE (256 * 1024) // scan candidates and grouping scratch
+
+/* face search parameters, in detector pixels */
+#define SAM_FACE_SCALE 1.4
+#define SAM_FACE_MIN 100
+#define SAM_FACE_MAX 150
+#define SAM_EYES_SCALE 1.1
+#define SAM_EYES_MIN 20
+#define SAM_EYES_MAX 50
+#define SAM_ROI_MARGIN 24 // added around the padding box on every side
+#define SAM_ROI_MAX_MISSES 3 // consecutive ROI misses before a full-frame scan
+
+/*
+ * Everything one frame needs on its way through the detector. The detector
+ * owns one for the serial calls below; a pipeline keeps one per frame in
+ * flight and uses the *_in variants.
+ */
+typedef struct {
+    IplImage image; // header over the current source frame
+    IplImage *image2; // scaled and equalised detector input
+    IMAGE_PYRAMID_T pyramid; // levels and integrals of image2, shared by both cascades
+    FRAME_ARENA_T arena; // per-frame scratch, reset by sam_detector_end_frame
+} SAM_DETECTOR_FRAME_T;
+
+typedef struct {
+    int width; // detector input size
+    int height;
+    CvHaarClassifierCascade *cascade; // NULL when running the compiled-in cascade
+    CvHaarClassifierCascade *eyes_cascade;
+    HAAR_NATIVE_T *native; // built-in evaluators, NULL where a cascade stays on OpenCV
+    HAAR_NATIVE_T *eyes_native;
+    int use_native; // 0 evaluates the loaded XML cascades with OpenCV
+    TASK_POOL_T *pool; // NULL scans on the calling thread alone
+    HAAR_SCAN_WORKERS_T face_workers;
+    HAAR_SCAN_WORKERS_T eyes_workers;
+    SAM_DETECTOR_FRAME_T frame;
+    FACE_TRACKER_T tracker;
+    CvRect search_box; // calibrated padding box grown by roi_margin, empty before calibration
+    int roi_margin;
+    int roi_max_misses;
+    int roi_misses;
+    uint32_t detect_runs; // frames that ran the full face detector
+    uint32_t roi_scans; // ... of which over search_box only
+    uint32_t track_runs; // frames answered by the tracker
+    HAAR_SCAN_STATS_T face_stats;
+    HAAR_SCAN_STATS_T eyes_stats;
+} SAM_DETECTOR_T;
+
+/*
+ * face_cascade and eyes_cascade are OpenCV XML files; NULL takes the cascade
+ * compiled into the binary (haar_cascades.h), which skips the XML parse.
+ */
+int sam_detector_init(SAM_DETECTOR_T *detector, int width, int height, const char *face_cascade, const char *eyes_cascade);
+void sam_detector_destroy(SAM_DETECTOR_T *detector);
+
+/*
+ * Spreads each face and eye scan over threads threads, the caller included;
+ * 0 takes one per online CPU and 1 goes back to scanning on the caller. Call
+ * between frames.
+ */
+int sam_detector_set_threads(SAM_DETECTOR_T *detector, int threads);
+
+/*
+ * Scales and equalises the frame into image2; the frame may be released right
+ * after. A frame exactly 4x the detector size takes the fused downscale_eq path.
+ */
+void sam_detector_prepare(SAM_DETECTOR_T *detector, const FRAME_T *frame);
+
+/*
+ * Restricts face detection to box grown by roi_margin, until roi_max_misses
+ * scans in a row find nothing there. NULL or an empty box scans the whole image.
+ */
+void sam_detector_set_search_box(SAM_DETECTOR_T *detector, const CvRect *box);
+
+/* Returns 1 and the first face found in image2 coordinates, 0 if none. */
+int sam_detector_face(SAM_DETECTOR_T *detector, CvRect *face);
+
+/*
+ * Same contract as sam_detector_face, but runs the full detector only every
+ * tracker.interval frames or when tracking confidence drops, and follows the
+ * face with face_tracker in between.
+ */
+int sam_detector_track_face(SAM_DETECTOR_T *detector, CvRect *face);
+
+/*
+ * Returns 1 when an eye is found inside the face rectangle, 0 otherwise. Scans
+ * the same pyramid as the face pass, so the face is neither copied nor
+ * re-equalised.
+ */
+int sam_detector_eyes(SAM_DETECTOR_T *detector, const CvRect *face);
+
+/* Drops this frame's scratch memory. Call once per frame. */
+void sam_detector_end_frame(SAM_DETECTOR_T *detector);
+
+/*
+ * Extra working frames for frames in flight at once. The face calls share
+ * the tracker and search box and the eye calls the eye evaluator, so each
+ * kind must stay on one thread; prepare may run anywhere.
+ */
+int sam_detector_frame_init(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *frame);
+void sam_detector_frame_destroy(SAM_DETECTOR_FRAME_T *frame);
+void sam_detector_prepare_in(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *work, const FRAME_T *frame);
+int sam_detector_face_in(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *work, CvRect *face);
+int sam_detector_track_face_in(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *work, CvRect *face);
+int sam_detector_eyes_in(SAM_DETECTOR_T *detector, SAM_DETECTOR_FRAME_T *work, const CvRect *face);
+void sam_detector_end_frame_in(SAM_DETECTOR_FRAME_T *work);
+
+#endif /* SAM_DETECTOR_H */
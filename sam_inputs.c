@@ -0,0 +1,74 @@
+/*
+ * File:   sam_inputs.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <string.h>
+
+#include "sam_inputs.h"
+#include "sam_log.h"
+#include "sys_util.h"
+
+void sam_inputs_config(GPIO_INPUT_CONFIG_T *config) {
+    gpio_input_config_default(config);
+    config->pins[0] = SAM_PIN_SLC_BUTTON;
+    config->pins[1] = SAM_PIN_L_TURN;
+    config->pins[2] = SAM_PIN_R_TURN;
+    config->pin_count = 3;
+}
+
+void sam_inputs_read(GPIO_INPUT_T *input, SAM_INPUTS_T *inputs, SAM_INPUT_STATS_T *stats) {
+    GPIO_EVENT_T event;
+    uint64_t now = now_ns();
+    uint64_t latency;
+    int presses = 0;
+
+    while (gpio_input_poll(input, &event)) {
+        if (event.pin == SAM_PIN_SLC_BUTTON && event.level) {
+            presses++;
+        }
+        if (stats) {
+            latency = now > event.time_ns ? now - event.time_ns : 0;
+            stats->events++;
+            stats->latency_ns += latency;
+            if (latency > stats->max_latency_ns) {
+                stats->max_latency_ns = latency;
+            }
+        }
+    }
+    if (stats) {
+        stats->presses += presses;
+    }
+    // every press toggles silence, two between frames cancel out
+    inputs->slc_pressed = presses & 1;
+    // the turn signals are wired crossed, as SAM_demo has always read them
+    inputs->l_turn = gpio_input_level(input, SAM_PIN_R_TURN) == 1;
+    inputs->r_turn = gpio_input_level(input, SAM_PIN_L_TURN) == 1;
+}
+
+void sam_inputs_frame(SAM_INPUT_PINS_T *pins, SAM_INPUTS_T *inputs) {
+    int level;
+
+    if (pins->input) {
+        sam_inputs_read(pins->input, inputs, &pins->stats);
+    } else {
+        // the low to high transition, as the edge path reports it; holding the button is not another press
+        level = pins->read_pin(SAM_PIN_SLC_BUTTON) == 1;
+        inputs->slc_pressed = level && !pins->slc_level;
+        pins->slc_level = level;
+        inputs->l_turn = pins->read_pin(SAM_PIN_R_TURN) == 1;
+        inputs->r_turn = pins->read_pin(SAM_PIN_L_TURN) == 1;
+    }
+    SAM_LOG(SAM_LOG_DEBUG, "R:%d L:%d", inputs->r_turn, inputs->l_turn);
+}
+
+void sam_inputs_log_stats(const SAM_INPUT_PINS_T *pins) {
+    const SAM_INPUT_STATS_T *stats = &pins->stats;
+
+    if (pins->input && stats->events) {
+        SAM_LOG(SAM_LOG_INFO, "inputs: %u events, %.1f ms average wait, %.1f ms worst", stats->events,
+                stats->latency_ns / 1000000.0 / stats->events, stats->max_latency_ns / 1000000.0);
+    }
+}
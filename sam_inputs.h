@@ -0,0 +1,55 @@
+/*
+ * File:   sam_inputs.h
+ * Author: Hassan
+ *
+ * SAM's input pins on top of gpio_input: turns the queued button and turn
+ * signal events into the SAM_INPUTS_T the alert logic takes once a frame,
+ * and keeps track of how long events waited to be picked up. Without
+ * gpio_input the pins are read once a frame through wiringPi instead.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef SAM_INPUTS_H
+#define SAM_INPUTS_H
+
+#include <stdint.h>
+
+#include "gpio_input.h"
+#include "sam_alert.h"
+
+/* wiringPi pins */
+#define SAM_PIN_SLC_BUTTON 3
+#define SAM_PIN_L_TURN 4
+#define SAM_PIN_R_TURN 5
+
+typedef struct {
+    uint32_t events;
+    uint32_t presses; // silence button presses
+    uint64_t latency_ns; // sum over events, edge to sam_inputs_read
+    uint64_t max_latency_ns;
+} SAM_INPUT_STATS_T;
+
+typedef int (*SAM_PIN_READ_T)(int pin); // wiringPi's digitalRead
+
+/* A program's inputs: gpio_input's events, or the pins polled. */
+typedef struct {
+    GPIO_INPUT_T *input; // NULL: poll read_pin once a frame
+    SAM_PIN_READ_T read_pin;
+    int slc_level; // polled: the button's level on the last frame
+    SAM_INPUT_STATS_T stats; // gpio_input's events
+} SAM_INPUT_PINS_T;
+
+/* The SAM input pins on top of gpio_input_config_default. */
+void sam_inputs_config(GPIO_INPUT_CONFIG_T *config);
+
+/* Drains the events since the last call into inputs. One thread only. */
+void sam_inputs_read(GPIO_INPUT_T *input, SAM_INPUTS_T *inputs, SAM_INPUT_STATS_T *stats);
+
+/* One frame's inputs from whichever pins has, a press either way the button going high. One thread only. */
+void sam_inputs_frame(SAM_INPUT_PINS_T *pins, SAM_INPUTS_T *inputs);
+
+/* How long events waited so far, to the log; nothing when there were none. */
+void sam_inputs_log_stats(const SAM_INPUT_PINS_T *pins);
+
+#endif /* SAM_INPUTS_H */
@@ -0,0 +1,537 @@
+/*
+ * File:   sam_log.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sam_log.h"
+#include "sys_util.h"
+
+#define LOG_NO_FORMAT 0xffffffffu
+
+typedef struct {
+    SAM_LOG_RECORD_T record[SAM_LOG_RING_SIZE];
+    const char *fmt[SAM_LOG_RING_SIZE];
+    uint32_t head; // next to format, log thread owned
+    uint32_t tail; // next to fill, owning thread
+} LOG_RING_T;
+
+typedef struct {
+    SAM_LOG_CONFIG_T config;
+    LOG_RING_T ring[SAM_LOG_MAX_THREADS];
+    uint32_t ring_count;
+    int running;
+    pthread_t thread;
+    uint32_t stop;
+    FILE *file;
+    size_t file_size;
+    const char *format[SAM_LOG_MAX_FORMATS]; // binary log ids, open addressed on the pointer
+    uint8_t written[SAM_LOG_MAX_FORMATS]; // defined in the current file
+    SAM_LOG_STATS_T stats;
+} LOG_T;
+
+int sam_log_level = SAM_LOG_INFO;
+
+static LOG_T log_state;
+static int log_rate = SAM_LOG_RATE; // the limit holds before sam_log_start too
+static __thread LOG_RING_T *thread_ring;
+static __thread int thread_ring_full;
+
+static const char *level_name[] = {"ERROR", "WARN", "INFO", "DEBUG"};
+
+const char *sam_log_level_name(int level) {
+    return level >= SAM_LOG_ERROR && level <= SAM_LOG_DEBUG ? level_name[level] : "?";
+}
+
+void sam_log_config_default(SAM_LOG_CONFIG_T *config) {
+    memset(config, 0, sizeof (SAM_LOG_CONFIG_T));
+    config->level = SAM_LOG_INFO;
+    config->max_file_size = 1 << 20;
+    config->max_files = 4;
+    config->rate_per_sec = SAM_LOG_RATE;
+}
+
+/* One conversion of a printf format: where it ends, its flags/width/precision and its length modifier. */
+typedef struct {
+    const char *end; // past the conversion character
+    char conv;
+    int length; // 0, 'h', 'H' (hh), 'l', 'q' (ll), 'j', 'z', 't', 'L'
+    char spec[32]; // "%" with flags, width and precision, no length or conversion
+} LOG_CONV_T;
+
+/* p points past a '%' that is not "%%". */
+static void parse_conv(const char *p, LOG_CONV_T *conv) {
+    const char *start = p;
+    size_t n;
+
+    while (*p && strchr("-+ #0", *p)) {
+        p++;
+    }
+    while (*p >= '0' && *p <= '9') {
+        p++;
+    }
+    if (*p == '.') {
+        p++;
+        while (*p >= '0' && *p <= '9') {
+            p++;
+        }
+    }
+    n = p - start;
+    if (n > sizeof (conv->spec) - 2) {
+        n = sizeof (conv->spec) - 2;
+    }
+    conv->spec[0] = '%';
+    memcpy(conv->spec + 1, start, n);
+    conv->spec[n + 1] = 0;
+    conv->length = 0;
+    if (p[0] == 'h' && p[1] == 'h') {
+        conv->length = 'H';
+        p += 2;
+    } else if (p[0] == 'l' && p[1] == 'l') {
+        conv->length = 'q';
+        p += 2;
+    } else if (*p && strchr("hljztL", *p)) {
+        conv->length = *p++;
+    }
+    conv->conv = *p;
+    conv->end = *p ? p + 1 : p;
+}
+
+static int is_double(char c) {
+    return c && strchr("fFeEgGaA", c) != NULL;
+}
+
+static int is_unsigned(char c) {
+    return c && strchr("ouxX", c) != NULL;
+}
+
+/* Copies the arguments of fmt into the record, in the types the conversions name. */
+static void capture(SAM_LOG_RECORD_T *record, const char *fmt, va_list ap) {
+    LOG_CONV_T conv;
+    const char *p = fmt, *s;
+    int text = 0;
+    double d;
+
+    record->nargs = 0;
+    record->doubles = 0;
+    record->text[0] = 0;
+    while ((p = strchr(p, '%')) != NULL) {
+        if (p[1] == '%') {
+            p += 2;
+            continue;
+        }
+        parse_conv(p + 1, &conv);
+        p = conv.end;
+        if (conv.conv == 0 || conv.conv == 'n' || record->nargs == SAM_LOG_MAX_ARGS) {
+            break;
+        }
+        if (conv.conv == 's') {
+            s = va_arg(ap, const char *);
+            if (!text) {
+                strncpy(record->text, s ? s : "(null)", SAM_LOG_TEXT_SIZE - 1);
+                record->text[SAM_LOG_TEXT_SIZE - 1] = 0;
+                text = 1;
+            }
+            record->arg[record->nargs++] = 0;
+        } else if (is_double(conv.conv)) {
+            d = conv.length == 'L' ? (double) va_arg(ap, long double) : va_arg(ap, double);
+            memcpy(&record->arg[record->nargs], &d, sizeof (d));
+            record->doubles |= 1u << record->nargs;
+            record->nargs++;
+        } else if (conv.conv == 'p') {
+            record->arg[record->nargs++] = (int64_t) (uintptr_t) va_arg(ap, void *);
+        } else if (conv.length == 'q' || conv.length == 'j') {
+            record->arg[record->nargs++] = va_arg(ap, long long);
+        } else if (conv.length == 'l' || conv.length == 'z' || conv.length == 't') {
+            record->arg[record->nargs++] = is_unsigned(conv.conv) ? (int64_t) va_arg(ap, unsigned long) : va_arg(ap, long);
+        } else {
+            record->arg[record->nargs++] = is_unsigned(conv.conv) ? (int64_t) va_arg(ap, unsigned int) : va_arg(ap, int);
+        }
+    }
+}
+
+static int format_message(char *buf, size_t size, const char *fmt, const SAM_LOG_RECORD_T *record) {
+    LOG_CONV_T conv;
+    const char *p = fmt, *q;
+    char spec[40];
+    size_t len = 0;
+    int arg = 0, text = 0, n;
+    double d;
+    int64_t v;
+
+    if (size == 0) {
+        return 0;
+    }
+    buf[0] = 0;
+    while (*p && len + 1 < size) {
+        q = strchr(p, '%');
+        if (!q) {
+            q = p + strlen(p);
+        }
+        n = q - p;
+        if ((size_t) n > size - 1 - len) {
+            n = size - 1 - len;
+        }
+        memcpy(buf + len, p, n);
+        len += n;
+        buf[len] = 0;
+        if (*q == 0 || len + 1 >= size) {
+            break;
+        }
+        if (q[1] == '%') {
+            buf[len++] = '%';
+            buf[len] = 0;
+            p = q + 2;
+            continue;
+        }
+        parse_conv(q + 1, &conv);
+        p = conv.end;
+        if (conv.conv == 0 || conv.conv == 'n') {
+            break;
+        }
+        if (arg >= record->nargs) {
+            n = snprintf(buf + len, size - len, "?");
+        } else if (conv.conv == 's') {
+            snprintf(spec, sizeof (spec), "%ss", conv.spec);
+            n = snprintf(buf + len, size - len, spec, text ? "?" : record->text);
+            text = 1;
+        } else if (record->doubles & (1u << arg)) {
+            memcpy(&d, &record->arg[arg], sizeof (d));
+            snprintf(spec, sizeof (spec), "%s%c", conv.spec, conv.conv);
+            n = snprintf(buf + len, size - len, spec, d);
+        } else {
+            v = record->arg[arg];
+            if (conv.conv == 'p') {
+                n = snprintf(buf + len, size - len, "%#llx", (unsigned long long) v);
+            } else if (conv.conv == 'c') {
+                snprintf(spec, sizeof (spec), "%sc", conv.spec);
+                n = snprintf(buf + len, size - len, spec, (int) v);
+            } else {
+                // every integer goes out as a long long, narrowed the way the length asked
+                if (conv.length == 'H') {
+                    v = is_unsigned(conv.conv) ? (int64_t) (unsigned char) v : (int64_t) (signed char) v;
+                } else if (conv.length == 'h') {
+                    v = is_unsigned(conv.conv) ? (int64_t) (unsigned short) v : (int64_t) (short) v;
+                }
+                snprintf(spec, sizeof (spec), "%sll%c", conv.spec, conv.conv);
+                n = snprintf(buf + len, size - len, spec, (long long) v);
+            }
+        }
+        arg++;
+        len = n < 0 ? len : len + n;
+        if (len >= size) {
+            len = size - 1;
+        }
+    }
+    return (int) len;
+}
+
+int sam_log_format(char *buf, size_t size, const char *fmt, const SAM_LOG_RECORD_T *record) {
+    int len, n;
+    size_t end;
+
+    len = snprintf(buf, size, "%10.3f %-5s t%-2d ", record->time_ns / 1000000000.0,
+            sam_log_level_name(record->level), record->thread);
+    if (len < 0 || (size_t) len >= size) {
+        return len;
+    }
+    len += format_message(buf + len, size - len, fmt ? fmt : "(unknown format)", record);
+    // a message's own newline would split the line
+    end = len;
+    while (end > 0 && buf[end - 1] == '\n') {
+        buf[--end] = 0;
+    }
+    len = end;
+    if (record->suppressed) {
+        n = snprintf(buf + len, size - len, " (%u suppressed)", record->suppressed);
+        len = n < 0 ? len : len + n;
+    }
+    return len;
+}
+
+static void print_record(FILE *f, const char *fmt, const SAM_LOG_RECORD_T *record) {
+    char line[512];
+
+    sam_log_format(line, sizeof (line), fmt, record);
+    fprintf(f, "%s\n", line);
+}
+
+static LOG_RING_T *claim_ring(void) {
+    uint32_t index;
+
+    if (thread_ring || thread_ring_full) {
+        return thread_ring;
+    }
+    index = __atomic_fetch_add(&log_state.ring_count, 1, __ATOMIC_ACQ_REL);
+    if (index >= SAM_LOG_MAX_THREADS) {
+        thread_ring_full = 1;
+        return NULL;
+    }
+    thread_ring = &log_state.ring[index];
+    return thread_ring;
+}
+
+/* 0 when the call site is over its rate this second. */
+static int site_allows(SAM_LOG_SITE_T *site, uint64_t now) {
+    uint64_t second = now / 1000000000ull;
+    int rate = log_rate;
+
+    if (rate <= 0) {
+        return 1;
+    }
+    // sites shared between threads may miscount a little at a second boundary
+    if (__atomic_load_n(&site->window, __ATOMIC_RELAXED) != second) {
+        __atomic_store_n(&site->window, second, __ATOMIC_RELAXED);
+        __atomic_store_n(&site->count, 0, __ATOMIC_RELAXED);
+    }
+    if (__atomic_add_fetch(&site->count, 1, __ATOMIC_RELAXED) > (uint32_t) rate) {
+        __atomic_add_fetch(&site->suppressed, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&log_state.stats.suppressed, 1, __ATOMIC_RELAXED);
+        return 0;
+    }
+    return 1;
+}
+
+void sam_log_write(int level, SAM_LOG_SITE_T *site, const char *fmt, ...) {
+    SAM_LOG_RECORD_T local;
+    SAM_LOG_RECORD_T *record = &local;
+    LOG_RING_T *ring = NULL;
+    uint64_t now = now_ns();
+    uint32_t tail = 0;
+    va_list ap;
+
+    if (!site_allows(site, now)) {
+        return;
+    }
+    if (__atomic_load_n(&log_state.running, __ATOMIC_ACQUIRE)) {
+        ring = claim_ring();
+        if (!ring) {
+            __atomic_add_fetch(&log_state.stats.dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        tail = ring->tail;
+        if (tail - __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == SAM_LOG_RING_SIZE) {
+            __atomic_add_fetch(&log_state.stats.dropped, 1, __ATOMIC_RELAXED);
+            return;
+        }
+        record = &ring->record[tail & (SAM_LOG_RING_SIZE - 1)];
+    }
+    record->time_ns = now;
+    record->level = level;
+    record->thread = ring ? ring - log_state.ring : 0;
+    record->fmt_id = 0;
+    record->suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+    va_start(ap, fmt);
+    capture(record, fmt, ap);
+    va_end(ap);
+    __atomic_add_fetch(&log_state.stats.records, 1, __ATOMIC_RELAXED);
+    if (!ring) {
+        print_record(stderr, fmt, record);
+        return;
+    }
+    ring->fmt[tail & (SAM_LOG_RING_SIZE - 1)] = fmt;
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+/* Log thread only. */
+static int open_file(LOG_T *log) {
+    log->file = fopen(log->config.path, "wb");
+    if (!log->file) {
+        printf("Error: sam_log: unable to open %s\n", log->config.path);
+        return -1;
+    }
+    fwrite(SAM_LOG_MAGIC, 1, 8, log->file);
+    log->file_size = 8;
+    memset(log->written, 0, sizeof (log->written));
+    return 0;
+}
+
+/* path.N-2 to path.N-1 ... path to path.1, and a fresh path. */
+static void rotate(LOG_T *log) {
+    char from[512], to[512];
+    int i;
+
+    fclose(log->file);
+    log->file = NULL;
+    for (i = log->config.max_files - 1; i > 0; i--) {
+        if (i == 1) {
+            snprintf(from, sizeof (from), "%s", log->config.path);
+        } else {
+            snprintf(from, sizeof (from), "%s.%d", log->config.path, i - 1);
+        }
+        snprintf(to, sizeof (to), "%s.%d", log->config.path, i);
+        rename(from, to);
+    }
+    log->stats.rotations++;
+    open_file(log);
+}
+
+static uint32_t format_id(LOG_T *log, const char *fmt) {
+    uint32_t i = (uint32_t) (((uintptr_t) fmt >> 3) * 2654435761u) % SAM_LOG_MAX_FORMATS;
+    int probes;
+
+    for (probes = 0; probes < SAM_LOG_MAX_FORMATS; probes++) {
+        if (log->format[i] == fmt) {
+            return i;
+        }
+        if (!log->format[i]) {
+            log->format[i] = fmt;
+            return i;
+        }
+        i = (i + 1) % SAM_LOG_MAX_FORMATS;
+    }
+    return LOG_NO_FORMAT;
+}
+
+/* 'F' id length text, the first time a file sees a format, then 'R' record. */
+static void write_binary(LOG_T *log, const char *fmt, SAM_LOG_RECORD_T *record) {
+    uint32_t id = format_id(log, fmt);
+    size_t len = strlen(fmt);
+    size_t need = 1 + sizeof (SAM_LOG_RECORD_T);
+    uint16_t len16;
+
+    if (len > 0xffff) {
+        len = 0xffff;
+    }
+    if (id != LOG_NO_FORMAT && !log->written[id]) {
+        need += 1 + 4 + 2 + len;
+    }
+    if (log->file_size + need > log->config.max_file_size && log->file_size > 8) {
+        rotate(log);
+    }
+    if (!log->file) {
+        return;
+    }
+    if (id != LOG_NO_FORMAT && !log->written[id]) {
+        len16 = (uint16_t) len;
+        fputc('F', log->file);
+        fwrite(&id, 4, 1, log->file);
+        fwrite(&len16, 2, 1, log->file);
+        fwrite(fmt, 1, len, log->file);
+        log->written[id] = 1;
+        log->file_size += 1 + 4 + 2 + len;
+    }
+    record->fmt_id = id;
+    fputc('R', log->file);
+    fwrite(record, sizeof (SAM_LOG_RECORD_T), 1, log->file);
+    log->file_size += 1 + sizeof (SAM_LOG_RECORD_T);
+}
+
+/* Writes everything queued, oldest first across the rings. */
+static void drain(LOG_T *log) {
+    uint32_t count = __atomic_load_n(&log->ring_count, __ATOMIC_ACQUIRE);
+    uint32_t tail[SAM_LOG_MAX_THREADS];
+    LOG_RING_T *ring, *oldest;
+    SAM_LOG_RECORD_T *record;
+    const char *fmt;
+    uint32_t i, slot;
+    int wrote = 0;
+
+    if (count > SAM_LOG_MAX_THREADS) {
+        count = SAM_LOG_MAX_THREADS;
+    }
+    for (i = 0; i < count; i++) {
+        tail[i] = __atomic_load_n(&log->ring[i].tail, __ATOMIC_ACQUIRE);
+    }
+    for (;;) {
+        oldest = NULL;
+        for (i = 0; i < count; i++) {
+            ring = &log->ring[i];
+            if (ring->head != tail[i] && (!oldest
+                    || ring->record[ring->head & (SAM_LOG_RING_SIZE - 1)].time_ns
+                    < oldest->record[oldest->head & (SAM_LOG_RING_SIZE - 1)].time_ns)) {
+                oldest = ring;
+            }
+        }
+        if (!oldest) {
+            break;
+        }
+        slot = oldest->head & (SAM_LOG_RING_SIZE - 1);
+        record = &oldest->record[slot];
+        fmt = oldest->fmt[slot];
+        if (log->config.path) {
+            write_binary(log, fmt, record);
+        } else {
+            print_record(stderr, fmt, record);
+        }
+        __atomic_store_n(&oldest->head, oldest->head + 1, __ATOMIC_RELEASE);
+        wrote = 1;
+    }
+    if (wrote) {
+        fflush(log->file ? log->file : stderr);
+    }
+}
+
+static void *log_thread(void *arg) {
+    LOG_T *log = (LOG_T *) arg;
+
+    while (!__atomic_load_n(&log->stop, __ATOMIC_ACQUIRE)) {
+        futex_wait(&log->stop, 0, SAM_LOG_FLUSH_MS);
+        drain(log);
+    }
+    drain(log);
+    return NULL;
+}
+
+int sam_log_start(const SAM_LOG_CONFIG_T *config) {
+    LOG_T *log = &log_state;
+
+    if (log->running) {
+        printf("Error: sam_log: already started\n");
+        return -1;
+    }
+    log->config = *config;
+    if (log->config.max_files < 1) {
+        log->config.max_files = 1;
+    }
+    sam_log_level = config->level;
+    log_rate = config->rate_per_sec;
+    log->stop = 0;
+    memset(log->format, 0, sizeof (log->format));
+    if (log->config.path && open_file(log) != 0) {
+        return -1;
+    }
+    if (pthread_create(&log->thread, NULL, log_thread, log) != 0) {
+        printf("Error: sam_log: unable to start the log thread\n");
+        if (log->file) {
+            fclose(log->file);
+            log->file = NULL;
+        }
+        return -1;
+    }
+    __atomic_store_n(&log->running, 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+void sam_log_stop(void) {
+    LOG_T *log = &log_state;
+
+    if (!log->running) {
+        return;
+    }
+    // later calls print directly; the thread writes what was queued before
+    __atomic_store_n(&log->running, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&log->stop, 1, __ATOMIC_RELEASE);
+    futex_wake(&log->stop);
+    pthread_join(log->thread, NULL);
+    if (log->file) {
+        fclose(log->file);
+        log->file = NULL;
+    }
+}
+
+void sam_log_get_stats(SAM_LOG_STATS_T *stats) {
+    stats->records = __atomic_load_n(&log_state.stats.records, __ATOMIC_RELAXED);
+    stats->suppressed = __atomic_load_n(&log_state.stats.suppressed, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&log_state.stats.dropped, __ATOMIC_RELAXED);
+    stats->rotations = log_state.stats.rotations;
+}
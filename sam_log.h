@@ -0,0 +1,105 @@
+/*
+ * File:   sam_log.h
+ * Author: Hassan
+ *
+ * Logging that keeps console I/O off the frame loop. SAM_LOG captures the
+ * format pointer and the arguments into a fixed-size record on the calling
+ * thread's own SPSC ring, nothing else; a background thread formats the
+ * records and writes them to stderr, or as binary to a file that rotates at
+ * max_file_size (path, path.1 ... path.N-1). sam_logdump turns the binary
+ * files back into text.
+ *
+ * Every call site is rate limited to rate_per_sec records a second, the
+ * next record that gets through says how many were dropped. A full ring
+ * drops the record and counts it. Before sam_log_start, and after
+ * sam_log_stop, records are printed straight to stderr.
+ *
+ * Formats take numeric conversions and at most one %s, which is copied and
+ * cut to SAM_LOG_TEXT_SIZE - 1 characters.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef SAM_LOG_H
+#define SAM_LOG_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SAM_LOG_MAX_THREADS 16
+#define SAM_LOG_RING_SIZE 256 // records per thread, power of two
+#define SAM_LOG_MAX_ARGS 6
+#define SAM_LOG_TEXT_SIZE 24
+#define SAM_LOG_RATE 5 // records per second per call site
+#define SAM_LOG_FLUSH_MS 20 // how often the log thread looks at the rings
+#define SAM_LOG_MAX_FORMATS 512 // distinct formats a binary log can name
+#define SAM_LOG_MAGIC "SAMLOG1\n"
+
+typedef enum {
+    SAM_LOG_ERROR = 0,
+    SAM_LOG_WARN,
+    SAM_LOG_INFO,
+    SAM_LOG_DEBUG
+} SAM_LOG_LEVEL_T;
+
+typedef struct {
+    SAM_LOG_LEVEL_T level; // records above it are dropped at the call
+    const char *path; // NULL: text to stderr
+    size_t max_file_size;
+    int max_files;
+    int rate_per_sec; // per call site, 0 for no limit
+} SAM_LOG_CONFIG_T;
+
+typedef struct {
+    uint64_t window; // second the count is for
+    uint32_t count;
+    uint32_t suppressed;
+} SAM_LOG_SITE_T;
+
+/* A record as it is queued, and as it is stored in a binary log with fmt replaced by an id. */
+typedef struct {
+    uint64_t time_ns; // CLOCK_MONOTONIC
+    int64_t arg[SAM_LOG_MAX_ARGS]; // doubles stored bit for bit
+    uint32_t suppressed; // records of the same site dropped before this one
+    uint32_t fmt_id; // binary log only
+    uint8_t level;
+    uint8_t thread;
+    uint8_t nargs;
+    uint8_t doubles; // bit i: arg[i] is a double
+    char text[SAM_LOG_TEXT_SIZE]; // the %s argument
+} SAM_LOG_RECORD_T;
+
+typedef struct {
+    uint32_t records;
+    uint32_t suppressed; // by the rate limit
+    uint32_t dropped; // full rings, or no ring left for a thread
+    uint32_t rotations;
+} SAM_LOG_STATS_T;
+
+extern int sam_log_level;
+
+#define SAM_LOG(level, ...) do { \
+        static SAM_LOG_SITE_T sam_log_site_; \
+        if ((level) <= sam_log_level) { \
+            sam_log_write((level), &sam_log_site_, __VA_ARGS__); \
+        } \
+    } while (0)
+
+void sam_log_config_default(SAM_LOG_CONFIG_T *config);
+
+/* Starts the log thread; the calls before it printed synchronously. */
+int sam_log_start(const SAM_LOG_CONFIG_T *config);
+
+/* Writes out whatever is queued and stops the thread. */
+void sam_log_stop(void);
+
+void sam_log_write(int level, SAM_LOG_SITE_T *site, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+void sam_log_get_stats(SAM_LOG_STATS_T *stats);
+
+/* The text line for a record, without the newline; shared with sam_logdump. */
+int sam_log_format(char *buf, size_t size, const char *fmt, const SAM_LOG_RECORD_T *record);
+
+const char *sam_log_level_name(int level);
+
+#endif /* SAM_LOG_H */
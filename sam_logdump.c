@@ -0,0 +1,88 @@
+/*
+ * File:   sam_logdump.c
+ * Author: Hassan
+ *
+ * Turns binary logs written by sam_log back into the text lines the stderr
+ * sink prints. Each file carries the formats it uses, so rotated files
+ * decode on their own; give them oldest first for one timeline:
+ *
+ *   sam_logdump sam.log.3 sam.log.2 sam.log.1 sam.log
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sam_log.h"
+
+static int dump(const char *path) {
+    FILE *f = fopen(path, "rb");
+    char *format[SAM_LOG_MAX_FORMATS];
+    char magic[8], line[512];
+    SAM_LOG_RECORD_T record;
+    uint32_t id;
+    uint16_t len;
+    int type, i, result = 0;
+
+    if (!f) {
+        printf("Error: unable to open %s\n", path);
+        return -1;
+    }
+    memset(format, 0, sizeof (format));
+    if (fread(magic, 1, 8, f) != 8 || memcmp(magic, SAM_LOG_MAGIC, 8) != 0) {
+        printf("Error: %s is not a SAM binary log\n", path);
+        fclose(f);
+        return -1;
+    }
+    while ((type = fgetc(f)) != EOF) {
+        if (type == 'F') {
+            if (fread(&id, 4, 1, f) != 1 || fread(&len, 2, 1, f) != 1 || id >= SAM_LOG_MAX_FORMATS) {
+                result = -1;
+                break;
+            }
+            free(format[id]);
+            format[id] = (char *) malloc(len + 1);
+            if (!format[id] || fread(format[id], 1, len, f) != len) {
+                result = -1;
+                break;
+            }
+            format[id][len] = 0;
+        } else if (type == 'R') {
+            if (fread(&record, sizeof (record), 1, f) != 1) {
+                result = -1;
+                break;
+            }
+            sam_log_format(line, sizeof (line), record.fmt_id < SAM_LOG_MAX_FORMATS ? format[record.fmt_id] : NULL, &record);
+            printf("%s\n", line);
+        } else {
+            result = -1;
+            break;
+        }
+    }
+    if (result != 0) {
+        // the last record of a log cut off by a crash or a full disk
+        printf("Error: %s: truncated or corrupt after %ld bytes\n", path, ftell(f));
+    }
+    for (i = 0; i < SAM_LOG_MAX_FORMATS; i++) {
+        free(format[i]);
+    }
+    fclose(f);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    int i, result = 0;
+
+    if (argc < 2) {
+        printf("usage: sam_logdump log [log ...]\n");
+        return 1;
+    }
+    for (i = 1; i < argc; i++) {
+        if (dump(argv[i]) != 0) {
+            result = 1;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,38 @@
+/*
+ * File:   sam_outputs.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include "sam_outputs.h"
+
+GPIO_OUTPUT_T *sam_outputs_open(const char *spec) {
+    int pins[2] = {SAM_PIN_BUZZ, SAM_PIN_FACE};
+
+    return gpio_output_open(spec, pins, 2);
+}
+
+void sam_outputs_write(GPIO_OUTPUT_T *output, const SAM_OUTPUTS_T *outputs, int buzzing) {
+    uint32_t buzz = gpio_output_bit(SAM_PIN_BUZZ);
+    uint32_t face = gpio_output_bit(SAM_PIN_FACE);
+
+    gpio_output_update(output, (outputs->buzz || buzzing ? buzz : 0) | (outputs->face_led ? face : 0), buzz | face);
+}
+
+void sam_outputs_frame(const SAM_OUTPUT_PINS_T *pins, const SAM_OUTPUTS_T *outputs, int buzzing) {
+    if (pins->output) {
+        sam_outputs_write(pins->output, outputs, buzzing);
+    } else {
+        pins->write_pin(SAM_PIN_FACE, outputs->face_led);
+        pins->write_pin(SAM_PIN_BUZZ, outputs->buzz || buzzing);
+    }
+}
+
+void sam_outputs_buzz(const SAM_OUTPUT_PINS_T *pins) {
+    if (pins->output) {
+        gpio_output_set(pins->output, SAM_PIN_BUZZ, 1);
+    } else {
+        pins->write_pin(SAM_PIN_BUZZ, 1);
+    }
+}
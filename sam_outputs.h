@@ -0,0 +1,42 @@
+/*
+ * File:   sam_outputs.h
+ * Author: Hassan
+ *
+ * SAM's output pins on top of gpio_output: the face LED and the buzzer go
+ * out together, and only when one of them changes. Without gpio_output
+ * they go out through wiringPi instead, every frame.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef SAM_OUTPUTS_H
+#define SAM_OUTPUTS_H
+
+#include "gpio_output.h"
+#include "sam_alert.h"
+
+/* wiringPi pins */
+#define SAM_PIN_BUZZ 0
+#define SAM_PIN_FACE 7
+
+typedef void (*SAM_PIN_WRITE_T)(int pin, int value); // wiringPi's digitalWrite
+
+/* A program's outputs: gpio_output, or the pins one by one. */
+typedef struct {
+    GPIO_OUTPUT_T *output; // NULL: write_pin
+    SAM_PIN_WRITE_T write_pin;
+} SAM_OUTPUT_PINS_T;
+
+/* "gpiomem" or "fake", with the SAM output pins. */
+GPIO_OUTPUT_T *sam_outputs_open(const char *spec);
+
+/* One frame's outputs; buzzing keeps the buzzer on whatever the frame says. */
+void sam_outputs_write(GPIO_OUTPUT_T *output, const SAM_OUTPUTS_T *outputs, int buzzing);
+
+/* As sam_outputs_write, to whichever pins has. */
+void sam_outputs_frame(const SAM_OUTPUT_PINS_T *pins, const SAM_OUTPUTS_T *outputs, int buzzing);
+
+/* The buzzer on now, for the alert timer; the next frame's outputs take over. */
+void sam_outputs_buzz(const SAM_OUTPUT_PINS_T *pins);
+
+#endif /* SAM_OUTPUTS_H */
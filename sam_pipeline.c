@@ -0,0 +1,261 @@
+/*
+ * File:   sam_pipeline.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sam_pipeline.h"
+#include "sys_util.h"
+
+static const char *stage_names[SAM_STAGE_COUNT] = {"prepare", "face", "eyes", "output"};
+
+static void account(SAM_PIPELINE_STAGE_STATS_T *stats, uint64_t waited, uint64_t worked) {
+    __atomic_add_fetch(&stats->wait_ns, waited, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->busy_ns, worked, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&stats->frames, 1, __ATOMIC_RELAXED);
+}
+
+/* Detector coordinates fit 16 bits; w and h are never 0 in a published box. */
+static uint64_t pack_box(const CvRect *r) {
+    return (uint64_t) (uint16_t) r->x | (uint64_t) (uint16_t) r->y << 16
+            | (uint64_t) (uint16_t) r->width << 32 | (uint64_t) (uint16_t) r->height << 48;
+}
+
+static CvRect unpack_box(uint64_t v) {
+    return cvRect((int16_t) (v & 0xffff), (int16_t) (v >> 16 & 0xffff), (int16_t) (v >> 32 & 0xffff), (int16_t) (v >> 48 & 0xffff));
+}
+
+/* Alert clock in ms: the timer wheel's CLOCK_MONOTONIC, or the recording's own. */
+static uint64_t frame_clock(const SAM_PIPELINE_T *pipeline, const FRAME_T *frame) {
+    if (pipeline->pts_clock && frame->pts != FRAME_PTS_UNKNOWN) {
+        return (uint64_t) (frame->pts / 1000);
+    }
+    return timer_wheel_now_ms();
+}
+
+static void *prepare_stage(void *arg) {
+    SAM_PIPELINE_T *pipeline = (SAM_PIPELINE_T *) arg;
+    SAM_PIPELINE_SLOT_T *slot = NULL;
+    FRAME_T *frame;
+    uint64_t t0, t1, t2;
+    int status;
+
+    for (;;) {
+        t0 = now_ns();
+        if (!slot) {
+            slot = (SAM_PIPELINE_SLOT_T *) spsc_queue_pop(&pipeline->free_slots);
+        }
+        if (__atomic_load_n(&pipeline->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        status = frame_source_acquire(pipeline->source, &frame, SAM_PIPELINE_ACQUIRE_TIMEOUT);
+        if (status < 0) {
+            break;
+        }
+        if (status == 0) {
+            continue;
+        }
+        t1 = now_ns();
+        slot->seq = frame->seq;
+        slot->pts = frame->pts;
+        slot->now = frame_clock(pipeline, frame);
+        sam_detector_prepare_in(pipeline->detector, &slot->work, frame);
+        frame_source_release(pipeline->source, frame);
+        t2 = now_ns();
+        account(&pipeline->stats[SAM_STAGE_PREPARE], t1 - t0, t2 - t1);
+        spsc_queue_push(&pipeline->queue[SAM_STAGE_FACE], slot);
+        slot = NULL;
+    }
+    // end of stream, the NULL drains the stages behind us
+    spsc_queue_push(&pipeline->queue[SAM_STAGE_FACE], NULL);
+    return NULL;
+}
+
+static void *face_stage(void *arg) {
+    SAM_PIPELINE_T *pipeline = (SAM_PIPELINE_T *) arg;
+    SAM_PIPELINE_SLOT_T *slot;
+    uint64_t applied = 0, box;
+    uint64_t t0, t1;
+
+    for (;;) {
+        t0 = now_ns();
+        slot = (SAM_PIPELINE_SLOT_T *) spsc_queue_pop(&pipeline->queue[SAM_STAGE_FACE]);
+        if (!slot) {
+            break;
+        }
+        t1 = now_ns();
+        box = __atomic_load_n(&pipeline->search_box, __ATOMIC_ACQUIRE);
+        if (box != applied) {
+            CvRect r = unpack_box(box);
+
+            sam_detector_set_search_box(pipeline->detector, box ? &r : NULL);
+            applied = box;
+        }
+        slot->face = cvRect(0, 0, 0, 0);
+        slot->face_found = sam_detector_track_face_in(pipeline->detector, &slot->work, &slot->face);
+        account(&pipeline->stats[SAM_STAGE_FACE], t1 - t0, now_ns() - t1);
+        spsc_queue_push(&pipeline->queue[SAM_STAGE_EYES], slot);
+    }
+    spsc_queue_push(&pipeline->queue[SAM_STAGE_EYES], NULL);
+    return NULL;
+}
+
+static void *eyes_stage(void *arg) {
+    SAM_PIPELINE_T *pipeline = (SAM_PIPELINE_T *) arg;
+    SAM_ALERT_T *alert = pipeline->alert;
+    SAM_PIPELINE_SLOT_T *slot;
+    uint64_t t0, t1;
+
+    for (;;) {
+        t0 = now_ns();
+        slot = (SAM_PIPELINE_SLOT_T *) spsc_queue_pop(&pipeline->queue[SAM_STAGE_EYES]);
+        if (!slot) {
+            break;
+        }
+        t1 = now_ns();
+        memset(&slot->inputs, 0, sizeof (slot->inputs));
+        if (pipeline->inputs_cb) {
+            pipeline->inputs_cb(&slot->inputs, pipeline->userdata);
+        }
+        sam_alert_inputs(alert, &slot->inputs);
+        sam_alert_face(alert, slot->face_found, &slot->face, slot->now);
+        slot->eyes_run = sam_alert_begin_eyes(alert, slot->now);
+        if (slot->eyes_run) {
+            sam_alert_eyes(alert, sam_detector_eyes_in(pipeline->detector, &slot->work, &alert->face));
+        }
+        sam_alert_decide(alert, slot->now, &slot->outputs);
+        slot->draw_flag = alert->draw_flag;
+        slot->padding = cvRect(alert->padding_x, alert->padding_y, alert->padding_w, alert->padding_h);
+        slot->out_of_bound = alert->out_of_bound;
+        slot->eyes_detected = alert->eyes_detected;
+        if (alert->draw_flag && pipeline->use_roi && slot->padding.width > 0 && slot->padding.height > 0) {
+            // once calibrated, the face stage looks around the padding box only
+            __atomic_store_n(&pipeline->search_box, pack_box(&slot->padding), __ATOMIC_RELEASE);
+        }
+        account(&pipeline->stats[SAM_STAGE_EYES], t1 - t0, now_ns() - t1);
+        spsc_queue_push(&pipeline->queue[SAM_STAGE_OUTPUT], slot);
+    }
+    spsc_queue_push(&pipeline->queue[SAM_STAGE_OUTPUT], NULL);
+    return NULL;
+}
+
+static void *output_stage(void *arg) {
+    SAM_PIPELINE_T *pipeline = (SAM_PIPELINE_T *) arg;
+    SAM_PIPELINE_SLOT_T *slot;
+    int first = 1;
+    uint64_t t0, t1;
+
+    for (;;) {
+        t0 = now_ns();
+        slot = (SAM_PIPELINE_SLOT_T *) spsc_queue_pop(&pipeline->queue[SAM_STAGE_OUTPUT]);
+        if (!slot) {
+            break;
+        }
+        t1 = now_ns();
+        if (!first && (int32_t) (slot->seq - pipeline->last_seq) <= 0) {
+            pipeline->out_of_order++;
+        }
+        pipeline->last_seq = slot->seq;
+        first = 0;
+        if (pipeline->output_cb) {
+            pipeline->output_cb(slot, pipeline->userdata);
+        }
+        sam_detector_end_frame_in(&slot->work);
+        account(&pipeline->stats[SAM_STAGE_OUTPUT], t1 - t0, now_ns() - t1);
+        spsc_queue_push(&pipeline->free_slots, slot);
+    }
+    pipeline->end_ns = now_ns();
+    return NULL;
+}
+
+int sam_pipeline_init(SAM_PIPELINE_T *pipeline, SAM_DETECTOR_T *detector, SAM_ALERT_T *alert, FRAME_SOURCE_T *source) {
+    int i;
+
+    memset(pipeline, 0, sizeof (SAM_PIPELINE_T));
+    pipeline->detector = detector;
+    pipeline->alert = alert;
+    pipeline->source = source;
+    pipeline->use_roi = 1;
+    spsc_queue_init(&pipeline->free_slots);
+    for (i = 0; i < SAM_STAGE_COUNT; i++) {
+        spsc_queue_init(&pipeline->queue[i]);
+        pipeline->stats[i].name = stage_names[i];
+    }
+    for (i = 0; i < SAM_PIPELINE_SLOTS; i++) {
+        if (sam_detector_frame_init(detector, &pipeline->slot[i].work) != 0) {
+            return -1;
+        }
+        spsc_queue_push(&pipeline->free_slots, &pipeline->slot[i]);
+    }
+    return 0;
+}
+
+void sam_pipeline_destroy(SAM_PIPELINE_T *pipeline) {
+    int i;
+
+    for (i = 0; i < SAM_PIPELINE_SLOTS; i++) {
+        sam_detector_frame_destroy(&pipeline->slot[i].work);
+    }
+}
+
+int sam_pipeline_start(SAM_PIPELINE_T *pipeline) {
+    void *(*stage[SAM_STAGE_COUNT])(void *) = {prepare_stage, face_stage, eyes_stage, output_stage};
+    int i;
+
+    pipeline->start_ns = now_ns();
+    // last stage first, so nothing is queued for a stage that failed to start
+    for (i = SAM_STAGE_COUNT - 1; i >= 0; i--) {
+        if (pthread_create(&pipeline->thread[i], NULL, stage[i], pipeline) != 0) {
+            fprintf(stderr, "Error: unable to start the %s stage\n", stage_names[i]);
+            // the stages already up drain on the NULL
+            if (i < SAM_STAGE_COUNT - 1) {
+                spsc_queue_push(&pipeline->queue[i + 1], NULL);
+            }
+            for (i++; i < SAM_STAGE_COUNT; i++) {
+                pthread_join(pipeline->thread[i], NULL);
+            }
+            return -1;
+        }
+    }
+    pipeline->started = 1;
+    return 0;
+}
+
+void sam_pipeline_stop(SAM_PIPELINE_T *pipeline) {
+    __atomic_store_n(&pipeline->stop, 1, __ATOMIC_RELEASE);
+}
+
+void sam_pipeline_wait(SAM_PIPELINE_T *pipeline) {
+    int i;
+
+    if (!pipeline->started) {
+        return;
+    }
+    for (i = 0; i < SAM_STAGE_COUNT; i++) {
+        pthread_join(pipeline->thread[i], NULL);
+    }
+    pipeline->started = 0;
+}
+
+void sam_pipeline_print_stats(SAM_PIPELINE_T *pipeline, FILE *out) {
+    uint64_t end = pipeline->end_ns ? pipeline->end_ns : now_ns();
+    double elapsed = (end - pipeline->start_ns) / 1000000.0;
+    uint32_t frames = __atomic_load_n(&pipeline->stats[SAM_STAGE_OUTPUT].frames, __ATOMIC_RELAXED);
+    int i;
+
+    fprintf(out, "pipeline: %u frames in %.2f s, %.2f FPS, %u out of order\n",
+            frames, elapsed / 1000.0, elapsed > 0 ? frames * 1000.0 / elapsed : 0.0, pipeline->out_of_order);
+    for (i = 0; i < SAM_STAGE_COUNT; i++) {
+        SAM_PIPELINE_STAGE_STATS_T *s = &pipeline->stats[i];
+        uint32_t n = __atomic_load_n(&s->frames, __ATOMIC_RELAXED);
+        double busy = __atomic_load_n(&s->busy_ns, __ATOMIC_RELAXED) / 1000000.0;
+        double wait = __atomic_load_n(&s->wait_ns, __ATOMIC_RELAXED) / 1000000.0;
+
+        fprintf(out, "  %-8s %5.1f%% busy, %6.2f ms per frame, %6.2f ms waiting per frame\n",
+                s->name, elapsed > 0 ? 100.0 * busy / elapsed : 0.0, n ? busy / n : 0.0, n ? wait / n : 0.0);
+    }
+}
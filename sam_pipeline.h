@@ -0,0 +1,122 @@
+/*
+ * File:   sam_pipeline.h
+ * Author: Hassan
+ *
+ * Runs SAM's per-frame work as four stages on their own threads, so that on a
+ * quad-core Pi up to four frames are worked on at once:
+ *
+ *   prepare  acquire a frame, scale and equalise it, hand the frame back
+ *   face     face detection and tracking
+ *   eyes     inputs, alert logic and eye detection
+ *   output   the caller's output callback (GPIO, overlay), in frame order
+ *
+ * Frames travel through SPSC_QUEUE_Ts in SAM_PIPELINE_SLOT_Ts, each with its
+ * own SAM_DETECTOR_FRAME_T, and come back to prepare through a queue of free
+ * slots; SAM_PIPELINE_SLOTS bounds the frames in flight. Every queue is
+ * first in first out and each stage has one thread, so slots reach the
+ * output stage in sequence order; the output stage checks it and counts any
+ * slip in out_of_order.
+ *
+ * The face stage owns the detector's tracker and search box, the eyes stage
+ * owns the SAM_ALERT_T. The padding box goes back from eyes to face through
+ * one atomic word and takes effect a frame or two later than in the serial
+ * loop.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef SAM_PIPELINE_H
+#define SAM_PIPELINE_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "frame_source.h"
+#include "sam_detector.h"
+#include "sam_alert.h"
+#include "spsc_queue.h"
+
+#define SAM_PIPELINE_SLOTS 4 // frames in flight
+#define SAM_PIPELINE_ACQUIRE_TIMEOUT 100 // ms, how quickly prepare notices sam_pipeline_stop
+
+typedef enum {
+    SAM_STAGE_PREPARE = 0,
+    SAM_STAGE_FACE,
+    SAM_STAGE_EYES,
+    SAM_STAGE_OUTPUT,
+    SAM_STAGE_COUNT
+} SAM_PIPELINE_STAGE_ID_T;
+
+typedef struct {
+    uint32_t seq; // source frame counter
+    int64_t pts;
+    uint64_t now; // alert clock of this frame, ms
+    SAM_INPUTS_T inputs;
+    int face_found;
+    CvRect face;
+    int eyes_run;
+    SAM_OUTPUTS_T outputs;
+    /* alert state after this frame, for the overlay */
+    int draw_flag;
+    CvRect padding;
+    int out_of_bound;
+    int eyes_detected;
+    SAM_DETECTOR_FRAME_T work;
+} SAM_PIPELINE_SLOT_T;
+
+typedef struct {
+    const char *name;
+    uint32_t frames;
+    uint64_t busy_ns; // working on frames
+    uint64_t wait_ns; // waiting for a frame or a slot
+} SAM_PIPELINE_STAGE_STATS_T;
+
+/* eyes thread, right before the alert logic of each frame */
+typedef void (*SAM_PIPELINE_INPUTS_CB_T)(SAM_INPUTS_T *inputs, void *userdata);
+
+/* output thread, once per frame in sequence order */
+typedef void (*SAM_PIPELINE_OUTPUT_CB_T)(const SAM_PIPELINE_SLOT_T *slot, void *userdata);
+
+typedef struct {
+    SAM_DETECTOR_T *detector;
+    SAM_ALERT_T *alert;
+    FRAME_SOURCE_T *source;
+    SAM_PIPELINE_INPUTS_CB_T inputs_cb; // NULL: no inputs
+    SAM_PIPELINE_OUTPUT_CB_T output_cb;
+    void *userdata;
+    int use_roi; // search the padding box once calibrated
+    int pts_clock; // alert timers on the frame timestamps (recordings) instead of CLOCK_MONOTONIC
+
+    SAM_PIPELINE_SLOT_T slot[SAM_PIPELINE_SLOTS];
+    SPSC_QUEUE_T free_slots; // output -> prepare
+    SPSC_QUEUE_T queue[SAM_STAGE_COUNT]; // input of each stage, queue[SAM_STAGE_PREPARE] unused
+    pthread_t thread[SAM_STAGE_COUNT];
+    int started;
+    int stop;
+    uint64_t search_box; // packed padding box, eyes -> face, 0 for none
+    uint32_t last_seq;
+    uint32_t out_of_order;
+    uint64_t start_ns;
+    uint64_t end_ns;
+    SAM_PIPELINE_STAGE_STATS_T stats[SAM_STAGE_COUNT];
+} SAM_PIPELINE_T;
+
+/* Sets up the slots; detector, alert and source stay the caller's. */
+int sam_pipeline_init(SAM_PIPELINE_T *pipeline, SAM_DETECTOR_T *detector, SAM_ALERT_T *alert, FRAME_SOURCE_T *source);
+void sam_pipeline_destroy(SAM_PIPELINE_T *pipeline);
+
+/* Starts the stage threads on a started source. */
+int sam_pipeline_start(SAM_PIPELINE_T *pipeline);
+
+/* Asks prepare to take no more frames; frames in flight still come out. */
+void sam_pipeline_stop(SAM_PIPELINE_T *pipeline);
+
+/* Waits until every stage has finished, at end of stream or after a stop. */
+void sam_pipeline_wait(SAM_PIPELINE_T *pipeline);
+
+/* Frames through, throughput and each stage's utilisation, to out. */
+void sam_pipeline_print_stats(SAM_PIPELINE_T *pipeline, FILE *out);
+
+#endif /* SAM_PIPELINE_H */
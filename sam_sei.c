@@ -0,0 +1,199 @@
+/*
+ * File:   sam_sei.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <string.h>
+
+#include "sam_sei.h"
+#include "h264_writer.h"
+
+#define NAL_SEI 6
+#define SEI_USER_DATA_UNREGISTERED 5
+
+static const uint8_t sam_uuid[16] = {
+    0x5a, 0x3d, 0x9c, 0x41, 0x7e, 0x02, 0x4b, 0x8f, 0xa1, 0x6c, 0x53, 0xd0, 0x2e, 0x94, 0xb7, 0x18
+};
+
+static uint8_t *put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t) v;
+    p[1] = (uint8_t) (v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+    return put16(put16(p, (uint16_t) v), (uint16_t) (v >> 16));
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t) (p[0] | p[1] << 8);
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return get16(p) | (uint32_t) get16(p + 2) << 16;
+}
+
+size_t sam_sei_write(const SAM_SEI_T *sei, uint8_t *out, size_t size) {
+    uint8_t rbsp[3 + 16 + SAM_SEI_PAYLOAD + 1], *p = rbsp;
+    size_t i, n = 0;
+    int zeros = 0;
+
+    if (size < SAM_SEI_NAL_MAX) {
+        return 0;
+    }
+    *p++ = SEI_USER_DATA_UNREGISTERED;
+    *p++ = 16 + SAM_SEI_PAYLOAD;
+    memcpy(p, sam_uuid, 16);
+    p += 16;
+    *p++ = SAM_SEI_VERSION;
+    *p++ = sei->flags;
+    p = put32(p, sei->seq);
+    p = put32(put32(p, (uint32_t) sei->pts), (uint32_t) ((uint64_t) sei->pts >> 32));
+    p = put16(p, sei->width);
+    p = put16(p, sei->height);
+    p = put16(p, sei->face_x);
+    p = put16(p, sei->face_y);
+    p = put16(p, sei->face_width);
+    p = put16(p, sei->face_height);
+    p = put16(p, sei->padding_x);
+    p = put16(p, sei->padding_y);
+    p = put16(p, sei->padding_width);
+    p = put16(p, sei->padding_height);
+    *p++ = 0x80; // rbsp trailing bits
+
+    memcpy(out, "\0\0\0\1", 4);
+    n = 4;
+    out[n++] = NAL_SEI;
+    // no start code inside the NAL unit: 0x03 after two zeros when a byte below 4 follows
+    for (i = 0; i < (size_t) (p - rbsp); i++) {
+        if (zeros == 2 && rbsp[i] <= 3) {
+            out[n++] = 3;
+            zeros = 0;
+        }
+        out[n++] = rbsp[i];
+        zeros = rbsp[i] == 0 ? zeros + 1 : 0;
+    }
+    return n;
+}
+
+int sam_sei_parse(const uint8_t *nal, size_t length, SAM_SEI_T *sei) {
+    uint8_t rbsp[512];
+    const uint8_t *p;
+    size_t i, n = 0, type, payload;
+    int zeros = 0;
+
+    if (length < 2 || (nal[0] & 0x1f) != NAL_SEI) {
+        return 0;
+    }
+    for (i = 1; i < length && n < sizeof (rbsp); i++) {
+        if (zeros == 2 && nal[i] == 3) {
+            zeros = 0;
+            continue;
+        }
+        rbsp[n++] = nal[i];
+        zeros = nal[i] == 0 ? zeros + 1 : 0;
+    }
+    // one or more messages, each with its type and size coded in 255s
+    p = rbsp;
+    while (p < rbsp + n && *p != 0x80) {
+        for (type = 0; p < rbsp + n && *p == 0xff; p++) {
+            type += 255;
+        }
+        type += p < rbsp + n ? *p++ : 0;
+        for (payload = 0; p < rbsp + n && *p == 0xff; p++) {
+            payload += 255;
+        }
+        payload += p < rbsp + n ? *p++ : 0;
+        if (payload > (size_t) (rbsp + n - p)) {
+            return 0;
+        }
+        if (type == SEI_USER_DATA_UNREGISTERED && payload >= 16 + SAM_SEI_PAYLOAD
+                && memcmp(p, sam_uuid, 16) == 0 && p[16] == SAM_SEI_VERSION) {
+            p += 17;
+            sei->flags = p[0];
+            sei->seq = get32(p + 1);
+            sei->pts = (int64_t) (get32(p + 5) | (uint64_t) get32(p + 9) << 32);
+            sei->width = get16(p + 13);
+            sei->height = get16(p + 15);
+            sei->face_x = get16(p + 17);
+            sei->face_y = get16(p + 19);
+            sei->face_width = get16(p + 21);
+            sei->face_height = get16(p + 23);
+            sei->padding_x = get16(p + 25);
+            sei->padding_y = get16(p + 27);
+            sei->padding_width = get16(p + 29);
+            sei->padding_height = get16(p + 31);
+            return 1;
+        }
+        p += payload;
+    }
+    return 0;
+}
+
+void sam_sei_from_slot(const SAM_PIPELINE_SLOT_T *slot, int width, int height, int alarm, SAM_SEI_T *sei) {
+    memset(sei, 0, sizeof (SAM_SEI_T));
+    sei->seq = slot->seq;
+    sei->pts = slot->pts;
+    sei->width = (uint16_t) width;
+    sei->height = (uint16_t) height;
+    if (slot->face_found) {
+        sei->flags |= SAM_SEI_FACE;
+        sei->face_x = (uint16_t) slot->face.x;
+        sei->face_y = (uint16_t) slot->face.y;
+        sei->face_width = (uint16_t) slot->face.width;
+        sei->face_height = (uint16_t) slot->face.height;
+    }
+    if (slot->draw_flag) {
+        sei->flags |= SAM_SEI_PADDING;
+        sei->padding_x = (uint16_t) slot->padding.x;
+        sei->padding_y = (uint16_t) slot->padding.y;
+        sei->padding_width = (uint16_t) slot->padding.width;
+        sei->padding_height = (uint16_t) slot->padding.height;
+    }
+    sei->flags |= slot->out_of_bound ? SAM_SEI_OUT_OF_BOUND : 0;
+    sei->flags |= slot->eyes_run ? SAM_SEI_EYES_RUN : 0;
+    sei->flags |= slot->eyes_detected ? SAM_SEI_EYES : 0;
+    sei->flags |= slot->outputs.buzz ? SAM_SEI_BUZZ : 0;
+    sei->flags |= alarm ? SAM_SEI_ALARM : 0;
+}
+
+void sam_sei_latest_init(SAM_SEI_LATEST_T *latest) {
+    memset(latest, 0, sizeof (SAM_SEI_LATEST_T));
+    pthread_mutex_init(&latest->lock, NULL);
+    latest->picture_start = 1;
+}
+
+void sam_sei_latest_destroy(SAM_SEI_LATEST_T *latest) {
+    pthread_mutex_destroy(&latest->lock);
+}
+
+void sam_sei_publish(SAM_SEI_LATEST_T *latest, const SAM_SEI_T *sei) {
+    pthread_mutex_lock(&latest->lock);
+    latest->sei = *sei;
+    latest->fresh = 1;
+    pthread_mutex_unlock(&latest->lock);
+}
+
+size_t sam_sei_take(SAM_SEI_LATEST_T *latest, uint8_t *out, size_t size) {
+    SAM_SEI_T sei;
+    int fresh;
+
+    pthread_mutex_lock(&latest->lock);
+    sei = latest->sei;
+    fresh = latest->fresh;
+    latest->fresh = 0;
+    pthread_mutex_unlock(&latest->lock);
+    return fresh ? sam_sei_write(&sei, out, size) : 0;
+}
+
+size_t sam_sei_take_before(SAM_SEI_LATEST_T *latest, int flags, uint8_t *out, size_t size) {
+    size_t n = 0;
+
+    if (latest->picture_start && !(flags & H264_WRITER_CONFIG)) {
+        n = sam_sei_take(latest, out, size);
+    }
+    latest->picture_start = (flags & (H264_WRITER_FRAME_END | H264_WRITER_CONFIG)) != 0;
+    return n;
+}
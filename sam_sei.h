@@ -0,0 +1,81 @@
+/*
+ * File:   sam_sei.h
+ * Author: Hassan
+ *
+ * The detection state of a frame carried in the H.264 stream itself, as a
+ * user data unregistered SEI NAL unit ahead of a picture's slices. The
+ * payload is the SAM UUID and SAM_SEI_PAYLOAD bytes, little endian, with
+ * the pts and sequence number of the frame the detector looked at: the
+ * detector runs a few frames behind the encoder, and the pts is what ties
+ * the state to its picture. A state goes into the stream once, with the
+ * next picture after it was published; decoders skip the NAL unit.
+ *
+ * The output stage publishes a pipeline slot's state, the encoder's
+ * callback thread takes it ahead of the next picture. sam_seidump prints
+ * the states back out of a recording.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef SAM_SEI_H
+#define SAM_SEI_H
+
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sam_pipeline.h"
+
+#define SAM_SEI_VERSION 1
+#define SAM_SEI_PAYLOAD 34 // bytes after the UUID
+#define SAM_SEI_NAL_MAX 96 // start code, NAL header, emulation prevention and all
+
+/* flags */
+#define SAM_SEI_FACE 1
+#define SAM_SEI_PADDING 2 // the padding box is drawn
+#define SAM_SEI_OUT_OF_BOUND 4
+#define SAM_SEI_EYES_RUN 8
+#define SAM_SEI_EYES 16 // eyes detected
+#define SAM_SEI_BUZZ 32 // this frame's output
+#define SAM_SEI_ALARM 64 // the alert timer has sounded the buzzer
+
+typedef struct {
+    uint32_t seq; // source frame counter
+    int64_t pts; // of the frame, microseconds
+    uint16_t width, height; // of the detection frame, the boxes are in its pixels
+    uint16_t face_x, face_y, face_width, face_height;
+    uint16_t padding_x, padding_y, padding_width, padding_height;
+    uint8_t flags;
+} SAM_SEI_T;
+
+typedef struct {
+    pthread_mutex_t lock;
+    SAM_SEI_T sei;
+    int fresh; // not in the stream yet
+    int picture_start; // taker: the next encoder buffer starts a picture
+} SAM_SEI_LATEST_T;
+
+/* The SEI NAL unit with a 4 byte start code; its length, 0 when size is too small. */
+size_t sam_sei_write(const SAM_SEI_T *sei, uint8_t *out, size_t size);
+
+/* An SEI NAL unit without its start code; 1 when it carried a SAM state, 0 otherwise. */
+int sam_sei_parse(const uint8_t *nal, size_t length, SAM_SEI_T *sei);
+
+/* What the detector made of a slot, boxes in width x height detection frame pixels; alarm as sam_alert_buzzing. */
+void sam_sei_from_slot(const SAM_PIPELINE_SLOT_T *slot, int width, int height, int alarm, SAM_SEI_T *sei);
+
+void sam_sei_latest_init(SAM_SEI_LATEST_T *latest);
+void sam_sei_latest_destroy(SAM_SEI_LATEST_T *latest);
+void sam_sei_publish(SAM_SEI_LATEST_T *latest, const SAM_SEI_T *sei);
+
+/* The NAL unit for a state published since the last call, as sam_sei_write; 0 when there is none. */
+size_t sam_sei_take(SAM_SEI_LATEST_T *latest, uint8_t *out, size_t size);
+
+/*
+ * The NAL unit to push ahead of an encoder buffer with h264_writer flags,
+ * as sam_sei_take, but only before the first buffer of a picture and after
+ * its SPS/PPS. One thread only, the encoder's callback.
+ */
+size_t sam_sei_take_before(SAM_SEI_LATEST_T *latest, int flags, uint8_t *out, size_t size);
+
+#endif /* SAM_SEI_H */
@@ -0,0 +1,450 @@
+/*
+ * File:   sam_seidump.c
+ * Author: Hassan
+ *
+ * Prints the detection states SAM_demo put into its recordings, one line
+ * per frame the detector finished, from raw H.264 (event clips, video_record
+ * to stdout) or from the fragmented MP4 segments h264_writer makes:
+ *
+ *   sam_seidump event-0003-20261017-101500.h264
+ *   sam_seidump rec-0000.mp4 rec-0001.mp4
+ *
+ * Only SEI NAL units are looked at; MP4 boxes other than mdat are skipped
+ * with a seek.
+ *
+ * sam_seidump --selftest checks the byte formats the recordings are made
+ * of, without a camera: SEI states written and parsed back, emulation
+ * prevention included, and a synthetic stream through mp4_mux with every
+ * box, offset and decode time of the output walked. It exits non-zero on
+ * the first mismatch.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sam_sei.h"
+#include "mp4_mux.h"
+
+#define READ_SIZE (1 << 20)
+#define NAL_SEI 6
+#define SELFTEST_SEI_ROUNDS 2000
+#define SELFTEST_FRAMES 95 // a few GOPs and a picture after the last IDR
+#define SELFTEST_GOP 30
+#define SELFTEST_SLICE 3000 // bytes
+#define SELFTEST_FRAGMENT_MAX (MP4_MUX_HEADER_SIZE + SAM_SEI_NAL_MAX + SELFTEST_SLICE + 16)
+
+/* an SPS for 1280x720 baseline, and one for 1920x1080 high with the 4:2:0 extension in avcC */
+static const uint8_t selftest_sps_baseline[] = {0x67, 0x42, 0xc0, 0x1f, 0xda, 0x01, 0x40, 0x16, 0xe4};
+static const uint8_t selftest_sps_high[] = {0x67, 0x64, 0x00, 0x28, 0xad, 0xff, 0xff, 0x80, 0xe5, 0x01, 0xe0, 0x08, 0x9f, 0x95};
+static const uint8_t selftest_pps[] = {0x68, 0xce, 0x3c, 0x80};
+
+typedef struct {
+    uint8_t *data; // SELFTEST_FRAMES fragments of SELFTEST_FRAGMENT_MAX
+    uint32_t length[SELFTEST_FRAMES];
+    int key[SELFTEST_FRAMES];
+    int64_t pts[SELFTEST_FRAMES];
+    int count;
+    int overflow;
+} SELFTEST_OUT_T;
+
+static void print_sei(const SAM_SEI_T *s) {
+    printf("pts %lld seq %u face %s %u,%u %ux%u padding %s %u,%u %ux%u out_of_bound %d eyes %s buzz %d alarm %d\n",
+            (long long) s->pts, s->seq, s->flags & SAM_SEI_FACE ? "yes" : "no",
+            s->face_x, s->face_y, s->face_width, s->face_height, s->flags & SAM_SEI_PADDING ? "yes" : "no",
+            s->padding_x, s->padding_y, s->padding_width, s->padding_height, (s->flags & SAM_SEI_OUT_OF_BOUND) != 0,
+            !(s->flags & SAM_SEI_EYES_RUN) ? "-" : s->flags & SAM_SEI_EYES ? "yes" : "no",
+            (s->flags & SAM_SEI_BUZZ) != 0, (s->flags & SAM_SEI_ALARM) != 0);
+}
+
+static int check_nal(const uint8_t *nal, size_t length) {
+    SAM_SEI_T sei;
+
+    if (length > 0 && (nal[0] & 0x1f) == NAL_SEI && sam_sei_parse(nal, length, &sei)) {
+        print_sei(&sei);
+        return 1;
+    }
+    return 0;
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | p[3];
+}
+
+/* Start codes in a window read ahead; a NAL unit is looked at once the next start code is in. */
+static int dump_annexb(FILE *f, uint8_t *buf, int *count) {
+    size_t have = 0, n, i, nal = 0;
+    int in_nal = 0;
+
+    while ((n = fread(buf + have, 1, READ_SIZE - have, f)) > 0 || have > 0) {
+        have += n;
+        for (i = nal; i + 3 <= have; i++) {
+            if (buf[i] == 0 && buf[i + 1] == 0 && buf[i + 2] == 1) {
+                if (in_nal) {
+                    *count += check_nal(buf + nal, i - nal);
+                }
+                nal = i + 3;
+                in_nal = 1;
+                i += 2;
+            }
+        }
+        if (n == 0) {
+            // the last one runs to the end of the file
+            if (in_nal) {
+                *count += check_nal(buf + nal, have - nal);
+            }
+            break;
+        }
+        if (!in_nal || nal == 0) {
+            // a NAL unit longer than the window is a picture, not an SEI: keep only what may start a code
+            nal = have >= 2 ? have - 2 : 0;
+            in_nal = 0;
+        }
+        memmove(buf, buf + nal, have - nal);
+        have -= nal;
+        nal = 0;
+    }
+    return ferror(f) ? -1 : 0;
+}
+
+/* Top level boxes; in each mdat, NAL units with 4 byte lengths. */
+static int dump_mp4(FILE *f, uint8_t *buf, int *count) {
+    uint8_t header[8];
+    uint32_t size, n, at;
+
+    while (fread(header, 1, 8, f) == 8) {
+        size = get32(header);
+        if (size < 8) {
+            return -1;
+        }
+        size -= 8;
+        if (memcmp(header + 4, "mdat", 4) != 0 || size > READ_SIZE) {
+            if (fseek(f, size, SEEK_CUR) != 0) {
+                return -1;
+            }
+            continue;
+        }
+        if (fread(buf, 1, size, f) != size) {
+            return -1;
+        }
+        for (at = 0; at + 4 <= size; at += 4 + n) {
+            n = get32(buf + at);
+            if (n > size - at - 4) {
+                return -1;
+            }
+            *count += check_nal(buf + at + 4, n);
+        }
+    }
+    return 0;
+}
+
+static uint64_t get64(const uint8_t *p) {
+    return (uint64_t) get32(p) << 32 | get32(p + 4);
+}
+
+static uint32_t selftest_random(uint32_t *seed) {
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 8;
+}
+
+/* zeros and small values most of all, they are what emulation prevention is for */
+static uint16_t selftest_value(uint32_t *seed) {
+    uint32_t r = selftest_random(seed);
+
+    switch (r % 5) {
+        case 0:
+            return 0;
+        case 1:
+            return (uint16_t) (r >> 8) % 4;
+        case 2:
+            return 0xffff;
+        default:
+            return (uint16_t) (r >> 8);
+    }
+}
+
+static int same_sei(const SAM_SEI_T *a, const SAM_SEI_T *b) {
+    return a->seq == b->seq && a->pts == b->pts && a->width == b->width && a->height == b->height
+            && a->face_x == b->face_x && a->face_y == b->face_y && a->face_width == b->face_width
+            && a->face_height == b->face_height && a->padding_x == b->padding_x && a->padding_y == b->padding_y
+            && a->padding_width == b->padding_width && a->padding_height == b->padding_height && a->flags == b->flags;
+}
+
+static int selftest_sei(void) {
+    uint8_t nal[SAM_SEI_NAL_MAX];
+    SAM_SEI_T in, out;
+    uint32_t seed = 1;
+    size_t n, i;
+    int round;
+
+    for (round = 0; round < SELFTEST_SEI_ROUNDS; round++) {
+        memset(&in, 0, sizeof (in));
+        in.seq = (uint32_t) selftest_value(&seed) << 16 | selftest_value(&seed);
+        in.pts = (int64_t) ((uint64_t) selftest_value(&seed) << 48 | (uint64_t) selftest_value(&seed) << 16 | selftest_value(&seed));
+        in.width = selftest_value(&seed);
+        in.height = selftest_value(&seed);
+        in.face_x = selftest_value(&seed);
+        in.face_y = selftest_value(&seed);
+        in.face_width = selftest_value(&seed);
+        in.face_height = selftest_value(&seed);
+        in.padding_x = selftest_value(&seed);
+        in.padding_y = selftest_value(&seed);
+        in.padding_width = selftest_value(&seed);
+        in.padding_height = selftest_value(&seed);
+        in.flags = (uint8_t) selftest_value(&seed) & 0x7f;
+
+        n = sam_sei_write(&in, nal, sizeof (nal));
+        if (n < 5 || n > SAM_SEI_NAL_MAX || memcmp(nal, "\0\0\0\1", 4) != 0) {
+            printf("Error: selftest: SEI %d written as %zu bytes\n", round, n);
+            return -1;
+        }
+        // 00 00 03 is the escape itself, anything lower would end the NAL unit early
+        for (i = 4; i + 3 <= n; i++) {
+            if (nal[i] == 0 && nal[i + 1] == 0 && nal[i + 2] < 3) {
+                printf("Error: selftest: SEI %d has 00 00 %02x at byte %zu\n", round, nal[i + 2], i);
+                return -1;
+            }
+        }
+        if (!sam_sei_parse(nal + 4, n - 4, &out) || !same_sei(&in, &out)) {
+            printf("Error: selftest: SEI %d did not parse back to what was written\n", round);
+            return -1;
+        }
+        // cut short, it must not be taken for a state
+        if (sam_sei_parse(nal + 4, n - 12, &out)) {
+            printf("Error: selftest: SEI %d parsed without its last bytes\n", round);
+            return -1;
+        }
+    }
+    printf("selftest: %d SEI round trips\n", SELFTEST_SEI_ROUNDS);
+    return 0;
+}
+
+static void selftest_emit(const uint8_t *data, size_t length, int key, int64_t pts, void *arg) {
+    SELFTEST_OUT_T *out = (SELFTEST_OUT_T *) arg;
+
+    if (out->count == SELFTEST_FRAMES || length > SELFTEST_FRAGMENT_MAX) {
+        out->overflow = 1;
+        return;
+    }
+    memcpy(out->data + (size_t) out->count * SELFTEST_FRAGMENT_MAX, data, length);
+    out->length[out->count] = (uint32_t) length;
+    out->key[out->count] = key;
+    out->pts[out->count] = pts;
+    out->count++;
+}
+
+/* The pts of frame i; every seventh has none, as the encoder sometimes does. */
+static int64_t selftest_pts(int i) {
+    return i % 7 == 3 ? MP4_MUX_PTS_UNKNOWN : 1000000 + (int64_t) i * 33333 + i % 5;
+}
+
+/* ftyp and moov, the picture size in tkhd and the SPS and PPS in avcC. */
+static int selftest_init(const MP4_MUX_T *mux, const uint8_t *sps, size_t sps_length, int width, int height) {
+    const uint8_t *init = mux->init, *p;
+    uint32_t ftyp = get32(init), moov;
+
+    if (ftyp < 8 || ftyp + 8 > mux->init_length || memcmp(init + 4, "ftyp", 4) != 0) {
+        printf("Error: selftest: init segment does not start with ftyp\n");
+        return -1;
+    }
+    moov = get32(init + ftyp);
+    if (memcmp(init + ftyp + 4, "moov", 4) != 0 || ftyp + moov != mux->init_length) {
+        printf("Error: selftest: moov does not end the init segment\n");
+        return -1;
+    }
+    for (p = init; p + 4 <= init + mux->init_length && memcmp(p, "tkhd", 4) != 0; p++) {
+    }
+    // tkhd fields after the type: version and flags, times, track, reserved, duration, reserved, layer, volume, matrix
+    if (p + 88 > init + mux->init_length || get32(p + 80) >> 16 != (uint32_t) width || get32(p + 84) >> 16 != (uint32_t) height) {
+        printf("Error: selftest: tkhd is not %dx%d\n", width, height);
+        return -1;
+    }
+    for (p = init; p + 4 <= init + mux->init_length && memcmp(p, "avcC", 4) != 0; p++) {
+    }
+    if (p + 11 + sps_length + 3 + sizeof (selftest_pps) > init + mux->init_length
+            || get32(p - 4) != 8 + 11 + sps_length + sizeof (selftest_pps) + (sps[1] == 100 ? 4 : 0)
+            || p[4] != 1 || p[5] != sps[1] || p[8] != 0xff || p[9] != 0xe1
+            || (size_t) (p[10] << 8 | p[11]) != sps_length || memcmp(p + 12, sps, sps_length) != 0
+            || p[12 + sps_length] != 1 || memcmp(p + 15 + sps_length, selftest_pps, sizeof (selftest_pps)) != 0) {
+        printf("Error: selftest: avcC does not hold the SPS and PPS\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* One fragment: moof of one sample, mdat right after, decode time following on from the last. */
+static int selftest_fragment(const SELFTEST_OUT_T *out, int i, uint64_t *time, int64_t *first_pts) {
+    const uint8_t *f = out->data + (size_t) i * SELFTEST_FRAGMENT_MAX, *p, *end;
+    uint32_t length = out->length[i], sample, n;
+    uint64_t tfdt;
+    int key = i % SELFTEST_GOP == 0, sei = 0, slice = 0;
+    SAM_SEI_T state;
+
+    if (length < MP4_MUX_HEADER_SIZE || get32(f) != MP4_MUX_HEADER_SIZE - 8 || memcmp(f + 4, "moof", 4) != 0
+            || get32(f + MP4_MUX_HEADER_SIZE - 8) != length - (MP4_MUX_HEADER_SIZE - 8)
+            || memcmp(f + MP4_MUX_HEADER_SIZE - 4, "mdat", 4) != 0) {
+        printf("Error: selftest: fragment %d is not moof and mdat over %u bytes\n", i, length);
+        return -1;
+    }
+    sample = length - MP4_MUX_HEADER_SIZE;
+    tfdt = get64(f + 60);
+    if (get32(f + 20) != (uint32_t) i + 1 || get32(f + 80) != 1 || get32(f + 84) != MP4_MUX_HEADER_SIZE
+            || get32(f + 92) != sample || get32(f + 96) != (key ? 0x02000000u : 0x01010000u) || out->key[i] != key) {
+        printf("Error: selftest: fragment %d has the wrong sequence, offset, size or sync flags\n", i);
+        return -1;
+    }
+    if (tfdt != *time) {
+        printf("Error: selftest: fragment %d starts at %llu, the one before ended at %llu\n", i,
+                (unsigned long long) tfdt, (unsigned long long) *time);
+        return -1;
+    }
+    if (out->pts[i] != MP4_MUX_PTS_UNKNOWN) {
+        if (*first_pts == MP4_MUX_PTS_UNKNOWN) {
+            *first_pts = out->pts[i] - (int64_t) (tfdt * 1000000 / MP4_MUX_TIMESCALE);
+        }
+        if ((int64_t) tfdt - (out->pts[i] - *first_pts) * MP4_MUX_TIMESCALE / 1000000 > 1
+                || (out->pts[i] - *first_pts) * MP4_MUX_TIMESCALE / 1000000 - (int64_t) tfdt > 1) {
+            printf("Error: selftest: fragment %d at %llu for pts %lld\n", i, (unsigned long long) tfdt, (long long) out->pts[i]);
+            return -1;
+        }
+    }
+    *time = tfdt + get32(f + 88);
+    // the sample: this frame's SEI, then its slice, no parameter sets or delimiters
+    for (p = f + MP4_MUX_HEADER_SIZE, end = f + length; p + 4 <= end; p += 4 + n) {
+        n = get32(p);
+        if (n == 0 || n > (uint32_t) (end - p - 4)) {
+            break;
+        }
+        if ((p[4] & 0x1f) == NAL_SEI && sam_sei_parse(p + 4, n, &state) && state.seq == (uint32_t) i) {
+            sei++;
+        } else if ((p[4] & 0x1f) == (key ? 5 : 1) && n == SELFTEST_SLICE && p[5] == 1 + i % 250) {
+            slice++;
+        } else {
+            break;
+        }
+    }
+    if (p != end || sei != 1 || slice != 1) {
+        printf("Error: selftest: fragment %d does not hold its SEI and slice as 4 byte length NAL units\n", i);
+        return -1;
+    }
+    return 0;
+}
+
+/* Frames as the encoder hands them out: SPS/PPS before each IDR, then SEI and the slice split over buffers. */
+static int selftest_mp4(const uint8_t *sps, size_t sps_length, int width, int height) {
+    static uint8_t picture[4 + SAM_SEI_NAL_MAX + 6 + SELFTEST_SLICE];
+    SELFTEST_OUT_T out;
+    MP4_MUX_T mux;
+    SAM_SEI_T state;
+    uint64_t time = 0;
+    int64_t first_pts = MP4_MUX_PTS_UNKNOWN;
+    size_t n, k;
+    int i, result = 0;
+
+    memset(&out, 0, sizeof (out));
+    out.data = (uint8_t *) malloc((size_t) SELFTEST_FRAMES * SELFTEST_FRAGMENT_MAX);
+    if (!out.data || mp4_mux_init(&mux, 30, selftest_emit, &out) != 0) {
+        printf("Error: no memory\n");
+        free(out.data);
+        return -1;
+    }
+    for (i = 0; i < SELFTEST_FRAMES; i++) {
+        if (i % SELFTEST_GOP == 0) {
+            memcpy(picture, "\0\0\0\1", 4);
+            memcpy(picture + 4, sps, sps_length);
+            memcpy(picture + 4 + sps_length, "\0\0\1", 3);
+            memcpy(picture + 7 + sps_length, selftest_pps, sizeof (selftest_pps));
+            mp4_mux_push(&mux, picture, 7 + sps_length + sizeof (selftest_pps), 0, MP4_MUX_PTS_UNKNOWN);
+        }
+        memset(&state, 0, sizeof (state));
+        state.seq = (uint32_t) i;
+        n = sam_sei_write(&state, picture, sizeof (picture));
+        memcpy(picture + n, "\0\0\0\1\x09\xf0\0\0\1", 9); // an access unit delimiter, kept out of the sample
+        n += 9;
+        picture[n] = i % SELFTEST_GOP == 0 ? 0x65 : 0x41;
+        for (k = 1; k < SELFTEST_SLICE; k++) {
+            picture[n + k] = (uint8_t) (1 + (i + k - 1) % 250);
+        }
+        picture[n + SELFTEST_SLICE - 1] = 0x80;
+        n += SELFTEST_SLICE;
+        // in three buffers, the pts on the first as MMAL sets it
+        mp4_mux_push(&mux, picture, n / 3, 0, selftest_pts(i));
+        mp4_mux_push(&mux, picture + n / 3, n / 3, 0, MP4_MUX_PTS_UNKNOWN);
+        mp4_mux_push(&mux, picture + 2 * (n / 3), n - 2 * (n / 3), 1, MP4_MUX_PTS_UNKNOWN);
+    }
+    mp4_mux_flush(&mux);
+
+    if (out.overflow || out.count != SELFTEST_FRAMES || mux.dropped) {
+        printf("Error: selftest: %d fragments out of %d frames, %u dropped\n", out.count, SELFTEST_FRAMES, mux.dropped);
+        result = -1;
+    } else if (mux.width != width || mux.height != height || selftest_init(&mux, sps, sps_length, width, height) != 0) {
+        printf("Error: selftest: init segment for %dx%d\n", width, height);
+        result = -1;
+    }
+    for (i = 0; result == 0 && i < out.count; i++) {
+        result = selftest_fragment(&out, i, &time, &first_pts);
+    }
+    if (result == 0) {
+        printf("selftest: %d fragments of %dx%d profile %d\n", out.count, width, height, sps[1]);
+    }
+    mp4_mux_destroy(&mux);
+    free(out.data);
+    return result;
+}
+
+static int dump(const char *path, uint8_t *buf) {
+    FILE *f = fopen(path, "rb");
+    uint8_t head[8];
+    int count = 0, result;
+
+    if (!f) {
+        printf("Error: unable to open %s\n", path);
+        return -1;
+    }
+    if (fread(head, 1, 8, f) == 8 && memcmp(head + 4, "ftyp", 4) == 0) {
+        rewind(f);
+        result = dump_mp4(f, buf, &count);
+    } else {
+        rewind(f);
+        result = dump_annexb(f, buf, &count);
+    }
+    if (result != 0) {
+        printf("Error: %s: truncated or corrupt after %ld bytes\n", path, ftell(f));
+    }
+    printf("%s: %d states\n", path, count);
+    fclose(f);
+    return result;
+}
+
+int main(int argc, char** argv) {
+    uint8_t *buf;
+    int i, result = 0;
+
+    if (argc < 2) {
+        printf("usage: sam_seidump recording [recording ...] | --selftest\n");
+        return 1;
+    }
+    if (strcmp(argv[1], "--selftest") == 0) {
+        if (selftest_sei() != 0 || selftest_mp4(selftest_sps_baseline, sizeof (selftest_sps_baseline), 1280, 720) != 0
+                || selftest_mp4(selftest_sps_high, sizeof (selftest_sps_high), 1920, 1080) != 0) {
+            printf("selftest: FAIL\n");
+            return 1;
+        }
+        printf("selftest: PASS\n");
+        return 0;
+    }
+    buf = (uint8_t *) malloc(READ_SIZE);
+    if (!buf) {
+        printf("Error: no memory\n");
+        return 1;
+    }
+    for (i = 1; i < argc; i++) {
+        if (dump(argv[i], buf) != 0) {
+            result = 1;
+        }
+    }
+    free(buf);
+    return result;
+}
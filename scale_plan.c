@@ -0,0 +1,39 @@
+/*
+ * File:   scale_plan.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include "scale_plan.h"
+
+int scale_plan_build(SCALE_PLAN_T *plan, CvSize orig_window, double scale_factor,
+        CvSize min_size, CvSize max_size, CvSize region) {
+    double factor;
+
+    plan->count = 0;
+    plan->skipped = 0;
+    if (scale_factor <= 1.0) {
+        return 0;
+    }
+    // same bounds as the cvHaarDetectObjects level loop: a window must leave
+    // 10 pixels of the region free
+    for (factor = 1; factor * orig_window.width < region.width - 10
+            && factor * orig_window.height < region.height - 10; factor *= scale_factor) {
+        CvSize win = cvSize(cvRound(orig_window.width * factor), cvRound(orig_window.height * factor));
+
+        if ((max_size.width > 0 && win.width > max_size.width)
+                || (max_size.height > 0 && win.height > max_size.height)) {
+            break;
+        }
+        if (win.width < min_size.width || win.height < min_size.height
+                || plan->count == SCALE_PLAN_MAX_LEVELS) {
+            plan->skipped++;
+            continue;
+        }
+        plan->factor[plan->count] = factor;
+        plan->window[plan->count] = win;
+        plan->count++;
+    }
+    return plan->count;
+}
@@ -0,0 +1,32 @@
+/*
+ * File:   scale_plan.h
+ * Author: Hassan
+ *
+ * The detection window sizes a Haar scan over a given region can actually
+ * produce. Walks the same factor sequence as cvHaarDetectObjects (1, s, s^2,
+ * ...) and keeps only the levels inside [min_size, max_size] that still fit
+ * the region, so callers can skip a scan that cannot find anything and bound
+ * the one that can.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef SCALE_PLAN_H
+#define SCALE_PLAN_H
+
+#include <opencv2/core/core_c.h>
+
+#define SCALE_PLAN_MAX_LEVELS 32
+
+typedef struct {
+    int count;
+    double factor[SCALE_PLAN_MAX_LEVELS];
+    CvSize window[SCALE_PLAN_MAX_LEVELS];
+    int skipped; // levels walked but outside the size range
+} SCALE_PLAN_T;
+
+/* Returns the number of usable levels, 0 when no face can fit the region. */
+int scale_plan_build(SCALE_PLAN_T *plan, CvSize orig_window, double scale_factor,
+        CvSize min_size, CvSize max_size, CvSize region);
+
+#endif /* SCALE_PLAN_H */
@@ -0,0 +1,66 @@
+/*
+ * File:   spsc_queue.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <string.h>
+#include <unistd.h>
+
+#include "spsc_queue.h"
+#include "sys_util.h"
+
+void spsc_queue_init(SPSC_QUEUE_T *queue) {
+    memset(queue, 0, sizeof (SPSC_QUEUE_T));
+}
+
+void spsc_queue_push(SPSC_QUEUE_T *queue, void *item) {
+    uint32_t tail = queue->tail;
+    uint32_t head;
+
+    for (;;) {
+        head = __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+        if (tail - head < SPSC_QUEUE_CAPACITY) {
+            break;
+        }
+        __atomic_store_n(&queue->push_waiting, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&queue->head, __ATOMIC_SEQ_CST) == head) {
+            futex_wait(&queue->head, head, -1);
+        }
+        __atomic_store_n(&queue->push_waiting, 0, __ATOMIC_SEQ_CST);
+    }
+    queue->item[tail & (SPSC_QUEUE_CAPACITY - 1)] = item;
+    __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&queue->pop_waiting, __ATOMIC_SEQ_CST)) {
+        futex_wake(&queue->tail);
+    }
+}
+
+void *spsc_queue_pop(SPSC_QUEUE_T *queue) {
+    uint32_t head = queue->head;
+    uint32_t tail;
+    void *item;
+
+    for (;;) {
+        tail = __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE);
+        if (tail != head) {
+            break;
+        }
+        __atomic_store_n(&queue->pop_waiting, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&queue->tail, __ATOMIC_SEQ_CST) == tail) {
+            futex_wait(&queue->tail, tail, -1);
+        }
+        __atomic_store_n(&queue->pop_waiting, 0, __ATOMIC_SEQ_CST);
+    }
+    item = queue->item[head & (SPSC_QUEUE_CAPACITY - 1)];
+    __atomic_store_n(&queue->head, head + 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&queue->push_waiting, __ATOMIC_SEQ_CST)) {
+        futex_wake(&queue->head);
+    }
+    return item;
+}
+
+uint32_t spsc_queue_size(SPSC_QUEUE_T *queue) {
+    return __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE) - __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE);
+}
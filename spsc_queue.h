@@ -0,0 +1,40 @@
+/*
+ * File:   spsc_queue.h
+ * Author: Hassan
+ *
+ * Bounded single-producer single-consumer queue of pointers, used between
+ * the stages of sam_pipeline. Lock free: each side owns one counter and only
+ * reads the other's. A side that finds the queue full (producer) or empty
+ * (consumer) sleeps on the other side's counter with a futex, the same way
+ * frame_mailbox waits, so an idle stage costs nothing.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdint.h>
+
+#define SPSC_QUEUE_CAPACITY 8 // power of two
+
+typedef struct {
+    void *item[SPSC_QUEUE_CAPACITY];
+    uint32_t head; // next to pop, consumer owned
+    uint32_t tail; // next to push, producer owned
+    uint32_t push_waiting;
+    uint32_t pop_waiting;
+} SPSC_QUEUE_T;
+
+void spsc_queue_init(SPSC_QUEUE_T *queue);
+
+/* Producer side, waits while the queue is full. */
+void spsc_queue_push(SPSC_QUEUE_T *queue, void *item);
+
+/* Consumer side, waits while the queue is empty. */
+void *spsc_queue_pop(SPSC_QUEUE_T *queue);
+
+/* Items queued right now, from either side. */
+uint32_t spsc_queue_size(SPSC_QUEUE_T *queue);
+
+#endif /* SPSC_QUEUE_H */
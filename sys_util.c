@@ -0,0 +1,63 @@
+/*
+ * File:   sys_util.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <errno.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "sys_util.h"
+
+void futex_wait(uint32_t *addr, uint32_t value, int timeout_ms) {
+    struct timespec ts;
+    struct timespec *pts = NULL;
+
+    if (timeout_ms >= 0) {
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+        pts = &ts;
+    }
+    syscall(SYS_futex, addr, FUTEX_WAIT_PRIVATE, value, pts, NULL, 0);
+}
+
+void futex_wake(uint32_t *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+}
+
+void futex_wake_all(uint32_t *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+}
+
+uint64_t now_ns(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000000000ull + (uint64_t) t.tv_nsec;
+}
+
+size_t write_all(int fd, const void *data, size_t length) {
+    const uint8_t *p = (const uint8_t *) data;
+    size_t done = 0;
+    ssize_t n;
+
+    while (done < length) {
+        n = write(fd, p + done, length - done);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            if (n == 0) {
+                errno = EIO;
+            }
+            break;
+        }
+        done += (size_t) n;
+    }
+    return done;
+}
@@ -0,0 +1,30 @@
+/*
+ * File:   sys_util.h
+ * Author: Hassan
+ *
+ * The few system calls the threaded modules share: futex waits on a 32 bit
+ * counter the other side bumps before waking, the CLOCK_MONOTONIC time all
+ * their stats and deadlines are in, and a write that rides out EINTR and
+ * short writes. Futexes are process private.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef SYS_UTIL_H
+#define SYS_UTIL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Sleeps while *addr == value, up to timeout_ms (-1 forever); may wake early. */
+void futex_wait(uint32_t *addr, uint32_t value, int timeout_ms);
+void futex_wake(uint32_t *addr); // one waiter
+void futex_wake_all(uint32_t *addr);
+
+/* CLOCK_MONOTONIC in ns. */
+uint64_t now_ns(void);
+
+/* Bytes written, less than length on an error, errno then tells which. */
+size_t write_all(int fd, const void *data, size_t length);
+
+#endif /* SYS_UTIL_H */
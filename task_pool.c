@@ -0,0 +1,246 @@
+/*
+ * File:   task_pool.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <limits.h>
+#include <sched.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "task_pool.h"
+#include "sys_util.h"
+
+#define RING_MASK (TASK_DEQUE_CAPACITY - 1)
+
+/* this thread's deque, per pool */
+static __thread TASK_POOL_T *tls_pool;
+static __thread int tls_index = -1;
+
+/* Owner only. Returns 0 when the deque is full. */
+static int deque_push(TASK_DEQUE_T *d, TASK_T *task) {
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED);
+    long t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+
+    if (b - t >= TASK_DEQUE_CAPACITY) {
+        return 0;
+    }
+    __atomic_store_n(&d->ring[b & RING_MASK], task, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    return 1;
+}
+
+/* Owner only, newest first. */
+static TASK_T *deque_take(TASK_DEQUE_T *d) {
+    long b = __atomic_load_n(&d->bottom, __ATOMIC_RELAXED) - 1;
+    long t;
+    TASK_T *task = NULL;
+
+    __atomic_store_n(&d->bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    t = __atomic_load_n(&d->top, __ATOMIC_RELAXED);
+    if (t <= b) {
+        task = __atomic_load_n(&d->ring[b & RING_MASK], __ATOMIC_RELAXED);
+        if (t == b) {
+            // last one, race the thieves for it
+            if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+                task = NULL;
+            }
+            __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+        }
+    } else {
+        __atomic_store_n(&d->bottom, b + 1, __ATOMIC_RELAXED);
+    }
+    return task;
+}
+
+/* Any thread, oldest first. NULL when empty or another thief won. */
+static TASK_T *deque_steal(TASK_DEQUE_T *d) {
+    long t = __atomic_load_n(&d->top, __ATOMIC_ACQUIRE);
+    long b;
+    TASK_T *task;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    b = __atomic_load_n(&d->bottom, __ATOMIC_ACQUIRE);
+    if (t >= b) {
+        return NULL;
+    }
+    task = __atomic_load_n(&d->ring[t & RING_MASK], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&d->top, &t, t + 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return NULL;
+    }
+    return task;
+}
+
+static void run_task(TASK_POOL_T *pool, TASK_T *task) {
+    // the submitter may return, and reuse task, as soon as pending hits 0
+    TASK_BATCH_T *batch = task->batch;
+
+    task->fn(task->arg);
+    __atomic_add_fetch(&pool->tasks, 1, __ATOMIC_RELAXED);
+    if (__atomic_sub_fetch(&batch->pending, 1, __ATOMIC_ACQ_REL) == 0) {
+        futex_wake_all(&batch->pending);
+    }
+}
+
+/* Own deque first, then every other one starting after self. */
+static TASK_T *find_task(TASK_POOL_T *pool, int self) {
+    int n = __atomic_load_n(&pool->deques, __ATOMIC_ACQUIRE);
+    TASK_T *task = self >= 0 ? deque_take(&pool->deque[self]) : NULL;
+    int i;
+
+    if (n > TASK_POOL_MAX_THREADS) {
+        n = TASK_POOL_MAX_THREADS;
+    }
+    for (i = 1; !task && i <= n; i++) {
+        int victim = (self + i) % n;
+
+        if (victim != self) {
+            task = deque_steal(&pool->deque[victim]);
+            if (task) {
+                __atomic_add_fetch(&pool->steals, 1, __ATOMIC_RELAXED);
+            }
+        }
+    }
+    return task;
+}
+
+static void *worker(void *arg) {
+    TASK_POOL_T *pool = (TASK_POOL_T *) arg;
+    int self = tls_index;
+    int idle = 0;
+    uint32_t seen;
+    TASK_T *task;
+
+    for (;;) {
+        seen = __atomic_load_n(&pool->signal, __ATOMIC_SEQ_CST);
+        task = find_task(pool, self);
+        if (task) {
+            run_task(pool, task);
+            idle = 0;
+            continue;
+        }
+        if (__atomic_load_n(&pool->stop, __ATOMIC_ACQUIRE)) {
+            break;
+        }
+        if (++idle < TASK_POOL_SPIN) {
+            continue;
+        }
+        __atomic_add_fetch(&pool->sleeping, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&pool->signal, __ATOMIC_SEQ_CST) == seen) {
+            futex_wait(&pool->signal, seen, -1);
+        }
+        __atomic_sub_fetch(&pool->sleeping, 1, __ATOMIC_SEQ_CST);
+    }
+    return NULL;
+}
+
+typedef struct {
+    TASK_POOL_T *pool;
+    int index;
+} WORKER_START_T;
+
+static void *worker_start(void *arg) {
+    WORKER_START_T *start = (WORKER_START_T *) arg;
+    TASK_POOL_T *pool = start->pool;
+
+    tls_pool = pool;
+    tls_index = start->index;
+    __atomic_store_n(&start->index, -1, __ATOMIC_RELEASE);
+    return worker(pool);
+}
+
+int task_pool_init(TASK_POOL_T *pool, int threads) {
+    WORKER_START_T start;
+    int i;
+
+    memset(pool, 0, sizeof (TASK_POOL_T));
+    if (threads <= 0) {
+        threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    if (threads > TASK_POOL_MAX_THREADS / 2) {
+        // leave deques for the calling threads
+        threads = TASK_POOL_MAX_THREADS / 2;
+    }
+    pool->deques = threads - 1;
+    for (i = 0; i < threads - 1; i++) {
+        start.pool = pool;
+        start.index = i;
+        if (pthread_create(&pool->thread[i], NULL, worker_start, &start) != 0) {
+            fprintf(stderr, "Error: task_pool: unable to start worker %d\n", i);
+            task_pool_destroy(pool);
+            return -1;
+        }
+        while (__atomic_load_n(&start.index, __ATOMIC_ACQUIRE) >= 0) {
+            sched_yield();
+        }
+        pool->workers++;
+    }
+    return 0;
+}
+
+void task_pool_destroy(TASK_POOL_T *pool) {
+    int i;
+
+    __atomic_store_n(&pool->stop, 1, __ATOMIC_RELEASE);
+    __atomic_add_fetch(&pool->signal, 1, __ATOMIC_SEQ_CST);
+    futex_wake_all(&pool->signal);
+    for (i = 0; i < pool->workers; i++) {
+        pthread_join(pool->thread[i], NULL);
+    }
+    pool->workers = 0;
+}
+
+void task_pool_run(TASK_POOL_T *pool, TASK_T *tasks, int count) {
+    TASK_BATCH_T batch;
+    TASK_T *task;
+    uint32_t pending;
+    int self, i;
+
+    batch.pending = count;
+    for (i = 0; i < count; i++) {
+        tasks[i].batch = &batch;
+    }
+    if (tls_pool != pool) {
+        tls_pool = pool;
+        tls_index = __atomic_fetch_add(&pool->deques, 1, __ATOMIC_ACQ_REL);
+        if (tls_index >= TASK_POOL_MAX_THREADS) {
+            tls_index = -1;
+        }
+    }
+    self = tls_index;
+    if (pool->workers == 0 || self < 0) {
+        for (i = 0; i < count; i++) {
+            run_task(pool, &tasks[i]);
+        }
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (!deque_push(&pool->deque[self], &tasks[i])) {
+            run_task(pool, &tasks[i]);
+        }
+    }
+    __atomic_add_fetch(&pool->signal, 1, __ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&pool->sleeping, __ATOMIC_SEQ_CST)) {
+        futex_wake_all(&pool->signal);
+    }
+
+    // help until the batch is done; what is left of it is running elsewhere
+    while ((pending = __atomic_load_n(&batch.pending, __ATOMIC_ACQUIRE)) != 0) {
+        task = find_task(pool, self);
+        if (task) {
+            run_task(pool, task);
+        } else {
+            futex_wait(&batch.pending, pending, -1);
+        }
+    }
+}
+
+int task_pool_threads(const TASK_POOL_T *pool) {
+    return pool->workers + 1;
+}
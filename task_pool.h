@@ -0,0 +1,68 @@
+/*
+ * File:   task_pool.h
+ * Author: Hassan
+ *
+ * Fork-join work-stealing scheduler for splitting one detection call over
+ * every core. task_pool_run pushes a batch of tasks onto the calling
+ * thread's own deque and then helps run them; idle worker threads steal from
+ * the top of any deque, the owner pops from the bottom (Chase-Lev), so a
+ * batch spreads over the cores without a shared lock. Any number of threads
+ * may call task_pool_run at once, each gets a deque of its own on first use.
+ * Idle workers sleep on a futex until the next batch.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef TASK_POOL_H
+#define TASK_POOL_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#define TASK_POOL_MAX_THREADS 16 // workers plus calling threads
+#define TASK_DEQUE_CAPACITY 256 // power of two; a fuller batch runs the excess inline
+#define TASK_POOL_SPIN 64 // empty steal rounds before a worker sleeps
+
+typedef struct {
+    uint32_t pending; // tasks not finished yet, futex
+} TASK_BATCH_T;
+
+typedef struct {
+    void (*fn)(void *arg);
+    void *arg;
+    TASK_BATCH_T *batch; // set by task_pool_run
+} TASK_T;
+
+typedef struct {
+    long top __attribute__((aligned(64))); // thieves take here
+    long bottom __attribute__((aligned(64))); // owner pushes and pops here
+    TASK_T *ring[TASK_DEQUE_CAPACITY];
+} TASK_DEQUE_T;
+
+typedef struct {
+    int workers; // threads started by the pool
+    int deques; // deques handed out, workers first
+    TASK_DEQUE_T deque[TASK_POOL_MAX_THREADS];
+    pthread_t thread[TASK_POOL_MAX_THREADS];
+    uint32_t signal; // futex, bumped whenever work is pushed
+    uint32_t sleeping;
+    int stop;
+    uint32_t tasks; // run so far
+    uint32_t steals; // ... of which taken from another thread's deque
+} TASK_POOL_T;
+
+/*
+ * threads counts the calling thread, which helps with its own batches; 0 or
+ * less means one per online CPU. One thread starts no workers and runs every
+ * batch inline.
+ */
+int task_pool_init(TASK_POOL_T *pool, int threads);
+void task_pool_destroy(TASK_POOL_T *pool);
+
+/* Runs tasks[0..count) and returns once all of them have finished. */
+void task_pool_run(TASK_POOL_T *pool, TASK_T *tasks, int count);
+
+/* Threads that can run tasks at once, the caller included. */
+int task_pool_threads(const TASK_POOL_T *pool);
+
+#endif /* TASK_POOL_H */
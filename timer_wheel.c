@@ -0,0 +1,242 @@
+/*
+ * File:   timer_wheel.c
+ * Author: Hassan
+ *
+ * Created on Oct 17, 2026
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include "timer_wheel.h"
+
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+uint64_t timer_wheel_now_ms(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (uint64_t) t.tv_sec * 1000 + (uint64_t) t.tv_nsec / 1000000;
+}
+
+static void unlink_timer(TIMER_WHEEL_T *wheel, TIMER_T *timer) {
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+    timer->next = timer->prev = NULL;
+    timer->armed = 0;
+    wheel->armed--;
+    if (wheel->earliest_known && timer->deadline == wheel->earliest) {
+        wheel->earliest_known = 0;
+    }
+}
+
+/*
+ * Earliest deadline in the wheel, 0 when empty. Remembered until its timer
+ * leaves; otherwise the slots are walked from the next tick and the first
+ * one holding a timer due on this turn ends the search. Only when every
+ * timer is a turn or more away does the walk go all the way round.
+ */
+static uint64_t next_deadline(TIMER_WHEEL_T *wheel) {
+    uint64_t next = 0, tick;
+    TIMER_T *head, *t;
+
+    if (wheel->armed == 0) {
+        return 0;
+    }
+    if (wheel->earliest_known) {
+        return wheel->earliest;
+    }
+    for (tick = 1; tick <= TIMER_WHEEL_SLOTS; tick++) {
+        head = &wheel->slot[(wheel->now + tick) & SLOT_MASK];
+        for (t = head->next; t != head; t = t->next) {
+            // timers for later turns are further out than anything due on this one
+            if (next == 0 || t->deadline < next) {
+                next = t->deadline;
+            }
+        }
+        // a late timer sits in the next tick's slot, anything up to this tick is due here
+        if (next != 0 && next <= wheel->now + tick) {
+            break;
+        }
+    }
+    wheel->earliest = next;
+    wheel->earliest_known = 1;
+    return next;
+}
+
+/* Points the timerfd at the earliest deadline. Wheel locked. */
+static void program(TIMER_WHEEL_T *wheel) {
+    struct itimerspec its;
+    uint64_t next;
+
+    if (wheel->timerfd < 0) {
+        return;
+    }
+    next = next_deadline(wheel);
+    if (next && next <= wheel->now) {
+        // late timers wait for the next tick, see timer_wheel_arm
+        next = wheel->now + 1;
+    }
+    if (next == wheel->programmed) {
+        return;
+    }
+    memset(&its, 0, sizeof (its));
+    if (next) {
+        // absolute, a deadline already gone fires at once
+        its.it_value.tv_sec = next / 1000;
+        its.it_value.tv_nsec = (long) (next % 1000) * 1000000;
+    }
+    timerfd_settime(wheel->timerfd, TFD_TIMER_ABSTIME, &its, NULL);
+    wheel->programmed = next;
+}
+
+static void advance_locked(TIMER_WHEEL_T *wheel, uint64_t now) {
+    uint64_t ticks, tick;
+    TIMER_T *head, *t, *next;
+
+    if (now <= wheel->now) {
+        return;
+    }
+    // more than a turn behind: one pass over every slot fires all that is due
+    ticks = now - wheel->now;
+    if (ticks > TIMER_WHEEL_SLOTS) {
+        ticks = TIMER_WHEEL_SLOTS;
+    }
+    for (tick = 1; tick <= ticks; tick++) {
+        head = &wheel->slot[(wheel->now + tick) & SLOT_MASK];
+        for (t = head->next; t != head; t = next) {
+            next = t->next;
+            // a timer for a later turn stays put
+            if (t->deadline <= now) {
+                unlink_timer(wheel, t);
+                if (now - t->deadline > wheel->late_ms) {
+                    wheel->late_ms = (uint32_t) (now - t->deadline);
+                }
+                wheel->fired++;
+                t->fn(t->userdata);
+            }
+        }
+    }
+    wheel->now = now;
+}
+
+static void *wheel_thread(void *arg) {
+    TIMER_WHEEL_T *wheel = (TIMER_WHEEL_T *) arg;
+    uint64_t expirations;
+
+    for (;;) {
+        // EINTR and the like: look again anyway
+        if (read(wheel->timerfd, &expirations, sizeof (expirations)) < 0) {
+            expirations = 0;
+        }
+        pthread_mutex_lock(&wheel->lock);
+        if (wheel->stop) {
+            pthread_mutex_unlock(&wheel->lock);
+            break;
+        }
+        wheel->programmed = 0;
+        advance_locked(wheel, timer_wheel_now_ms());
+        program(wheel);
+        pthread_mutex_unlock(&wheel->lock);
+    }
+    return NULL;
+}
+
+void timer_wheel_init(TIMER_WHEEL_T *wheel, uint64_t now) {
+    int i;
+
+    memset(wheel, 0, sizeof (TIMER_WHEEL_T));
+    for (i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        wheel->slot[i].next = wheel->slot[i].prev = &wheel->slot[i];
+    }
+    wheel->now = now;
+    wheel->timerfd = -1;
+    pthread_mutex_init(&wheel->lock, NULL);
+}
+
+int timer_wheel_start(TIMER_WHEEL_T *wheel) {
+    wheel->timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (wheel->timerfd < 0) {
+        fprintf(stderr, "Error: timer_wheel: unable to create a timerfd\n");
+        return -1;
+    }
+    pthread_mutex_lock(&wheel->lock);
+    wheel->now = timer_wheel_now_ms();
+    program(wheel);
+    pthread_mutex_unlock(&wheel->lock);
+    if (pthread_create(&wheel->thread, NULL, wheel_thread, wheel) != 0) {
+        fprintf(stderr, "Error: timer_wheel: unable to start the thread\n");
+        close(wheel->timerfd);
+        wheel->timerfd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+void timer_wheel_destroy(TIMER_WHEEL_T *wheel) {
+    struct itimerspec its;
+
+    if (wheel->timerfd >= 0) {
+        pthread_mutex_lock(&wheel->lock);
+        wheel->stop = 1;
+        // long gone, wakes the thread at once
+        memset(&its, 0, sizeof (its));
+        its.it_value.tv_nsec = 1;
+        timerfd_settime(wheel->timerfd, TFD_TIMER_ABSTIME, &its, NULL);
+        pthread_mutex_unlock(&wheel->lock);
+        pthread_join(wheel->thread, NULL);
+        close(wheel->timerfd);
+        wheel->timerfd = -1;
+    }
+    pthread_mutex_destroy(&wheel->lock);
+}
+
+void timer_init(TIMER_T *timer, TIMER_FN_T fn, void *userdata) {
+    memset(timer, 0, sizeof (TIMER_T));
+    timer->fn = fn;
+    timer->userdata = userdata;
+}
+
+void timer_wheel_arm(TIMER_WHEEL_T *wheel, TIMER_T *timer, uint64_t deadline) {
+    TIMER_T *head;
+
+    pthread_mutex_lock(&wheel->lock);
+    if (timer->armed) {
+        unlink_timer(wheel, timer);
+    }
+    timer->deadline = deadline;
+    // slots behind the wheel are only visited a turn later, a late timer takes the next tick
+    head = &wheel->slot[(deadline > wheel->now ? deadline : wheel->now + 1) & SLOT_MASK];
+    timer->next = head->next;
+    timer->prev = head;
+    head->next->prev = timer;
+    head->next = timer;
+    timer->armed = 1;
+    wheel->armed++;
+    if (wheel->earliest_known && deadline < wheel->earliest) {
+        wheel->earliest = deadline;
+    }
+    if (wheel->programmed == 0 || deadline < wheel->programmed) {
+        program(wheel);
+    }
+    pthread_mutex_unlock(&wheel->lock);
+}
+
+void timer_wheel_cancel(TIMER_WHEEL_T *wheel, TIMER_T *timer) {
+    pthread_mutex_lock(&wheel->lock);
+    if (timer->armed) {
+        unlink_timer(wheel, timer);
+        // the timerfd may still go off for it, the thread then finds nothing due
+    }
+    pthread_mutex_unlock(&wheel->lock);
+}
+
+void timer_wheel_advance(TIMER_WHEEL_T *wheel, uint64_t now) {
+    pthread_mutex_lock(&wheel->lock);
+    advance_locked(wheel, now);
+    program(wheel);
+    pthread_mutex_unlock(&wheel->lock);
+}
@@ -0,0 +1,72 @@
+/*
+ * File:   timer_wheel.h
+ * Author: Hassan
+ *
+ * Millisecond one-shot timers on CLOCK_MONOTONIC, for the alert deadlines
+ * that must not wait for the next detection frame. Timers hang off a hashed
+ * wheel of TIMER_WHEEL_SLOTS one-millisecond slots, a timer further out than
+ * one turn simply stays in its slot for more turns. A thread sleeps on a
+ * timerfd set to the earliest deadline and fires what is due; without the
+ * thread the owner drives the wheel with timer_wheel_advance, on any clock.
+ *
+ * Callbacks run on the wheel thread with the wheel locked: keep them short
+ * and do not arm or cancel from inside one. Once timer_wheel_cancel returns
+ * the callback is neither running nor going to run.
+ *
+ * Created on Oct 17, 2026
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <pthread.h>
+#include <stdint.h>
+
+#define TIMER_WHEEL_SLOTS 256 // power of two, one millisecond each
+
+typedef void (*TIMER_FN_T)(void *userdata);
+
+typedef struct TIMER_T {
+    struct TIMER_T *next;
+    struct TIMER_T *prev;
+    uint64_t deadline; // ms
+    TIMER_FN_T fn;
+    void *userdata;
+    int armed;
+} TIMER_T;
+
+typedef struct {
+    TIMER_T slot[TIMER_WHEEL_SLOTS]; // list heads
+    uint64_t now; // last ms processed
+    int armed; // timers in the wheel
+    uint64_t earliest; // deadline of the first timer due, while earliest_known
+    int earliest_known; // cleared when that timer leaves the wheel
+    pthread_mutex_t lock;
+    pthread_t thread;
+    int timerfd; // -1 without a thread
+    uint64_t programmed; // deadline the timerfd is set to, 0 for none
+    int stop;
+    uint32_t fired;
+    uint32_t late_ms; // worst delay between a deadline and its callback
+} TIMER_WHEEL_T;
+
+/* Current CLOCK_MONOTONIC time in ms, the wheel thread's clock. */
+uint64_t timer_wheel_now_ms(void);
+
+/* now is the wheel's starting time on whatever clock will drive it. */
+void timer_wheel_init(TIMER_WHEEL_T *wheel, uint64_t now);
+void timer_wheel_destroy(TIMER_WHEEL_T *wheel);
+
+/* Starts the wheel thread; deadlines are then timer_wheel_now_ms times. */
+int timer_wheel_start(TIMER_WHEEL_T *wheel);
+
+void timer_init(TIMER_T *timer, TIMER_FN_T fn, void *userdata);
+
+/* (Re)arms timer for deadline; a deadline already passed fires on the next tick. */
+void timer_wheel_arm(TIMER_WHEEL_T *wheel, TIMER_T *timer, uint64_t deadline);
+void timer_wheel_cancel(TIMER_WHEEL_T *wheel, TIMER_T *timer);
+
+/* Fires every timer due by now. The wheel thread calls it, or the owner when there is no thread. */
+void timer_wheel_advance(TIMER_WHEEL_T *wheel, uint64_t now);
+
+#endif /* TIMER_WHEEL_H */
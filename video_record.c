@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <unistd.h>
 
 #include "bcm_host.h"
 #include "interface/vcos/vcos.h"
@@ -17,6 +18,10 @@
 #include "interface/mmal/util/mmal_connection.h"
 #include <cairo/cairo.h>
 
+#include "glyph_atlas.h"
+#include "overlay_spans.h"
+#include "h264_writer.h"
+
 #define MMAL_CAMERA_PREVIEW_PORT 0
 #define MMAL_CAMERA_VIDEO_PORT 1
 #define MMAL_CAMERA_CAPTURE_PORT 2
@@ -24,6 +29,14 @@
 #define VIDEO_FPS 30 
 #define VIDEO_WIDTH 1280
 #define VIDEO_HEIGHT 720
+// camera buffers go to the encoder as they are; it may hold this many, two stay with the camera
+#define ENCODER_IN_FLIGHT 2
+#define CAMERA_BUFFERS (ENCODER_IN_FLIGHT + 2)
+#define INTRA_PERIOD (VIDEO_FPS * 2) // an IDR with its SPS/PPS every two seconds, where segments may start
+#define WRITER_STATS_INTERVAL 100 // main loop turns
+#define OVERLAY_WIDTH 600
+#define OVERLAY_HEIGHT 100
+#define TEXT_COLOR 0xffffe060 // the yellow the overlay used to be hardcoded to
 
 
 
@@ -38,20 +51,40 @@ typedef struct {
     MMAL_PORT_T *camera_still_port;
     MMAL_POOL_T *camera_video_port_pool;
     MMAL_PORT_T *encoder_input_port;
-    MMAL_POOL_T *encoder_input_pool;
     MMAL_PORT_T *encoder_output_port;
     MMAL_POOL_T *encoder_output_pool;
     uint8_t *overlay_buffer;
     uint8_t *overlay_buffer2;
+    OVERLAY_SPANS_T overlay_spans; // the lit runs of overlay_buffer
+    OVERLAY_SPANS_T overlay_spans2;
     int overlay;
     float fps;
+    int encoder_in_flight; // camera buffers the encoder has not released yet
+    unsigned encoded; // frames handed to the encoder
+    unsigned dropped_busy; // the encoder already held ENCODER_IN_FLIGHT frames
+    unsigned dropped_error; // the encoder was not up yet or refused the buffer
+    H264_WRITER_T writer; // the encoder output, written from its own thread
 } PORT_USERDATA;
 
+/* Hands a free camera buffer back to the video port, after one came home. */
+static void camera_buffer_return(PORT_USERDATA *userdata) {
+    MMAL_BUFFER_HEADER_T *new_buffer;
+    MMAL_PORT_T *port = userdata->camera_video_port;
+
+    if (!port->is_enabled) {
+        return;
+    }
+    new_buffer = mmal_queue_get(userdata->camera_video_port_pool->queue);
+    if (!new_buffer || mmal_port_send_buffer(port, new_buffer) != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: Unable to return a buffer to the video port\n");
+    }
+}
+
 static void camera_video_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer) {
     static int frame_count = 0;
     static struct timespec t1;
     struct timespec t2;
-    uint8_t *local_overlay_buffer;
+    OVERLAY_SPANS_T *local_overlay_spans;
 
     //fprintf(stderr, "INFO:%s\n", __func__);
     if (frame_count == 0) {
@@ -61,56 +94,48 @@ static void camera_video_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T
 
     int d = t2.tv_sec - t1.tv_sec;
 
-    MMAL_BUFFER_HEADER_T *new_buffer;
-    MMAL_BUFFER_HEADER_T *output_buffer = 0;
     PORT_USERDATA *userdata = (PORT_USERDATA *) port->userdata;
-
-    MMAL_POOL_T *pool = userdata->camera_video_port_pool;
+    MMAL_PORT_T *encoder_port = userdata->encoder_input_port;
+    int sent = 0;
 
 
     frame_count++;
 
-    output_buffer = mmal_queue_get(userdata->encoder_input_pool->queue);
-
     //Set pointer to  latest updated/drawn double buffer to local pointer  
     if (userdata->overlay == 0) {
-        local_overlay_buffer = userdata->overlay_buffer;
+        local_overlay_spans = &userdata->overlay_spans;
     }
     else {
-        local_overlay_buffer = userdata->overlay_buffer2;
+        local_overlay_spans = &userdata->overlay_spans2;
     }
 
-    //Try to some colors http://en.wikipedia.org/wiki/YUV
+    //I420: Y, then U and V at a quarter of the size each
     int chrominance_offset = userdata->width * userdata->height;
     int v_offset = chrominance_offset / 4;
-    int chroma = 0;
 
-    if (output_buffer) {
+    if (!encoder_port || !encoder_port->is_enabled) {
+        // frames arrive before setup_encoder has run
+        userdata->dropped_error++;
+    } else if (__atomic_load_n(&userdata->encoder_in_flight, __ATOMIC_ACQUIRE) >= ENCODER_IN_FLIGHT) {
+        userdata->dropped_busy++;
+    } else {
+        // the overlay goes straight into the camera's buffer, which then is the encoder's input
         mmal_buffer_header_mem_lock(buffer);
-        memcpy(output_buffer->data, buffer->data, buffer->length);
-        // dim
-        int x, y;
-        for (x = 0; x < 600; x++) {
-            for (y = 0; y < 100; y++) {
-                if (local_overlay_buffer[(y * 600 + x) * 4] > 0) {
-                    //copy luma Y
-                    output_buffer->data[y * userdata->width + x ] = 0xdf;
-                    //pointer to chrominance U/V
-                    chroma= y / 2 * userdata->width / 2 + x / 2 + chrominance_offset;
-                    //just guessing colors 
-                    output_buffer->data[chroma] = 0x38 ;
-                    output_buffer->data[chroma+v_offset] = 0xb8 ;
-                }
-            }
-        }
-
-        output_buffer->length = buffer->length;
+        // only the lit runs of the overlay are touched, compiled when the text changed
+        overlay_spans_blend(local_overlay_spans, buffer->data, userdata->width,
+                buffer->data + chrominance_offset, buffer->data + chrominance_offset + v_offset,
+                userdata->width / 2, 0, 0);
         mmal_buffer_header_mem_unlock(buffer);
-        if (mmal_port_send_buffer(userdata->encoder_input_port, output_buffer) != MMAL_SUCCESS) {
+
+        __atomic_add_fetch(&userdata->encoder_in_flight, 1, __ATOMIC_ACQ_REL);
+        if (mmal_port_send_buffer(encoder_port, buffer) == MMAL_SUCCESS) {
+            userdata->encoded++;
+            sent = 1;
+        } else {
+            __atomic_sub_fetch(&userdata->encoder_in_flight, 1, __ATOMIC_ACQ_REL);
+            userdata->dropped_error++;
             fprintf(stderr, "ERROR: Unable to send buffer \n");
         }
-    } else {
-        fprintf(stderr, "ERROR: mmal_queue_get (%d)\n", output_buffer);
     }
 
 
@@ -126,41 +151,52 @@ static void camera_video_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T
             fps = frame_count;
         }
         userdata->fps = fps;
-        fprintf(stderr, "  Frame = %d,  Framerate = %.1f fps \n", frame_count, fps);
+        fprintf(stderr, "  Frame = %d,  Framerate = %.1f fps, overlay %d runs %d pixels, encoded %u dropped %u busy %u error \n",
+                frame_count, fps, local_overlay_spans->luma_count, local_overlay_spans->pixels,
+                userdata->encoded, userdata->dropped_busy, userdata->dropped_error);
     }
 
-
+    if (sent) {
+        // comes back through encoder_input_buffer_callback
+        return;
+    }
     mmal_buffer_header_release(buffer);
 
     // and send one back to the port (if still open)
-    if (port->is_enabled) {
-        MMAL_STATUS_T status;
-
-        new_buffer = mmal_queue_get(pool->queue);
-
-        if (new_buffer) {
-            status = mmal_port_send_buffer(port, new_buffer);
-        }
-
-        if (!new_buffer || status != MMAL_SUCCESS) {
-            fprintf(stderr, "Error: Unable to return a buffer to the video port\n");
-        }
-    }
+    camera_buffer_return(userdata);
 }
 
+/* The encoder is done with a camera buffer: back to the camera's pool, and a free one to the camera. */
 static void encoder_input_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer) {
+    PORT_USERDATA *userdata = (PORT_USERDATA *) port->userdata;
+
     //fprintf(stderr, "INFO:%s\n", __func__);    
     mmal_buffer_header_release(buffer);
+    __atomic_sub_fetch(&userdata->encoder_in_flight, 1, __ATOMIC_ACQ_REL);
+    camera_buffer_return(userdata);
 }
 
 static void encoder_output_buffer_callback(MMAL_PORT_T *port, MMAL_BUFFER_HEADER_T *buffer) {
     MMAL_BUFFER_HEADER_T *new_buffer;
     PORT_USERDATA *userdata = (PORT_USERDATA *) port->userdata;
     MMAL_POOL_T *pool = userdata->encoder_output_pool;
+    int flags;
     //fprintf(stderr, "INFO:%s\n", __func__);
 
+    // only a copy into the writer's ring, a slow card must not hold up the encoder's buffers
+    flags = 0;
+    if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_CONFIG) {
+        flags |= H264_WRITER_CONFIG;
+    }
+    if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_KEYFRAME) {
+        flags |= H264_WRITER_KEYFRAME;
+    }
+    if (buffer->flags & MMAL_BUFFER_HEADER_FLAG_FRAME_END) {
+        flags |= H264_WRITER_FRAME_END;
+    }
     mmal_buffer_header_mem_lock(buffer);
-    fwrite(buffer->data, 1, buffer->length, stdout);
+    h264_writer_push(&userdata->writer, buffer->data, buffer->length, flags,
+            buffer->pts == MMAL_TIME_UNKNOWN ? H264_WRITER_PTS_UNKNOWN : buffer->pts);
     mmal_buffer_header_mem_unlock(buffer);
 
     mmal_buffer_header_release(buffer);
@@ -270,7 +306,7 @@ int setup_camera(PORT_USERDATA *userdata) {
     format->es->video.frame_rate.den = 1;
 
     camera_video_port->buffer_size = format->es->video.width * format->es->video.height * 12 / 8;
-    camera_video_port->buffer_num = 2;
+    camera_video_port->buffer_num = CAMERA_BUFFERS;
 
     fprintf(stderr, "INFO:camera video buffer_size = %d\n", camera_video_port->buffer_size);
     fprintf(stderr, "INFO:camera video buffer_num = %d\n", camera_video_port->buffer_num);
@@ -281,6 +317,11 @@ int setup_camera(PORT_USERDATA *userdata) {
         return -1;
     }
 
+    // the buffers are shared with the GPU, the encoder reads the same memory the camera wrote
+    if (mmal_port_parameter_set_boolean(camera_video_port, MMAL_PARAMETER_ZERO_COPY, 1) != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to set zero copy on the camera video port\n");
+        return -1;
+    }
     camera_video_port_pool = (MMAL_POOL_T *) mmal_port_pool_create(camera_video_port, camera_video_port->buffer_num, camera_video_port->buffer_size);
     userdata->camera_video_port_pool = camera_video_port_pool;
     camera_video_port->userdata = (struct MMAL_PORT_USERDATA_T *) userdata;
@@ -316,7 +357,6 @@ int setup_encoder(PORT_USERDATA *userdata) {
     MMAL_PORT_T *preview_input_port = NULL;
 
     MMAL_PORT_T *encoder_input_port = NULL, *encoder_output_port = NULL;
-    MMAL_POOL_T *encoder_input_port_pool;
     MMAL_POOL_T *encoder_output_port_pool;
 
     status = mmal_component_create(MMAL_COMPONENT_DEFAULT_VIDEO_ENCODER, &encoder);
@@ -331,8 +371,9 @@ int setup_encoder(PORT_USERDATA *userdata) {
     userdata->encoder_output_port = encoder_input_port;
 
     mmal_format_copy(encoder_input_port->format, userdata->camera_video_port->format);
-    encoder_input_port->buffer_size = encoder_input_port->buffer_size_recommended;
-    encoder_input_port->buffer_num = 2;
+    // it is fed the camera's own buffers, no pool of its own
+    encoder_input_port->buffer_size = userdata->camera_video_port->buffer_size;
+    encoder_input_port->buffer_num = userdata->camera_video_port->buffer_num;
 
 
     mmal_format_copy(encoder_output_port->format, encoder_input_port->format);
@@ -370,21 +411,30 @@ int setup_encoder(PORT_USERDATA *userdata) {
         return -1;
     }
 
+    // SPS/PPS ahead of every IDR, so each segment the writer cuts decodes on its own
+    if (mmal_port_parameter_set_uint32(encoder_output_port, MMAL_PARAMETER_INTRAPERIOD, INTRA_PERIOD) != MMAL_SUCCESS
+            || mmal_port_parameter_set_boolean(encoder_output_port, MMAL_PARAMETER_VIDEO_ENCODE_INLINE_HEADER, 1) != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to set the encoder intra period and inline headers\n");
+        return -1;
+    }
+
     fprintf(stderr, " encoder input buffer_size = %d\n", encoder_input_port->buffer_size);
     fprintf(stderr, " encoder input buffer_num = %d\n", encoder_input_port->buffer_num);
 
     fprintf(stderr, " encoder output buffer_size = %d\n", encoder_output_port->buffer_size);
     fprintf(stderr, " encoder output buffer_num = %d\n", encoder_output_port->buffer_num);
 
-    encoder_input_port_pool = (MMAL_POOL_T *) mmal_port_pool_create(encoder_input_port, encoder_input_port->buffer_num, encoder_input_port->buffer_size);
-    userdata->encoder_input_pool = encoder_input_port_pool;
+    if (mmal_port_parameter_set_boolean(encoder_input_port, MMAL_PARAMETER_ZERO_COPY, 1) != MMAL_SUCCESS) {
+        fprintf(stderr, "Error: unable to set zero copy on the encoder input port\n");
+        return -1;
+    }
     encoder_input_port->userdata = (struct MMAL_PORT_USERDATA_T *) userdata;
     status = mmal_port_enable(encoder_input_port, encoder_input_buffer_callback);
     if (status != MMAL_SUCCESS) {
         fprintf(stderr, "Error: unable to enable encoder input port (%u)\n", status);
         return -1;
     }
-    fprintf(stderr, "INFO:Encoder input pool has been created\n");
+    fprintf(stderr, "INFO:Encoder input port takes the camera buffers\n");
 
 
     encoder_output_port_pool = (MMAL_POOL_T *) mmal_port_pool_create(encoder_output_port, encoder_output_port->buffer_num, encoder_output_port->buffer_size);
@@ -460,7 +510,10 @@ int main(int argc, char** argv) {
 
 
     cairo_surface_t *surface,*surface2;
-    cairo_t *context,*context2;
+    GLYPH_ATLAS_T atlas;
+    GLYPH_TEXT_T shown, shown2;
+    H264_WRITER_CONFIG_T writer_config;
+    int turns = 0;
 
     memset(&userdata, 0, sizeof (PORT_USERDATA));
 
@@ -475,23 +528,27 @@ int main(int argc, char** argv) {
 
     bcm_host_init();
 
-    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 600, 100);
-    context = cairo_create(surface);
-    cairo_rectangle(context, 0.0, 0.0, 600, 100);
-    cairo_set_source_rgba(context, 0.0, 0.0, 0.0, 1.0);
-    cairo_fill(context);
-
+    // new surfaces are transparent, the text keeps its colour and gets its coverage as alpha
+    surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, OVERLAY_WIDTH, OVERLAY_HEIGHT);
     userdata.overlay_buffer = cairo_image_surface_get_data(surface);
     userdata.overlay = 1;
 
-    surface2 = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 600, 100);
-    context2 = cairo_create(surface2);
-    cairo_rectangle(context2, 0.0, 0.0, 600, 100);
-    cairo_set_source_rgba(context2, 0.0, 0.0, 0.0, 1.0);
-    cairo_fill(context2);
-
+    surface2 = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, OVERLAY_WIDTH, OVERLAY_HEIGHT);
     userdata.overlay_buffer2 = cairo_image_surface_get_data(surface2);
 
+    if (overlay_spans_init(&userdata.overlay_spans, OVERLAY_WIDTH, OVERLAY_HEIGHT) != 0
+            || overlay_spans_init(&userdata.overlay_spans2, OVERLAY_WIDTH, OVERLAY_HEIGHT) != 0) {
+        return -1;
+    }
+    fprintf(stderr, "Overlay blend: %s\n", overlay_spans_impl());
+
+    // text is blitted from glyphs rasterised once, each buffer redraws only the characters it changed
+    if (glyph_atlas_init(&atlas, "sans-serif", 20) != 0) {
+        return -1;
+    }
+    glyph_text_init(&shown, &atlas);
+    glyph_text_init(&shown2, &atlas);
+
 
 
     if (1 && setup_camera(&userdata) != 0) {
@@ -500,6 +557,18 @@ int main(int argc, char** argv) {
     }
 
 
+    // video_record [segment prefix]: fragmented MP4 segments with an index, raw H.264 to stdout without one
+    h264_writer_config_default(&writer_config);
+    writer_config.path = argc > 1 ? argv[1] : NULL;
+    if (writer_config.path) {
+        writer_config.format = H264_WRITER_MP4;
+        writer_config.fps = VIDEO_FPS;
+        writer_config.index = 1;
+    }
+    if (h264_writer_init(&userdata.writer, &writer_config) != 0) {
+        return -1;
+    }
+
     if (1 && setup_encoder(&userdata) != 0) {
         fprintf(stderr, "Error: setup encoder %x\n", status);
         return -1;
@@ -525,31 +594,29 @@ int main(int argc, char** argv) {
         //Update Draw to unused buffer that way there is no flickering of the overlay text if the overlay update rate
         //and video FPS are not the same
         if (userdata.overlay == 1) { 
-            cairo_rectangle(context, 0.0, 0.0, 600, 100);
-            cairo_set_source_rgba(context, 0.0, 0.0, 0.0, 1.0);
-            cairo_fill(context);
-            cairo_move_to(context, 0.0, 0.0);
-            cairo_set_source_rgba(context, 1.0, 1.0, 1.0, 1.0);        
-            cairo_move_to(context, 0.0, 30.0);
-            cairo_set_font_size(context, 20.0);
             sprintf(text, "%.2fFPS GPS: %.3f, %.3f Speed %.1fkm/h b0", userdata.fps,lat,lon,speed);
-            cairo_show_text(context, text);
+            if (glyph_text_draw(&shown, (uint32_t *) userdata.overlay_buffer, cairo_image_surface_get_stride(surface) / 4,
+                    OVERLAY_WIDTH, OVERLAY_HEIGHT, 0, 30 - atlas.baseline, text, TEXT_COLOR, 0) > 0) {
+                overlay_spans_compile(&userdata.overlay_spans, (uint32_t *) userdata.overlay_buffer,
+                        cairo_image_surface_get_stride(surface) / 4);
+            }
             userdata.overlay = 0;
         }
         else {
-            cairo_rectangle(context2, 0.0, 0.0, 600, 100);
-            cairo_set_source_rgba(context2, 0.0, 0.0, 0.0, 1.0);
-            cairo_fill(context2);
-            cairo_move_to(context2, 0.0, 0.0);
-            cairo_set_source_rgba(context2, 1.0, 1.0, 1.0, 1.0);        
-            cairo_move_to(context2, 0.0, 30.0);
-            cairo_set_font_size(context2, 20.0);
             sprintf(text, "%.2fFPS GPS: %.3f, %.3f Speed %.1fkm/h b1", userdata.fps,lat,lon,speed);
             //sprintf(text, "%.2fFPS GPS: 0.00000, 0.00000 Speed 0km/h b1", userdata.fps);
-            cairo_show_text(context2, text);
+            if (glyph_text_draw(&shown2, (uint32_t *) userdata.overlay_buffer2, cairo_image_surface_get_stride(surface2) / 4,
+                    OVERLAY_WIDTH, OVERLAY_HEIGHT, 0, 30 - atlas.baseline, text, TEXT_COLOR, 0) > 0) {
+                overlay_spans_compile(&userdata.overlay_spans2, (uint32_t *) userdata.overlay_buffer2,
+                        cairo_image_surface_get_stride(surface2) / 4);
+            }
             userdata.overlay = 1;
         }
 
+        if (++turns % WRITER_STATS_INTERVAL == 0) {
+            h264_writer_print_stats(&userdata.writer);
+        }
+
 
         lat += 0.01;
         lon += 0.01;